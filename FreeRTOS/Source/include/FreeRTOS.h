@@ -254,6 +254,86 @@
     #define configIDLE_SHOULD_YIELD    1
 #endif
 
+#ifndef configNUMBER_OF_CORES
+    #define configNUMBER_OF_CORES    1
+#endif
+
+#ifndef configUSE_CORE_AFFINITY
+    #define configUSE_CORE_AFFINITY    0
+#endif
+
+#ifndef configUSE_PASSIVE_IDLE_HOOK
+    #define configUSE_PASSIVE_IDLE_HOOK    0
+#endif
+
+#ifndef configUSE_TIMING_WHEEL
+    #define configUSE_TIMING_WHEEL    0
+#endif
+
+#ifndef configTIMING_WHEEL_SIZE
+    #define configTIMING_WHEEL_SIZE    256
+#endif
+
+#if ( configUSE_TIMING_WHEEL == 1 ) && ( ( configTIMING_WHEEL_SIZE < 1 ) || ( ( configTIMING_WHEEL_SIZE & ( configTIMING_WHEEL_SIZE - 1 ) ) != 0 ) )
+    #error configTIMING_WHEEL_SIZE must be a power of 2
+#endif
+
+#ifndef configUSE_EDF_SCHEDULING
+    #define configUSE_EDF_SCHEDULING    0
+#endif
+
+#ifndef configEDF_PRIORITY
+    #define configEDF_PRIORITY    1
+#endif
+
+#if ( configUSE_EDF_SCHEDULING == 1 ) && ( ( configEDF_PRIORITY < 1 ) || ( configEDF_PRIORITY >= configMAX_PRIORITIES ) )
+    #error configEDF_PRIORITY must be above the idle priority and below configMAX_PRIORITIES
+#endif
+
+#ifndef configUSE_ADMISSION_CONTROL
+    #define configUSE_ADMISSION_CONTROL    0
+#endif
+
+/* 1 to refuse a timing contract that makes the tasks unschedulable, 0 to
+ * accept it and call vApplicationAdmissionWarningHook(). */
+#ifndef configADMISSION_CONTROL_REJECTS
+    #define configADMISSION_CONTROL_REJECTS    1
+#endif
+
+#ifndef configUSE_TASK_BUDGETS
+    #define configUSE_TASK_BUDGETS    0
+#endif
+
+/* The priority of a task that overran a budget set with eBudgetDemote, until
+ * the budget is replenished. */
+#ifndef configBUDGET_DEMOTED_PRIORITY
+    #define configBUDGET_DEMOTED_PRIORITY    0
+#endif
+
+#if ( configUSE_TASK_BUDGETS == 1 ) && ( configBUDGET_DEMOTED_PRIORITY >= configMAX_PRIORITIES )
+    #error configBUDGET_DEMOTED_PRIORITY must be below configMAX_PRIORITIES
+#endif
+
+#ifndef configUSE_TASK_SNAPSHOTS
+    #define configUSE_TASK_SNAPSHOTS    0
+#endif
+
+/* The tasks uxTaskGetSnapshot() can report.  A task created while every slot
+ * is taken is left out, and reported as truncated. */
+#ifndef configTASK_SNAPSHOT_SLOTS
+    #define configTASK_SNAPSHOT_SLOTS    16
+#endif
+
+/* The stack bytes the idle task checks for its high water mark per
+ * iteration, in a critical section. */
+#ifndef configTASK_SNAPSHOT_SCAN_BYTES
+    #define configTASK_SNAPSHOT_SCAN_BYTES    64
+#endif
+
+#if ( configUSE_TASK_SNAPSHOTS == 1 ) && ( ( configTASK_SNAPSHOT_SLOTS < 1 ) || ( configTASK_SNAPSHOT_SCAN_BYTES < 1 ) )
+    #error configTASK_SNAPSHOT_SLOTS and configTASK_SNAPSHOT_SCAN_BYTES must be at least 1
+#endif
+
 #if configMAX_TASK_NAME_LEN < 1
     #error configMAX_TASK_NAME_LEN must be set to a minimum of 1 in FreeRTOSConfig.h
 #endif
@@ -285,6 +365,12 @@
     #define portSOFTWARE_BARRIER()
 #endif
 
+/* Orders the accesses to the sequence counter of a task snapshot and to the
+ * snapshot itself, see configUSE_TASK_SNAPSHOTS. */
+#ifndef portSEQLOCK_BARRIER
+    #define portSEQLOCK_BARRIER()    portMEMORY_BARRIER()
+#endif
+
 /* The timers module relies on xTaskGetSchedulerState(). */
 #if configUSE_TIMERS == 1
 
@@ -927,6 +1013,30 @@
     #endif /* INCLUDE_vTaskSuspend */
 #endif /* configUSE_TICKLESS_IDLE */
 
+#if ( configNUMBER_OF_CORES > 1 )
+    #ifndef portGET_CORE_ID
+        #error portGET_CORE_ID must be defined by the port when configNUMBER_OF_CORES is greater than 1
+    #endif
+    #ifndef portYIELD_CORE
+        #error portYIELD_CORE must be defined by the port when configNUMBER_OF_CORES is greater than 1
+    #endif
+    #if !defined( portGET_TASK_LOCK ) || !defined( portRELEASE_TASK_LOCK )
+        #error portGET_TASK_LOCK and portRELEASE_TASK_LOCK must be defined by the port when configNUMBER_OF_CORES is greater than 1
+    #endif
+    #if ( configUSE_TICKLESS_IDLE != 0 )
+        #error configUSE_TICKLESS_IDLE is not supported when configNUMBER_OF_CORES is greater than 1
+    #endif
+    #if ( configUSE_PORT_OPTIMISED_TASK_SELECTION == 1 )
+        #error configUSE_PORT_OPTIMISED_TASK_SELECTION is not supported when configNUMBER_OF_CORES is greater than 1
+    #endif
+    #if ( configSUPPORT_DYNAMIC_ALLOCATION != 1 )
+        #error configSUPPORT_DYNAMIC_ALLOCATION must be 1 when configNUMBER_OF_CORES is greater than 1, the passive idle tasks are created dynamically
+    #endif
+    #if ( configUSE_CORE_AFFINITY == 1 ) && ( configNUMBER_OF_CORES > 32 )
+        #error configUSE_CORE_AFFINITY supports at most 32 cores
+    #endif
+#endif /* configNUMBER_OF_CORES */
+
 #if ( ( configSUPPORT_STATIC_ALLOCATION == 0 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 0 ) )
     #error configSUPPORT_STATIC_ALLOCATION and configSUPPORT_DYNAMIC_ALLOCATION cannot both be 0, but can both be 1.
 #endif
@@ -1223,6 +1333,31 @@ typedef struct xSTATIC_TCB
     #if ( configUSE_POSIX_ERRNO == 1 )
         int iDummy22;
     #endif
+    #if ( configNUMBER_OF_CORES > 1 )
+        BaseType_t xDummy23[ 2 ];
+        #if ( configUSE_CORE_AFFINITY == 1 )
+            UBaseType_t uxDummy25;
+        #endif
+    #endif
+    #if ( configUSE_EDF_SCHEDULING == 1 )
+        TickType_t xDummy26[ 4 ];
+        UBaseType_t uxDummy27;
+    #endif
+    #if ( configUSE_ADMISSION_CONTROL == 1 )
+        TickType_t xDummy28[ 3 ];
+        void * pvDummy29;
+        uint64_t ullDummy30[ 2 ];
+        UBaseType_t uxDummy36;
+    #endif
+    #if ( configUSE_TASK_BUDGETS == 1 )
+        TickType_t xDummy31[ 4 ];
+        UBaseType_t uxDummy32[ 2 ];
+        void * pvDummy33;
+        uint8_t ucDummy34[ 2 ];
+    #endif
+    #if ( configUSE_TASK_SNAPSHOTS == 1 )
+        void * pvDummy35;
+    #endif
 } StaticTask_t;
 
 /*
@@ -30,9 +30,10 @@
  * @file atomic.h
  * @brief FreeRTOS atomic operation support.
  *
- * This file implements atomic functions by disabling interrupts globally.
- * Implementations with architecture specific atomic instructions can be
- * provided under each compiler directory.
+ * This file implements atomic functions by disabling interrupts globally,
+ * or with the atomic builtins of the compiler when configUSE_ATOMIC_BUILTINS
+ * is 1.  Implementations with architecture specific atomic instructions can
+ * be provided under each compiler directory.
  */
 
 #ifndef ATOMIC_H
@@ -59,7 +60,11 @@
  * ATOMIC_ENTER_CRITICAL().
  *
  */
-#if defined( portSET_INTERRUPT_MASK_FROM_ISR )
+#if defined( ATOMIC_ENTER_CRITICAL )
+
+/* Provided by the port. */
+
+#elif defined( portSET_INTERRUPT_MASK_FROM_ISR )
 
 /* Nested interrupt scheme is supported in this port. */
     #define ATOMIC_ENTER_CRITICAL() \
@@ -87,6 +92,24 @@
     #define portFORCE_INLINE
 #endif
 
+/*
+ * Use the __atomic builtins of GCC and Clang instead of critical sections.
+ * By default only when they compile to lock-free instructions for 32-bit
+ * integers and pointers, so no operation falls back to a library lock.
+ */
+#ifndef configUSE_ATOMIC_BUILTINS
+    #if defined( __GCC_ATOMIC_INT_LOCK_FREE ) && ( __GCC_ATOMIC_INT_LOCK_FREE == 2 ) && \
+        defined( __GCC_ATOMIC_POINTER_LOCK_FREE ) && ( __GCC_ATOMIC_POINTER_LOCK_FREE == 2 )
+        #define configUSE_ATOMIC_BUILTINS    1
+    #else
+        #define configUSE_ATOMIC_BUILTINS    0
+    #endif
+#endif
+
+#if ( configUSE_ATOMIC_BUILTINS == 1 )
+    #define ATOMIC_MEMORY_ORDER    __ATOMIC_SEQ_CST
+#endif
+
 #define ATOMIC_COMPARE_AND_SWAP_SUCCESS    0x1U     /**< Compare and swap succeeded, swapped. */
 #define ATOMIC_COMPARE_AND_SWAP_FAILURE    0x0U     /**< Compare and swap failed, did not swap. */
 
@@ -111,6 +134,11 @@ static portFORCE_INLINE uint32_t Atomic_CompareAndSwap_u32( uint32_t volatile *
                                                             uint32_t ulExchange,
                                                             uint32_t ulComparand )
 {
+    #if ( configUSE_ATOMIC_BUILTINS == 1 )
+    return __atomic_compare_exchange_n( pulDestination, &ulComparand, ulExchange, 0,
+                                        ATOMIC_MEMORY_ORDER, ATOMIC_MEMORY_ORDER ) ?
+           ATOMIC_COMPARE_AND_SWAP_SUCCESS : ATOMIC_COMPARE_AND_SWAP_FAILURE;
+    #else
     uint32_t ulReturnValue;
 
     ATOMIC_ENTER_CRITICAL();
@@ -128,6 +156,7 @@ static portFORCE_INLINE uint32_t Atomic_CompareAndSwap_u32( uint32_t volatile *
     ATOMIC_EXIT_CRITICAL();
 
     return ulReturnValue;
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -146,6 +175,9 @@ static portFORCE_INLINE uint32_t Atomic_CompareAndSwap_u32( uint32_t volatile *
 static portFORCE_INLINE void * Atomic_SwapPointers_p32( void * volatile * ppvDestination,
                                                         void * pvExchange )
 {
+    #if ( configUSE_ATOMIC_BUILTINS == 1 )
+    return __atomic_exchange_n( ppvDestination, pvExchange, ATOMIC_MEMORY_ORDER );
+    #else
     void * pReturnValue;
 
     ATOMIC_ENTER_CRITICAL();
@@ -156,6 +188,7 @@ static portFORCE_INLINE void * Atomic_SwapPointers_p32( void * volatile * ppvDes
     ATOMIC_EXIT_CRITICAL();
 
     return pReturnValue;
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -179,6 +212,11 @@ static portFORCE_INLINE uint32_t Atomic_CompareAndSwapPointers_p32( void * volat
                                                                     void * pvExchange,
                                                                     void * pvComparand )
 {
+    #if ( configUSE_ATOMIC_BUILTINS == 1 )
+    return __atomic_compare_exchange_n( ppvDestination, &pvComparand, pvExchange, 0,
+                                        ATOMIC_MEMORY_ORDER, ATOMIC_MEMORY_ORDER ) ?
+           ATOMIC_COMPARE_AND_SWAP_SUCCESS : ATOMIC_COMPARE_AND_SWAP_FAILURE;
+    #else
     uint32_t ulReturnValue = ATOMIC_COMPARE_AND_SWAP_FAILURE;
 
     ATOMIC_ENTER_CRITICAL();
@@ -192,6 +230,7 @@ static portFORCE_INLINE uint32_t Atomic_CompareAndSwapPointers_p32( void * volat
     ATOMIC_EXIT_CRITICAL();
 
     return ulReturnValue;
+    #endif
 }
 
 
@@ -211,6 +250,9 @@ static portFORCE_INLINE uint32_t Atomic_CompareAndSwapPointers_p32( void * volat
 static portFORCE_INLINE uint32_t Atomic_Add_u32( uint32_t volatile * pulAddend,
                                                  uint32_t ulCount )
 {
+    #if ( configUSE_ATOMIC_BUILTINS == 1 )
+    return __atomic_fetch_add( pulAddend, ulCount, ATOMIC_MEMORY_ORDER );
+    #else
     uint32_t ulCurrent;
 
     ATOMIC_ENTER_CRITICAL();
@@ -221,6 +263,7 @@ static portFORCE_INLINE uint32_t Atomic_Add_u32( uint32_t volatile * pulAddend,
     ATOMIC_EXIT_CRITICAL();
 
     return ulCurrent;
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -239,6 +282,9 @@ static portFORCE_INLINE uint32_t Atomic_Add_u32( uint32_t volatile * pulAddend,
 static portFORCE_INLINE uint32_t Atomic_Subtract_u32( uint32_t volatile * pulAddend,
                                                       uint32_t ulCount )
 {
+    #if ( configUSE_ATOMIC_BUILTINS == 1 )
+    return __atomic_fetch_sub( pulAddend, ulCount, ATOMIC_MEMORY_ORDER );
+    #else
     uint32_t ulCurrent;
 
     ATOMIC_ENTER_CRITICAL();
@@ -249,6 +295,7 @@ static portFORCE_INLINE uint32_t Atomic_Subtract_u32( uint32_t volatile * pulAdd
     ATOMIC_EXIT_CRITICAL();
 
     return ulCurrent;
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -264,6 +311,9 @@ static portFORCE_INLINE uint32_t Atomic_Subtract_u32( uint32_t volatile * pulAdd
  */
 static portFORCE_INLINE uint32_t Atomic_Increment_u32( uint32_t volatile * pulAddend )
 {
+    #if ( configUSE_ATOMIC_BUILTINS == 1 )
+    return __atomic_fetch_add( pulAddend, 1U, ATOMIC_MEMORY_ORDER );
+    #else
     uint32_t ulCurrent;
 
     ATOMIC_ENTER_CRITICAL();
@@ -274,6 +324,7 @@ static portFORCE_INLINE uint32_t Atomic_Increment_u32( uint32_t volatile * pulAd
     ATOMIC_EXIT_CRITICAL();
 
     return ulCurrent;
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -289,6 +340,9 @@ static portFORCE_INLINE uint32_t Atomic_Increment_u32( uint32_t volatile * pulAd
  */
 static portFORCE_INLINE uint32_t Atomic_Decrement_u32( uint32_t volatile * pulAddend )
 {
+    #if ( configUSE_ATOMIC_BUILTINS == 1 )
+    return __atomic_fetch_sub( pulAddend, 1U, ATOMIC_MEMORY_ORDER );
+    #else
     uint32_t ulCurrent;
 
     ATOMIC_ENTER_CRITICAL();
@@ -299,6 +353,7 @@ static portFORCE_INLINE uint32_t Atomic_Decrement_u32( uint32_t volatile * pulAd
     ATOMIC_EXIT_CRITICAL();
 
     return ulCurrent;
+    #endif
 }
 
 /*----------------------------- Bitwise Logical ------------------------------*/
@@ -317,6 +372,9 @@ static portFORCE_INLINE uint32_t Atomic_Decrement_u32( uint32_t volatile * pulAd
 static portFORCE_INLINE uint32_t Atomic_OR_u32( uint32_t volatile * pulDestination,
                                                 uint32_t ulValue )
 {
+    #if ( configUSE_ATOMIC_BUILTINS == 1 )
+    return __atomic_fetch_or( pulDestination, ulValue, ATOMIC_MEMORY_ORDER );
+    #else
     uint32_t ulCurrent;
 
     ATOMIC_ENTER_CRITICAL();
@@ -327,6 +385,7 @@ static portFORCE_INLINE uint32_t Atomic_OR_u32( uint32_t volatile * pulDestinati
     ATOMIC_EXIT_CRITICAL();
 
     return ulCurrent;
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -344,6 +403,9 @@ static portFORCE_INLINE uint32_t Atomic_OR_u32( uint32_t volatile * pulDestinati
 static portFORCE_INLINE uint32_t Atomic_AND_u32( uint32_t volatile * pulDestination,
                                                  uint32_t ulValue )
 {
+    #if ( configUSE_ATOMIC_BUILTINS == 1 )
+    return __atomic_fetch_and( pulDestination, ulValue, ATOMIC_MEMORY_ORDER );
+    #else
     uint32_t ulCurrent;
 
     ATOMIC_ENTER_CRITICAL();
@@ -354,6 +416,7 @@ static portFORCE_INLINE uint32_t Atomic_AND_u32( uint32_t volatile * pulDestinat
     ATOMIC_EXIT_CRITICAL();
 
     return ulCurrent;
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -371,6 +434,9 @@ static portFORCE_INLINE uint32_t Atomic_AND_u32( uint32_t volatile * pulDestinat
 static portFORCE_INLINE uint32_t Atomic_NAND_u32( uint32_t volatile * pulDestination,
                                                   uint32_t ulValue )
 {
+    #if ( configUSE_ATOMIC_BUILTINS == 1 )
+    return __atomic_fetch_nand( pulDestination, ulValue, ATOMIC_MEMORY_ORDER );
+    #else
     uint32_t ulCurrent;
 
     ATOMIC_ENTER_CRITICAL();
@@ -381,6 +447,7 @@ static portFORCE_INLINE uint32_t Atomic_NAND_u32( uint32_t volatile * pulDestina
     ATOMIC_EXIT_CRITICAL();
 
     return ulCurrent;
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -398,6 +465,9 @@ static portFORCE_INLINE uint32_t Atomic_NAND_u32( uint32_t volatile * pulDestina
 static portFORCE_INLINE uint32_t Atomic_XOR_u32( uint32_t volatile * pulDestination,
                                                  uint32_t ulValue )
 {
+    #if ( configUSE_ATOMIC_BUILTINS == 1 )
+    return __atomic_fetch_xor( pulDestination, ulValue, ATOMIC_MEMORY_ORDER );
+    #else
     uint32_t ulCurrent;
 
     ATOMIC_ENTER_CRITICAL();
@@ -408,6 +478,7 @@ static portFORCE_INLINE uint32_t Atomic_XOR_u32( uint32_t volatile * pulDestinat
     ATOMIC_EXIT_CRITICAL();
 
     return ulCurrent;
+    #endif
 }
 
 /* *INDENT-OFF* */
@@ -164,6 +164,37 @@ typedef struct xTASK_STATUS
     configSTACK_DEPTH_TYPE usStackHighWaterMark;     /* The minimum amount of stack space that has remained for the task since the task was created.  The closer this value is to zero the closer the task has come to overflowing its stack. */
 } TaskStatus_t;
 
+/* The timing contract of a periodic task, used by the admission test of
+ * configUSE_ADMISSION_CONTROL. */
+typedef struct xTASK_TIMING_CONTRACT
+{
+    TickType_t xPeriod;   /* The time in ticks between the releases of two jobs. */
+    TickType_t xWCET;     /* The worst case execution time of a job in ticks.  Raised by a longer job measured, when the port defines portGET_TASK_CPU_TIME_NS(). */
+    TickType_t xDeadline; /* The time in ticks from the release of a job to its deadline, between 1 and xPeriod. */
+} TaskTimingContract_t;
+
+/* Actions on a task that ran past its budget, see vTaskSetBudget(). */
+typedef enum
+{
+    eBudgetDemote = 0, /* The task runs at configBUDGET_DEMOTED_PRIORITY until its budget is replenished. */
+    eBudgetSuspend     /* The task is suspended until its budget is replenished. */
+} eBudgetAction;
+
+/* The copy of a task made by uxTaskGetSnapshot(), see
+ * configUSE_TASK_SNAPSHOTS.  The fields are those of TaskStatus_t, but the
+ * name is copied, so it stays valid after the task is deleted. */
+typedef struct xTASK_SNAPSHOT
+{
+    TaskHandle_t xHandle;                                /* The handle of the task.  The task may have been deleted since the copy was made. */
+    char pcTaskName[ configMAX_TASK_NAME_LEN ];          /* The name of the task. */ /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+    UBaseType_t xTaskNumber;                             /* A number unique to the task. */
+    eTaskState eCurrentState;                            /* The state of the task when it was last published. */
+    UBaseType_t uxCurrentPriority;                       /* The priority of the task, which may be inherited. */
+    UBaseType_t uxBasePriority;                          /* The priority the task returns to after an inherited priority.  Only valid if configUSE_MUTEXES is 1. */
+    configRUN_TIME_COUNTER_TYPE ulRunTimeCounter;        /* The run time of the task up to when it was last switched out.  Only valid if configGENERATE_RUN_TIME_STATS is 1. */
+    configSTACK_DEPTH_TYPE usStackHighWaterMark;         /* The least stack space, in words, the task had left, as of the last scan of its stack by the idle task. */
+} TaskSnapshot_t;
+
 /* Possible return values for eTaskConfirmSleepModeStatus(). */
 typedef enum
 {
@@ -179,6 +210,14 @@ typedef enum
  */
 #define tskIDLE_PRIORITY    ( ( UBaseType_t ) 0U )
 
+/**
+ * Core affinity mask of a task allowed on every core
+ * (configUSE_CORE_AFFINITY).
+ *
+ * \ingroup TaskUtils
+ */
+#define tskNO_AFFINITY      ( ( UBaseType_t ) -1 )
+
 /**
  * task. h
  *
@@ -354,6 +393,137 @@ typedef enum
                             TaskHandle_t * const pxCreatedTask ) PRIVILEGED_FUNCTION;
 #endif
 
+/**
+ * task. h
+ * <pre>
+ * BaseType_t xTaskCreateEDF(
+ *                            TaskFunction_t pxTaskCode,
+ *                            const char *pcName,
+ *                            configSTACK_DEPTH_TYPE usStackDepth,
+ *                            void *pvParameters,
+ *                            TickType_t xPeriod,
+ *                            TickType_t xRelativeDeadline,
+ *                            TaskHandle_t *pxCreatedTask
+ *                        );
+ * </pre>
+ *
+ * Create a periodic task scheduled by earliest deadline first, and add it to
+ * the list of tasks that are ready to run.
+ *
+ * configSUPPORT_DYNAMIC_ALLOCATION and configUSE_EDF_SCHEDULING must both be
+ * defined as 1 for this function to be available.
+ *
+ * The task runs at the priority configEDF_PRIORITY, so it preempts the tasks
+ * of lower priority and is preempted by the tasks of higher priority as any
+ * other task.  Among the tasks of that priority the one whose current job
+ * has the earliest absolute deadline runs.  The first job is released when
+ * the task is created, or when the scheduler starts if it is created before.
+ * The task ends each job with xTaskWaitForNextPeriod().
+ *
+ * @param pxTaskCode, pcName, usStackDepth, pvParameters, pxCreatedTask As
+ * for xTaskCreate().
+ *
+ * @param xPeriod The time in ticks between the releases of two jobs.
+ *
+ * @param xRelativeDeadline The time in ticks from the release of a job to its
+ * deadline, between 1 and xPeriod.
+ *
+ * @return pdPASS if the task was successfully created and added to a ready
+ * list, otherwise an error code defined in the file projdefs.h
+ *
+ * Example usage:
+ * <pre>
+ * // A job of up to 2 ticks every 10 ticks, due 8 ticks after its release.
+ * void vTaskCode( void * pvParameters )
+ * {
+ *   for( ;; )
+ *   {
+ *       // Perform the job.
+ *       xTaskWaitForNextPeriod();
+ *   }
+ * }
+ *
+ * void vOtherFunction( void )
+ * {
+ *   xTaskCreateEDF( vTaskCode, "EDF", configMINIMAL_STACK_SIZE, NULL, 10, 8, NULL );
+ * }
+ * </pre>
+ * \defgroup xTaskCreateEDF xTaskCreateEDF
+ * \ingroup Tasks
+ */
+#if ( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configUSE_EDF_SCHEDULING == 1 ) )
+    BaseType_t xTaskCreateEDF( TaskFunction_t pxTaskCode,
+                               const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+                               const configSTACK_DEPTH_TYPE usStackDepth,
+                               void * const pvParameters,
+                               TickType_t xPeriod,
+                               TickType_t xRelativeDeadline,
+                               TaskHandle_t * const pxCreatedTask ) PRIVILEGED_FUNCTION;
+#endif
+
+/**
+ * task. h
+ * <pre>
+ * BaseType_t xTaskCreateWithContract(
+ *                            TaskFunction_t pxTaskCode,
+ *                            const char *pcName,
+ *                            configSTACK_DEPTH_TYPE usStackDepth,
+ *                            void *pvParameters,
+ *                            UBaseType_t uxPriority,
+ *                            const TaskTimingContract_t *pxContract,
+ *                            TaskHandle_t *pxCreatedTask
+ *                        );
+ * </pre>
+ *
+ * Create a periodic task with a timing contract, if the tasks with a
+ * contract stay schedulable with it, and add it to the list of tasks that
+ * are ready to run.
+ *
+ * configSUPPORT_DYNAMIC_ALLOCATION, configUSE_ADMISSION_CONTROL and
+ * INCLUDE_vTaskDelete must all be defined as 1 for this function to be
+ * available.
+ *
+ * The admission test is that of xTaskCheckSchedulability().  If it fails the
+ * task is freed without having run and errTASK_NOT_SCHEDULABLE is returned,
+ * or with configADMISSION_CONTROL_REJECTS set to 0 the task is created and
+ * vApplicationAdmissionWarningHook() is called.  With
+ * configUSE_EDF_SCHEDULING a task created at configEDF_PRIORITY is an EDF
+ * task of the period and deadline of its contract, as xTaskCreateEDF()
+ * creates.  The task ends each job with xTaskDelayUntil(), or
+ * xTaskWaitForNextPeriod() for an EDF task.
+ *
+ * @param pxTaskCode, pcName, usStackDepth, pvParameters, uxPriority,
+ * pxCreatedTask As for xTaskCreate().  *pxCreatedTask is set to NULL if the
+ * task is not admitted.
+ *
+ * @param pxContract The timing contract of the task, copied.
+ *
+ * @return pdPASS if the task was successfully created and added to a ready
+ * list, otherwise an error code defined in the file projdefs.h
+ *
+ * Example usage:
+ * <pre>
+ * // 1 ms of work every 10 ms, due within 5 ms.
+ * const TaskTimingContract_t xContract = { pdMS_TO_TICKS( 10 ), pdMS_TO_TICKS( 1 ), pdMS_TO_TICKS( 5 ) };
+ *
+ * if( xTaskCreateWithContract( vADCTask, "ADC", configMINIMAL_STACK_SIZE, NULL, 3, &xContract, NULL ) == errTASK_NOT_SCHEDULABLE )
+ * {
+ *   // The task would make a task with a contract miss a deadline.
+ * }
+ * </pre>
+ * \defgroup xTaskCreateWithContract xTaskCreateWithContract
+ * \ingroup Tasks
+ */
+#if ( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configUSE_ADMISSION_CONTROL == 1 ) && ( INCLUDE_vTaskDelete == 1 ) )
+    BaseType_t xTaskCreateWithContract( TaskFunction_t pxTaskCode,
+                                        const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+                                        const configSTACK_DEPTH_TYPE usStackDepth,
+                                        void * const pvParameters,
+                                        UBaseType_t uxPriority,
+                                        const TaskTimingContract_t * const pxContract,
+                                        TaskHandle_t * const pxCreatedTask ) PRIVILEGED_FUNCTION;
+#endif
+
 /**
  * task. h
  * <pre>
@@ -864,6 +1034,250 @@ BaseType_t xTaskDelayUntil( TickType_t * const pxPreviousWakeTime,
     ( void ) xTaskDelayUntil( pxPreviousWakeTime, xTimeIncrement ); \
 }
 
+/**
+ * task. h
+ * <pre>
+ * BaseType_t xTaskWaitForNextPeriod( void );
+ * </pre>
+ *
+ * configUSE_EDF_SCHEDULING must be defined as 1 for this function to be
+ * available.  Only a task created with xTaskCreateEDF() may call it.
+ *
+ * Ends the current job of the calling task, and blocks it until the release
+ * of the next one, one period after the release of the last.  The deadline
+ * of the next job is set from its release.  If the next release has already
+ * passed the task stays ready, placed by its new deadline.
+ *
+ * @return pdFALSE if the job ended after its deadline, which is also
+ * counted, see uxTaskGetDeadlineMisses(), otherwise pdTRUE.
+ *
+ * Example usage:
+ * <pre>
+ * void vTaskFunction( void * pvParameters )
+ * {
+ *   for( ;; )
+ *   {
+ *       // Perform the job of this period.
+ *       xTaskWaitForNextPeriod();
+ *   }
+ * }
+ * </pre>
+ * \defgroup xTaskWaitForNextPeriod xTaskWaitForNextPeriod
+ * \ingroup TaskCtrl
+ */
+BaseType_t xTaskWaitForNextPeriod( void ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <pre>
+ * UBaseType_t uxTaskGetDeadlineMisses( TaskHandle_t xTask );
+ * </pre>
+ *
+ * configUSE_EDF_SCHEDULING must be defined as 1 for this function to be
+ * available.
+ *
+ * @param xTask Handle to the task.  Passing a NULL handle returns the count
+ * of the calling task.
+ *
+ * @return The number of jobs of an EDF task that ended after their
+ * deadline.
+ *
+ * \defgroup uxTaskGetDeadlineMisses uxTaskGetDeadlineMisses
+ * \ingroup TaskCtrl
+ */
+UBaseType_t uxTaskGetDeadlineMisses( TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <pre>
+ * BaseType_t xTaskSetTimingContract( TaskHandle_t xTask, const TaskTimingContract_t *pxContract );
+ * </pre>
+ *
+ * configUSE_ADMISSION_CONTROL must be defined as 1 for this function to be
+ * available.
+ *
+ * Give an existing task a timing contract, or replace its contract, and run
+ * the admission test of xTaskCheckSchedulability().  If it fails the
+ * previous contract is kept and errTASK_NOT_SCHEDULABLE is returned, or with
+ * configADMISSION_CONTROL_REJECTS set to 0 the contract is kept and
+ * vApplicationAdmissionWarningHook() is called.  The contract of an EDF task
+ * has its period and relative deadline.
+ *
+ * @param xTask Handle to the task.  Passing a NULL handle sets the contract
+ * of the calling task.
+ *
+ * @param pxContract The timing contract, copied, or NULL to remove the
+ * contract of the task.
+ *
+ * @return pdPASS if the contract was set, otherwise errTASK_NOT_SCHEDULABLE.
+ *
+ * \defgroup xTaskSetTimingContract xTaskSetTimingContract
+ * \ingroup TaskCtrl
+ */
+BaseType_t xTaskSetTimingContract( TaskHandle_t xTask,
+                                   const TaskTimingContract_t * const pxContract ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <pre>
+ * BaseType_t xTaskGetTimingContract( TaskHandle_t xTask, TaskTimingContract_t *pxContract );
+ * </pre>
+ *
+ * configUSE_ADMISSION_CONTROL must be defined as 1 for this function to be
+ * available.
+ *
+ * Read the timing contract of a task, whose xWCET is raised by the jobs
+ * measured longer, see uxTaskGetContractOverruns().
+ *
+ * @param xTask Handle to the task.  Passing a NULL handle reads the contract
+ * of the calling task.
+ *
+ * @param pxContract The structure filled with the contract, all 0 if the
+ * task has none.
+ *
+ * @return pdTRUE if the task has a contract, otherwise pdFALSE.
+ *
+ * \defgroup xTaskGetTimingContract xTaskGetTimingContract
+ * \ingroup TaskCtrl
+ */
+BaseType_t xTaskGetTimingContract( TaskHandle_t xTask,
+                                   TaskTimingContract_t * const pxContract ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <pre>
+ * BaseType_t xTaskCheckSchedulability( void );
+ * </pre>
+ *
+ * configUSE_ADMISSION_CONTROL must be defined as 1 for this function to be
+ * available.
+ *
+ * Run the admission test on the tasks with a timing contract, with their
+ * current execution time estimates.  Each task of fixed priority passes if
+ * its worst case response time, found by response time analysis, is within
+ * its deadline; the tasks of the same priority are counted as preempting it.
+ * With configUSE_EDF_SCHEDULING the EDF tasks pass if the density of the
+ * EDF tasks and of the tasks of the same or higher priority, the sum of the
+ * execution times over the deadlines, is at most 1.  Blocking on resources
+ * and kernel overheads are not counted.
+ *
+ * @return pdTRUE if every task with a contract passes, otherwise pdFALSE.
+ *
+ * \defgroup xTaskCheckSchedulability xTaskCheckSchedulability
+ * \ingroup TaskCtrl
+ */
+BaseType_t xTaskCheckSchedulability( void ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <pre>
+ * uint64_t ullTaskGetLongestJobNs( TaskHandle_t xTask );
+ * </pre>
+ *
+ * configUSE_ADMISSION_CONTROL must be defined as 1, and the port must define
+ * portGET_TASK_CPU_TIME_NS(), for this function to be available.
+ *
+ * The jobs of a task with a timing contract, between two calls of
+ * xTaskDelayUntil() or xTaskWaitForNextPeriod(), are measured with the CPU
+ * time clock of the task.  The job running when the contract is given is
+ * not measured.
+ *
+ * @param xTask Handle to the task.  Passing a NULL handle reads the calling
+ * task.
+ *
+ * @return The CPU time of the longest job measured, in nanoseconds.
+ *
+ * \defgroup ullTaskGetLongestJobNs ullTaskGetLongestJobNs
+ * \ingroup TaskCtrl
+ */
+uint64_t ullTaskGetLongestJobNs( TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <pre>
+ * UBaseType_t uxTaskGetContractOverruns( TaskHandle_t xTask );
+ * </pre>
+ *
+ * configUSE_ADMISSION_CONTROL must be defined as 1, and the port must define
+ * portGET_TASK_CPU_TIME_NS(), for this function to be available.
+ *
+ * A job measured longer than the WCET of the contract of its task raises the
+ * WCET to the ticks the job ran into and runs the admission test again.  If
+ * the tasks with a contract fail it, vApplicationAdmissionWarningHook() is
+ * called with configADMISSION_CONTROL_REJECTS set to 0, and
+ * xTaskCheckSchedulability() returns pdFALSE until the contracts change.
+ *
+ * @param xTask Handle to the task.  Passing a NULL handle reads the calling
+ * task.
+ *
+ * @return The number of jobs measured longer than the WCET of the contract.
+ *
+ * \defgroup uxTaskGetContractOverruns uxTaskGetContractOverruns
+ * \ingroup TaskCtrl
+ */
+UBaseType_t uxTaskGetContractOverruns( TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <pre>
+ * void vTaskSetBudget( TaskHandle_t xTask, TickType_t xBudget, TickType_t xPeriod, eBudgetAction eAction );
+ * </pre>
+ *
+ * configUSE_TASK_BUDGETS must be defined as 1 for this function to be
+ * available.
+ *
+ * Limit the processor time of a task to xBudget ticks in every period of
+ * xPeriod ticks, starting now with the whole budget.  Each tick is charged to
+ * the task running when it comes.  A task still running after its budget is
+ * used is throttled until the next period starts: with eBudgetDemote it runs
+ * at configBUDGET_DEMOTED_PRIORITY, with eBudgetSuspend it is suspended (and
+ * INCLUDE_vTaskSuspend must be 1).  A task holding a mutex is throttled once
+ * it has released them.  Each period in which the task ran past its budget
+ * counts an overrun, see uxTaskGetBudgetOverruns().
+ *
+ * @param xTask Handle to the task.  Passing a NULL handle sets the budget of
+ * the calling task.
+ *
+ * @param xBudget The ticks per period, at most xPeriod, or 0 to remove the
+ * budget of the task.
+ *
+ * @param xPeriod The replenishment period in ticks.
+ *
+ * @param eAction The action taken when the task runs past its budget.
+ *
+ * Example usage:
+ * <pre>
+ * // Processing may take at most 20 ms in every 100 ms, beyond that it only
+ * // runs when no other task is ready.
+ * vTaskSetBudget( xProcessingTask, pdMS_TO_TICKS( 20 ), pdMS_TO_TICKS( 100 ), eBudgetDemote );
+ * </pre>
+ * \defgroup vTaskSetBudget vTaskSetBudget
+ * \ingroup TaskCtrl
+ */
+void vTaskSetBudget( TaskHandle_t xTask,
+                     TickType_t xBudget,
+                     TickType_t xPeriod,
+                     eBudgetAction eAction ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <pre>
+ * UBaseType_t uxTaskGetBudgetOverruns( TaskHandle_t xTask );
+ * </pre>
+ *
+ * configUSE_TASK_BUDGETS must be defined as 1 for this function to be
+ * available.
+ *
+ * @param xTask Handle to the task.  Passing a NULL handle returns the count
+ * of the calling task.
+ *
+ * @return The number of periods in which the task ran past its budget.
+ *
+ * \defgroup uxTaskGetBudgetOverruns uxTaskGetBudgetOverruns
+ * \ingroup TaskCtrl
+ */
+UBaseType_t uxTaskGetBudgetOverruns( TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
+
 
 /**
  * task. h
@@ -1082,6 +1496,58 @@ void vTaskGetInfo( TaskHandle_t xTask,
 void vTaskPrioritySet( TaskHandle_t xTask,
                        UBaseType_t uxNewPriority ) PRIVILEGED_FUNCTION;
 
+/**
+ * task. h
+ * <pre>
+ * void vTaskCoreAffinitySet( const TaskHandle_t xTask, UBaseType_t uxCoreAffinityMask );
+ * </pre>
+ *
+ * configNUMBER_OF_CORES must be greater than 1 and configUSE_CORE_AFFINITY
+ * must be defined as 1 for this function to be available.
+ *
+ * Sets the cores a task may run on.  Bit n of the mask allows core n, a task
+ * is created with tskNO_AFFINITY.  A task running on a core it is no longer
+ * allowed on is switched out of it.
+ *
+ * @param xTask Handle to the task.  Passing a NULL handle sets the affinity
+ * of the calling task.
+ *
+ * @param uxCoreAffinityMask The cores the task may run on.
+ *
+ * Example usage:
+ * <pre>
+ * void vAFunction( void )
+ * {
+ * TaskHandle_t xHandle;
+ *
+ *   xTaskCreate( vTaskCode, "NAME", STACK_SIZE, NULL, tskIDLE_PRIORITY, &xHandle );
+ *
+ *   // Run the task on core 1 only.
+ *   vTaskCoreAffinitySet( xHandle, ( 1 << 1 ) );
+ * }
+ * </pre>
+ * \defgroup vTaskCoreAffinitySet vTaskCoreAffinitySet
+ * \ingroup TaskCtrl
+ */
+void vTaskCoreAffinitySet( const TaskHandle_t xTask,
+                           UBaseType_t uxCoreAffinityMask ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <pre>
+ * UBaseType_t vTaskCoreAffinityGet( const TaskHandle_t xTask );
+ * </pre>
+ *
+ * Returns the core affinity mask of a task, see vTaskCoreAffinitySet().
+ *
+ * @param xTask Handle to the task.  Passing a NULL handle returns the
+ * affinity of the calling task.
+ *
+ * \defgroup vTaskCoreAffinityGet vTaskCoreAffinityGet
+ * \ingroup TaskCtrl
+ */
+UBaseType_t vTaskCoreAffinityGet( const TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
+
 /**
  * task. h
  * <pre>
@@ -1627,6 +2093,25 @@ configSTACK_DEPTH_TYPE uxTaskGetStackHighWaterMark2( TaskHandle_t xTask ) PRIVIL
 
 #endif
 
+#if ( ( configUSE_ADMISSION_CONTROL == 1 ) && ( configADMISSION_CONTROL_REJECTS == 0 ) )
+
+/**
+ * task.h
+ * <pre>void vApplicationAdmissionWarningHook( TaskHandle_t xTask, char *pcTaskName ); </pre>
+ *
+ * Called when a timing contract, or a job measured longer than its WCET,
+ * makes the tasks with a contract fail the admission test, see
+ * xTaskCheckSchedulability() and uxTaskGetContractOverruns().  The contract
+ * is kept.  Called with the scheduler suspended, so it must not block.
+ *
+ * @param xTask The task given the contract, or whose job overran.
+ * @param pcTaskName The name of the task.
+ */
+    void vApplicationAdmissionWarningHook( TaskHandle_t xTask,
+                                           char * pcTaskName );
+
+#endif
+
 #if  (  configUSE_TICK_HOOK > 0 )
     /**
      *  task.h
@@ -1781,6 +2266,64 @@ UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray,
                                   const UBaseType_t uxArraySize,
                                   configRUN_TIME_COUNTER_TYPE * const pulTotalRunTime ) PRIVILEGED_FUNCTION;
 
+/**
+ * task. h
+ * <pre>
+ * UBaseType_t uxTaskGetSnapshot( TaskSnapshot_t * const pxSnapshotArray, const UBaseType_t uxArraySize, configRUN_TIME_COUNTER_TYPE * const pulTotalRunTime, BaseType_t * const pxTruncated );
+ * </pre>
+ *
+ * configUSE_TASK_SNAPSHOTS must be defined as 1 in FreeRTOSConfig.h for
+ * uxTaskGetSnapshot() to be available.
+ *
+ * The kernel keeps a copy of each task (TaskSnapshot_t) in one of
+ * configTASK_SNAPSHOT_SLOTS slots, guarded by a sequence counter.  A task is
+ * published when it is created, when it is switched in or out, when it is
+ * made ready, suspended or blocked, when its priority changes, including by
+ * priority inheritance, and by the idle task, which scans
+ * configTASK_SNAPSHOT_SCAN_BYTES of one stack per iteration for the high water
+ * mark and republishes the task when its scan is complete.  The run time and
+ * the high water mark are those of the last publication.
+ * uxTaskGetSnapshot() copies the slots and copies a slot again if the kernel
+ * wrote it meanwhile, so each entry is consistent, and neither the scheduler
+ * nor the interrupts are ever held while the tasks are walked.  A task
+ * created while every slot is taken has no snapshot.
+ *
+ * @param pxSnapshotArray An array of TaskSnapshot_t structures.
+ *
+ * @param uxArraySize The size of the array.  Only the first uxArraySize tasks
+ * found are copied.
+ *
+ * @param pulTotalRunTime Set to the total run time as with
+ * uxTaskGetSystemState(), if not NULL.
+ *
+ * @param pxTruncated Set to pdTRUE if tasks were left out, because the array
+ * was too small or because they have no slot, and to pdFALSE otherwise, if
+ * not NULL.
+ *
+ * @return The number of TaskSnapshot_t structures written.
+ *
+ * Example usage:
+ * <pre>
+ *  TaskSnapshot_t xTasks[ configTASK_SNAPSHOT_SLOTS ];
+ *  UBaseType_t x, uxTasks;
+ *  BaseType_t xTruncated;
+ *
+ *  uxTasks = uxTaskGetSnapshot( xTasks, configTASK_SNAPSHOT_SLOTS, NULL, &xTruncated );
+ *  configASSERT( xTruncated == pdFALSE );
+ *
+ *  for( x = 0; x < uxTasks; x++ )
+ *  {
+ *      printf( "%s %u words left\n", xTasks[ x ].pcTaskName, ( unsigned ) xTasks[ x ].usStackHighWaterMark );
+ *  }
+ * </pre>
+ * \defgroup uxTaskGetSnapshot uxTaskGetSnapshot
+ * \ingroup TaskUtils
+ */
+UBaseType_t uxTaskGetSnapshot( TaskSnapshot_t * const pxSnapshotArray,
+                               const UBaseType_t uxArraySize,
+                               configRUN_TIME_COUNTER_TYPE * const pulTotalRunTime,
+                               BaseType_t * const pxTruncated ) PRIVILEGED_FUNCTION;
+
 /**
  * task. h
  * <PRE>void vTaskList( char *pcWriteBuffer );</PRE>
@@ -2978,6 +3521,12 @@ TickType_t uxTaskResetEventItemValue( void ) PRIVILEGED_FUNCTION;
  */
 TaskHandle_t xTaskGetCurrentTaskHandle( void ) PRIVILEGED_FUNCTION;
 
+/*
+ * Return the handle of the task running on a core (configNUMBER_OF_CORES
+ * greater than 1).
+ */
+TaskHandle_t xTaskGetCurrentTaskHandleForCore( BaseType_t xCoreID ) PRIVILEGED_FUNCTION;
+
 /*
  * Shortcut used by the queue implementation to prevent unnecessary call to
  * taskYIELD();
@@ -87,8 +87,8 @@ void vPortFree( void * pv )
     {
         vTaskSuspendAll();
         {
-            free( pv );
             traceFREE( pv, 0 );
+            free( pv );
         }
         ( void ) xTaskResumeAll();
     }
@@ -34,11 +34,50 @@
  * running are blocked in sigwait().
  *
  * Task switch is done by resuming the thread for the next task by
- * signaling the condition variable and then waiting on a condition variable
- * with the current thread.
+ * signaling its event and then waiting on the event of the current
+ * thread (utils/wait_for_event.c, a futex word on Linux).  With
+ * configPOSIX_THREAD_POOL_SIZE the thread of a deleted task is parked,
+ * with its event, and given to a task created later.  With
+ * configPOSIX_GUARDED_STACKS a task thread runs on a host stack above a
+ * guard page, and the SIGSEGV of an overflow reports the task.
  *
  * The timer interrupt uses SIGALRM and care is taken to ensure that
  * the signal handler runs only on the thread for the current task.
+ * With configPOSIX_TICK_THREAD the SIGALRM is sent by a host thread
+ * blocked on a timerfd, directly to the thread of the running task,
+ * instead of coming from the process wide setitimer().
+ *
+ * With configPOSIX_GREEN_THREADS all the tasks run on the thread that
+ * started the scheduler instead.  A task switch only swaps the stack and
+ * the callee-saved registers (ucontext on architectures without a switch
+ * routine).  Switches always happen with interrupts disabled, inside a
+ * critical section or the tick handler, so the signal mask is the same on
+ * both sides and is not part of the context: a task preempted by the tick
+ * re-enables its signals when its handler returns.  Tasks share the
+ * thread-local state of the host thread (errno, stdio lock ownership).
+ *
+ * With configPOSIX_SOFT_INTERRUPT_MASK, disabling interrupts only raises
+ * a mask level instead of blocking the signals with a system call.
+ * Interrupts are numbered lines with a priority, the tick being line 0.
+ * A signal marks its line pending and runs the pending lines above the
+ * mask level, most urgent first; the others run when the level drops.
+ * Critical sections mask the lines up to
+ * configMAX_SYSCALL_INTERRUPT_PRIORITY.  A switch requested by an
+ * interrupt (portYIELD_FROM_ISR()) is deferred until no interrupt or
+ * critical section is active.  The signal mask is only changed around
+ * task switches, so suspended threads still cannot take a signal.
+ *
+ * configPOSIX_INTERRUPT_CONTROLLER adds lines raised by host sources
+ * (timerfd, eventfd, any readable file descriptor) watched with epoll by
+ * the tick thread, which sends SIG_INTERRUPT to the running task, and by
+ * vPortRaiseInterrupt().
+ *
+ * With configNUMBER_OF_CORES above 1 every core runs its selected task on
+ * the task thread, all at once.  One recursive kernel lock serialises the
+ * kernel: critical sections and the FromISR mask take it, a task switch
+ * hands it to the resumed thread.  The interrupt lines, the tick included,
+ * are handled on core 0; another core is only sent SIG_INTERRUPT to take
+ * a switch requested by portYIELD_CORE().
  *
  * Use of part of the standard C library requires care as some
  * functions can take pthread mutexes internally which can result in
@@ -50,15 +89,32 @@
  * semaphore or mutex.
  *----------------------------------------------------------*/
 
+/* ppoll() is a GNU extension. */
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
 #include <errno.h>
+#include <poll.h>
 #include <pthread.h>
+#include <sched.h>
+#include <setjmp.h>
 #include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include <sys/time.h>
+#include <sys/timerfd.h>
 #include <sys/times.h>
 #include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
 
 /* Scheduler includes. */
 #include "FreeRTOS.h"
@@ -68,6 +124,216 @@
 /*-----------------------------------------------------------*/
 
 #define SIG_RESUME SIGUSR1
+#define SIG_INTERRUPT SIGUSR2
+
+/* Drive the tick from a host thread blocked on a timerfd rather than from
+ * setitimer(ITIMER_REAL). */
+#ifndef configPOSIX_TICK_THREAD
+    #define configPOSIX_TICK_THREAD 0
+#endif
+
+/* Compare the monotonic time with the ticks handled on every tick
+ * interrupt and handle the missing ones, so the kernel time follows the
+ * wall time when signals are coalesced or delayed under host load. */
+#ifndef configPOSIX_TICK_CATCH_UP
+    #define configPOSIX_TICK_CATCH_UP 0
+#endif
+
+/* Most ticks handled by one interrupt in catch-up mode, one second of
+ * ticks by default.  A larger lag (the process was stopped, e.g. in a
+ * debugger) is dropped instead of replayed. */
+#ifndef configPOSIX_TICK_CATCH_UP_LIMIT
+    #define configPOSIX_TICK_CATCH_UP_LIMIT configTICK_RATE_HZ
+#endif
+
+/* The tick period is kept in nanoseconds, setitimer() has microseconds. */
+#if ( configTICK_RATE_HZ > 1000000 )
+    #error configTICK_RATE_HZ above 1 MHz is not supported by the Posix port
+#endif
+
+/* Highest expiration rate of the host timer.  A wake-up of the host costs
+ * more than the tick itself at 100 kHz, so above this rate the timer
+ * expires every portTICK_BATCH ticks and each expiration accounts for as
+ * many ticks.  The kernel time keeps the resolution of configTICK_RATE_HZ,
+ * the delays the granularity of the batch. */
+#ifndef configPOSIX_TICK_INTERRUPT_MAX_HZ
+    #define configPOSIX_TICK_INTERRUPT_MAX_HZ 20000
+#endif
+
+#define portTICK_BATCH \
+    ( ( configTICK_RATE_HZ + configPOSIX_TICK_INTERRUPT_MAX_HZ - 1 ) / configPOSIX_TICK_INTERRUPT_MAX_HZ )
+#define portTICK_BATCH_PERIOD_NS ( portTICK_BATCH * 1000000000ULL / configTICK_RATE_HZ )
+
+/* Longest tickless sleep, in ticks. */
+#ifndef configPOSIX_TICKLESS_MAX_SLEEP_TICKS
+    #define configPOSIX_TICKLESS_MAX_SLEEP_TICKS ( 3600 * configTICK_RATE_HZ )
+#endif
+
+/* Disable interrupts with a mask level instead of the signal mask. */
+#ifndef configPOSIX_SOFT_INTERRUPT_MASK
+    #define configPOSIX_SOFT_INTERRUPT_MASK 0
+#endif
+
+/* Interrupt lines raised by host file descriptors. */
+#ifndef configPOSIX_INTERRUPT_CONTROLLER
+    #define configPOSIX_INTERRUPT_CONTROLLER 0
+#endif
+
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 1 ) && \
+    ( ( configPOSIX_SOFT_INTERRUPT_MASK == 0 ) || ( configPOSIX_TICK_THREAD == 0 ) )
+    #error configPOSIX_INTERRUPT_CONTROLLER requires configPOSIX_SOFT_INTERRUPT_MASK and configPOSIX_TICK_THREAD
+#endif
+
+/* Discrete event simulation: the time is virtual and only advances while
+ * the idle task runs, straight to the next tick or timer line expiry.  The
+ * tick thread no longer waits on a timer, it is kicked by the idle task. */
+#ifndef configPOSIX_VIRTUAL_TIME
+    #define configPOSIX_VIRTUAL_TIME 0
+#endif
+
+#if ( configPOSIX_VIRTUAL_TIME == 1 )
+    #if ( configPOSIX_SOFT_INTERRUPT_MASK == 0 ) || ( configPOSIX_TICK_THREAD == 0 ) || \
+        ( INCLUDE_xTaskGetIdleTaskHandle == 0 ) || ( INCLUDE_xTaskGetSchedulerState == 0 )
+        #error configPOSIX_VIRTUAL_TIME requires configPOSIX_SOFT_INTERRUPT_MASK, configPOSIX_TICK_THREAD, INCLUDE_xTaskGetIdleTaskHandle and INCLUDE_xTaskGetSchedulerState
+    #endif
+
+    /* No tick is ever late in virtual time. */
+    #undef configPOSIX_TICK_CATCH_UP
+    #define configPOSIX_TICK_CATCH_UP 0
+#endif
+
+/* Run all the tasks on a single host thread. */
+#ifndef configPOSIX_GREEN_THREADS
+    #define configPOSIX_GREEN_THREADS 0
+#endif
+
+/* Switch the green threads with swapcontext(), the only choice on
+ * architectures without a switch routine below. */
+#ifndef configPOSIX_GREEN_THREADS_UCONTEXT
+    #if defined( __x86_64__ )
+        #define configPOSIX_GREEN_THREADS_UCONTEXT 0
+    #else
+        #define configPOSIX_GREEN_THREADS_UCONTEXT 1
+    #endif
+#endif
+
+/* Host stack mapped for a green thread whose task stack is smaller than
+ * PTHREAD_STACK_MIN, as pthread_create() falls back to a default stack. */
+#ifndef configPOSIX_GREEN_THREADS_STACK_SIZE
+    #define configPOSIX_GREEN_THREADS_STACK_SIZE ( 256 * 1024 )
+#endif
+
+/* Run every task thread on a host stack mapped by the port above a
+ * PROT_NONE guard page.  An overflow faults on the guard page and is
+ * reported to vApplicationStackOverflowHook() by a SIGSEGV handler on an
+ * alternate signal stack, with no check on the task switches. */
+#ifndef configPOSIX_GUARDED_STACKS
+    #define configPOSIX_GUARDED_STACKS 0
+#endif
+
+/* Smallest guarded host stack: the task stacks of the simulator are only
+ * sized for the thread record, not for the host library. */
+#ifndef configPOSIX_GUARDED_STACK_SIZE
+    #define configPOSIX_GUARDED_STACK_SIZE ( 256 * 1024 )
+#endif
+
+#if ( configPOSIX_GUARDED_STACKS == 1 ) && ( configPOSIX_GREEN_THREADS == 1 )
+    #error configPOSIX_GUARDED_STACKS requires a host thread per task, without configPOSIX_GREEN_THREADS
+#endif
+
+/* Host threads of deleted tasks kept parked for the next tasks created,
+ * with their wait event, instead of ending them (0 ends them).  A pooled
+ * thread runs on a stack of the host, not on the task stack. */
+#ifndef configPOSIX_THREAD_POOL_SIZE
+    #define configPOSIX_THREAD_POOL_SIZE 0
+#endif
+
+#if ( configPOSIX_GREEN_THREADS == 1 )
+    /* There is no host thread per task to reuse. */
+    #undef configPOSIX_THREAD_POOL_SIZE
+    #define configPOSIX_THREAD_POOL_SIZE 0
+#endif
+
+#define portTHREAD_POOL ( configPOSIX_THREAD_POOL_SIZE > 0 )
+
+#if ( configNUMBER_OF_CORES > 1 )
+    #if ( configPOSIX_SOFT_INTERRUPT_MASK == 0 ) || ( configPOSIX_TICK_THREAD == 0 ) || \
+        ( configPOSIX_GREEN_THREADS == 1 ) || ( configPOSIX_VIRTUAL_TIME == 1 )
+        #error configNUMBER_OF_CORES above 1 requires configPOSIX_SOFT_INTERRUPT_MASK and configPOSIX_TICK_THREAD, without configPOSIX_GREEN_THREADS and configPOSIX_VIRTUAL_TIME
+    #endif
+
+    /* The mask level and the critical section nesting belong to a core:
+     * each one is kept by the thread running on it. */
+    #define portTHREAD_LOCAL __thread
+#else
+    #define portTHREAD_LOCAL
+    #define portGET_CORE_ID() ( ( BaseType_t ) 0 )
+#endif
+
+/* Host scheduling of the simulator threads, so that the load of the host
+ * does not perturb the timing.  The task threads run SCHED_FIFO at this
+ * priority (1 to 99, 0 leaves them SCHED_OTHER), the tick thread above
+ * them.  A busy task then holds its CPU against every SCHED_OTHER thread
+ * of the host, up to the real-time throttling of the kernel. */
+#ifndef configPOSIX_HOST_PRIORITY
+    #define configPOSIX_HOST_PRIORITY 0
+#endif
+
+#if ( configPOSIX_HOST_PRIORITY < 0 ) || ( configPOSIX_HOST_PRIORITY > 98 )
+    #error configPOSIX_HOST_PRIORITY must be 0 to 98, the tick thread runs at 99
+#endif
+
+/* Host CPUs of the task threads and of the tick thread, one bit per CPU,
+ * e.g. an isolated CPU (isolcpus=).  0 leaves them on every CPU. */
+#ifndef configPOSIX_HOST_CPU_MASK
+    #define configPOSIX_HOST_CPU_MASK 0
+#endif
+
+/* Lock the memory of the process (mlockall()), present and future, so
+ * that a page fault never delays a task. */
+#ifndef configPOSIX_HOST_MLOCK
+    #define configPOSIX_HOST_MLOCK 0
+#endif
+
+#define portHOST_SCHEDULING \
+    ( ( configPOSIX_HOST_PRIORITY != 0 ) || ( configPOSIX_HOST_CPU_MASK != 0 ) || ( configPOSIX_HOST_MLOCK != 0 ) )
+
+#if ( configPOSIX_GREEN_THREADS == 1 )
+
+#if ( configPOSIX_GREEN_THREADS_UCONTEXT == 1 )
+#include <ucontext.h>
+
+/* The ucontext is kept at the top of the host stack, it does not fit in
+ * the small task stacks. */
+typedef struct CONTEXT
+{
+    ucontext_t *pxUContext;
+} Context_t;
+#else
+typedef struct CONTEXT
+{
+    void *pvStackPointer;
+} Context_t;
+#endif
+
+#endif /* configPOSIX_GREEN_THREADS */
+
+#if portTHREAD_POOL
+struct THREAD;
+
+/* Host thread of the pool, running a task or parked. */
+typedef struct POOL_THREAD
+{
+    pthread_t pthread;
+    struct event *ev;
+    struct THREAD * volatile pxThread; /* Task run, NULL while parked. */
+    sigjmp_buf xParkContext;            /* Start of the thread, back to park. */
+#if ( configPOSIX_GUARDED_STACKS == 1 )
+    void *pvAltStack;                   /* Alternate signal stack of the thread. */
+#endif
+    struct POOL_THREAD *pxNext;
+} PoolThread_t;
+#endif
 
 typedef struct THREAD
 {
@@ -75,7 +341,24 @@ typedef struct THREAD
     pdTASK_CODE pxCode;
     void *pvParams;
     BaseType_t xDying;
+#if ( configNUMBER_OF_CORES > 1 )
+    UBaseType_t uxCore;     /* Core the task was last resumed on. */
+    UBaseType_t uxLockDepth; /* Kernel lock depth while switched out. */
+#endif
+#if ( configPOSIX_GREEN_THREADS == 1 )
+    Context_t xContext;
+#else
     struct event *ev;
+#endif
+#if ( configPOSIX_GREEN_THREADS == 1 ) || ( configPOSIX_GUARDED_STACKS == 1 )
+    void *pvHostStack;      /* Mapped by the port, NULL when the task stack is used. */
+    size_t xHostStackSize;
+#endif
+#if portTHREAD_POOL
+    PoolThread_t *pxPoolThread;
+    volatile BaseType_t xCancelled; /* Deleted by another task while suspended. */
+    volatile BaseType_t xReleased;  /* The host thread no longer uses the task stack. */
+#endif
 } Thread_t;
 
 /*
@@ -96,21 +379,170 @@ static sigset_t xResumeSignals;
 static sigset_t xAllSignals;
 static sigset_t xSchedulerOriginalSignalMask;
 static pthread_t hMainThread = ( pthread_t )NULL;
-static volatile portBASE_TYPE uxCriticalNesting;
+static portTHREAD_LOCAL volatile portBASE_TYPE uxCriticalNesting;
+
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+typedef struct INTERRUPT_LINE
+{
+    PortInterruptHandler_t pxHandler;
+    void *pvParameter;
+    UBaseType_t uxPriority;
+    int iFd;                /* Host source, -1 if none. */
+    BaseType_t xRearm;      /* Source watched once per interrupt. */
+    volatile uint32_t ulCount;
+#if ( configPOSIX_VIRTUAL_TIME == 1 )
+    uint64_t ullPeriodNs;   /* Timer line in virtual time, 0 if none. */
+    uint64_t ullExpiryNs;
+#endif
+} InterruptLine_t;
+
+static InterruptLine_t xInterruptLines[ portINTERRUPT_LINES ];
+
+/* Lines with a priority up to the mask level do not run.  0 in a task,
+ * configMAX_SYSCALL_INTERRUPT_PRIORITY in a critical section and the
+ * priority of the line in an interrupt handler.  Every task switch
+ * happens at configMAX_SYSCALL_INTERRUPT_PRIORITY, so the level does not
+ * need to be saved per task. */
+static portTHREAD_LOCAL volatile UBaseType_t uxInterruptMask = portMAX_INTERRUPT_PRIORITY;
+
+/* One bit per line raised and not handled yet. */
+static volatile uint32_t ulPendingInterrupts = 0;
+
+/* Handlers running, and task switch requested by one of them. */
+static portTHREAD_LOCAL volatile UBaseType_t uxInterruptNesting = 0;
+static portTHREAD_LOCAL volatile BaseType_t xSwitchPending = pdFALSE;
+#endif
+
+#if ( configNUMBER_OF_CORES > 1 )
+__thread volatile UBaseType_t uxPortCoreID = 0;
+
+/* Switch requested on each core by portYIELD_CORE(). */
+static volatile BaseType_t xCoreYieldRequests[ configNUMBER_OF_CORES ];
+
+/* Kernel lock: the core holding it, its recursion depth, and a futex word
+ * (0 free, 1 taken, 2 taken with waiters). */
+static volatile BaseType_t xKernelLockOwner = -1;
+static UBaseType_t uxKernelLockDepth = 0;
+static uint32_t ulKernelLockWord = 0;
+
+/* A signal handler found the kernel lock taken by another core, the core
+ * is signalled again when it is released. */
+static BaseType_t xCoreDispatchDeferred[ configNUMBER_OF_CORES ];
+#endif
+
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 1 )
+/* Host sources of the interrupt lines, watched by the tick thread. */
+static int iInterruptEpollFd = -1;
+#endif
+
+#if ( configPOSIX_GUARDED_STACKS == 1 )
+#define portPAGE_SIZE() ( ( size_t ) sysconf( _SC_PAGESIZE ) )
+
+/* Size of the alternate signal stack of a task thread. */
+#define portALT_STACK_SIZE ( 64 * 1024 )
+
+/* Declared by task.h only with configCHECK_FOR_STACK_OVERFLOW. */
+extern void vApplicationStackOverflowHook( TaskHandle_t xTask, char *pcTaskName );
+
+/* Guard page below the host stack of the calling task thread. */
+static __thread uint8_t *pucGuardPage = NULL;
+static __thread size_t xGuardPageSize = 0;
+#endif
+
+#if portTHREAD_POOL
+/* Parked host threads, the last parked first. */
+static pthread_mutex_t xThreadPoolMutex = PTHREAD_MUTEX_INITIALIZER;
+static PoolThread_t *pxParkedThreads = NULL;
+static UBaseType_t uxParkedThreads = 0;
+#endif
+
+#ifdef portREADY_BITMAP_WORDS
+/* Second level of the ready priority bitmap, see portmacro.h. */
+UBaseType_t uxPortReadyPriorities[ portREADY_BITMAP_WORDS ];
+#endif
 /*-----------------------------------------------------------*/
 
 static portBASE_TYPE xSchedulerEnd = pdFALSE;
+
+#if portHOST_SCHEDULING
+/* Errors of the host scheduling settings, 0 if applied. */
+static int iHostPriorityError = 0;
+static int iHostAffinityError = 0;
+static int iHostMlockError = 0;
+#endif
+
+/* Thread of the task selected to run on each core, the target of the
+ * tick signal on core 0. */
+static Thread_t * volatile pxRunningThreads[ configNUMBER_OF_CORES ];
+/*-----------------------------------------------------------*/
+
+#if ( configPOSIX_TICK_THREAD == 1 )
+static pthread_t hTickThread;
+static int iTickTimerFd = -1;
+
+/* Ticks counted by the tick thread and not yet handled by
+ * vPortSystemTickHandler(). */
+static uint32_t ulPendingTicks = 0;
+
+/* A SIGALRM was sent for ulPendingTicks and not handled yet. */
+static BaseType_t xTickSignalled = pdFALSE;
+#endif
+
+#if ( configPOSIX_VIRTUAL_TIME == 1 )
+/* Virtual clock, and the ticks elapsed on it (handled or stepped). */
+static uint64_t ullVirtualTimeNs = 0;
+static uint64_t ullVirtualTicks = 0;
+static Thread_t *pxIdleThread = NULL;
+#endif
 /*-----------------------------------------------------------*/
 
 static void prvSetupSignalsAndSchedulerPolicy( void );
+static void prvSetupHostScheduling( void );
+static void prvReportHostScheduling( void );
 static void prvSetupTimerInterrupt( void );
-static void *prvWaitForStart( void * pvParams );
+static void prvStopTimerInterrupt( void );
 static void prvSwitchThread( Thread_t * xThreadToResume,
                              Thread_t *xThreadToSuspend );
+#if ( configPOSIX_GREEN_THREADS == 1 )
+static void prvGreenThreadStart( void );
+static void prvInitialiseContext( Thread_t *pxThread, void *pvStack, size_t xStackSize );
+static void prvSwapContext( Context_t *pxSave, Context_t *pxRestore );
+#else
+#if portTHREAD_POOL
+static void *prvPoolThreadStart( void * pvParams );
+static void prvTakePoolThread( Thread_t *pxThread );
+static void prvParkThread( Thread_t *pxThread ) __attribute__( ( noreturn ) );
+static void prvEndPoolThread( PoolThread_t *pxPoolThread ) __attribute__( ( noreturn ) );
+static void prvDrainThreadPool( void );
+#else
+static void *prvWaitForStart( void * pvParams );
+#endif
+static void prvRunTask( Thread_t *pxThread );
 static void prvSuspendSelf( Thread_t * thread);
+#if ( configPOSIX_GUARDED_STACKS == 1 )
+static void prvSetupStackGuard( uint8_t *pucGuard, size_t xGuardSize, void *pvAltStack );
+static void prvStackFaultHandler( int iSignal, siginfo_t *pxInfo, void *pvContext );
+#endif
 static void prvResumeThread( Thread_t * xThreadId );
+#endif
 static void vPortSystemTickHandler( int sig );
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+static void prvTickInterrupt( void *pvParameter );
+static void prvDispatchInterrupts( void );
+static inline BaseType_t prvDispatchPending( void );
+#else
+static void prvTickInterrupt( void );
+#endif
+#if ( configPOSIX_VIRTUAL_TIME == 1 )
+static void prvKickVirtualTime( void );
+#endif
 static void vPortStartFirstTask( void );
+#if ( configNUMBER_OF_CORES > 1 )
+static void prvKernelLockAcquire( void );
+static BaseType_t prvKernelLockTry( void );
+static void prvKernelLockRelease( void );
+static BaseType_t prvSignalRunningThread( UBaseType_t uxCore, int iSignal );
+#endif
 /*-----------------------------------------------------------*/
 
 static void prvFatalError( const char *pcCall, int iErrno )
@@ -130,6 +562,9 @@ Thread_t *thread;
 pthread_attr_t xThreadAttributes;
 size_t ulStackSize;
 int iRet;
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 ) && ( configPOSIX_GREEN_THREADS == 0 ) && !portTHREAD_POOL
+sigset_t xSavedSignalMask;
+#endif
 
     (void)pthread_once( &hSigSetupThread, prvSetupSignalsAndSchedulerPolicy );
 
@@ -143,13 +578,78 @@ int iRet;
     thread->pxCode = pxCode;
     thread->pvParams = pvParameters;
     thread->xDying = pdFALSE;
+#if ( configNUMBER_OF_CORES > 1 )
+    thread->uxCore = 0;
+    thread->uxLockDepth = 1;
+#endif
+
+#if ( configPOSIX_GREEN_THREADS == 1 )
+    ( void ) xThreadAttributes;
+    ( void ) iRet;
+
+    /* Every task runs on the thread that starts the scheduler, the target
+     * of the tick thread. */
+    thread->pthread = pthread_self();
+    thread->pvHostStack = NULL;
+    thread->xHostStackSize = 0;
+
+    if ( ulStackSize < PTHREAD_STACK_MIN )
+    {
+        thread->xHostStackSize = configPOSIX_GREEN_THREADS_STACK_SIZE;
+        thread->pvHostStack = mmap( NULL, thread->xHostStackSize,
+                                    PROT_READ | PROT_WRITE,
+                                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK | MAP_NORESERVE,
+                                    -1, 0 );
+        if ( thread->pvHostStack == MAP_FAILED )
+        {
+            prvFatalError( "mmap", errno );
+        }
+
+        prvInitialiseContext( thread, thread->pvHostStack, thread->xHostStackSize );
+    }
+    else
+    {
+        prvInitialiseContext( thread, pxEndOfStack, ulStackSize );
+    }
+#elif portTHREAD_POOL
+    ( void ) xThreadAttributes;
+    ( void ) ulStackSize;
+    ( void ) iRet;
 
+    /* As below, the host library may take its locks. */
+    vPortEnterCritical();
+    prvTakePoolThread( thread );
+    vPortExitCritical();
+#else
     pthread_attr_init( &xThreadAttributes );
+#if ( configPOSIX_GUARDED_STACKS == 1 )
+    /* [guard page][host stack][alternate signal stack] */
+    ulStackSize = ( ulStackSize < configPOSIX_GUARDED_STACK_SIZE ) ? configPOSIX_GUARDED_STACK_SIZE : ulStackSize;
+    ulStackSize = ( ulStackSize + portPAGE_SIZE() - 1 ) & ~( portPAGE_SIZE() - 1 );
+    thread->xHostStackSize = portPAGE_SIZE() + ulStackSize + portALT_STACK_SIZE;
+    thread->pvHostStack = mmap( NULL, thread->xHostStackSize, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK | MAP_NORESERVE, -1, 0 );
+    if ( thread->pvHostStack == MAP_FAILED )
+    {
+        prvFatalError( "mmap", errno );
+    }
+    if ( mprotect( thread->pvHostStack, portPAGE_SIZE(), PROT_NONE ) )
+    {
+        prvFatalError( "mprotect", errno );
+    }
+    pthread_attr_setstack( &xThreadAttributes, ( uint8_t * ) thread->pvHostStack + portPAGE_SIZE(), ulStackSize );
+#else
     pthread_attr_setstack( &xThreadAttributes, pxEndOfStack, ulStackSize );
+#endif
 
-    thread->ev = event_create();
-
+    /* The task is not switched out while the host library holds its locks:
+     * another task could need them inside a critical section. */
     vPortEnterCritical();
+    thread->ev = event_create();
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+    /* The thread inherits the signal mask, it starts suspended. */
+    (void)pthread_sigmask( SIG_BLOCK, &xAllSignals, &xSavedSignalMask );
+#endif
 
     iRet = pthread_create( &thread->pthread, &xThreadAttributes,
                            prvWaitForStart, thread );
@@ -158,18 +658,59 @@ int iRet;
         prvFatalError( "pthread_create", iRet );
     }
 
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+    (void)pthread_sigmask( SIG_SETMASK, &xSavedSignalMask, NULL );
+#endif
     vPortExitCritical();
+#endif /* configPOSIX_GREEN_THREADS */
 
     return pxTopOfStack;
 }
 /*-----------------------------------------------------------*/
 
+#if ( configPOSIX_GREEN_THREADS == 1 )
+/* Context of xPortStartScheduler(), resumed by vPortEndScheduler(). */
+static Context_t xSchedulerContext;
+#endif
+
 void vPortStartFirstTask( void )
 {
+#if ( configNUMBER_OF_CORES > 1 )
+Thread_t *pxFirstThreads[ configNUMBER_OF_CORES ];
+BaseType_t xCoreID;
+
+    /* Start the first task of every core, the cores known before any of
+     * them runs. */
+    for ( xCoreID = 0; xCoreID < configNUMBER_OF_CORES; xCoreID++ )
+    {
+        pxFirstThreads[ xCoreID ] = prvGetThreadFromTask( xTaskGetCurrentTaskHandleForCore( xCoreID ) );
+        pxFirstThreads[ xCoreID ]->uxCore = ( UBaseType_t ) xCoreID;
+        pxRunningThreads[ xCoreID ] = pxFirstThreads[ xCoreID ];
+    }
+
+    for ( xCoreID = 0; xCoreID < configNUMBER_OF_CORES; xCoreID++ )
+    {
+        prvResumeThread( pxFirstThreads[ xCoreID ] );
+    }
+#else
 Thread_t *pxFirstThread = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
 
     /* Start the first task. */
+    pxRunningThreads[ 0 ] = pxFirstThread;
+#if ( configPOSIX_VIRTUAL_TIME == 1 )
+    pxIdleThread = prvGetThreadFromTask( xTaskGetIdleTaskHandle() );
+    if ( pxFirstThread == pxIdleThread )
+    {
+        prvKickVirtualTime();
+    }
+#endif
+#if ( configPOSIX_GREEN_THREADS == 1 )
+    /* Returns when the scheduler is ended. */
+    prvSwapContext( &xSchedulerContext, &pxFirstThread->xContext );
+#else
     prvResumeThread( pxFirstThread );
+#endif
+#endif /* configNUMBER_OF_CORES */
 }
 /*-----------------------------------------------------------*/
 
@@ -178,18 +719,22 @@ Thread_t *pxFirstThread = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
  */
 portBASE_TYPE xPortStartScheduler( void )
 {
+#if ( configPOSIX_GREEN_THREADS == 0 )
 int iSignal;
 sigset_t xSignals;
+#endif
 
     hMainThread = pthread_self();
 
     /* Start the timer that generates the tick ISR(SIGALRM).
        Interrupts are disabled here already. */
     prvSetupTimerInterrupt();
+    prvReportHostScheduling();
 
     /* Start the first task. */
     vPortStartFirstTask();
 
+#if ( configPOSIX_GREEN_THREADS == 0 )
     /* Wait until signaled by vPortEndScheduler(). */
     sigemptyset( &xSignals );
     sigaddset( &xSignals, SIG_RESUME );
@@ -198,6 +743,7 @@ sigset_t xSignals;
     {
         sigwait( &xSignals, &iSignal );
     }
+#endif
 
     /* Cancel the Idle task and free its resources */
 #if ( INCLUDE_xTaskGetIdleTaskHandle == 1 )
@@ -209,6 +755,10 @@ sigset_t xSignals;
     vPortCancelThread( xTimerGetTimerDaemonTaskHandle() );
 #endif /* configUSE_TIMERS */
 
+#if portTHREAD_POOL
+    prvDrainThreadPool();
+#endif
+
     /* Restore original signal mask. */
     (void)pthread_sigmask( SIG_SETMASK, &xSchedulerOriginalSignalMask,  NULL );
 
@@ -218,18 +768,12 @@ sigset_t xSignals;
 
 void vPortEndScheduler( void )
 {
-struct itimerval itimer;
 struct sigaction sigtick;
 Thread_t *xCurrentThread;
 
     /* Stop the timer and ignore any pending SIGALRMs that would end
      * up running on the main thread when it is resumed. */
-    itimer.it_value.tv_sec = 0;
-    itimer.it_value.tv_usec = 0;
-
-    itimer.it_interval.tv_sec = 0;
-    itimer.it_interval.tv_usec = 0;
-    (void)setitimer( ITIMER_REAL, &itimer, NULL );
+    prvStopTimerInterrupt();
 
     sigtick.sa_flags = 0;
     sigtick.sa_handler = SIG_IGN;
@@ -238,10 +782,19 @@ Thread_t *xCurrentThread;
 
     /* Signal the scheduler to exit its loop. */
     xSchedulerEnd = pdTRUE;
+    xCurrentThread = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+
+#if ( configPOSIX_GREEN_THREADS == 1 )
+    /* Return from vPortStartFirstTask(), the task is never resumed. */
+    prvSwapContext( &xCurrentThread->xContext, &xSchedulerContext );
+#else
     (void)pthread_kill( hMainThread, SIG_RESUME );
 
-    xCurrentThread = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+    (void)pthread_sigmask( SIG_BLOCK, &xAllSignals, NULL );
+#endif
     prvSuspendSelf(xCurrentThread);
+#endif
 }
 /*-----------------------------------------------------------*/
 
@@ -251,6 +804,20 @@ void vPortEnterCritical( void )
     {
         vPortDisableInterrupts();
     }
+#if ( configNUMBER_OF_CORES > 1 )
+    prvKernelLockAcquire();
+
+    /* A switch requested by another core is taken first, the task may have
+     * been suspended, deleted or moved meanwhile. */
+    while ( ( xCoreYieldRequests[ portGET_CORE_ID() ] != pdFALSE ) && ( uxKernelLockDepth == 1 ) &&
+            ( uxCriticalNesting == 0 ) && ( uxInterruptNesting == 0 ) )
+    {
+        prvKernelLockRelease();
+        vPortEnableInterrupts();
+        vPortDisableInterrupts();
+        prvKernelLockAcquire();
+    }
+#endif
     uxCriticalNesting++;
 }
 /*-----------------------------------------------------------*/
@@ -258,6 +825,9 @@ void vPortEnterCritical( void )
 void vPortExitCritical( void )
 {
     uxCriticalNesting--;
+#if ( configNUMBER_OF_CORES > 1 )
+    prvKernelLockRelease();
+#endif
 
     /* If we have reached 0 then re-enable the interrupts. */
     if( uxCriticalNesting == 0 )
@@ -284,153 +854,1644 @@ Thread_t *xThreadToResume;
 
 void vPortYield( void )
 {
+#if ( configNUMBER_OF_CORES > 1 )
+    /* The kernel lock is held once per critical section, a switch inside
+     * one would leave the others to the resumed thread.  The switch is
+     * taken by the dispatcher when the section ends. */
+    xSwitchPending = pdTRUE;
+    if ( uxInterruptMask == 0 )
+    {
+        prvDispatchInterrupts();
+    }
+#else
     vPortEnterCritical();
 
     vPortYieldFromISR();
 
     vPortExitCritical();
+#endif
 }
 /*-----------------------------------------------------------*/
 
 void vPortDisableInterrupts( void )
 {
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+    /* Only the signal handlers of this thread read the level, compiler
+     * barriers order it with the critical section. */
+    __atomic_signal_fence( __ATOMIC_SEQ_CST );
+    uxInterruptMask = configMAX_SYSCALL_INTERRUPT_PRIORITY;
+    __atomic_signal_fence( __ATOMIC_SEQ_CST );
+#else
     pthread_sigmask( SIG_BLOCK, &xAllSignals, NULL );
+#endif
 }
 /*-----------------------------------------------------------*/
 
 void vPortEnableInterrupts( void )
 {
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+    __atomic_signal_fence( __ATOMIC_SEQ_CST );
+    uxInterruptMask = 0;
+    __atomic_signal_fence( __ATOMIC_SEQ_CST );
+
+    /* An interrupt raised before the level dropped is pending, one raised
+     * after it ran already. */
+    if ( prvDispatchPending() != pdFALSE )
+    {
+        prvDispatchInterrupts();
+    }
+#else
     pthread_sigmask( SIG_UNBLOCK, &xAllSignals, NULL );
+#endif
 }
 /*-----------------------------------------------------------*/
 
 portBASE_TYPE xPortSetInterruptMask( void )
 {
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+UBaseType_t uxPreviousMask = uxInterruptMask;
+
+    /* A nested interrupt restores the level it found before returning. */
+    if ( uxPreviousMask < configMAX_SYSCALL_INTERRUPT_PRIORITY )
+    {
+        uxInterruptMask = configMAX_SYSCALL_INTERRUPT_PRIORITY;
+    }
+    __atomic_signal_fence( __ATOMIC_SEQ_CST );
+#if ( configNUMBER_OF_CORES > 1 )
+    prvKernelLockAcquire();
+#endif
+
+    return ( portBASE_TYPE ) uxPreviousMask;
+#else
     /* Interrupts are always disabled inside ISRs (signals
        handlers). */
     return pdTRUE;
+#endif
 }
 /*-----------------------------------------------------------*/
 
 void vPortClearInterruptMask( portBASE_TYPE xMask )
 {
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+#if ( configNUMBER_OF_CORES > 1 )
+    prvKernelLockRelease();
+#endif
+    __atomic_signal_fence( __ATOMIC_SEQ_CST );
+    uxInterruptMask = ( UBaseType_t ) xMask;
+    __atomic_signal_fence( __ATOMIC_SEQ_CST );
+
+    if ( prvDispatchPending() != pdFALSE )
+    {
+        prvDispatchInterrupts();
+    }
+#else
+    (void)xMask;
+#endif
 }
 /*-----------------------------------------------------------*/
 
-static uint64_t prvGetTimeNs(void)
+void vPortEndSwitchingISR( BaseType_t xSwitchRequired )
 {
-struct timespec t;
+    if ( xSwitchRequired == pdFALSE )
+    {
+        return;
+    }
 
-    clock_gettime(CLOCK_MONOTONIC, &t);
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+    /* In a handler the switch waits for the interrupted task level, as
+     * PendSV does on a Cortex-M. */
+    if ( uxInterruptNesting > 0 )
+    {
+        xSwitchPending = pdTRUE;
+        return;
+    }
+#endif
 
-    return t.tv_sec * 1000000000ull + t.tv_nsec;
+    vPortYield();
 }
+/*-----------------------------------------------------------*/
 
-static uint64_t prvStartTimeNs;
-/* commented as part of the code below in vPortSystemTickHandler,
- * to adjust timing according to full demo requirements */
-/* static uint64_t prvTickCount; */
+void vPortValidateInterruptPriority( void )
+{
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+    /* Handlers above configMAX_SYSCALL_INTERRUPT_PRIORITY are not masked
+     * by critical sections and must not call the kernel. */
+    configASSERT( uxInterruptMask <= configMAX_SYSCALL_INTERRUPT_PRIORITY );
+#endif
+}
+/*-----------------------------------------------------------*/
+
+#if ( configNUMBER_OF_CORES > 1 )
 
 /*
- * Setup the systick timer to generate the tick interrupts at the required
- * frequency.
+ * Take the kernel lock, again if this core holds it already.  Always
+ * called with the mask level at configMAX_SYSCALL_INTERRUPT_PRIORITY or
+ * above.  The owner is a core rather than a thread: a task switch hands
+ * the lock to the resumed thread, with the depth it had when it was
+ * switched out.
  */
-void prvSetupTimerInterrupt( void )
+static void prvKernelLockAcquire( void )
 {
-struct itimerval itimer;
-int iRet;
+BaseType_t xCoreID = portGET_CORE_ID();
+uint32_t ulWord = 0;
 
-    /* Initialise the structure with the current timer information. */
-    iRet = getitimer( ITIMER_REAL, &itimer );
-    if ( iRet )
+    if ( __atomic_load_n( &xKernelLockOwner, __ATOMIC_RELAXED ) == xCoreID )
     {
-        prvFatalError( "getitimer", errno );
+        uxKernelLockDepth++;
+        return;
     }
 
-    /* Set the interval between timer events. */
-    itimer.it_interval.tv_sec = 0;
-    itimer.it_interval.tv_usec = portTICK_RATE_MICROSECONDS;
-
-    /* Set the current count-down. */
-    itimer.it_value.tv_sec = 0;
-    itimer.it_value.tv_usec = portTICK_RATE_MICROSECONDS;
-
-    /* Set-up the timer interrupt. */
-    iRet = setitimer( ITIMER_REAL, &itimer, NULL );
-    if ( iRet )
+    if ( !__atomic_compare_exchange_n( &ulKernelLockWord, &ulWord, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED ) )
     {
-        prvFatalError( "setitimer", errno );
+        /* Contended: mark the waiters, sleep until the word is released. */
+        if ( ulWord != 2 )
+        {
+            ulWord = __atomic_exchange_n( &ulKernelLockWord, 2, __ATOMIC_ACQUIRE );
+        }
+        while ( ulWord != 0 )
+        {
+            (void)syscall( SYS_futex, &ulKernelLockWord, FUTEX_WAIT_PRIVATE, 2, NULL, NULL, 0 );
+            ulWord = __atomic_exchange_n( &ulKernelLockWord, 2, __ATOMIC_ACQUIRE );
+        }
     }
 
-    prvStartTimeNs = prvGetTimeNs();
+    /* The depth first: a handler taking the lock again in between finds
+     * it set. */
+    uxKernelLockDepth = 1;
+    __atomic_signal_fence( __ATOMIC_SEQ_CST );
+    __atomic_store_n( &xKernelLockOwner, xCoreID, __ATOMIC_RELAXED );
 }
 /*-----------------------------------------------------------*/
 
-static void vPortSystemTickHandler( int sig )
-{
-Thread_t *pxThreadToSuspend;
-Thread_t *pxThreadToResume;
-/* uint64_t xExpectedTicks; */
-
-    uxCriticalNesting++; /* Signals are blocked in this signal handler. */
-
-#if ( configUSE_PREEMPTION == 1 )
-    pxThreadToSuspend = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
-#endif
-
-    /* Tick Increment, accounting for any lost signals or drift in
-     * the timer. */
 /*
- *      Comment code to adjust timing according to full demo requirements
- *      xExpectedTicks = (prvGetTimeNs() - prvStartTimeNs)
- *        / (portTICK_RATE_MICROSECONDS * 1000);
- * do { */
-        xTaskIncrementTick();
-/*        prvTickCount++;
- *    } while (prvTickCount < xExpectedTicks);
-*/
+ * Take the kernel lock without waiting, for the signal handlers: the
+ * interrupted thread may hold a host library lock the owner waits for.
+ */
+static BaseType_t prvKernelLockTry( void )
+{
+BaseType_t xCoreID = portGET_CORE_ID();
+uint32_t ulWord = 0;
 
-#if ( configUSE_PREEMPTION == 1 )
-    /* Select Next Task. */
-    vTaskSwitchContext();
+    if ( __atomic_load_n( &xKernelLockOwner, __ATOMIC_RELAXED ) == xCoreID )
+    {
+        uxKernelLockDepth++;
+        return pdTRUE;
+    }
 
-    pxThreadToResume = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+    if ( !__atomic_compare_exchange_n( &ulKernelLockWord, &ulWord, 1, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST ) )
+    {
+        return pdFALSE;
+    }
 
-    prvSwitchThread(pxThreadToResume, pxThreadToSuspend);
-#endif
+    uxKernelLockDepth = 1;
+    __atomic_signal_fence( __ATOMIC_SEQ_CST );
+    __atomic_store_n( &xKernelLockOwner, xCoreID, __ATOMIC_RELAXED );
 
-    uxCriticalNesting--;
+    return pdTRUE;
 }
 /*-----------------------------------------------------------*/
 
-void vPortThreadDying( void *pxTaskToDelete, volatile BaseType_t *pxPendYield )
+static void prvKernelLockRelease( void )
 {
-Thread_t *pxThread = prvGetThreadFromTask( pxTaskToDelete );
+BaseType_t xCoreID;
 
-    pxThread->xDying = pdTRUE;
-}
+    if ( uxKernelLockDepth > 1 )
+    {
+        uxKernelLockDepth--;
+        return;
+    }
 
-void vPortCancelThread( void *pxTaskToDelete )
+    /* The owner first: a handler in between no longer takes the lock as
+     * its own. */
+    __atomic_store_n( &xKernelLockOwner, -1, __ATOMIC_RELAXED );
+    __atomic_signal_fence( __ATOMIC_SEQ_CST );
+    uxKernelLockDepth = 0;
+    if ( __atomic_exchange_n( &ulKernelLockWord, 0, __ATOMIC_SEQ_CST ) == 2 )
+    {
+        (void)syscall( SYS_futex, &ulKernelLockWord, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0 );
+    }
+
+    for ( xCoreID = 0; xCoreID < configNUMBER_OF_CORES; xCoreID++ )
+    {
+        if ( __atomic_exchange_n( &xCoreDispatchDeferred[ xCoreID ], pdFALSE, __ATOMIC_SEQ_CST ) )
+        {
+            (void)prvSignalRunningThread( ( UBaseType_t ) xCoreID, SIG_INTERRUPT );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* The scheduler is suspended under the lock of the critical sections. */
+void vPortGetTaskLock( void )
+{
+    prvKernelLockAcquire();
+}
+/*-----------------------------------------------------------*/
+
+void vPortReleaseTaskLock( void )
+{
+    prvKernelLockRelease();
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Ask another core for a task switch.  Called with the kernel lock held;
+ * the core takes the switch as soon as it runs at the task level.
+ */
+void vPortYieldCore( BaseType_t xCoreID )
+{
+    __atomic_store_n( &xCoreYieldRequests[ xCoreID ], pdTRUE, __ATOMIC_SEQ_CST );
+    (void)prvSignalRunningThread( ( UBaseType_t ) xCoreID, SIG_INTERRUPT );
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configNUMBER_OF_CORES */
+
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+
+/*
+ * Most urgent pending line above the mask level, portINTERRUPT_LINES if
+ * there is none.
+ */
+static UBaseType_t prvHighestPendingLine( UBaseType_t uxMask )
+{
+uint32_t ulPending = ( portGET_CORE_ID() == 0 ) ? ulPendingInterrupts : 0;
+UBaseType_t uxLine;
+UBaseType_t uxBest = portINTERRUPT_LINES;
+UBaseType_t uxBestPriority = uxMask;
+
+    while ( ulPending != 0 )
+    {
+        uxLine = ( UBaseType_t )__builtin_ctz( ulPending );
+        ulPending &= ulPending - 1;
+
+        if ( xInterruptLines[ uxLine ].uxPriority > uxBestPriority )
+        {
+            uxBestPriority = xInterruptLines[ uxLine ].uxPriority;
+            uxBest = uxLine;
+        }
+    }
+
+    return uxBest;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Work for the dispatcher of this core: a line it handles, a deferred
+ * task switch, or a switch requested by another core.
+ */
+static inline BaseType_t prvDispatchPending( void )
+{
+#if ( configNUMBER_OF_CORES > 1 )
+    if ( xCoreYieldRequests[ portGET_CORE_ID() ] != pdFALSE )
+    {
+        return pdTRUE;
+    }
+#endif
+
+    return ( ( ( ulPendingInterrupts != 0 ) && ( portGET_CORE_ID() == 0 ) ) ||
+             ( xSwitchPending != pdFALSE ) ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+/* A task switch is due on this core. */
+static inline BaseType_t prvSwitchPending( void )
+{
+#if ( configNUMBER_OF_CORES > 1 )
+    if ( xCoreYieldRequests[ portGET_CORE_ID() ] != pdFALSE )
+    {
+        return pdTRUE;
+    }
+#endif
+
+    return xSwitchPending;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Task switch requested by a handler, taken once the mask level is back
+ * to 0.  Runs at the kernel level, as vPortYield() does.
+ */
+static void prvSwitchFromInterrupt( void )
+{
+Thread_t *pxThreadToSuspend;
+Thread_t *pxThreadToResume;
+
+    uxInterruptMask = configMAX_SYSCALL_INTERRUPT_PRIORITY;
+    __atomic_signal_fence( __ATOMIC_SEQ_CST );
+#if ( configNUMBER_OF_CORES > 1 )
+    /* Handed to the resumed thread, and back to this one when it runs
+     * again, on whichever core. */
+    prvKernelLockAcquire();
+    xCoreYieldRequests[ portGET_CORE_ID() ] = pdFALSE;
+#endif
+    uxCriticalNesting++;
+    xSwitchPending = pdFALSE;
+
+    pxThreadToSuspend = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+    vTaskSwitchContext();
+    pxThreadToResume = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+    prvSwitchThread( pxThreadToResume, pxThreadToSuspend );
+
+    uxCriticalNesting--;
+#if ( configNUMBER_OF_CORES > 1 )
+    prvKernelLockRelease();
+#endif
+    __atomic_signal_fence( __ATOMIC_SEQ_CST );
+    uxInterruptMask = 0;
+    __atomic_signal_fence( __ATOMIC_SEQ_CST );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Run the pending lines above the mask level, most urgent first, each
+ * with the level raised to its priority, then the deferred task switch.
+ * Called from the signal handlers and whenever the level drops.  A signal
+ * arriving meanwhile either only marks its line pending or runs more
+ * urgent lines to completion before this continues.
+ */
+static void prvDispatchInterrupts( void )
+{
+InterruptLine_t *pxLine;
+UBaseType_t uxPreviousMask;
+UBaseType_t uxLine;
+uint32_t ulBit;
+
+    do
+    {
+        for ( ;; )
+        {
+            uxPreviousMask = uxInterruptMask;
+            uxLine = prvHighestPendingLine( uxPreviousMask );
+            if ( uxLine == portINTERRUPT_LINES )
+            {
+                break;
+            }
+            pxLine = &xInterruptLines[ uxLine ];
+            ulBit = 1UL << uxLine;
+
+            /* Raise the level, then claim the line: a nested signal may
+             * have changed either in between. */
+            if ( !__atomic_compare_exchange_n( &uxInterruptMask, &uxPreviousMask, pxLine->uxPriority,
+                                               false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST ) )
+            {
+                continue;
+            }
+            if ( ( __atomic_fetch_and( &ulPendingInterrupts, ~ulBit, __ATOMIC_SEQ_CST ) & ulBit ) == 0 )
+            {
+                uxInterruptMask = uxPreviousMask;
+                continue;
+            }
+
+            /* A critical section entered by the kernel inside the handler
+             * must not drop the level when it ends. */
+            uxInterruptNesting++;
+            uxCriticalNesting++;
+            pxLine->pxHandler( pxLine->pvParameter );
+            pxLine->ulCount++;
+            uxCriticalNesting--;
+            uxInterruptNesting--;
+
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 1 )
+            if ( pxLine->xRearm != pdFALSE )
+            {
+                struct epoll_event xEvent = { .events = EPOLLIN | EPOLLONESHOT, .data.u32 = ( uint32_t )uxLine };
+
+                (void)epoll_ctl( iInterruptEpollFd, EPOLL_CTL_MOD, pxLine->iFd, &xEvent );
+            }
+#endif
+
+            __atomic_signal_fence( __ATOMIC_SEQ_CST );
+            uxInterruptMask = uxPreviousMask;
+            __atomic_signal_fence( __ATOMIC_SEQ_CST );
+        }
+
+        if ( ( prvSwitchPending() == pdFALSE ) || ( uxInterruptMask != 0 ) )
+        {
+            break;
+        }
+
+        prvSwitchFromInterrupt();
+
+        /* Lines raised while this task was switched out. */
+    } while ( prvDispatchPending() != pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configPOSIX_SOFT_INTERRUPT_MASK */
+
+static uint64_t prvGetTimeNs(void)
+{
+struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return t.tv_sec * 1000000000ull + t.tv_nsec;
+}
+
+static uint64_t prvStartTimeNs;
+
+/*
+ * Ticks elapsed in ullNs, exact when the tick period is not a whole number
+ * of nanoseconds (30 kHz): the catch-up and the tickless idle count the
+ * ticks from the start time with it, so the tick count does not drift with
+ * the rounded period of the timer.
+ */
+static inline uint64_t prvNsToTicks( uint64_t ullNs )
+{
+    return ( ullNs / 1000000000ull ) * configTICK_RATE_HZ
+           + ( ullNs % 1000000000ull ) * configTICK_RATE_HZ / 1000000000ull;
+}
+
+/* Start of tick ullTicks, rounded up. */
+static inline uint64_t prvTicksToNs( uint64_t ullTicks )
+{
+    return ( ullTicks / configTICK_RATE_HZ ) * 1000000000ull
+           + ( ( ullTicks % configTICK_RATE_HZ ) * 1000000000ull + configTICK_RATE_HZ - 1 ) / configTICK_RATE_HZ;
+}
+
+#if ( configPOSIX_TICK_CATCH_UP == 1 )
+/* Ticks handled since prvStartTimeNs, including the dropped ones. */
+static uint64_t prvTickCount;
+#endif
+
+volatile uint32_t ulPortTicksCaughtUp = 0;
+volatile uint32_t ulPortTicksLost = 0;
+volatile uint32_t ulPortTickInterrupts = 0;
+
+#if ( configPOSIX_TICK_THREAD == 1 )
+
+/*
+ * Send an interrupt signal to the thread of the task running on a core.
+ *
+ * If a switch is in progress the signal may land on the thread being
+ * suspended and stay pending there (its signals are blocked), it is then
+ * sent again to the thread that was selected meanwhile.
+ */
+static BaseType_t prvSignalRunningThread( UBaseType_t uxCore, int iSignal )
+{
+Thread_t *pxThread;
+
+    do
+    {
+        pxThread = pxRunningThreads[ uxCore ];
+        if ( pxThread == NULL )
+        {
+            return pdFALSE;
+        }
+        (void)pthread_kill( pxThread->pthread, iSignal );
+    } while ( pxThread != pxRunningThreads[ uxCore ] );
+
+    return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Account for timer expirations and send SIGALRM unless one is on its way
+ * already: at high tick rates a busy task takes one signal per batch of
+ * ticks, not one per tick.
+ */
+static void prvForwardTicks( uint64_t ullExpirations )
+{
+    __atomic_add_fetch( &ulPendingTicks, ( uint32_t ) ullExpirations * portTICK_BATCH, __ATOMIC_RELEASE );
+
+    if ( !__atomic_exchange_n( &xTickSignalled, pdTRUE, __ATOMIC_ACQ_REL ) )
+    {
+        /* Before the first task runs the next expiration tries again. */
+        if ( prvSignalRunningThread( 0, SIGALRM ) == pdFALSE )
+        {
+            __atomic_store_n( &xTickSignalled, pdFALSE, __ATOMIC_RELEASE );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+#if ( configPOSIX_VIRTUAL_TIME == 1 )
+
+/*
+ * Ask the tick thread for a tick signal, which advances the virtual time
+ * if the idle task is still running when it is handled.
+ */
+static void prvKickVirtualTime( void )
+{
+uint64_t ullKick = 1;
+
+    (void)write( iTickTimerFd, &ullKick, sizeof( ullKick ) );
+}
+/*-----------------------------------------------------------*/
+
+/* Earliest expiry of the timer lines, UINT64_MAX if there is none. */
+static uint64_t prvNextTimerLineNs( void )
+{
+uint64_t ullNext = UINT64_MAX;
+UBaseType_t uxLine;
+
+    for ( uxLine = 0; uxLine < portINTERRUPT_LINES; uxLine++ )
+    {
+        if ( ( xInterruptLines[ uxLine ].ullPeriodNs != 0 ) && ( xInterruptLines[ uxLine ].ullExpiryNs < ullNext ) )
+        {
+            ullNext = xInterruptLines[ uxLine ].ullExpiryNs;
+        }
+    }
+
+    return ullNext;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Advance the virtual clock from the tick interrupt: tick after tick while
+ * no task is unblocked, or to the expiry of a timer line, which is raised.
+ * Returns pdTRUE when a tick unblocked a task.  Only taken while the idle
+ * task runs with no switch pending, i.e. when no other task can run before
+ * the next event, so the order of the events does not depend on the host.
+ * At most one second is simulated per call, the idle task runs in between.
+ */
+static BaseType_t prvAdvanceVirtualTime( void )
+{
+uint64_t ullTickNs;
+uint64_t ullTimerNs;
+uint32_t ulRaised = 0;
+uint32_t ulStep;
+UBaseType_t uxLine;
+
+    if ( ( pxRunningThreads[ 0 ] != pxIdleThread ) || ( xSwitchPending != pdFALSE ) )
+    {
+        /* Kicked again when the idle task is resumed. */
+        return pdFALSE;
+    }
+
+    /* The next step follows the handlers of this one, or the end of the
+     * tickless step of the idle task. */
+    prvKickVirtualTime();
+
+    if ( xTaskGetSchedulerState() != taskSCHEDULER_RUNNING )
+    {
+        return pdFALSE;
+    }
+
+    ullTimerNs = prvNextTimerLineNs();
+
+    for ( ulStep = 0; ulStep < configTICK_RATE_HZ; ulStep++ )
+    {
+        ullTickNs = prvTicksToNs( ullVirtualTicks + 1 );
+
+        if ( ullTimerNs <= ullTickNs )
+        {
+            __atomic_store_n( &ullVirtualTimeNs, ullTimerNs, __ATOMIC_RELAXED );
+
+            for ( uxLine = 0; uxLine < portINTERRUPT_LINES; uxLine++ )
+            {
+                if ( ( xInterruptLines[ uxLine ].ullPeriodNs != 0 ) && ( xInterruptLines[ uxLine ].ullExpiryNs <= ullTimerNs ) )
+                {
+                    xInterruptLines[ uxLine ].ullExpiryNs += xInterruptLines[ uxLine ].ullPeriodNs;
+                    ulRaised |= 1UL << uxLine;
+                }
+            }
+
+            /* Run by the dispatcher once this handler returns. */
+            __atomic_or_fetch( &ulPendingInterrupts, ulRaised, __ATOMIC_SEQ_CST );
+            return pdFALSE;
+        }
+
+        __atomic_store_n( &ullVirtualTimeNs, ullTickNs, __ATOMIC_RELAXED );
+        ullVirtualTicks++;
+
+        if ( xTaskIncrementTick() != pdFALSE )
+        {
+            return pdTRUE;
+        }
+    }
+
+    return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configPOSIX_VIRTUAL_TIME */
+
+/*
+ * Tick thread, runs with all signals blocked and never executes kernel
+ * code: it only forwards the timer expirations to the running task as
+ * SIGALRM, so the tick is handled exactly like a timer interrupt on the
+ * thread that owns the CPU.  With configPOSIX_INTERRUPT_CONTROLLER it
+ * also waits for the sources of the other lines, marks them pending and
+ * sends SIG_INTERRUPT.
+ */
+static void *prvTickThread( void *pvParams )
+{
+uint64_t ullExpirations;
+ssize_t xRead;
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 1 )
+struct epoll_event xEvents[ 8 ];
+InterruptLine_t *pxLine;
+uint32_t ulRaised;
+uint32_t ulLine;
+int iEvents;
+int i;
+#endif
+
+    (void)pvParams;
+
+    while ( !xSchedulerEnd )
+    {
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 1 )
+        iEvents = epoll_wait( iInterruptEpollFd, xEvents, 8, -1 );
+        ulRaised = 0;
+
+        for ( i = 0; i < iEvents; i++ )
+        {
+            ulLine = xEvents[ i ].data.u32;
+            if ( ulLine == portINTERRUPT_LINE_TICK )
+            {
+                xRead = read( iTickTimerFd, &ullExpirations, sizeof( ullExpirations ) );
+                if ( xRead == sizeof( ullExpirations ) )
+                {
+                    prvForwardTicks( ullExpirations );
+                }
+                continue;
+            }
+
+            /* Coalesced timer expirations and event counts raise the line
+             * once, as a level interrupt would. */
+            pxLine = &xInterruptLines[ ulLine ];
+            if ( pxLine->xRearm == pdFALSE )
+            {
+                (void)read( pxLine->iFd, &ullExpirations, sizeof( ullExpirations ) );
+            }
+            ulRaised |= 1UL << ulLine;
+        }
+
+        if ( ulRaised != 0 )
+        {
+            __atomic_or_fetch( &ulPendingInterrupts, ulRaised, __ATOMIC_SEQ_CST );
+            prvSignalRunningThread( 0, SIG_INTERRUPT );
+        }
+#else
+        xRead = read( iTickTimerFd, &ullExpirations, sizeof( ullExpirations ) );
+        if ( xRead != sizeof( ullExpirations ) )
+        {
+            continue;
+        }
+
+        prvForwardTicks( ullExpirations );
+#endif
+    }
+
+    return NULL;
+}
+
+/*
+ * Setup a timerfd and the tick thread that waits on it.  The thread is
+ * made SCHED_FIFO at the highest priority when the process is allowed to,
+ * so its wake-up is not delayed by the task threads.
+ */
+#if ( configPOSIX_VIRTUAL_TIME == 0 )
+/*
+ * Program the timerfd: first expiration at the absolute monotonic time
+ * ullFirstTickNs, then every portTICK_BATCH ticks.  0 stops the timer.
+ */
+static void prvArmTickTimer( uint64_t ullFirstTickNs )
+{
+struct itimerspec xPeriod;
+
+    memset( &xPeriod, 0, sizeof( xPeriod ) );
+    if ( ullFirstTickNs != 0 )
+    {
+        xPeriod.it_interval.tv_sec = portTICK_BATCH_PERIOD_NS / 1000000000ull;
+        xPeriod.it_interval.tv_nsec = portTICK_BATCH_PERIOD_NS % 1000000000ull;
+        xPeriod.it_value.tv_sec = ullFirstTickNs / 1000000000ull;
+        xPeriod.it_value.tv_nsec = ullFirstTickNs % 1000000000ull;
+    }
+
+    if ( timerfd_settime( iTickTimerFd, TFD_TIMER_ABSTIME, &xPeriod, NULL ) )
+    {
+        prvFatalError( "timerfd_settime", errno );
+    }
+}
+/*-----------------------------------------------------------*/
+#endif
+
+static void prvSetupTimerInterrupt( void )
+{
+struct sched_param xParam;
+pthread_attr_t xAttr;
+int iRet;
+
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 1 )
+struct epoll_event xEvent;
+
+#if ( configPOSIX_VIRTUAL_TIME == 1 )
+    /* Written by prvKickVirtualTime() instead of expiring. */
+    iTickTimerFd = eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+    if ( iTickTimerFd < 0 )
+    {
+        prvFatalError( "eventfd", errno );
+    }
+#else
+    iTickTimerFd = timerfd_create( CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK );
+    if ( iTickTimerFd < 0 )
+    {
+        prvFatalError( "timerfd_create", errno );
+    }
+#endif
+
+    xEvent.events = EPOLLIN;
+    xEvent.data.u32 = portINTERRUPT_LINE_TICK;
+    if ( epoll_ctl( iInterruptEpollFd, EPOLL_CTL_ADD, iTickTimerFd, &xEvent ) )
+    {
+        prvFatalError( "epoll_ctl", errno );
+    }
+#elif ( configPOSIX_VIRTUAL_TIME == 1 )
+    iTickTimerFd = eventfd( 0, EFD_CLOEXEC );
+    if ( iTickTimerFd < 0 )
+    {
+        prvFatalError( "eventfd", errno );
+    }
+#else
+    iTickTimerFd = timerfd_create( CLOCK_MONOTONIC, TFD_CLOEXEC );
+    if ( iTickTimerFd < 0 )
+    {
+        prvFatalError( "timerfd_create", errno );
+    }
+#endif
+
+    /* Interrupts are disabled here already, the thread inherits a mask
+     * with every signal blocked. */
+    pthread_attr_init( &xAttr );
+    pthread_attr_setinheritsched( &xAttr, PTHREAD_EXPLICIT_SCHED );
+    pthread_attr_setschedpolicy( &xAttr, SCHED_FIFO );
+    xParam.sched_priority = sched_get_priority_max( SCHED_FIFO );
+    pthread_attr_setschedparam( &xAttr, &xParam );
+
+    iRet = pthread_create( &hTickThread, &xAttr, prvTickThread, NULL );
+    if ( iRet == EPERM )
+    {
+        /* Not allowed to use a real-time policy. */
+        iRet = pthread_create( &hTickThread, NULL, prvTickThread, NULL );
+    }
+    pthread_attr_destroy( &xAttr );
+
+    if ( iRet )
+    {
+        prvFatalError( "pthread_create", iRet );
+    }
+
+#if ( configPOSIX_VIRTUAL_TIME == 0 )
+    prvStartTimeNs = prvGetTimeNs();
+    prvArmTickTimer( prvStartTimeNs + portTICK_BATCH_PERIOD_NS );
+#endif
+}
+/*-----------------------------------------------------------*/
+
+static void prvStopTimerInterrupt( void )
+{
+#if ( configPOSIX_VIRTUAL_TIME == 0 )
+    prvArmTickTimer( 0 );
+#endif
+
+    /* read() and epoll_wait() are cancellation points. */
+    (void)pthread_cancel( hTickThread );
+    (void)pthread_join( hTickThread, NULL );
+    (void)close( iTickTimerFd );
+    iTickTimerFd = -1;
+}
+/*-----------------------------------------------------------*/
+
+#else /* configPOSIX_TICK_THREAD */
+
+/*
+ * Program the interval timer: first expiration at the monotonic time
+ * ullFirstTickNs, then every portTICK_BATCH ticks.  0 stops the timer.
+ */
+static void prvArmTickTimer( uint64_t ullFirstTickNs )
+{
+struct itimerval itimer;
+uint64_t ullNow;
+uint64_t ullDelayUs = 0;
+int iRet;
+
+    memset( &itimer, 0, sizeof( itimer ) );
+    if ( ullFirstTickNs != 0 )
+    {
+        ullNow = prvGetTimeNs();
+        if ( ullFirstTickNs > ullNow )
+        {
+            ullDelayUs = ( ullFirstTickNs - ullNow ) / 1000;
+        }
+
+        /* A zero it_value would stop the timer. */
+        if ( ullDelayUs == 0 )
+        {
+            ullDelayUs = 1;
+        }
+
+        /* Set the interval between timer events. */
+        itimer.it_interval.tv_sec = portTICK_BATCH_PERIOD_NS / 1000000000ull;
+        itimer.it_interval.tv_usec = ( portTICK_BATCH_PERIOD_NS % 1000000000ull ) / 1000;
+
+        /* Set the current count-down. */
+        itimer.it_value.tv_sec = ullDelayUs / 1000000;
+        itimer.it_value.tv_usec = ullDelayUs % 1000000;
+    }
+
+    iRet = setitimer( ITIMER_REAL, &itimer, NULL );
+    if ( iRet )
+    {
+        prvFatalError( "setitimer", errno );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Setup the systick timer to generate the tick interrupts at the required
+ * frequency.
+ */
+static void prvSetupTimerInterrupt( void )
+{
+    prvStartTimeNs = prvGetTimeNs();
+    prvArmTickTimer( prvStartTimeNs + portTICK_BATCH_PERIOD_NS );
+}
+/*-----------------------------------------------------------*/
+
+static void prvStopTimerInterrupt( void )
+{
+    prvArmTickTimer( 0 );
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configPOSIX_TICK_THREAD */
+
+#if ( configPOSIX_TICK_CATCH_UP == 1 )
+
+/*
+ * Number of ticks to handle so that the tick count matches the monotonic
+ * time.  Can be 0 when the interrupt came early.
+ */
+static uint32_t prvTicksToCatchUp( void )
+{
+uint64_t ullExpectedTicks;
+uint64_t ullLag;
+
+    /* Rounded, so an interrupt slightly early or late is not taken for a
+     * missing or an extra tick. */
+    ullExpectedTicks = prvNsToTicks( prvGetTimeNs() - prvStartTimeNs + portTICK_PERIOD_NS / 2 );
+
+    if ( ullExpectedTicks <= prvTickCount )
+    {
+        return 0;
+    }
+
+    ullLag = ullExpectedTicks - prvTickCount;
+    prvTickCount = ullExpectedTicks;
+
+    if ( ullLag > configPOSIX_TICK_CATCH_UP_LIMIT )
+    {
+        ulPortTicksLost += ( uint32_t ) ( ullLag - configPOSIX_TICK_CATCH_UP_LIMIT );
+        ullLag = configPOSIX_TICK_CATCH_UP_LIMIT;
+    }
+
+    /* A batch of ticks per expiration is on time. */
+    if ( ullLag > portTICK_BATCH )
+    {
+        ulPortTicksCaughtUp += ( uint32_t ) ( ullLag - portTICK_BATCH );
+    }
+
+    return ( uint32_t ) ullLag;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configPOSIX_TICK_CATCH_UP */
+
+#if ( configUSE_TICKLESS_IDLE == 1 ) && ( configPOSIX_VIRTUAL_TIME == 0 )
+
+/*
+ * Called by the idle task, with the scheduler suspended, when no task is
+ * due for at least xExpectedIdleTime ticks.  The tick timer is stopped and
+ * the host thread sleeps until the next unblock time or until a signal
+ * other than the tick (a simulated interrupt) arrives.  The ticks that
+ * elapsed are then stepped and the tick timer is restarted on the next
+ * tick boundary.
+ */
+void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
+{
+const uint64_t ullTickNs = portTICK_PERIOD_NS;
+struct timespec xTimeout;
+sigset_t xSleepSignals;
+#if ( configPOSIX_TICK_CATCH_UP == 0 )
+uint64_t ullSleepStartNs;
+#endif
+uint64_t ullNow;
+uint64_t ullTicks;
+
+    /* Keep the sleep time representable, the timer is checked again on
+     * wake-up anyway. */
+    if ( xExpectedIdleTime > configPOSIX_TICKLESS_MAX_SLEEP_TICKS )
+    {
+        xExpectedIdleTime = configPOSIX_TICKLESS_MAX_SLEEP_TICKS;
+    }
+
+    vPortEnterCritical();
+
+    if ( eTaskConfirmSleepModeStatus() == eAbortSleep )
+    {
+        vPortExitCritical();
+        return;
+    }
+
+    prvArmTickTimer( 0 );
+#if ( configPOSIX_TICK_CATCH_UP == 0 )
+    ullSleepStartNs = prvGetTimeNs();
+#endif
+
+    /* Sleep with every signal but the tick unblocked, so a simulated
+     * interrupt ends the sleep and its handler runs. */
+    sigemptyset( &xSleepSignals );
+    sigaddset( &xSleepSignals, SIGALRM );
+    xTimeout.tv_sec = ( xExpectedIdleTime * ullTickNs ) / 1000000000ull;
+    xTimeout.tv_nsec = ( xExpectedIdleTime * ullTickNs ) % 1000000000ull;
+    (void)ppoll( NULL, 0, &xTimeout, &xSleepSignals );
+
+    ullNow = prvGetTimeNs();
+
+#if ( configPOSIX_TICK_CATCH_UP == 1 )
+    /* Step to the tick boundary the time base has reached, the catch-up
+     * handles an oversleep past the expected idle time. */
+    ullTicks = prvNsToTicks( ullNow - prvStartTimeNs );
+    ullTicks = ( ullTicks > prvTickCount ) ? ullTicks - prvTickCount : 0;
+#else
+    ullTicks = ( ullNow - ullSleepStartNs ) / ullTickNs;
+#endif
+
+    /* The kernel cannot be stepped past the unblock time of a task. */
+    if ( ullTicks > xExpectedIdleTime )
+    {
+        ullTicks = xExpectedIdleTime;
+    }
+
+#if ( configPOSIX_TICK_CATCH_UP == 1 )
+    prvTickCount += ullTicks;
+#endif
+
+    vTaskStepTick( ( TickType_t ) ullTicks );
+
+    /* Restart on the tick grid, the first expiration accounts for a whole
+     * batch. */
+    prvArmTickTimer( prvStartTimeNs + prvTicksToNs( prvNsToTicks( ullNow - prvStartTimeNs ) + portTICK_BATCH ) );
+
+    vPortExitCritical();
+}
+/*-----------------------------------------------------------*/
+
+#elif ( configUSE_TICKLESS_IDLE == 1 )
+
+/*
+ * Virtual time: the ticks before the next unblock time, or before the next
+ * expiry of a timer line, are stepped at once.  The last one is left to
+ * the tick interrupt (prvAdvanceVirtualTime()), so the task is unblocked
+ * by xTaskIncrementTick() as usual.  With no task waiting for a timeout and
+ * no timer line nothing can happen in virtual time, the host thread sleeps
+ * until a host source raises an interrupt.
+ */
+void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
+{
+eSleepModeStatus eSleepStatus;
+sigset_t xSleepSignals;
+uint64_t ullTimerNs;
+uint64_t ullTimerTicks;
+uint64_t ullTicks;
+
+    vPortEnterCritical();
+
+    eSleepStatus = eTaskConfirmSleepModeStatus();
+    if ( eSleepStatus == eAbortSleep )
+    {
+        vPortExitCritical();
+        return;
+    }
+
+    ullTimerNs = prvNextTimerLineNs();
+
+    if ( ( eSleepStatus == eNoTasksWaitingTimeout ) && ( ullTimerNs == UINT64_MAX ) )
+    {
+        sigemptyset( &xSleepSignals );
+        sigaddset( &xSleepSignals, SIGALRM );
+        (void)ppoll( NULL, 0, NULL, &xSleepSignals );
+        vPortExitCritical();
+        return;
+    }
+
+    ullTicks = xExpectedIdleTime - 1;
+
+    if ( ullTimerNs != UINT64_MAX )
+    {
+        /* Ticks starting before the expiry. */
+        ullTimerTicks = prvNsToTicks( ullTimerNs - 1 );
+        ullTimerTicks = ( ullTimerTicks > ullVirtualTicks ) ? ullTimerTicks - ullVirtualTicks : 0;
+        if ( ullTimerTicks < ullTicks )
+        {
+            ullTicks = ullTimerTicks;
+        }
+    }
+
+    if ( ullTicks > 0 )
+    {
+        vTaskStepTick( ( TickType_t ) ullTicks );
+        ullVirtualTicks += ullTicks;
+        __atomic_store_n( &ullVirtualTimeNs, prvTicksToNs( ullVirtualTicks ), __ATOMIC_RELAXED );
+    }
+
+    vPortExitCritical();
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configUSE_TICKLESS_IDLE */
+
+/*
+ * Handler of SIGALRM (the tick) and SIG_INTERRUPT (the other lines, marked
+ * pending by their sender).
+ */
+static void vPortSystemTickHandler( int sig )
+{
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+    if ( sig == SIGALRM )
+    {
+        __atomic_or_fetch( &ulPendingInterrupts, 1UL << portINTERRUPT_LINE_TICK, __ATOMIC_SEQ_CST );
+    }
+
+#if ( configNUMBER_OF_CORES > 1 )
+    /* The task moved to another core since the signal was sent, the lines
+     * are handled on core 0. */
+    if ( ( portGET_CORE_ID() != 0 ) && ( ulPendingInterrupts != 0 ) )
+    {
+        (void)prvSignalRunningThread( 0, SIG_INTERRUPT );
+    }
+
+    /* Only a thread at the task level waits for the kernel lock.  The
+     * flag is set before trying again, so either this handler takes the
+     * lock or its owner sees the flag once it has released it. */
+    if ( prvKernelLockTry() == pdFALSE )
+    {
+        __atomic_store_n( &xCoreDispatchDeferred[ portGET_CORE_ID() ], pdTRUE, __ATOMIC_SEQ_CST );
+        if ( prvKernelLockTry() == pdFALSE )
+        {
+            return;
+        }
+        __atomic_store_n( &xCoreDispatchDeferred[ portGET_CORE_ID() ], pdFALSE, __ATOMIC_SEQ_CST );
+    }
+
+    prvDispatchInterrupts();
+    prvKernelLockRelease();
+#else
+    prvDispatchInterrupts();
+#endif
+#else
+    (void)sig;
+
+    prvTickInterrupt();
+#endif
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Tick interrupt, runs with interrupts disabled.
+ */
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+static void prvTickInterrupt( void *pvParameter )
+{
+BaseType_t xSwitchRequired = pdFALSE;
+uint32_t ulTicks = portTICK_BATCH;
+#if ( configNUMBER_OF_CORES > 1 )
+UBaseType_t uxSavedMask;
+#endif
+
+    (void)pvParameter;
+#else
+static void prvTickInterrupt( void )
+{
+Thread_t *pxThreadToSuspend;
+Thread_t *pxThreadToResume;
+uint32_t ulTicks = portTICK_BATCH;
+#endif
+
+#if ( configPOSIX_TICK_THREAD == 1 )
+    /* A SIGALRM left pending on a thread that was being suspended is
+     * delivered when it runs again; its ticks have already been handled.
+     * Ticks counted from here on need a new signal. */
+    __atomic_store_n( &xTickSignalled, pdFALSE, __ATOMIC_SEQ_CST );
+    ulTicks = __atomic_exchange_n( &ulPendingTicks, 0, __ATOMIC_SEQ_CST );
+    if ( ulTicks == 0 )
+    {
+        return;
+    }
+#endif
+
+#if ( configPOSIX_VIRTUAL_TIME == 1 )
+    /* The signal only asks the virtual clock to move on, which handles
+     * the ticks itself. */
+    portYIELD_FROM_ISR( prvAdvanceVirtualTime() );
+    return;
+#elif ( configPOSIX_TICK_CATCH_UP == 1 )
+    /* The time decides, the number of signals only triggers the check. */
+    ulTicks = prvTicksToCatchUp();
+    if ( ulTicks == 0 )
+    {
+        return;
+    }
+#endif
+
+    ulPortTickInterrupts++;
+
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+    /* The switch is taken by the dispatcher, only if the tick unblocked
+     * a task or time slicing is due. */
+#if ( configNUMBER_OF_CORES > 1 )
+    /* The kernel lock, as a FromISR function takes it. */
+    uxSavedMask = xPortSetInterruptMask();
+#endif
+    while ( ulTicks-- > 0 )
+    {
+        if ( xTaskIncrementTick() != pdFALSE )
+        {
+            xSwitchRequired = pdTRUE;
+        }
+    }
+#if ( configNUMBER_OF_CORES > 1 )
+    vPortClearInterruptMask( uxSavedMask );
+#endif
+
+    portYIELD_FROM_ISR( xSwitchRequired );
+#else
+    uxCriticalNesting++; /* Signals are blocked in this signal handler. */
+
+#if ( configUSE_PREEMPTION == 1 )
+    pxThreadToSuspend = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+#endif
+
+    /* Tick Increment, accounting for any lost signals or drift in
+     * the timer.  xTaskCatchUpTicks() cannot be used here, it suspends
+     * and resumes the scheduler, which may yield. */
+    while ( ulTicks-- > 0 )
+    {
+        xTaskIncrementTick();
+    }
+
+#if ( configUSE_PREEMPTION == 1 )
+    /* Select Next Task. */
+    vTaskSwitchContext();
+
+    pxThreadToResume = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+
+    prvSwitchThread(pxThreadToResume, pxThreadToSuspend);
+#endif
+
+    uxCriticalNesting--;
+#endif /* configPOSIX_SOFT_INTERRUPT_MASK */
+}
+/*-----------------------------------------------------------*/
+
+void vPortThreadDying( void *pxTaskToDelete, volatile BaseType_t *pxPendYield )
+{
+Thread_t *pxThread = prvGetThreadFromTask( pxTaskToDelete );
+
+    pxThread->xDying = pdTRUE;
+}
+
+void vPortCancelThread( void *pxTaskToDelete )
+{
+Thread_t *pxThreadToCancel = prvGetThreadFromTask( pxTaskToDelete );
+
+#if ( configPOSIX_GREEN_THREADS == 1 )
+    /*
+     * The task is not running and is never resumed, only the stack mapped
+     * by the port has to be released.
+     */
+    if ( pxThreadToCancel->pvHostStack != NULL )
+    {
+        (void)munmap( pxThreadToCancel->pvHostStack, pxThreadToCancel->xHostStackSize );
+        pxThreadToCancel->pvHostStack = NULL;
+    }
+#elif portTHREAD_POOL
+    /*
+     * A task deleted while suspended parks its thread when woken, one
+     * deleting itself already parks it.  The task stack is freed on return,
+     * once the thread no longer uses it.
+     */
+    if ( !pxThreadToCancel->xDying )
+    {
+        pxThreadToCancel->xCancelled = pdTRUE;
+        event_signal( pxThreadToCancel->ev );
+    }
+
+    while ( !__atomic_load_n( &pxThreadToCancel->xReleased, __ATOMIC_ACQUIRE ) )
+    {
+        (void)sched_yield();
+    }
+#else
+    /*
+     * The thread has already been suspended so it can be safely cancelled.
+     * The calling task is not switched out while the host library holds
+     * its locks, as in pxPortInitialiseStack().
+     */
+    if ( !xSchedulerEnd )
+    {
+        vPortEnterCritical();
+    }
+
+    pthread_cancel( pxThreadToCancel->pthread );
+    pthread_join( pxThreadToCancel->pthread, NULL );
+    event_delete( pxThreadToCancel->ev );
+#if ( configPOSIX_GUARDED_STACKS == 1 )
+    (void)munmap( pxThreadToCancel->pvHostStack, pxThreadToCancel->xHostStackSize );
+#endif
+
+    if ( !xSchedulerEnd )
+    {
+        vPortExitCritical();
+    }
+#endif
+}
+/*-----------------------------------------------------------*/
+
+#if ( configPOSIX_GREEN_THREADS == 1 )
+
+/*
+ * Entry point of a green thread, reached by the first switch to the task.
+ */
+static void prvGreenThreadStart( void )
+{
+Thread_t *pxThread = pxRunningThreads[ 0 ];
+
+    /* Started for the first time, unblocks all signals. */
+    uxCriticalNesting = 0;
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+    (void)pthread_sigmask( SIG_UNBLOCK, &xAllSignals, NULL );
+#endif
+    vPortEnableInterrupts();
+
+    /* Call the task's entry point. */
+    pxThread->pxCode( pxThread->pvParams );
+
+    /* A task must not return, there is no thread to end here. */
+    configASSERT( pdFALSE );
+    fprintf( stderr, "task function returned\n" );
+    abort();
+}
+/*-----------------------------------------------------------*/
+
+#if ( configPOSIX_GREEN_THREADS_UCONTEXT == 1 )
+
+static void prvInitialiseContext( Thread_t *pxThread, void *pvStack, size_t xStackSize )
+{
+ucontext_t *pxUContext;
+
+    /* The ucontext goes at the top of the stack. */
+    pxUContext = ( ucontext_t * )( ( ( uintptr_t )pvStack + xStackSize - sizeof( ucontext_t ) )
+                                   & ~( uintptr_t )15 );
+
+    if ( getcontext( pxUContext ) )
+    {
+        prvFatalError( "getcontext", errno );
+    }
+    pxUContext->uc_stack.ss_sp = pvStack;
+    pxUContext->uc_stack.ss_size = ( uintptr_t )pxUContext - ( uintptr_t )pvStack;
+    pxUContext->uc_link = NULL;
+    makecontext( pxUContext, prvGreenThreadStart, 0 );
+
+    pxThread->xContext.pxUContext = pxUContext;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSwapContext( Context_t *pxSave, Context_t *pxRestore )
+{
+static ucontext_t xSchedulerUContext;
+
+    /* Only the context of xPortStartScheduler() is not created here. */
+    if ( pxSave->pxUContext == NULL )
+    {
+        pxSave->pxUContext = &xSchedulerUContext;
+    }
+
+    if ( swapcontext( pxSave->pxUContext, pxRestore->pxUContext ) )
+    {
+        prvFatalError( "swapcontext", errno );
+    }
+}
+/*-----------------------------------------------------------*/
+
+#else /* configPOSIX_GREEN_THREADS_UCONTEXT */
+
+/*
+ * void vPortSwitchStack( void **ppvSaveStackPointer, void *pvRestoreStackPointer )
+ *
+ * Pushes the callee-saved registers and the SSE/x87 control words of the
+ * System V ABI, saves the stack pointer, then pops the same frame from the
+ * restored stack and returns on it.
+ */
+void vPortSwitchStack( void **ppvSaveStackPointer, void *pvRestoreStackPointer )
+    __attribute__( ( visibility( "hidden" ) ) );
+
+__asm__(
+    "    .text\n"
+    "    .p2align 4\n"
+    "    .globl vPortSwitchStack\n"
+    "    .type vPortSwitchStack, @function\n"
+    "vPortSwitchStack:\n"
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    subq $8, %rsp\n"
+    "    stmxcsr (%rsp)\n"
+    "    fnstcw 4(%rsp)\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    ldmxcsr (%rsp)\n"
+    "    fldcw 4(%rsp)\n"
+    "    addq $8, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    "    .size vPortSwitchStack, .-vPortSwitchStack\n"
+);
+
+static void prvInitialiseContext( Thread_t *pxThread, void *pvStack, size_t xStackSize )
+{
+uint64_t *pullTop;
+uint32_t ulMxcsr;
+uint16_t usFpuControl;
+int i;
+
+    __asm volatile ( "stmxcsr %0" : "=m" ( ulMxcsr ) );
+    __asm volatile ( "fnstcw %0" : "=m" ( usFpuControl ) );
+
+    /* Frame popped by vPortSwitchStack(), from the top of the stack down:
+     * a null return address ending the backtraces, the entry point
+     * returned to, rbp, rbx, r12-r15 and the control words.  The entry
+     * point is reached with the alignment of a call. */
+    pullTop = ( uint64_t * )( ( ( uintptr_t )pvStack + xStackSize ) & ~( uintptr_t )15 );
+    *--pullTop = 0;
+    *--pullTop = ( uint64_t )( uintptr_t )prvGreenThreadStart;
+    for ( i = 0; i < 6; i++ )
+    {
+        *--pullTop = 0;
+    }
+    *--pullTop = ( uint64_t )ulMxcsr | ( ( uint64_t )usFpuControl << 32 );
+
+    pxThread->xContext.pvStackPointer = pullTop;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSwapContext( Context_t *pxSave, Context_t *pxRestore )
+{
+    vPortSwitchStack( &pxSave->pvStackPointer, pxRestore->pvStackPointer );
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configPOSIX_GREEN_THREADS_UCONTEXT */
+
+#else /* configPOSIX_GREEN_THREADS */
+
+#if portTHREAD_POOL
+
+/*
+ * Entry point of a host thread of the pool, and where it parks again when
+ * its task is deleted.
+ */
+static void *prvPoolThreadStart( void * pvParams )
+{
+PoolThread_t *pxPoolThread = pvParams;
+Thread_t *pxThread;
+#if ( configPOSIX_GUARDED_STACKS == 1 )
+pthread_attr_t xThreadAttributes;
+void *pvStack;
+size_t xStackSize;
+size_t xGuardSize;
+
+    /* The host stack of a pooled thread is allocated by the host library,
+     * with its own guard page below it. */
+    (void)pthread_getattr_np( pthread_self(), &xThreadAttributes );
+    (void)pthread_attr_getstack( &xThreadAttributes, &pvStack, &xStackSize );
+    (void)pthread_attr_getguardsize( &xThreadAttributes, &xGuardSize );
+    (void)pthread_attr_destroy( &xThreadAttributes );
+    prvSetupStackGuard( ( uint8_t * ) pvStack - xGuardSize, xGuardSize, pxPoolThread->pvAltStack );
+#endif
+
+    (void)sigsetjmp( pxPoolThread->xParkContext, 0 );
+
+    /* Resumed for the first time by the task given to the thread, or woken
+     * without one by prvDrainThreadPool(). */
+    event_wait( pxPoolThread->ev );
+
+    pxThread = __atomic_load_n( &pxPoolThread->pxThread, __ATOMIC_ACQUIRE );
+    if ( pxThread == NULL )
+    {
+        prvEndPoolThread( pxPoolThread );
+    }
+
+    if ( pxThread->xCancelled )
+    {
+        prvParkThread( pxThread );
+    }
+
+    prvRunTask( pxThread );
+
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Give a host thread to a new task, parked or else created, with signals
+ * blocked until the task starts.  Called in a critical section.
+ */
+static void prvTakePoolThread( Thread_t *pxThread )
+{
+PoolThread_t *pxPoolThread;
+pthread_attr_t xThreadAttributes;
+int iRet;
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+sigset_t xSavedSignalMask;
+#endif
+
+    pxThread->xCancelled = pdFALSE;
+    pxThread->xReleased = pdFALSE;
+
+    (void)pthread_mutex_lock( &xThreadPoolMutex );
+    pxPoolThread = pxParkedThreads;
+    if ( pxPoolThread != NULL )
+    {
+        pxParkedThreads = pxPoolThread->pxNext;
+        uxParkedThreads--;
+    }
+    (void)pthread_mutex_unlock( &xThreadPoolMutex );
+
+    if ( pxPoolThread != NULL )
+    {
+        /* Parked on its event until the task is resumed. */
+        pxThread->pthread = pxPoolThread->pthread;
+        pxThread->ev = pxPoolThread->ev;
+        pxThread->pxPoolThread = pxPoolThread;
+        __atomic_store_n( &pxPoolThread->pxThread, pxThread, __ATOMIC_RELEASE );
+    }
+    else
+    {
+        pxPoolThread = malloc( sizeof( *pxPoolThread ) );
+        if ( pxPoolThread == NULL )
+        {
+            prvFatalError( "malloc", ENOMEM );
+        }
+        pxPoolThread->ev = event_create();
+        pxPoolThread->pxThread = pxThread;
+#if ( configPOSIX_GUARDED_STACKS == 1 )
+        pxPoolThread->pvAltStack = mmap( NULL, portALT_STACK_SIZE, PROT_READ | PROT_WRITE,
+                                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK | MAP_NORESERVE, -1, 0 );
+        if ( pxPoolThread->pvAltStack == MAP_FAILED )
+        {
+            prvFatalError( "mmap", errno );
+        }
+#endif
+        pxThread->ev = pxPoolThread->ev;
+        pxThread->pxPoolThread = pxPoolThread;
+
+        /* Never joined, a thread left over ends by itself. */
+        pthread_attr_init( &xThreadAttributes );
+        pthread_attr_setdetachstate( &xThreadAttributes, PTHREAD_CREATE_DETACHED );
+#if ( configPOSIX_GUARDED_STACKS == 1 )
+        pthread_attr_setstacksize( &xThreadAttributes, configPOSIX_GUARDED_STACK_SIZE );
+        pthread_attr_setguardsize( &xThreadAttributes, portPAGE_SIZE() );
+#endif
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+        (void)pthread_sigmask( SIG_BLOCK, &xAllSignals, &xSavedSignalMask );
+#endif
+        iRet = pthread_create( &pxPoolThread->pthread, &xThreadAttributes,
+                               prvPoolThreadStart, pxPoolThread );
+        if ( iRet )
+        {
+            prvFatalError( "pthread_create", iRet );
+        }
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+        (void)pthread_sigmask( SIG_SETMASK, &xSavedSignalMask, NULL );
+#endif
+        (void)pthread_attr_destroy( &xThreadAttributes );
+        pxThread->pthread = pxPoolThread->pthread;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Leave the deleted task of the calling thread, with all signals blocked,
+ * and park the thread, or end it when the pool is full.
+ */
+static void prvParkThread( Thread_t *pxThread )
+{
+PoolThread_t *pxPoolThread = pxThread->pxPoolThread;
+BaseType_t xParked = pdFALSE;
+
+    /* The task stack, pxThread included, can be freed from here on. */
+    __atomic_store_n( &pxPoolThread->pxThread, NULL, __ATOMIC_RELAXED );
+    __atomic_store_n( &pxThread->xReleased, pdTRUE, __ATOMIC_RELEASE );
+
+    (void)pthread_mutex_lock( &xThreadPoolMutex );
+    if ( uxParkedThreads < configPOSIX_THREAD_POOL_SIZE )
+    {
+        pxPoolThread->pxNext = pxParkedThreads;
+        pxParkedThreads = pxPoolThread;
+        uxParkedThreads++;
+        xParked = pdTRUE;
+    }
+    (void)pthread_mutex_unlock( &xThreadPoolMutex );
+
+    if ( xParked )
+    {
+        siglongjmp( pxPoolThread->xParkContext, 1 );
+    }
+
+    prvEndPoolThread( pxPoolThread );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * End the calling thread of the pool, not parked.
+ */
+static void prvEndPoolThread( PoolThread_t *pxPoolThread )
 {
-Thread_t *pxThreadToCancel = prvGetThreadFromTask( pxTaskToDelete );
+#if ( configPOSIX_GUARDED_STACKS == 1 )
+stack_t xAltStack = { .ss_flags = SS_DISABLE };
 
-    /*
-     * The thread has already been suspended so it can be safely cancelled.
-     */
-    pthread_cancel( pxThreadToCancel->pthread );
-    pthread_join( pxThreadToCancel->pthread, NULL );
-    event_delete( pxThreadToCancel->ev );
+    (void)sigaltstack( &xAltStack, NULL );
+    (void)munmap( pxPoolThread->pvAltStack, portALT_STACK_SIZE );
+#endif
+    event_delete( pxPoolThread->ev );
+    free( pxPoolThread );
+    pthread_exit( NULL );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * End the parked threads, once the scheduler has ended.
+ */
+static void prvDrainThreadPool( void )
+{
+PoolThread_t *pxPoolThread;
+
+    (void)pthread_mutex_lock( &xThreadPoolMutex );
+    while ( pxParkedThreads != NULL )
+    {
+        pxPoolThread = pxParkedThreads;
+        pxParkedThreads = pxPoolThread->pxNext;
+        uxParkedThreads--;
+        event_signal( pxPoolThread->ev );
+    }
+    (void)pthread_mutex_unlock( &xThreadPoolMutex );
 }
 /*-----------------------------------------------------------*/
 
+#else
+
 static void *prvWaitForStart( void * pvParams )
 {
 Thread_t *pxThread = pvParams;
 
     prvSuspendSelf(pxThread);
+    prvRunTask(pxThread);
+
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* portTHREAD_POOL */
+
+static void prvRunTask( Thread_t *pxThread )
+{
+#if ( configPOSIX_GUARDED_STACKS == 1 ) && !portTHREAD_POOL
+    prvSetupStackGuard( pxThread->pvHostStack, portPAGE_SIZE(),
+                        ( uint8_t * ) pxThread->pvHostStack + pxThread->xHostStackSize - portALT_STACK_SIZE );
+#endif
 
     /* Resumed for the first time, unblocks all signals. */
     uxCriticalNesting = 0;
+#if ( configNUMBER_OF_CORES > 1 )
+    uxPortCoreID = pxThread->uxCore;
+#if portTHREAD_POOL
+    /* Left as they were by the previous task of a pooled thread. */
+    uxInterruptNesting = 0;
+    xSwitchPending = pdFALSE;
+#endif
+
+    /* Handed the kernel lock by the task switched out, unless started by
+     * vPortStartFirstTask(). */
+    if ( __atomic_load_n( &xKernelLockOwner, __ATOMIC_RELAXED ) == portGET_CORE_ID() )
+    {
+        prvKernelLockRelease();
+    }
+#endif
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+    (void)pthread_sigmask( SIG_UNBLOCK, &xAllSignals, NULL );
+#endif
     vPortEnableInterrupts();
 
     /* Call the task's entry point. */
@@ -442,15 +2503,26 @@ Thread_t *pxThread = pvParams;
     * to be triggered if configASSERT() is defined, so application writers can
         * catch the error. */
     configASSERT( pdFALSE );
-
-    return NULL;
 }
 /*-----------------------------------------------------------*/
 
+#endif /* configPOSIX_GREEN_THREADS */
+
 static void prvSwitchThread( Thread_t *pxThreadToResume,
                              Thread_t *pxThreadToSuspend )
 {
 BaseType_t uxSavedCriticalNesting;
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 ) && ( configPOSIX_GREEN_THREADS == 0 )
+sigset_t xSavedSignalMask;
+#endif
+
+#if ( configPOSIX_VIRTUAL_TIME == 1 )
+    /* Every other task is blocked, the time can advance. */
+    if ( pxThreadToResume == pxIdleThread )
+    {
+        prvKickVirtualTime();
+    }
+#endif
 
     if ( pxThreadToSuspend != pxThreadToResume )
     {
@@ -463,22 +2535,52 @@ BaseType_t uxSavedCriticalNesting;
          */
         uxSavedCriticalNesting = uxCriticalNesting;
 
+        pxRunningThreads[ portGET_CORE_ID() ] = pxThreadToResume;
+#if ( configNUMBER_OF_CORES > 1 )
+        pxThreadToResume->uxCore = ( UBaseType_t ) portGET_CORE_ID();
+        pxThreadToSuspend->uxLockDepth = uxKernelLockDepth;
+        uxKernelLockDepth = pxThreadToResume->uxLockDepth;
+#endif
+#if ( configPOSIX_GREEN_THREADS == 1 )
+        /* A dying task is simply never switched back to. */
+        prvSwapContext( &pxThreadToSuspend->xContext, &pxThreadToResume->xContext );
+#else
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+        /* A suspended thread must not take signals, the critical section
+         * no longer blocks them.  Restored as it was (unblocked in a task
+         * or in a tick handler) when this task runs again. */
+        (void)pthread_sigmask( SIG_BLOCK, &xAllSignals, &xSavedSignalMask );
+#endif
         prvResumeThread( pxThreadToResume );
         if ( pxThreadToSuspend->xDying )
         {
+#if portTHREAD_POOL
+            prvParkThread( pxThreadToSuspend );
+#else
             pthread_exit( NULL );
+#endif
         }
         prvSuspendSelf( pxThreadToSuspend );
+#if ( configNUMBER_OF_CORES > 1 )
+        /* Resumed by the core that selected the task. */
+        uxPortCoreID = pxThreadToSuspend->uxCore;
+#endif
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+        (void)pthread_sigmask( SIG_SETMASK, &xSavedSignalMask, NULL );
+#endif
+#endif
 
         uxCriticalNesting = uxSavedCriticalNesting;
     }
 }
 /*-----------------------------------------------------------*/
 
+#if ( configPOSIX_GREEN_THREADS == 0 )
+
 static void prvSuspendSelf( Thread_t *thread )
 {
     /*
-     * Suspend this thread by waiting for a pthread_cond_signal event.
+     * Suspend this thread by waiting for its event to be signalled.
      *
      * A suspended thread must not handle signals (interrupts) so
      * all signals must be blocked by calling this from:
@@ -491,6 +2593,14 @@ static void prvSuspendSelf( Thread_t *thread )
      * - A thread with all signals blocked with pthread_sigmask().
         */
     event_wait(thread->ev);
+
+#if portTHREAD_POOL
+    /* Woken by vPortCancelThread(). */
+    if ( thread->xCancelled )
+    {
+        prvParkThread( thread );
+    }
+#endif
 }
 
 /*-----------------------------------------------------------*/
@@ -504,13 +2614,230 @@ static void prvResumeThread( Thread_t *xThreadId )
 }
 /*-----------------------------------------------------------*/
 
+#if ( configPOSIX_GUARDED_STACKS == 1 )
+
+/*
+ * Record the guard page of the host stack of the calling task thread and
+ * give it the alternate signal stack of prvStackFaultHandler().
+ */
+static void prvSetupStackGuard( uint8_t *pucGuard, size_t xGuardSize, void *pvAltStack )
+{
+stack_t xAltStack;
+
+    pucGuardPage = pucGuard;
+    xGuardPageSize = xGuardSize;
+
+    xAltStack.ss_sp = pvAltStack;
+    xAltStack.ss_size = portALT_STACK_SIZE;
+    xAltStack.ss_flags = 0;
+    if ( sigaltstack( &xAltStack, NULL ) )
+    {
+        prvFatalError( "sigaltstack", errno );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * SIGSEGV, on the alternate signal stack as the stack of the task may be
+ * exhausted.  A fault on the guard page is a stack overflow of the running
+ * task.  The handler is reset to the default action on entry: when the
+ * hook returns, or for any other fault, the instruction faults again and
+ * the process is ended with a core dump.
+ */
+static void prvStackFaultHandler( int iSignal, siginfo_t *pxInfo, void *pvContext )
+{
+uint8_t *pucAddress = pxInfo->si_addr;
+TaskHandle_t xTask;
+
+    ( void ) iSignal;
+    ( void ) pvContext;
+
+    if ( ( pucGuardPage != NULL ) && ( pucAddress >= pucGuardPage ) &&
+         ( pucAddress < pucGuardPage + xGuardPageSize ) )
+    {
+        xTask = xTaskGetCurrentTaskHandle();
+        vApplicationStackOverflowHook( xTask, pcTaskGetName( xTask ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configPOSIX_GUARDED_STACKS */
+
+#endif /* configPOSIX_GREEN_THREADS */
+
+/*
+ * Apply the host scheduling settings to the calling thread, the one that
+ * creates the first task: the task threads and the tick thread inherit
+ * its CPUs, and the task threads its policy.  A setting refused by the
+ * host (no CAP_SYS_NICE, RLIMIT_MEMLOCK) is reported, not fatal.
+ */
+static void prvSetupHostScheduling( void )
+{
+#if ( configPOSIX_HOST_PRIORITY != 0 )
+struct sched_param xParam;
+#endif
+#if ( configPOSIX_HOST_CPU_MASK != 0 )
+cpu_set_t xCpus;
+int iCpu;
+#endif
+
+#if ( configPOSIX_HOST_PRIORITY != 0 )
+    xParam.sched_priority = configPOSIX_HOST_PRIORITY;
+    iHostPriorityError = pthread_setschedparam( pthread_self(), SCHED_FIFO, &xParam );
+#endif
+
+#if ( configPOSIX_HOST_CPU_MASK != 0 )
+    CPU_ZERO( &xCpus );
+    for ( iCpu = 0; iCpu < 64; iCpu++ )
+    {
+        if ( ( ( uint64_t )( configPOSIX_HOST_CPU_MASK ) >> iCpu ) & 1U )
+        {
+            CPU_SET( iCpu, &xCpus );
+        }
+    }
+    iHostAffinityError = pthread_setaffinity_np( pthread_self(), sizeof( xCpus ), &xCpus );
+#endif
+
+#if ( configPOSIX_HOST_MLOCK != 0 )
+    if ( mlockall( MCL_CURRENT | MCL_FUTURE ) != 0 )
+    {
+        iHostMlockError = errno;
+    }
+#endif
+}
+/*-----------------------------------------------------------*/
+
+#if portHOST_SCHEDULING
+static const char *prvPolicyName( int iPolicy )
+{
+    switch ( iPolicy )
+    {
+        case SCHED_FIFO:
+            return "SCHED_FIFO";
+        case SCHED_RR:
+            return "SCHED_RR";
+        default:
+            return "SCHED_OTHER";
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* CPUs of a set as a list of ranges, "0,2-3". */
+static void prvFormatCpus( const cpu_set_t *pxCpus, char *pcBuffer, size_t xSize )
+{
+size_t xUsed = 0;
+int iCpu;
+int iFirst;
+
+    pcBuffer[ 0 ] = '\0';
+
+    for ( iCpu = 0; iCpu < CPU_SETSIZE; iCpu++ )
+    {
+        if ( !CPU_ISSET( iCpu, pxCpus ) )
+        {
+            continue;
+        }
+
+        iFirst = iCpu;
+        while ( ( iCpu + 1 < CPU_SETSIZE ) && CPU_ISSET( iCpu + 1, pxCpus ) )
+        {
+            iCpu++;
+        }
+
+        if ( xUsed < xSize )
+        {
+            xUsed += ( size_t )snprintf( pcBuffer + xUsed, xSize - xUsed,
+                                         ( iFirst == iCpu ) ? "%s%d" : "%s%d-%d",
+                                         ( xUsed > 0 ) ? "," : "", iFirst, iCpu );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+#endif /* portHOST_SCHEDULING */
+
+/*
+ * Print the host scheduling in effect when the scheduler starts, as read
+ * back from the host, with the settings it refused.
+ */
+static void prvReportHostScheduling( void )
+{
+#if portHOST_SCHEDULING
+struct sched_param xParam;
+cpu_set_t xCpus;
+char cCpus[ 128 ];
+int iPolicy;
+
+    (void)pthread_getschedparam( pthread_self(), &iPolicy, &xParam );
+    fprintf( stderr, "Posix port: tasks %s %d", prvPolicyName( iPolicy ), xParam.sched_priority );
+    if ( iHostPriorityError != 0 )
+    {
+        fprintf( stderr, " (SCHED_FIFO %d refused: %s)", configPOSIX_HOST_PRIORITY, strerror( iHostPriorityError ) );
+    }
+
+#if ( configPOSIX_TICK_THREAD == 1 )
+    (void)pthread_getschedparam( hTickThread, &iPolicy, &xParam );
+    fprintf( stderr, ", tick thread %s %d", prvPolicyName( iPolicy ), xParam.sched_priority );
+#endif
+
+    CPU_ZERO( &xCpus );
+    (void)pthread_getaffinity_np( pthread_self(), sizeof( xCpus ), &xCpus );
+    prvFormatCpus( &xCpus, cCpus, sizeof( cCpus ) );
+    fprintf( stderr, ", CPUs %s", cCpus );
+    if ( iHostAffinityError != 0 )
+    {
+        fprintf( stderr, " (mask 0x%llx refused: %s)", ( unsigned long long )( configPOSIX_HOST_CPU_MASK ),
+                 strerror( iHostAffinityError ) );
+    }
+
+#if ( configPOSIX_HOST_MLOCK != 0 )
+    if ( iHostMlockError != 0 )
+    {
+        fprintf( stderr, ", memory not locked (%s)", strerror( iHostMlockError ) );
+    }
+    else
+    {
+        fprintf( stderr, ", memory locked" );
+    }
+#endif
+
+    fprintf( stderr, "\n" );
+#endif /* portHOST_SCHEDULING */
+}
+/*-----------------------------------------------------------*/
+
 static void prvSetupSignalsAndSchedulerPolicy( void )
 {
 struct sigaction sigresume, sigtick;
+#if ( configPOSIX_GUARDED_STACKS == 1 )
+struct sigaction sigfault;
+#endif
 int iRet;
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+UBaseType_t uxLine;
+#endif
 
     hMainThread = pthread_self();
 
+    /* Before the first task thread is created, they all inherit it. */
+    prvSetupHostScheduling();
+
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+    for ( uxLine = 0; uxLine < portINTERRUPT_LINES; uxLine++ )
+    {
+        xInterruptLines[ uxLine ].iFd = -1;
+    }
+    xInterruptLines[ portINTERRUPT_LINE_TICK ].pxHandler = prvTickInterrupt;
+    xInterruptLines[ portINTERRUPT_LINE_TICK ].uxPriority = configKERNEL_INTERRUPT_PRIORITY;
+#endif
+
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 1 )
+    iInterruptEpollFd = epoll_create1( EPOLL_CLOEXEC );
+    if ( iInterruptEpollFd < 0 )
+    {
+        prvFatalError( "epoll_create1", errno );
+    }
+#endif
+
     /* Initialise common signal masks. */
     sigemptyset( &xResumeSignals );
     sigaddset( &xResumeSignals, SIG_RESUME );
@@ -518,6 +2845,11 @@ int iRet;
     /* Don't block SIGINT so this can be used to break into GDB while
      * in a critical section. */
     sigdelset( &xAllSignals, SIGINT );
+#if ( configPOSIX_GUARDED_STACKS == 1 )
+    /* A blocked fault ends the process without its handler, and a stack
+     * can overflow with interrupts disabled. */
+    sigdelset( &xAllSignals, SIGSEGV );
+#endif
 
     /*
      * Block all signals in this thread so all new threads
@@ -535,9 +2867,18 @@ int iRet;
     sigresume.sa_handler = SIG_IGN;
     sigfillset( &sigresume.sa_mask );
 
-    sigtick.sa_flags = 0;
+    /* Restart the system calls interrupted by the tick in the running
+     * task. */
+    sigtick.sa_flags = SA_RESTART;
     sigtick.sa_handler = vPortSystemTickHandler;
+#if ( configPOSIX_SOFT_INTERRUPT_MASK == 1 )
+    /* The handler masks interrupts with the mask level, leaving the signal
+     * mask alone keeps it the same in every task. */
+    sigtick.sa_flags |= SA_NODEFER;
+    sigemptyset( &sigtick.sa_mask );
+#else
     sigfillset( &sigtick.sa_mask );
+#endif
 
     iRet = sigaction( SIG_RESUME, &sigresume, NULL );
     if ( iRet )
@@ -550,15 +2891,221 @@ int iRet;
     {
         prvFatalError( "sigaction", errno );
     }
+
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 1 ) || ( configNUMBER_OF_CORES > 1 )
+    iRet = sigaction( SIG_INTERRUPT, &sigtick, NULL );
+    if ( iRet )
+    {
+        prvFatalError( "sigaction", errno );
+    }
+#endif
+
+#if ( configPOSIX_GUARDED_STACKS == 1 )
+    sigfault.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_RESETHAND;
+    sigfault.sa_sigaction = prvStackFaultHandler;
+    sigemptyset( &sigfault.sa_mask );
+
+    iRet = sigaction( SIGSEGV, &sigfault, NULL );
+    if ( iRet )
+    {
+        prvFatalError( "sigaction", errno );
+    }
+#endif
+}
+/*-----------------------------------------------------------*/
+
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 1 )
+
+BaseType_t xPortInstallInterruptHandler( UBaseType_t uxLine,
+                                         UBaseType_t uxPriority,
+                                         PortInterruptHandler_t pxHandler,
+                                         void *pvParameter )
+{
+InterruptLine_t *pxLine;
+
+    (void)pthread_once( &hSigSetupThread, prvSetupSignalsAndSchedulerPolicy );
+
+    if ( ( uxLine == portINTERRUPT_LINE_TICK ) || ( uxLine >= portINTERRUPT_LINES ) ||
+         ( uxPriority == 0 ) || ( uxPriority > portMAX_INTERRUPT_PRIORITY ) ||
+         ( pxHandler == NULL ) || ( xInterruptLines[ uxLine ].pxHandler != NULL ) )
+    {
+        return pdFAIL;
+    }
+
+    pxLine = &xInterruptLines[ uxLine ];
+    pxLine->pvParameter = pvParameter;
+    pxLine->uxPriority = uxPriority;
+    __atomic_store_n( &pxLine->pxHandler, pxHandler, __ATOMIC_RELEASE );
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Watch iFd with the tick thread.  xRearm: the line is raised once per
+ * readiness and the handler consumes the data, otherwise the tick thread
+ * reads the 8 byte counter of the timerfd or eventfd itself.
+ */
+static BaseType_t prvAttachSource( UBaseType_t uxLine, int iFd, BaseType_t xRearm )
+{
+InterruptLine_t *pxLine;
+struct epoll_event xEvent;
+
+    if ( ( uxLine == portINTERRUPT_LINE_TICK ) || ( uxLine >= portINTERRUPT_LINES ) ||
+         ( xInterruptLines[ uxLine ].pxHandler == NULL ) || ( xInterruptLines[ uxLine ].iFd >= 0 ) )
+    {
+        errno = EINVAL;
+        return pdFAIL;
+    }
+
+    pxLine = &xInterruptLines[ uxLine ];
+    pxLine->iFd = iFd;
+    pxLine->xRearm = xRearm;
+
+    xEvent.events = EPOLLIN | ( xRearm ? EPOLLONESHOT : 0 );
+    xEvent.data.u32 = ( uint32_t )uxLine;
+    if ( epoll_ctl( iInterruptEpollFd, EPOLL_CTL_ADD, iFd, &xEvent ) )
+    {
+        pxLine->iFd = -1;
+        return pdFAIL;
+    }
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortInterruptAttachFd( UBaseType_t uxLine, int iFd )
+{
+    return prvAttachSource( uxLine, iFd, pdTRUE );
+}
+/*-----------------------------------------------------------*/
+
+int iPortInterruptAttachTimer( UBaseType_t uxLine, uint32_t ulPeriodUs )
+{
+#if ( configPOSIX_VIRTUAL_TIME == 1 )
+int iFd;
+
+    /* Expires in virtual time, see prvAdvanceVirtualTime().  The eventfd
+     * keeps the descriptor returned to the caller meaningful. */
+    if ( ulPeriodUs == 0 )
+    {
+        return -1;
+    }
+
+    iFd = iPortInterruptAttachEvent( uxLine );
+    if ( iFd >= 0 )
+    {
+        /* The period marks the line as a timer, set last. */
+        xInterruptLines[ uxLine ].ullExpiryNs = ullPortGetTimeNs() + ulPeriodUs * 1000ull;
+        __atomic_store_n( &xInterruptLines[ uxLine ].ullPeriodNs, ulPeriodUs * 1000ull, __ATOMIC_RELEASE );
+    }
+
+    return iFd;
+#else
+struct itimerspec xPeriod;
+int iFd;
+
+    iFd = timerfd_create( CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK );
+    if ( iFd < 0 )
+    {
+        return -1;
+    }
+
+    memset( &xPeriod, 0, sizeof( xPeriod ) );
+    xPeriod.it_interval.tv_sec = ulPeriodUs / 1000000;
+    xPeriod.it_interval.tv_nsec = ( ulPeriodUs % 1000000 ) * 1000;
+    xPeriod.it_value = xPeriod.it_interval;
+
+    if ( ( prvAttachSource( uxLine, iFd, pdFALSE ) != pdPASS ) ||
+         timerfd_settime( iFd, 0, &xPeriod, NULL ) )
+    {
+        (void)close( iFd );
+        return -1;
+    }
+
+    return iFd;
+#endif
+}
+/*-----------------------------------------------------------*/
+
+int iPortInterruptAttachEvent( UBaseType_t uxLine )
+{
+int iFd;
+
+    iFd = eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+    if ( iFd < 0 )
+    {
+        return -1;
+    }
+
+    if ( prvAttachSource( uxLine, iFd, pdFALSE ) != pdPASS )
+    {
+        (void)close( iFd );
+        return -1;
+    }
+
+    return iFd;
+}
+/*-----------------------------------------------------------*/
+
+void vPortRaiseInterrupt( UBaseType_t uxLine )
+{
+    if ( uxLine >= portINTERRUPT_LINES )
+    {
+        return;
+    }
+
+    __atomic_or_fetch( &ulPendingInterrupts, 1UL << uxLine, __ATOMIC_SEQ_CST );
+
+    /* Runs the handler before returning when called by the running task
+     * with the line unmasked. */
+    prvSignalRunningThread( 0, SIG_INTERRUPT );
+}
+/*-----------------------------------------------------------*/
+
+const volatile uint32_t *pulPortInterruptCounter( UBaseType_t uxLine )
+{
+    return ( uxLine < portINTERRUPT_LINES ) ? &xInterruptLines[ uxLine ].ulCount : NULL;
 }
 /*-----------------------------------------------------------*/
 
+#endif /* configPOSIX_INTERRUPT_CONTROLLER */
+
 unsigned long ulPortGetRunTime( void )
 {
+#if ( configPOSIX_VIRTUAL_TIME == 1 )
+    /* Microseconds of virtual time. */
+    return ( unsigned long ) ( ullPortGetTimeNs() / 1000 );
+#else
 struct tms xTimes;
 
     times( &xTimes );
 
     return ( unsigned long ) xTimes.tms_utime;
+#endif
+}
+/*-----------------------------------------------------------*/
+
+#if ( configPOSIX_GREEN_THREADS == 0 )
+uint64_t ullPortGetTaskCPUTimeNs( void )
+{
+struct timespec xTime;
+
+    /* Each task has a host thread, the clock of the thread is the CPU time
+     * of the task, in virtual time too. */
+    clock_gettime( CLOCK_THREAD_CPUTIME_ID, &xTime );
+
+    return ( uint64_t ) xTime.tv_sec * 1000000000ull + ( uint64_t ) xTime.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+#endif /* configPOSIX_GREEN_THREADS */
+
+uint64_t ullPortGetTimeNs( void )
+{
+#if ( configPOSIX_VIRTUAL_TIME == 1 )
+    return __atomic_load_n( &ullVirtualTimeNs, __ATOMIC_RELAXED );
+#else
+    return prvGetTimeNs();
+#endif
 }
 /*-----------------------------------------------------------*/
@@ -35,6 +35,7 @@ extern "C" {
 #endif
 
 #include <limits.h>
+#include <stdint.h>
 
 /*-----------------------------------------------------------
  * Port specific definitions.
@@ -72,6 +73,7 @@ typedef unsigned long TickType_t;
 #define portHAS_STACK_OVERFLOW_CHECKING	( 1 )
 #define portTICK_PERIOD_MS			( ( TickType_t ) 1000 / configTICK_RATE_HZ )
 #define portTICK_RATE_MICROSECONDS	( ( portTickType ) 1000000 / configTICK_RATE_HZ )
+#define portTICK_PERIOD_NS			( 1000000000ULL / configTICK_RATE_HZ )
 #define portBYTE_ALIGNMENT			8
 /*-----------------------------------------------------------*/
 
@@ -80,10 +82,60 @@ extern void vPortYield( void );
 
 #define portYIELD() vPortYield()
 
-#define portEND_SWITCHING_ISR( xSwitchRequired ) if( xSwitchRequired != pdFALSE ) vPortYield()
+/* With configPOSIX_SOFT_INTERRUPT_MASK a switch requested by a handler
+ * is deferred until the interrupted task level is back. */
+extern void vPortEndSwitchingISR( BaseType_t xSwitchRequired );
+#define portEND_SWITCHING_ISR( xSwitchRequired ) vPortEndSwitchingISR( xSwitchRequired )
 #define portYIELD_FROM_ISR( x ) portEND_SWITCHING_ISR( x )
 /*-----------------------------------------------------------*/
 
+/* Port optimised task selection (configUSE_PORT_OPTIMISED_TASK_SELECTION).
+ * uxTopReadyPriority is a bitmap of the ready priorities and the highest
+ * one is found with a count of leading zeros, whatever configMAX_PRIORITIES.
+ * Above the bits of a UBaseType_t the bitmap has two levels: a bit of
+ * uxTopReadyPriority tells which word of uxPortReadyPriorities has a ready
+ * priority. */
+#if defined( configUSE_PORT_OPTIMISED_TASK_SELECTION ) && ( configUSE_PORT_OPTIMISED_TASK_SELECTION == 1 )
+	#define portREADY_BITMAP_BITS		( __SIZEOF_LONG__ * CHAR_BIT )
+	#define portTOP_BIT( uxBitmap )		( ( UBaseType_t ) ( portREADY_BITMAP_BITS - 1 ) - ( UBaseType_t ) __builtin_clzl( uxBitmap ) )
+
+	#if ( configMAX_PRIORITIES <= portREADY_BITMAP_BITS )
+		#define portRECORD_READY_PRIORITY( uxPriority, uxReadyPriorities )	( uxReadyPriorities ) |= ( 1UL << ( uxPriority ) )
+		#define portRESET_READY_PRIORITY( uxPriority, uxReadyPriorities )	( uxReadyPriorities ) &= ~( 1UL << ( uxPriority ) )
+		#define portGET_HIGHEST_PRIORITY( uxTopPriority, uxReadyPriorities )	uxTopPriority = portTOP_BIT( uxReadyPriorities )
+	#elif ( configMAX_PRIORITIES <= portREADY_BITMAP_BITS * portREADY_BITMAP_BITS )
+		#define portREADY_BITMAP_WORDS		( ( configMAX_PRIORITIES + portREADY_BITMAP_BITS - 1 ) / portREADY_BITMAP_BITS )
+		extern UBaseType_t uxPortReadyPriorities[ portREADY_BITMAP_WORDS ];
+
+		#define portRECORD_READY_PRIORITY( uxPriority, uxReadyPriorities )									\
+			do {																							\
+				uxPortReadyPriorities[ ( uxPriority ) / portREADY_BITMAP_BITS ] |= 1UL << ( ( uxPriority ) % portREADY_BITMAP_BITS ); \
+				( uxReadyPriorities ) |= 1UL << ( ( uxPriority ) / portREADY_BITMAP_BITS );					\
+			} while( 0 )
+		#define portRESET_READY_PRIORITY( uxPriority, uxReadyPriorities )									\
+			do {																							\
+				uxPortReadyPriorities[ ( uxPriority ) / portREADY_BITMAP_BITS ] &= ~( 1UL << ( ( uxPriority ) % portREADY_BITMAP_BITS ) ); \
+				if( uxPortReadyPriorities[ ( uxPriority ) / portREADY_BITMAP_BITS ] == 0 )					\
+				{																							\
+					( uxReadyPriorities ) &= ~( 1UL << ( ( uxPriority ) / portREADY_BITMAP_BITS ) );		\
+				}																							\
+			} while( 0 )
+		#define portGET_HIGHEST_PRIORITY( uxTopPriority, uxReadyPriorities )								\
+			do {																							\
+				UBaseType_t uxWord = portTOP_BIT( uxReadyPriorities );										\
+				uxTopPriority = uxWord * portREADY_BITMAP_BITS + portTOP_BIT( uxPortReadyPriorities[ uxWord ] ); \
+			} while( 0 )
+	#else
+		#error configUSE_PORT_OPTIMISED_TASK_SELECTION supports at most ( bits of a UBaseType_t ) squared priorities
+	#endif
+#endif
+/*-----------------------------------------------------------*/
+
+/* Tickless idle (configUSE_TICKLESS_IDLE). */
+extern void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime );
+#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) vPortSuppressTicksAndSleep( xExpectedIdleTime )
+/*-----------------------------------------------------------*/
+
 /* Critical section management. */
 extern void vPortDisableInterrupts( void );
 extern void vPortEnableInterrupts( void );
@@ -93,6 +145,21 @@ extern void vPortEnableInterrupts( void );
 extern portBASE_TYPE xPortSetInterruptMask( void );
 extern void vPortClearInterruptMask( portBASE_TYPE xMask );
 
+/* Interrupt priorities of the soft mask (configPOSIX_SOFT_INTERRUPT_MASK):
+ * a higher number is more urgent, as on the Cortex-R.  Lines above
+ * configMAX_SYSCALL_INTERRUPT_PRIORITY are never masked by the kernel and
+ * must not call the FreeRTOS API. */
+#define portMAX_INTERRUPT_PRIORITY		31
+#ifndef configKERNEL_INTERRUPT_PRIORITY
+	#define configKERNEL_INTERRUPT_PRIORITY			1
+#endif
+#ifndef configMAX_SYSCALL_INTERRUPT_PRIORITY
+	#define configMAX_SYSCALL_INTERRUPT_PRIORITY	16
+#endif
+
+extern void vPortValidateInterruptPriority( void );
+#define portASSERT_IF_INTERRUPT_PRIORITY_INVALID()	vPortValidateInterruptPriority()
+
 extern void vPortEnterCritical( void );
 extern void vPortExitCritical( void );
 #define portSET_INTERRUPT_MASK_FROM_ISR()		xPortSetInterruptMask()
@@ -102,6 +169,15 @@ extern void vPortExitCritical( void );
 #define portENTER_CRITICAL()					vPortEnterCritical()
 #define portEXIT_CRITICAL()						vPortExitCritical()
 
+/* Without the soft interrupt mask portSET_INTERRUPT_MASK_FROM_ISR() does
+ * nothing (signal handlers already run with every signal blocked), so a
+ * task could be switched out in the middle of an atomic.h operation.  The
+ * operations then use a critical section, which blocks the tick signal. */
+#if !defined( configPOSIX_SOFT_INTERRUPT_MASK ) || ( configPOSIX_SOFT_INTERRUPT_MASK == 0 )
+#define ATOMIC_ENTER_CRITICAL()					portENTER_CRITICAL()
+#define ATOMIC_EXIT_CRITICAL()					portEXIT_CRITICAL()
+#endif
+
 /*-----------------------------------------------------------*/
 
 extern void vPortThreadDying( void *pxTaskToDelete, volatile BaseType_t *pxPendYield );
@@ -124,10 +200,67 @@ extern void vPortCancelThread( void *pxTaskToDelete );
  */
 #define portMEMORY_BARRIER() __asm volatile( "" ::: "memory" )
 
+/* Task snapshots are read without any lock, by tasks on other cores with
+ * configNUMBER_OF_CORES > 1 and by host threads, so they need a fence. */
+#define portSEQLOCK_BARRIER() __atomic_thread_fence( __ATOMIC_SEQ_CST )
+
+/* Tick catch-up counters (configPOSIX_TICK_CATCH_UP): ticks handled late
+ * in a batch, and ticks dropped because the lag exceeded
+ * configPOSIX_TICK_CATCH_UP_LIMIT. */
+extern volatile uint32_t ulPortTicksCaughtUp;
+extern volatile uint32_t ulPortTicksLost;
+
+/* Tick interrupts that stepped the kernel, one per batch of ticks when
+ * they are batched. */
+extern volatile uint32_t ulPortTickInterrupts;
+
+/* Simulated interrupt controller (configPOSIX_INTERRUPT_CONTROLLER).  Line
+ * 0 is the tick, the other lines are raised by the tick thread when their
+ * source is ready or by vPortRaiseInterrupt(). */
+#define portINTERRUPT_LINES				32
+#define portINTERRUPT_LINE_TICK			0
+
+typedef void ( *PortInterruptHandler_t )( void *pvParameter );
+
+extern BaseType_t xPortInstallInterruptHandler( UBaseType_t uxLine, UBaseType_t uxPriority,
+                                                PortInterruptHandler_t pxHandler, void *pvParameter );
+extern BaseType_t xPortInterruptAttachFd( UBaseType_t uxLine, int iFd );
+extern int iPortInterruptAttachTimer( UBaseType_t uxLine, uint32_t ulPeriodUs );
+extern int iPortInterruptAttachEvent( UBaseType_t uxLine );
+extern void vPortRaiseInterrupt( UBaseType_t uxLine );
+extern const volatile uint32_t *pulPortInterruptCounter( UBaseType_t uxLine );
+
+/* Time of the simulation in nanoseconds: the virtual clock with
+ * configPOSIX_VIRTUAL_TIME, the monotonic clock otherwise.  The run time
+ * counter follows it in virtual time. */
+extern uint64_t ullPortGetTimeNs( void );
+
+/* Simulated cores (configNUMBER_OF_CORES above 1): the core of a task
+ * thread follows the task, 0 in the other host threads. */
+#if defined( configNUMBER_OF_CORES ) && ( configNUMBER_OF_CORES > 1 )
+extern __thread volatile UBaseType_t uxPortCoreID;
+extern void vPortYieldCore( BaseType_t xCoreID );
+extern void vPortGetTaskLock( void );
+extern void vPortReleaseTaskLock( void );
+
+#define portGET_CORE_ID()			( ( BaseType_t ) uxPortCoreID )
+#define portYIELD_CORE( xCoreID )	vPortYieldCore( xCoreID )
+#define portGET_TASK_LOCK()			vPortGetTaskLock()
+#define portRELEASE_TASK_LOCK()		vPortReleaseTaskLock()
+#endif
+
 extern unsigned long ulPortGetRunTime( void );
 #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() /* no-op */
 #define portGET_RUN_TIME_COUNTER_VALUE()         ulPortGetRunTime()
 
+/* CPU time of the host thread of the calling task in nanoseconds, which
+ * measures the jobs of configUSE_ADMISSION_CONTROL.  Not given with
+ * configPOSIX_GREEN_THREADS, where the tasks share a host thread. */
+#if !defined( configPOSIX_GREEN_THREADS ) || ( configPOSIX_GREEN_THREADS == 0 )
+extern uint64_t ullPortGetTaskCPUTimeNs( void );
+#define portGET_TASK_CPU_TIME_NS()               ullPortGetTaskCPUTimeNs()
+#endif
+
 #ifdef __cplusplus
 }
 #endif
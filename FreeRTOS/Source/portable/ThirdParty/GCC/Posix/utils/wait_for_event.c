@@ -26,12 +26,220 @@
  *
  */
 
+/*
+ * Events used by the Posix port to hand the CPU from one task thread to the
+ * next: prvSwitchThread() signals the event of the thread to resume and
+ * waits on the event of its own thread.
+ *
+ * On Linux the event is a single futex word, so a switch costs one
+ * FUTEX_WAKE on the signalling side and one FUTEX_WAIT on the waiting side.
+ * The portable implementation uses a mutex and a condition variable, which
+ * takes several system calls and wakeups per switch.
+ */
+
+/* syscall() is a GNU extension. */
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
 #include <pthread.h>
 #include <stdlib.h>
 #include <errno.h>
 
 #include "wait_for_event.h"
 
+#ifndef configPOSIX_FUTEX_EVENTS
+    #ifdef __linux__
+        #define configPOSIX_FUTEX_EVENTS    1
+    #else
+        #define configPOSIX_FUTEX_EVENTS    0
+    #endif
+#endif
+
+/*
+ * Number of polls of the futex word before a waiter goes to sleep.  Spinning
+ * saves the FUTEX_WAIT/FUTEX_WAKE pair when the event is signalled from
+ * another CPU shortly after the wait starts, it is skipped on a single CPU
+ * host where the signalling thread cannot run while the waiter spins.
+ */
+#ifndef configPOSIX_FUTEX_SPIN_COUNT
+    #define configPOSIX_FUTEX_SPIN_COUNT    0
+#endif
+
+#if ( configPOSIX_FUTEX_EVENTS == 1 )
+
+#include <limits.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+/* States of the futex word. */
+#define eventCLEAR        0U    /* Not signalled, no sleeping waiter. */
+#define eventSIGNALLED    1U    /* Signalled, not consumed yet. */
+#define eventSLEEPING     2U    /* Not signalled, the waiter sleeps in FUTEX_WAIT. */
+
+struct event
+{
+    uint32_t state;
+};
+
+static int spin_count = -1;
+
+static long futex( uint32_t * uaddr,
+                   int op,
+                   uint32_t val,
+                   const struct timespec * timeout )
+{
+    return syscall( SYS_futex, uaddr, op | FUTEX_PRIVATE_FLAG, val, timeout, NULL, 0 );
+}
+
+static bool event_try_consume( struct event * ev )
+{
+    uint32_t expected = eventSIGNALLED;
+
+    return __atomic_compare_exchange_n( &ev->state, &expected, eventCLEAR, false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED );
+}
+
+static void event_spin( struct event * ev )
+{
+    int i;
+
+    for( i = 0; i < spin_count; i++ )
+    {
+        if( __atomic_load_n( &ev->state, __ATOMIC_RELAXED ) == eventSIGNALLED )
+        {
+            break;
+        }
+
+        #if defined( __x86_64__ ) || defined( __i386__ )
+            __builtin_ia32_pause();
+        #endif
+    }
+}
+
+/*
+ * Sleeps until the event is signalled or the timeout expires.  Returns false
+ * on timeout.
+ *
+ * FUTEX_WAIT is not a cancellation point, the wait is made asynchronously
+ * cancellable so vPortCancelThread() can still cancel a suspended thread.
+ * Nothing is held while the thread sleeps.
+ */
+static bool event_sleep( struct event * ev,
+                         const struct timespec * timeout )
+{
+    uint32_t expected = eventCLEAR;
+    int old_type;
+    long ret;
+
+    /* Tell the signaller a FUTEX_WAKE is needed.  Fails when the word is
+     * already eventSLEEPING (woken spuriously) or eventSIGNALLED. */
+    __atomic_compare_exchange_n( &ev->state, &expected, eventSLEEPING, false,
+                                 __ATOMIC_RELAXED, __ATOMIC_RELAXED );
+
+    if( expected == eventSIGNALLED )
+    {
+        return true;
+    }
+
+    pthread_setcanceltype( PTHREAD_CANCEL_ASYNCHRONOUS, &old_type );
+    ret = futex( &ev->state, FUTEX_WAIT, eventSLEEPING, timeout );
+    pthread_setcanceltype( old_type, NULL );
+
+    return !( ( ret == -1 ) && ( errno == ETIMEDOUT ) );
+}
+
+struct event * event_create()
+{
+    struct event * ev = malloc( sizeof( struct event ) );
+
+    if( __atomic_load_n( &spin_count, __ATOMIC_RELAXED ) < 0 )
+    {
+        __atomic_store_n( &spin_count,
+                          ( sysconf( _SC_NPROCESSORS_ONLN ) > 1 ) ? configPOSIX_FUTEX_SPIN_COUNT : 0,
+                          __ATOMIC_RELAXED );
+    }
+
+    ev->state = eventCLEAR;
+    return ev;
+}
+
+void event_delete( struct event * ev )
+{
+    free( ev );
+}
+
+bool event_wait( struct event * ev )
+{
+    event_spin( ev );
+
+    while( event_try_consume( ev ) == false )
+    {
+        event_sleep( ev, NULL );
+    }
+
+    return true;
+}
+
+bool event_wait_timed( struct event * ev,
+                       time_t ms )
+{
+    struct timespec deadline;
+    struct timespec now;
+    struct timespec timeout;
+    uint32_t expected;
+
+    clock_gettime( CLOCK_MONOTONIC, &deadline );
+    deadline.tv_sec += ms / 1000;
+    deadline.tv_nsec += ( ms % 1000 ) * 1000000;
+
+    if( deadline.tv_nsec >= 1000000000 )
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    event_spin( ev );
+
+    while( event_try_consume( ev ) == false )
+    {
+        /* FUTEX_WAIT takes a relative timeout. */
+        clock_gettime( CLOCK_MONOTONIC, &now );
+        timeout.tv_sec = deadline.tv_sec - now.tv_sec;
+        timeout.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+
+        if( timeout.tv_nsec < 0 )
+        {
+            timeout.tv_sec--;
+            timeout.tv_nsec += 1000000000;
+        }
+
+        if( ( timeout.tv_sec < 0 ) || ( event_sleep( ev, &timeout ) == false ) )
+        {
+            /* Withdraw the wakeup request, unless the event was signalled
+             * in the meantime. */
+            expected = eventSLEEPING;
+            __atomic_compare_exchange_n( &ev->state, &expected, eventCLEAR, false,
+                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED );
+            return event_try_consume( ev );
+        }
+    }
+
+    return true;
+}
+
+void event_signal( struct event * ev )
+{
+    if( __atomic_exchange_n( &ev->state, eventSIGNALLED, __ATOMIC_RELEASE ) == eventSLEEPING )
+    {
+        futex( &ev->state, FUTEX_WAKE, 1, NULL );
+    }
+}
+
+#else /* configPOSIX_FUTEX_EVENTS */
+
 struct event
 {
     pthread_mutex_t mutex;
@@ -102,3 +310,5 @@ void event_signal( struct event * ev )
     pthread_cond_signal( &ev->cond );
     pthread_mutex_unlock( &ev->mutex );
 }
+
+#endif /* configPOSIX_FUTEX_EVENTS */
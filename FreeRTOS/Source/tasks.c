@@ -86,7 +86,7 @@
 /* If any of the following are set then task stacks are filled with a known
  * value so the high water mark can be determined.  If none of the following are
  * set then don't fill the stack so there is no unnecessary dependency on memset. */
-#if ( ( configCHECK_FOR_STACK_OVERFLOW > 1 ) || ( configUSE_TRACE_FACILITY == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark2 == 1 ) )
+#if ( ( configCHECK_FOR_STACK_OVERFLOW > 1 ) || ( configUSE_TRACE_FACILITY == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark2 == 1 ) || ( configUSE_TASK_SNAPSHOTS == 1 ) )
     #define tskSET_NEW_STACKS_TO_KNOWN_VALUE    1
 #else
     #define tskSET_NEW_STACKS_TO_KNOWN_VALUE    0
@@ -115,6 +115,47 @@
     #define configIDLE_TASK_NAME    "IDLE"
 #endif
 
+#if ( configUSE_EDF_SCHEDULING == 1 )
+
+/* The ready list of configEDF_PRIORITY is kept in the order of the absolute
+ * deadlines, so its head is selected.  The other ready lists are shared in
+ * turn. */
+    #define taskSELECT_FROM_READY_LIST( uxPriority )                                                          \
+    {                                                                                                       \
+        if( ( uxPriority ) == ( UBaseType_t ) configEDF_PRIORITY )                                          \
+        {                                                                                                   \
+            pxCurrentTCB = listGET_OWNER_OF_HEAD_ENTRY( &( pxReadyTasksLists[ configEDF_PRIORITY ] ) );     \
+        }                                                                                                   \
+        else                                                                                                \
+        {                                                                                                   \
+            listGET_OWNER_OF_NEXT_ENTRY( pxCurrentTCB, &( pxReadyTasksLists[ ( uxPriority ) ] ) );          \
+        }                                                                                                   \
+    }
+
+/* A task made ready preempts the running task of a lower priority and, at
+ * configEDF_PRIORITY, the running task of a later absolute deadline, as it
+ * comes first in the ready list.  The second form also yields to a task of
+ * the priority of the running task outside configEDF_PRIORITY, where the
+ * ready list is shared in turn. */
+    #define taskPREEMPTS_CURRENT( pxTCB )                                               \
+    ( ( ( pxTCB )->uxPriority > pxCurrentTCB->uxPriority ) ||                          \
+      ( ( ( pxTCB )->uxPriority == pxCurrentTCB->uxPriority ) &&                       \
+        ( pxCurrentTCB->uxPriority == ( UBaseType_t ) configEDF_PRIORITY ) &&          \
+        ( ( pxTCB )->xEDFDeadline < pxCurrentTCB->xEDFDeadline ) ) )
+
+    #define taskPREEMPTS_OR_SHARES_CURRENT( pxTCB )                                     \
+    ( ( ( pxTCB )->uxPriority > pxCurrentTCB->uxPriority ) ||                          \
+      ( ( ( pxTCB )->uxPriority == pxCurrentTCB->uxPriority ) &&                       \
+        ( ( pxCurrentTCB->uxPriority != ( UBaseType_t ) configEDF_PRIORITY ) ||        \
+          ( ( pxTCB )->xEDFDeadline < pxCurrentTCB->xEDFDeadline ) ) ) )
+#else
+    #define taskSELECT_FROM_READY_LIST( uxPriority )    listGET_OWNER_OF_NEXT_ENTRY( pxCurrentTCB, &( pxReadyTasksLists[ ( uxPriority ) ] ) )
+    #define taskPREEMPTS_CURRENT( pxTCB )               ( ( pxTCB )->uxPriority > pxCurrentTCB->uxPriority )
+    #define taskPREEMPTS_OR_SHARES_CURRENT( pxTCB )     ( ( pxTCB )->uxPriority >= pxCurrentTCB->uxPriority )
+#endif /* configUSE_EDF_SCHEDULING */
+
+/*-----------------------------------------------------------*/
+
 #if ( configUSE_PORT_OPTIMISED_TASK_SELECTION == 0 )
 
 /* If configUSE_PORT_OPTIMISED_TASK_SELECTION is 0 then task selection is
@@ -133,6 +174,8 @@
 
 /*-----------------------------------------------------------*/
 
+    #if ( configNUMBER_OF_CORES == 1 )
+
     #define taskSELECT_HIGHEST_PRIORITY_TASK()                                \
     {                                                                         \
         UBaseType_t uxTopPriority = uxTopReadyPriority;                       \
@@ -146,10 +189,18 @@
                                                                               \
         /* listGET_OWNER_OF_NEXT_ENTRY indexes through the list, so the tasks of \
          * the  same priority get an equal share of the processor time. */                    \
-        listGET_OWNER_OF_NEXT_ENTRY( pxCurrentTCB, &( pxReadyTasksLists[ uxTopPriority ] ) ); \
+        taskSELECT_FROM_READY_LIST( uxTopPriority );                                          \
         uxTopReadyPriority = uxTopPriority;                                                   \
     } /* taskSELECT_HIGHEST_PRIORITY_TASK */
 
+    #else /* configNUMBER_OF_CORES */
+
+/* Each core selects the highest priority ready task that is not running on
+ * another core and is allowed on it. */
+    #define taskSELECT_HIGHEST_PRIORITY_TASK()    prvSelectHighestPriorityTask( portGET_CORE_ID() )
+
+    #endif /* configNUMBER_OF_CORES */
+
 /*-----------------------------------------------------------*/
 
 /* Define away taskRESET_READY_PRIORITY() and portRESET_READY_PRIORITY() as
@@ -176,7 +227,7 @@
         /* Find the highest priority list that contains ready tasks. */                         \
         portGET_HIGHEST_PRIORITY( uxTopPriority, uxTopReadyPriority );                          \
         configASSERT( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ uxTopPriority ] ) ) > 0 ); \
-        listGET_OWNER_OF_NEXT_ENTRY( pxCurrentTCB, &( pxReadyTasksLists[ uxTopPriority ] ) );   \
+        taskSELECT_FROM_READY_LIST( uxTopPriority );                                            \
     } /* taskSELECT_HIGHEST_PRIORITY_TASK() */
 
 /*-----------------------------------------------------------*/
@@ -196,9 +247,11 @@
 
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_TIMING_WHEEL == 0 )
+
 /* pxDelayedTaskList and pxOverflowDelayedTaskList are switched when the tick
  * count overflows. */
-#define taskSWITCH_DELAYED_LISTS()                                                \
+    #define taskSWITCH_DELAYED_LISTS()                                                \
     {                                                                             \
         List_t * pxTemp;                                                          \
                                                                                   \
@@ -212,17 +265,71 @@
         prvResetNextTaskUnblockTime();                                            \
     }
 
+#else /* configUSE_TIMING_WHEEL */
+
+/* The timing wheel holds the delayed tasks on both sides of the tick count
+ * overflow, so only the next unblock time has to move to the new side. */
+    #define taskSWITCH_DELAYED_LISTS()     \
+    {                                      \
+        xNumOfOverflows++;                 \
+        prvResetNextTaskUnblockTime();     \
+    }
+
+/* The slot of the timing wheel of a wake time. */
+    #define taskTIMING_WHEEL_INDEX( xTime )    ( ( xTime ) & ( TickType_t ) ( configTIMING_WHEEL_SIZE - 1 ) )
+
+/* Append a task to the slot of its wake time, keeping the earliest wake time
+ * of the slot. */
+    #define taskTIMING_WHEEL_INSERT( pxTCB, xTimeToWake )                                                       \
+    {                                                                                                           \
+        const TickType_t xIndex = taskTIMING_WHEEL_INDEX( xTimeToWake );                                        \
+                                                                                                                \
+        if( ( listLIST_IS_EMPTY( &( xDelayedTaskWheel[ xIndex ] ) ) != pdFALSE ) ||                             \
+            ( ( ( xTimeToWake ) - xTimingWheelTime ) < ( xTimingWheelSlotWake[ xIndex ] - xTimingWheelTime ) ) ) \
+        {                                                                                                       \
+            xTimingWheelSlotWake[ xIndex ] = ( xTimeToWake );                                                   \
+        }                                                                                                       \
+                                                                                                                \
+        listINSERT_END( &( xDelayedTaskWheel[ xIndex ] ), &( ( pxTCB )->xStateListItem ) );                    \
+    }
+
+/* A state list is one of the slots of the timing wheel. */
+    #define taskLIST_IS_DELAYED( pxList )     ( ( ( pxList ) >= &( xDelayedTaskWheel[ 0 ] ) ) && ( ( pxList ) < &( xDelayedTaskWheel[ configTIMING_WHEEL_SIZE ] ) ) )
+
+#endif /* configUSE_TIMING_WHEEL */
+
 /*-----------------------------------------------------------*/
 
 /*
  * Place the task represented by pxTCB into the appropriate ready list for
- * the task.  It is inserted at the end of the list.
+ * the task.  It is inserted at the end of the list, or with
+ * configUSE_EDF_SCHEDULING in the order of its absolute deadline in the list
+ * of configEDF_PRIORITY.  A task of that priority without a period, as a
+ * mutex holder inheriting it, has a deadline of 0 and goes first.
  */
-#define prvAddTaskToReadyList( pxTCB )                                                                 \
-    traceMOVED_TASK_TO_READY_STATE( pxTCB );                                                           \
-    taskRECORD_READY_PRIORITY( ( pxTCB )->uxPriority );                                                \
-    listINSERT_END( &( pxReadyTasksLists[ ( pxTCB )->uxPriority ] ), &( ( pxTCB )->xStateListItem ) ); \
-    tracePOST_MOVED_TASK_TO_READY_STATE( pxTCB )
+#if ( configUSE_EDF_SCHEDULING == 1 )
+    #define taskINSERT_READY_LIST( pxTCB )                                                                     \
+    {                                                                                                          \
+        if( ( pxTCB )->uxPriority == ( UBaseType_t ) configEDF_PRIORITY )                                      \
+        {                                                                                                      \
+            listSET_LIST_ITEM_VALUE( &( ( pxTCB )->xStateListItem ), ( pxTCB )->xEDFDeadline );                \
+            vListInsert( &( pxReadyTasksLists[ configEDF_PRIORITY ] ), &( ( pxTCB )->xStateListItem ) );       \
+        }                                                                                                      \
+        else                                                                                                   \
+        {                                                                                                      \
+            listINSERT_END( &( pxReadyTasksLists[ ( pxTCB )->uxPriority ] ), &( ( pxTCB )->xStateListItem ) ); \
+        }                                                                                                      \
+    }
+#else
+    #define taskINSERT_READY_LIST( pxTCB )    listINSERT_END( &( pxReadyTasksLists[ ( pxTCB )->uxPriority ] ), &( ( pxTCB )->xStateListItem ) )
+#endif /* configUSE_EDF_SCHEDULING */
+
+#define prvAddTaskToReadyList( pxTCB )                      \
+    traceMOVED_TASK_TO_READY_STATE( pxTCB );                \
+    taskRECORD_READY_PRIORITY( ( pxTCB )->uxPriority );     \
+    taskINSERT_READY_LIST( pxTCB );                         \
+    tracePOST_MOVED_TASK_TO_READY_STATE( pxTCB );           \
+    taskPUBLISH_READY_SNAPSHOT( pxTCB )
 /*-----------------------------------------------------------*/
 
 /*
@@ -233,6 +340,26 @@
  */
 #define prvGetTCBFromHandle( pxHandle )    ( ( ( pxHandle ) == NULL ) ? pxCurrentTCB : ( pxHandle ) )
 
+#if ( configNUMBER_OF_CORES > 1 )
+
+/* Values of the xTaskRunState member of the TCB: the core the task runs on,
+ * or taskTASK_NOT_RUNNING. */
+    #define taskTASK_NOT_RUNNING           ( ( BaseType_t ) -1 )
+    #define taskTASK_IS_RUNNING( pxTCB )    ( ( pxTCB )->xTaskRunState != taskTASK_NOT_RUNNING )
+
+    #if ( configUSE_CORE_AFFINITY == 1 )
+        #define taskCORE_ALLOWED( pxTCB, xCoreID )    ( ( ( pxTCB )->uxCoreAffinityMask & ( ( UBaseType_t ) 1U << ( UBaseType_t ) ( xCoreID ) ) ) != 0U )
+    #else
+        #define taskCORE_ALLOWED( pxTCB, xCoreID )    pdTRUE
+    #endif
+
+/* The scheduler may be suspended by a task on another core, the variable is
+ * only read under the kernel lock there. */
+    #define taskASSERT_SCHEDULER_NOT_SUSPENDED()    configASSERT( xTaskGetSchedulerState() != taskSCHEDULER_SUSPENDED )
+#else
+    #define taskASSERT_SCHEDULER_NOT_SUSPENDED()    configASSERT( uxSchedulerSuspended == 0 )
+#endif /* configNUMBER_OF_CORES */
+
 /* The item value of the event list item is normally used to hold the priority
  * of the task to which it belongs (coded to allow it to be held in reverse
  * priority order).  However, it is occasionally borrowed for other purposes.  It
@@ -328,25 +455,97 @@ typedef struct tskTaskControlBlock       /* The old naming convention is used to
     #if ( configUSE_POSIX_ERRNO == 1 )
         int iTaskErrno;
     #endif
+
+    #if ( configNUMBER_OF_CORES > 1 )
+        volatile BaseType_t xTaskRunState; /*< The core the task is running on, or taskTASK_NOT_RUNNING. */
+        BaseType_t xIsIdle;                /*< Set to pdTRUE for the idle tasks, which any task preempts. */
+
+        #if ( configUSE_CORE_AFFINITY == 1 )
+            UBaseType_t uxCoreAffinityMask; /*< Bit n is set if the task may run on core n. */
+        #endif
+    #endif
+
+    #if ( configUSE_EDF_SCHEDULING == 1 )
+        TickType_t xEDFPeriod;            /*< The period of an EDF task, 0 for the other tasks. */
+        TickType_t xEDFRelativeDeadline;  /*< The deadline of each job from its release. */
+        TickType_t xEDFRelease;           /*< The release time of the current job. */
+        TickType_t xEDFDeadline;          /*< The absolute deadline of the current job, the key of the EDF ready list. */
+        UBaseType_t uxEDFDeadlineMisses;  /*< The jobs completed after their deadline. */
+    #endif
+
+    #if ( configUSE_ADMISSION_CONTROL == 1 )
+        TickType_t xContractPeriod;                          /*< The period of the timing contract of the task, 0 if it has none. */
+        TickType_t xContractWCET;                            /*< The worst case execution time of a job, raised by a longer job measured. */
+        TickType_t xContractDeadline;                        /*< The deadline of a job from its release. */
+        struct tskTaskControlBlock * pxNextContract;         /*< The next task of the list of tasks with a timing contract. */
+        uint64_t ullJobStartNs;                              /*< The CPU time of the task at the start of the current job, 0 if not known. */
+        uint64_t ullLongestJobNs;                            /*< The longest job measured. */
+        UBaseType_t uxContractOverruns;                      /*< The jobs measured longer than the WCET of the contract. */
+    #endif
+
+    #if ( configUSE_TASK_BUDGETS == 1 )
+        TickType_t xBudget;                          /*< The ticks the task may run per replenishment period, 0 if it has no budget. */
+        TickType_t xBudgetPeriod;                    /*< The replenishment period in ticks. */
+        TickType_t xBudgetRemaining;                 /*< The ticks left in the current period. */
+        TickType_t xBudgetPeriodStart;               /*< The tick the current period started at. */
+        UBaseType_t uxBudgetPriority;                /*< The priority to restore after a demotion. */
+        UBaseType_t uxBudgetOverruns;                /*< The periods in which the task ran past its budget. */
+        struct tskTaskControlBlock * pxNextBudget;   /*< The next task of the list of tasks with a budget. */
+        uint8_t ucBudgetAction;                      /*< The eBudgetAction taken on an overrun. */
+        uint8_t ucBudgetState;                       /*< One of the taskBUDGET_ values. */
+    #endif
+
+    #if ( configUSE_TASK_SNAPSHOTS == 1 )
+        struct tskTaskSnapshotSlot * pxSnapshotSlot; /*< The slot the task is published to, NULL if every slot was taken. */
+    #endif
 } tskTCB;
 
 /* The old tskTCB name is maintained above then typedefed to the new TCB_t name
  * below to enable the use of older kernel aware debuggers. */
 typedef tskTCB TCB_t;
 
+/* Values of the ucBudgetState member of the TCB.  A task that overran its
+ * budget while holding a mutex stays taskBUDGET_EXHAUSTED until it is
+ * throttled. */
+#define taskBUDGET_AVAILABLE    ( ( uint8_t ) 0 )
+#define taskBUDGET_EXHAUSTED    ( ( uint8_t ) 1 )
+#define taskBUDGET_DEMOTED      ( ( uint8_t ) 2 )
+#define taskBUDGET_SUSPENDED    ( ( uint8_t ) 3 )
+
+/* The execution time of the jobs of a task with a timing contract is
+ * measured with the CPU time clock of the task, when the port has one. */
+#if ( configUSE_ADMISSION_CONTROL == 1 ) && defined( portGET_TASK_CPU_TIME_NS )
+    #define taskMEASURE_JOBS    1
+#else
+    #define taskMEASURE_JOBS    0
+#endif
+
 /*lint -save -e956 A manual analysis and inspection has been used to determine
  * which static variables must be declared volatile. */
-PRIVILEGED_DATA TCB_t * volatile pxCurrentTCB = NULL;
+#if ( configNUMBER_OF_CORES == 1 )
+    PRIVILEGED_DATA TCB_t * volatile pxCurrentTCB = NULL;
+#else
+    PRIVILEGED_DATA TCB_t * volatile pxCurrentTCBs[ configNUMBER_OF_CORES ]; /*< The task running on each core. */
+
+/* The task running on the calling core. */
+    #define pxCurrentTCB    xTaskGetCurrentTaskHandle()
+#endif
 
 /* Lists for ready and blocked tasks. --------------------
  * xDelayedTaskList1 and xDelayedTaskList2 could be moved to function scope but
  * doing so breaks some kernel aware debuggers and debuggers that rely on removing
  * the static qualifier. */
 PRIVILEGED_DATA static List_t pxReadyTasksLists[ configMAX_PRIORITIES ]; /*< Prioritised ready tasks. */
-PRIVILEGED_DATA static List_t xDelayedTaskList1;                         /*< Delayed tasks. */
-PRIVILEGED_DATA static List_t xDelayedTaskList2;                         /*< Delayed tasks (two lists are used - one for delays that have overflowed the current tick count. */
-PRIVILEGED_DATA static List_t * volatile pxDelayedTaskList;              /*< Points to the delayed task list currently being used. */
-PRIVILEGED_DATA static List_t * volatile pxOverflowDelayedTaskList;      /*< Points to the delayed task list currently being used to hold tasks that have overflowed the current tick count. */
+#if ( configUSE_TIMING_WHEEL == 0 )
+    PRIVILEGED_DATA static List_t xDelayedTaskList1;                     /*< Delayed tasks. */
+    PRIVILEGED_DATA static List_t xDelayedTaskList2;                     /*< Delayed tasks (two lists are used - one for delays that have overflowed the current tick count. */
+    PRIVILEGED_DATA static List_t * volatile pxDelayedTaskList;          /*< Points to the delayed task list currently being used. */
+    PRIVILEGED_DATA static List_t * volatile pxOverflowDelayedTaskList;  /*< Points to the delayed task list currently being used to hold tasks that have overflowed the current tick count. */
+#else
+    PRIVILEGED_DATA static List_t xDelayedTaskWheel[ configTIMING_WHEEL_SIZE ]; /*< Delayed tasks, unsorted, in the slot of their wake time modulo configTIMING_WHEEL_SIZE. */
+    PRIVILEGED_DATA static TickType_t xTimingWheelTime;                         /*< The tick count up to which the slots of the wheel have been processed. */
+    PRIVILEGED_DATA static TickType_t xTimingWheelSlotWake[ configTIMING_WHEEL_SIZE ]; /*< Earliest wake time of the tasks of each slot, or earlier if that task left the slot before its wake time. */
+#endif
 PRIVILEGED_DATA static List_t xPendingReadyList;                         /*< Tasks that have been readied while the scheduler was suspended.  They will be moved to the ready list when the scheduler is resumed. */
 
 #if ( INCLUDE_vTaskDelete == 1 )
@@ -374,7 +573,12 @@ PRIVILEGED_DATA static volatile TickType_t xTickCount = ( TickType_t ) configINI
 PRIVILEGED_DATA static volatile UBaseType_t uxTopReadyPriority = tskIDLE_PRIORITY;
 PRIVILEGED_DATA static volatile BaseType_t xSchedulerRunning = pdFALSE;
 PRIVILEGED_DATA static volatile TickType_t xPendedTicks = ( TickType_t ) 0U;
-PRIVILEGED_DATA static volatile BaseType_t xYieldPending = pdFALSE;
+#if ( configNUMBER_OF_CORES == 1 )
+    PRIVILEGED_DATA static volatile BaseType_t xYieldPending = pdFALSE;
+#else
+    PRIVILEGED_DATA static volatile BaseType_t xYieldPendings[ configNUMBER_OF_CORES ]; /*< A switch is pending on each core. */
+    #define xYieldPending    xYieldPendings[ portGET_CORE_ID() ]
+#endif
 PRIVILEGED_DATA static volatile BaseType_t xNumOfOverflows = ( BaseType_t ) 0;
 PRIVILEGED_DATA static UBaseType_t uxTaskNumber = ( UBaseType_t ) 0U;
 PRIVILEGED_DATA static volatile TickType_t xNextTaskUnblockTime = ( TickType_t ) 0U; /* Initialised to portMAX_DELAY before the scheduler starts. */
@@ -399,11 +603,72 @@ PRIVILEGED_DATA static volatile UBaseType_t uxSchedulerSuspended = ( UBaseType_t
 
 /* Do not move these variables to function scope as doing so prevents the
  * code working with debuggers that need to remove the static qualifier. */
-    PRIVILEGED_DATA static configRUN_TIME_COUNTER_TYPE ulTaskSwitchedInTime = 0UL;    /*< Holds the value of a timer/counter the last time a task was switched in. */
+    #if ( configNUMBER_OF_CORES == 1 )
+        PRIVILEGED_DATA static configRUN_TIME_COUNTER_TYPE ulTaskSwitchedInTime = 0UL; /*< Holds the value of a timer/counter the last time a task was switched in. */
+    #else
+        PRIVILEGED_DATA static configRUN_TIME_COUNTER_TYPE ulTaskSwitchedInTimes[ configNUMBER_OF_CORES ];
+        #define ulTaskSwitchedInTime    ulTaskSwitchedInTimes[ portGET_CORE_ID() ]
+    #endif
     PRIVILEGED_DATA static volatile configRUN_TIME_COUNTER_TYPE ulTotalRunTime = 0UL; /*< Holds the total amount of execution time as defined by the run time counter clock. */
 
 #endif
 
+#if ( configUSE_ADMISSION_CONTROL == 1 )
+
+/* The tasks with a timing contract, linked through pxNextContract.  Only
+ * accessed with the scheduler suspended. */
+    PRIVILEGED_DATA static TCB_t * pxTimingContracts = NULL;
+
+#endif
+
+#if ( configUSE_TASK_BUDGETS == 1 )
+
+/* The tasks with a budget, linked through pxNextBudget.  Walked by the tick,
+ * so only changed in a critical section. */
+    PRIVILEGED_DATA static TCB_t * pxBudgetedTasks = NULL;
+
+#endif
+
+#if ( configUSE_TASK_SNAPSHOTS == 1 )
+
+/* A task published for uxTaskGetSnapshot().  uxSequence is odd while the
+ * kernel writes xSnapshot, which it only does in a critical section or in
+ * vTaskSwitchContext().  Readers copy xSnapshot without any lock and copy it
+ * again if uxSequence was odd or changed.  A free slot has a NULL
+ * xSnapshot.xHandle. */
+    typedef struct tskTaskSnapshotSlot
+    {
+        volatile UBaseType_t uxSequence;
+        TaskSnapshot_t xSnapshot;
+        uint32_t ulStackFreeBytes;    /*< The fill bytes left at the end of the stack as of the last complete scan. */
+        uint32_t ulStackScannedBytes; /*< The fill bytes found so far by the scan in progress. */
+    } TaskSnapshotSlot_t;
+
+    PRIVILEGED_DATA static TaskSnapshotSlot_t xTaskSnapshots[ configTASK_SNAPSHOT_SLOTS ];
+
+/* The slot whose stack the idle task scans. */
+    PRIVILEGED_DATA static UBaseType_t uxSnapshotScanSlot = ( UBaseType_t ) 0U;
+
+/* The tasks left without a slot, as every slot was taken when they were
+ * created. */
+    PRIVILEGED_DATA static volatile UBaseType_t uxTasksWithoutSnapshot = ( UBaseType_t ) 0U;
+
+/* Whether pxTCB is running, for the state it is published in. */
+    #if ( configNUMBER_OF_CORES == 1 )
+        #define taskSNAPSHOT_IS_RUNNING( pxTCB )    ( ( pxTCB ) == pxCurrentTCB )
+    #else
+        #define taskSNAPSHOT_IS_RUNNING( pxTCB )    taskTASK_IS_RUNNING( pxTCB )
+    #endif
+
+/* Publish a task whose state or priority changed, and a task just added to
+ * a ready list.  Both in a critical section. */
+    #define taskPUBLISH_SNAPSHOT( pxTCB )          prvPublishTaskSnapshot( ( pxTCB ), taskSNAPSHOT_IS_RUNNING( pxTCB ) ? eRunning : prvGetTaskStateFromLists( pxTCB ) )
+    #define taskPUBLISH_READY_SNAPSHOT( pxTCB )    prvPublishTaskSnapshot( ( pxTCB ), taskSNAPSHOT_IS_RUNNING( pxTCB ) ? eRunning : eReady )
+#else
+    #define taskPUBLISH_SNAPSHOT( pxTCB )
+    #define taskPUBLISH_READY_SNAPSHOT( pxTCB )
+#endif
+
 /*lint -restore */
 
 /*-----------------------------------------------------------*/
@@ -440,6 +705,36 @@ static void prvInitialiseTaskLists( void ) PRIVILEGED_FUNCTION;
  */
 static portTASK_FUNCTION_PROTO( prvIdleTask, pvParameters ) PRIVILEGED_FUNCTION;
 
+#if ( configNUMBER_OF_CORES > 1 )
+
+/*
+ * The idle task of the cores other than the first.  It neither frees deleted
+ * tasks nor suppresses ticks, these are left to the idle task of core 0.
+ */
+    static portTASK_FUNCTION_PROTO( prvPassiveIdleTask, pvParameters ) PRIVILEGED_FUNCTION;
+
+/*
+ * Sets the current TCB of a core to the highest priority ready task that is
+ * not running on another core and is allowed on the core.  Called with the
+ * kernel lock held.
+ */
+    static void prvSelectHighestPriorityTask( BaseType_t xCoreID ) PRIVILEGED_FUNCTION;
+
+/*
+ * Requests a switch on a core.  Returns pdTRUE if the core is the calling
+ * one, in which case the caller yields as the single core kernel would.
+ */
+    static BaseType_t prvYieldCore( BaseType_t xCoreID ) PRIVILEGED_FUNCTION;
+
+/*
+ * Called when pxTCB has been added to a ready list: requests a switch on the
+ * core running the lowest priority task, if pxTCB preempts it.  Returns
+ * pdTRUE if that core is the calling one.
+ */
+    static BaseType_t prvYieldForTask( const TCB_t * pxTCB ) PRIVILEGED_FUNCTION;
+
+#endif /* configNUMBER_OF_CORES */
+
 /*
  * Utility to free all memory allocated by the scheduler to hold a TCB,
  * including the stack pointed to by the TCB.
@@ -453,6 +748,127 @@ static portTASK_FUNCTION_PROTO( prvIdleTask, pvParameters ) PRIVILEGED_FUNCTION;
 
 #endif
 
+#if ( configUSE_EDF_SCHEDULING == 1 )
+
+/*
+ * Make pxTCB an EDF task of the given period and relative deadline, its
+ * first job released now.
+ */
+    static void prvSetEDFPeriod( TCB_t * pxTCB,
+                                 TickType_t xPeriod,
+                                 TickType_t xRelativeDeadline ) PRIVILEGED_FUNCTION;
+
+#endif
+
+#if ( configUSE_ADMISSION_CONTROL == 1 )
+
+/*
+ * Give pxTCB the timing contract pointed to by pxContract, or remove its
+ * contract if pxContract is NULL, then run the admission test.  A contract
+ * that fails it is undone, or only reported with
+ * configADMISSION_CONTROL_REJECTS set to 0.  Called with the scheduler
+ * suspended.
+ */
+    static BaseType_t prvAdmitTimingContract( TCB_t * pxTCB,
+                                              const TaskTimingContract_t * const pxContract ) PRIVILEGED_FUNCTION;
+
+/*
+ * The admission test of the tasks with a timing contract, see
+ * xTaskCheckSchedulability().  Called with the scheduler suspended.
+ */
+    static BaseType_t prvTimingContractsSchedulable( void ) PRIVILEGED_FUNCTION;
+
+#endif
+
+#if ( configUSE_TASK_BUDGETS == 1 )
+
+/*
+ * Charge the tick to the running tasks with a budget, throttle the ones that
+ * ran past it and replenish the budgets whose period ended.  Called by the
+ * tick with the scheduler not suspended.  Returns pdTRUE if the calling core
+ * must switch.
+ */
+    static BaseType_t prvProcessBudgets( const TickType_t xConstTickCount ) PRIVILEGED_FUNCTION;
+
+/*
+ * Demote or suspend pxTCB until its budget is replenished, if it is ready
+ * and holds no mutex.  Returns pdTRUE if the calling core must switch.
+ */
+    static BaseType_t prvThrottleTask( TCB_t * pxTCB ) PRIVILEGED_FUNCTION;
+
+/*
+ * Undo prvThrottleTask() when the budget of pxTCB is replenished or removed.
+ * Returns pdTRUE if the calling core must switch.
+ */
+    static BaseType_t prvReleaseThrottledTask( TCB_t * pxTCB ) PRIVILEGED_FUNCTION;
+
+/*
+ * Take pxTCB, which has a budget, out of the list of tasks with a budget.
+ * Called in a critical section.
+ */
+    static void prvRemoveBudget( TCB_t * pxTCB ) PRIVILEGED_FUNCTION;
+
+#endif
+
+#if ( ( INCLUDE_eTaskGetState == 1 ) || ( configUSE_TRACE_FACILITY == 1 ) || ( INCLUDE_xTaskAbortDelay == 1 ) || ( configUSE_TASK_SNAPSHOTS == 1 ) )
+
+/*
+ * The state of pxTCB, which is not running, from the list it is referenced
+ * from.  Called in a critical section.
+ */
+    static eTaskState prvGetTaskStateFromLists( const TCB_t * pxTCB ) PRIVILEGED_FUNCTION;
+
+#endif
+
+#if ( configUSE_TASK_SNAPSHOTS == 1 )
+
+/*
+ * Give pxTCB a free snapshot slot, if any, and publish it.  Called in a
+ * critical section.
+ */
+    static void prvClaimTaskSnapshot( TCB_t * pxTCB ) PRIVILEGED_FUNCTION;
+
+/*
+ * Free the snapshot slot of pxTCB.  Called in a critical section.
+ */
+    static void prvReleaseTaskSnapshot( TCB_t * pxTCB ) PRIVILEGED_FUNCTION;
+
+/*
+ * Write the fields of pxSlot that change while the task lives.  Only called
+ * between the two increments of the sequence of the slot.
+ */
+    static void prvWriteTaskSnapshot( TaskSnapshotSlot_t * pxSlot,
+                                      const TCB_t * pxTCB,
+                                      eTaskState eState ) PRIVILEGED_FUNCTION;
+
+/*
+ * Publish pxTCB in state eState, if it has a snapshot slot.  Called in a
+ * critical section or by vTaskSwitchContext().
+ */
+    static void prvPublishTaskSnapshot( const TCB_t * pxTCB,
+                                        eTaskState eState ) PRIVILEGED_FUNCTION;
+
+/*
+ * Used only by the idle task.  Scan the next configTASK_SNAPSHOT_SCAN_BYTES
+ * of the stack of one task for its high water mark, and republish the task
+ * once its scan is complete.
+ */
+    static void prvUpdateTaskSnapshots( void ) PRIVILEGED_FUNCTION;
+
+#endif
+
+#if ( taskMEASURE_JOBS == 1 )
+
+/*
+ * Called by the running task at the end of a job: a job longer than the
+ * execution time estimate of its timing contract raises the estimate, is
+ * counted, and runs the admission test again.  Called with the scheduler
+ * suspended.
+ */
+    static void prvMeasureJob( TCB_t * pxTCB ) PRIVILEGED_FUNCTION;
+
+#endif
+
 /*
  * Used only by the idle task.  This checks to see if anything has been placed
  * in the list of tasks waiting to be deleted.  If so the task is cleaned up
@@ -526,6 +942,17 @@ static void prvAddCurrentTaskToDelayedList( TickType_t xTicksToWait,
  */
 static void prvResetNextTaskUnblockTime( void ) PRIVILEGED_FUNCTION;
 
+#if ( configUSE_TIMING_WHEEL == 1 )
+
+/*
+ * Unblock the tasks of the timing wheel whose wake time is between the last
+ * tick processed and xConstTickCount.  Returns pdTRUE if one of them should
+ * run now.
+ */
+    static BaseType_t prvProcessTimingWheel( const TickType_t xConstTickCount ) PRIVILEGED_FUNCTION;
+
+#endif
+
 #if ( ( configUSE_TRACE_FACILITY == 1 ) && ( configUSE_STATS_FORMATTING_FUNCTIONS > 0 ) )
 
 /*
@@ -556,6 +983,22 @@ static void prvInitialiseNewTask( TaskFunction_t pxTaskCode,
  */
 static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB ) PRIVILEGED_FUNCTION;
 
+#if ( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+
+/*
+ * Allocate and initialise a task for xTaskCreate() and xTaskCreateEDF(),
+ * without adding it to the ready lists.  Returns NULL if the memory could not
+ * be allocated.
+ */
+    static TCB_t * prvCreateTask( TaskFunction_t pxTaskCode,
+                                  const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+                                  const configSTACK_DEPTH_TYPE usStackDepth,
+                                  void * const pvParameters,
+                                  UBaseType_t uxPriority,
+                                  TaskHandle_t * const pxCreatedTask ) PRIVILEGED_FUNCTION;
+
+#endif
+
 /*
  * freertos_tasks_c_additions_init() should only be called if the user definable
  * macro FREERTOS_TASKS_C_ADDITIONS_INIT() is defined, as that is the only macro
@@ -724,15 +1167,14 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB ) PRIVILEGED_FUNCTION;
 
 #if ( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
 
-    BaseType_t xTaskCreate( TaskFunction_t pxTaskCode,
-                            const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
-                            const configSTACK_DEPTH_TYPE usStackDepth,
-                            void * const pvParameters,
-                            UBaseType_t uxPriority,
-                            TaskHandle_t * const pxCreatedTask )
+    static TCB_t * prvCreateTask( TaskFunction_t pxTaskCode,
+                                  const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+                                  const configSTACK_DEPTH_TYPE usStackDepth,
+                                  void * const pvParameters,
+                                  UBaseType_t uxPriority,
+                                  TaskHandle_t * const pxCreatedTask )
     {
         TCB_t * pxNewTCB;
-        BaseType_t xReturn;
 
         /* If the stack grows down then allocate the stack then the TCB so the stack
          * does not grow into the TCB.  Likewise if the stack grows up then allocate
@@ -801,6 +1243,26 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB ) PRIVILEGED_FUNCTION;
             #endif /* tskSTATIC_AND_DYNAMIC_ALLOCATION_POSSIBLE */
 
             prvInitialiseNewTask( pxTaskCode, pcName, ( uint32_t ) usStackDepth, pvParameters, uxPriority, pxCreatedTask, pxNewTCB, NULL );
+        }
+
+        return pxNewTCB;
+    }
+/*-----------------------------------------------------------*/
+
+    BaseType_t xTaskCreate( TaskFunction_t pxTaskCode,
+                            const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+                            const configSTACK_DEPTH_TYPE usStackDepth,
+                            void * const pvParameters,
+                            UBaseType_t uxPriority,
+                            TaskHandle_t * const pxCreatedTask )
+    {
+        TCB_t * pxNewTCB;
+        BaseType_t xReturn;
+
+        pxNewTCB = prvCreateTask( pxTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pxCreatedTask );
+
+        if( pxNewTCB != NULL )
+        {
             prvAddNewTaskToReadyList( pxNewTCB );
             xReturn = pdPASS;
         }
@@ -811,6 +1273,102 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB ) PRIVILEGED_FUNCTION;
 
         return xReturn;
     }
+/*-----------------------------------------------------------*/
+
+    #if ( configUSE_EDF_SCHEDULING == 1 )
+
+        BaseType_t xTaskCreateEDF( TaskFunction_t pxTaskCode,
+                                   const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+                                   const configSTACK_DEPTH_TYPE usStackDepth,
+                                   void * const pvParameters,
+                                   TickType_t xPeriod,
+                                   TickType_t xRelativeDeadline,
+                                   TaskHandle_t * const pxCreatedTask )
+        {
+            TCB_t * pxNewTCB;
+            BaseType_t xReturn;
+
+            pxNewTCB = prvCreateTask( pxTaskCode, pcName, usStackDepth, pvParameters, configEDF_PRIORITY, pxCreatedTask );
+
+            if( pxNewTCB != NULL )
+            {
+                prvSetEDFPeriod( pxNewTCB, xPeriod, xRelativeDeadline );
+                prvAddNewTaskToReadyList( pxNewTCB );
+                xReturn = pdPASS;
+            }
+            else
+            {
+                xReturn = errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+            }
+
+            return xReturn;
+        }
+
+    #endif /* configUSE_EDF_SCHEDULING */
+/*-----------------------------------------------------------*/
+
+    #if ( ( configUSE_ADMISSION_CONTROL == 1 ) && ( INCLUDE_vTaskDelete == 1 ) )
+
+        BaseType_t xTaskCreateWithContract( TaskFunction_t pxTaskCode,
+                                            const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+                                            const configSTACK_DEPTH_TYPE usStackDepth,
+                                            void * const pvParameters,
+                                            UBaseType_t uxPriority,
+                                            const TaskTimingContract_t * const pxContract,
+                                            TaskHandle_t * const pxCreatedTask )
+        {
+            TCB_t * pxNewTCB;
+            BaseType_t xReturn;
+
+            configASSERT( pxContract != NULL );
+
+            pxNewTCB = prvCreateTask( pxTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pxCreatedTask );
+
+            if( pxNewTCB != NULL )
+            {
+                #if ( configUSE_EDF_SCHEDULING == 1 )
+                    {
+                        if( uxPriority == ( UBaseType_t ) configEDF_PRIORITY )
+                        {
+                            prvSetEDFPeriod( pxNewTCB, pxContract->xPeriod, pxContract->xDeadline );
+                        }
+                        else
+                        {
+                            mtCOVERAGE_TEST_MARKER();
+                        }
+                    }
+                #endif
+
+                vTaskSuspendAll();
+                {
+                    xReturn = prvAdmitTimingContract( pxNewTCB, pxContract );
+                }
+                ( void ) xTaskResumeAll();
+
+                if( xReturn == pdPASS )
+                {
+                    prvAddNewTaskToReadyList( pxNewTCB );
+                }
+                else
+                {
+                    /* The task never ran, it is freed here. */
+                    prvDeleteTCB( pxNewTCB );
+
+                    if( pxCreatedTask != NULL )
+                    {
+                        *pxCreatedTask = NULL;
+                    }
+                }
+            }
+            else
+            {
+                xReturn = errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+            }
+
+            return xReturn;
+        }
+
+    #endif /* ( configUSE_ADMISSION_CONTROL == 1 ) && ( INCLUDE_vTaskDelete == 1 ) */
 
 #endif /* configSUPPORT_DYNAMIC_ALLOCATION */
 /*-----------------------------------------------------------*/
@@ -1001,20 +1559,75 @@ static void prvInitialiseNewTask( TaskFunction_t pxTaskCode,
         }
     #endif
 
-    /* Initialize the TCB stack to look as if the task was already running,
-     * but had been interrupted by the scheduler.  The return address is set
-     * to the start of the task function. Once the stack has been initialised
-     * the top of stack variable is updated. */
-    #if ( portUSING_MPU_WRAPPERS == 1 )
+    #if ( configUSE_EDF_SCHEDULING == 1 )
         {
-            /* If the port has capability to detect stack overflow,
-             * pass the stack end address to the stack initialization
-             * function as well. */
-            #if ( portHAS_STACK_OVERFLOW_CHECKING == 1 )
-                {
-                    #if ( portSTACK_GROWTH < 0 )
-                        {
-                            pxNewTCB->pxTopOfStack = pxPortInitialiseStack( pxTopOfStack, pxNewTCB->pxStack, pxTaskCode, pvParameters, xRunPrivileged );
+            pxNewTCB->xEDFPeriod = ( TickType_t ) 0;
+            pxNewTCB->xEDFRelativeDeadline = ( TickType_t ) 0;
+            pxNewTCB->xEDFRelease = ( TickType_t ) 0;
+            pxNewTCB->xEDFDeadline = ( TickType_t ) 0;
+            pxNewTCB->uxEDFDeadlineMisses = ( UBaseType_t ) 0U;
+        }
+    #endif
+
+    #if ( configUSE_ADMISSION_CONTROL == 1 )
+        {
+            pxNewTCB->xContractPeriod = ( TickType_t ) 0;
+            pxNewTCB->xContractWCET = ( TickType_t ) 0;
+            pxNewTCB->xContractDeadline = ( TickType_t ) 0;
+            pxNewTCB->pxNextContract = NULL;
+            pxNewTCB->ullJobStartNs = ( uint64_t ) 0;
+            pxNewTCB->ullLongestJobNs = ( uint64_t ) 0;
+            pxNewTCB->uxContractOverruns = ( UBaseType_t ) 0U;
+        }
+    #endif
+
+    #if ( configUSE_TASK_BUDGETS == 1 )
+        {
+            pxNewTCB->xBudget = ( TickType_t ) 0;
+            pxNewTCB->xBudgetPeriod = ( TickType_t ) 0;
+            pxNewTCB->xBudgetRemaining = ( TickType_t ) 0;
+            pxNewTCB->xBudgetPeriodStart = ( TickType_t ) 0;
+            pxNewTCB->uxBudgetPriority = ( UBaseType_t ) 0U;
+            pxNewTCB->uxBudgetOverruns = ( UBaseType_t ) 0U;
+            pxNewTCB->pxNextBudget = NULL;
+            pxNewTCB->ucBudgetAction = ( uint8_t ) eBudgetDemote;
+            pxNewTCB->ucBudgetState = taskBUDGET_AVAILABLE;
+        }
+    #endif
+
+    #if ( configUSE_TASK_SNAPSHOTS == 1 )
+        {
+            pxNewTCB->pxSnapshotSlot = NULL;
+        }
+    #endif
+
+    #if ( configNUMBER_OF_CORES > 1 )
+        {
+            pxNewTCB->xTaskRunState = taskTASK_NOT_RUNNING;
+            pxNewTCB->xIsIdle = pdFALSE;
+
+            #if ( configUSE_CORE_AFFINITY == 1 )
+                {
+                    pxNewTCB->uxCoreAffinityMask = tskNO_AFFINITY;
+                }
+            #endif
+        }
+    #endif
+
+    /* Initialize the TCB stack to look as if the task was already running,
+     * but had been interrupted by the scheduler.  The return address is set
+     * to the start of the task function. Once the stack has been initialised
+     * the top of stack variable is updated. */
+    #if ( portUSING_MPU_WRAPPERS == 1 )
+        {
+            /* If the port has capability to detect stack overflow,
+             * pass the stack end address to the stack initialization
+             * function as well. */
+            #if ( portHAS_STACK_OVERFLOW_CHECKING == 1 )
+                {
+                    #if ( portSTACK_GROWTH < 0 )
+                        {
+                            pxNewTCB->pxTopOfStack = pxPortInitialiseStack( pxTopOfStack, pxNewTCB->pxStack, pxTaskCode, pvParameters, xRunPrivileged );
                         }
                     #else /* portSTACK_GROWTH */
                         {
@@ -1066,6 +1679,8 @@ static void prvInitialiseNewTask( TaskFunction_t pxTaskCode,
 }
 /*-----------------------------------------------------------*/
 
+#if ( configNUMBER_OF_CORES == 1 )
+
 static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
 {
     /* Ensure interrupts don't access the task lists while the lists are being
@@ -1124,6 +1739,12 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
         #endif /* configUSE_TRACE_FACILITY */
         traceTASK_CREATE( pxNewTCB );
 
+        #if ( configUSE_TASK_SNAPSHOTS == 1 )
+            {
+                prvClaimTaskSnapshot( pxNewTCB );
+            }
+        #endif
+
         prvAddTaskToReadyList( pxNewTCB );
 
         portSETUP_TCB( pxNewTCB );
@@ -1134,7 +1755,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
     {
         /* If the created task is of a higher priority than the current task
          * then it should run now. */
-        if( pxCurrentTCB->uxPriority < pxNewTCB->uxPriority )
+        if( taskPREEMPTS_CURRENT( pxNewTCB ) )
         {
             taskYIELD_IF_USING_PREEMPTION();
         }
@@ -1148,6 +1769,62 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
         mtCOVERAGE_TEST_MARKER();
     }
 }
+
+#else /* configNUMBER_OF_CORES */
+
+static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
+{
+    taskENTER_CRITICAL();
+    {
+        uxCurrentNumberOfTasks++;
+
+        if( uxCurrentNumberOfTasks == ( UBaseType_t ) 1 )
+        {
+            /* This is the first task to be created so do the preliminary
+             * initialisation required. */
+            prvInitialiseTaskLists();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        uxTaskNumber++;
+
+        #if ( configUSE_TRACE_FACILITY == 1 )
+            {
+                /* Add a counter into the TCB for tracing only. */
+                pxNewTCB->uxTCBNumber = uxTaskNumber;
+            }
+        #endif /* configUSE_TRACE_FACILITY */
+        traceTASK_CREATE( pxNewTCB );
+
+        #if ( configUSE_TASK_SNAPSHOTS == 1 )
+            {
+                prvClaimTaskSnapshot( pxNewTCB );
+            }
+        #endif
+
+        prvAddTaskToReadyList( pxNewTCB );
+
+        portSETUP_TCB( pxNewTCB );
+
+        /* The current tasks are selected per core when the scheduler starts.
+         * Once it runs, the new task preempts the lowest priority task of the
+         * cores it is allowed on. */
+        if( prvYieldForTask( pxNewTCB ) != pdFALSE )
+        {
+            taskYIELD_IF_USING_PREEMPTION();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+#endif /* configNUMBER_OF_CORES */
 /*-----------------------------------------------------------*/
 
 #if ( INCLUDE_vTaskDelete == 1 )
@@ -1155,6 +1832,19 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
     void vTaskDelete( TaskHandle_t xTaskToDelete )
     {
         TCB_t * pxTCB;
+        BaseType_t xTaskIsRunning;
+
+        #if ( configUSE_ADMISSION_CONTROL == 1 )
+            {
+                /* The contract of the task no longer counts in the admission
+                 * test. */
+                vTaskSuspendAll();
+                {
+                    ( void ) prvAdmitTimingContract( prvGetTCBFromHandle( xTaskToDelete ), NULL );
+                }
+                ( void ) xTaskResumeAll();
+            }
+        #endif
 
         taskENTER_CRITICAL();
         {
@@ -1162,6 +1852,25 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
              * being deleted. */
             pxTCB = prvGetTCBFromHandle( xTaskToDelete );
 
+            #if ( configUSE_TASK_BUDGETS == 1 )
+                {
+                    if( pxTCB->xBudget > ( TickType_t ) 0 )
+                    {
+                        prvRemoveBudget( pxTCB );
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+            #endif
+
+            #if ( configUSE_TASK_SNAPSHOTS == 1 )
+                {
+                    prvReleaseTaskSnapshot( pxTCB );
+                }
+            #endif
+
             /* Remove task from the ready/delayed list. */
             if( uxListRemove( &( pxTCB->xStateListItem ) ) == ( UBaseType_t ) 0 )
             {
@@ -1188,7 +1897,13 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
              * not return. */
             uxTaskNumber++;
 
-            if( pxTCB == pxCurrentTCB )
+            #if ( configNUMBER_OF_CORES == 1 )
+                xTaskIsRunning = ( pxTCB == pxCurrentTCB ) ? pdTRUE : pdFALSE;
+            #else
+                xTaskIsRunning = taskTASK_IS_RUNNING( pxTCB );
+            #endif
+
+            if( xTaskIsRunning != pdFALSE )
             {
                 /* A task is deleting itself.  This cannot complete within the
                  * task itself, as a context switch to another task is required.
@@ -1212,6 +1927,23 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
                  * hence xYieldPending is used to latch that a context switch is
                  * required. */
                 portPRE_TASK_DELETE_HOOK( pxTCB, &xYieldPending );
+
+                #if ( configNUMBER_OF_CORES > 1 )
+                    {
+                        /* The task is deleted while running on another core,
+                         * which switches it out when the kernel lock is
+                         * released.  The idle task frees it once it is no
+                         * longer running. */
+                        if( pxTCB->xTaskRunState != portGET_CORE_ID() )
+                        {
+                            ( void ) prvYieldCore( pxTCB->xTaskRunState );
+                        }
+                        else
+                        {
+                            mtCOVERAGE_TEST_MARKER();
+                        }
+                    }
+                #endif
             }
             else
             {
@@ -1232,104 +1964,912 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
         {
             if( pxTCB == pxCurrentTCB )
             {
-                configASSERT( uxSchedulerSuspended == 0 );
-                portYIELD_WITHIN_API();
+                taskASSERT_SCHEDULER_NOT_SUSPENDED();
+                portYIELD_WITHIN_API();
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+    }
+
+#endif /* INCLUDE_vTaskDelete */
+/*-----------------------------------------------------------*/
+
+#if ( INCLUDE_xTaskDelayUntil == 1 )
+
+    BaseType_t xTaskDelayUntil( TickType_t * const pxPreviousWakeTime,
+                                const TickType_t xTimeIncrement )
+    {
+        TickType_t xTimeToWake;
+        BaseType_t xAlreadyYielded, xShouldDelay = pdFALSE;
+
+        configASSERT( pxPreviousWakeTime );
+        configASSERT( ( xTimeIncrement > 0U ) );
+        taskASSERT_SCHEDULER_NOT_SUSPENDED();
+
+        vTaskSuspendAll();
+        {
+            /* Minor optimisation.  The tick count cannot change in this
+             * block. */
+            const TickType_t xConstTickCount = xTickCount;
+
+            /* Generate the tick time at which the task wants to wake. */
+            xTimeToWake = *pxPreviousWakeTime + xTimeIncrement;
+
+            if( xConstTickCount < *pxPreviousWakeTime )
+            {
+                /* The tick count has overflowed since this function was
+                 * lasted called.  In this case the only time we should ever
+                 * actually delay is if the wake time has also  overflowed,
+                 * and the wake time is greater than the tick time.  When this
+                 * is the case it is as if neither time had overflowed. */
+                if( ( xTimeToWake < *pxPreviousWakeTime ) && ( xTimeToWake > xConstTickCount ) )
+                {
+                    xShouldDelay = pdTRUE;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                /* The tick time has not overflowed.  In this case we will
+                 * delay if either the wake time has overflowed, and/or the
+                 * tick time is less than the wake time. */
+                if( ( xTimeToWake < *pxPreviousWakeTime ) || ( xTimeToWake > xConstTickCount ) )
+                {
+                    xShouldDelay = pdTRUE;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+
+            /* Update the wake time ready for the next call. */
+            *pxPreviousWakeTime = xTimeToWake;
+
+            #if ( taskMEASURE_JOBS == 1 )
+                {
+                    /* A periodic task ends a job here. */
+                    prvMeasureJob( pxCurrentTCB );
+                }
+            #endif
+
+            if( xShouldDelay != pdFALSE )
+            {
+                traceTASK_DELAY_UNTIL( xTimeToWake );
+
+                /* prvAddCurrentTaskToDelayedList() needs the block time, not
+                 * the time to wake, so subtract the current tick count. */
+                prvAddCurrentTaskToDelayedList( xTimeToWake - xConstTickCount, pdFALSE );
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        xAlreadyYielded = xTaskResumeAll();
+
+        /* Force a reschedule if xTaskResumeAll has not already done so, we may
+         * have put ourselves to sleep. */
+        if( xAlreadyYielded == pdFALSE )
+        {
+            portYIELD_WITHIN_API();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        return xShouldDelay;
+    }
+
+#endif /* INCLUDE_xTaskDelayUntil */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_EDF_SCHEDULING == 1 )
+
+    BaseType_t xTaskWaitForNextPeriod( void )
+    {
+        TCB_t * pxTCB;
+        TickType_t xElapsed;
+        BaseType_t xReturn = pdTRUE, xAlreadyYielded;
+
+        taskASSERT_SCHEDULER_NOT_SUSPENDED();
+
+        vTaskSuspendAll();
+        {
+            /* Minor optimisation.  The tick count cannot change in this
+             * block. */
+            const TickType_t xConstTickCount = xTickCount;
+
+            pxTCB = pxCurrentTCB;
+            configASSERT( pxTCB->xEDFPeriod > ( TickType_t ) 0 );
+
+            #if ( taskMEASURE_JOBS == 1 )
+                {
+                    prvMeasureJob( pxTCB );
+                }
+            #endif
+
+            /* Ticks since the release of the job just completed. */
+            xElapsed = xConstTickCount - pxTCB->xEDFRelease;
+
+            if( xElapsed > pxTCB->xEDFRelativeDeadline )
+            {
+                pxTCB->uxEDFDeadlineMisses++;
+                xReturn = pdFALSE;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            pxTCB->xEDFRelease += pxTCB->xEDFPeriod;
+            pxTCB->xEDFDeadline = pxTCB->xEDFRelease + pxTCB->xEDFRelativeDeadline;
+
+            if( xElapsed < pxTCB->xEDFPeriod )
+            {
+                /* The deadline is the key of the ready list only, the task
+                 * is back in it by its new deadline when the delay ends. */
+                prvAddCurrentTaskToDelayedList( pxTCB->xEDFPeriod - xElapsed, pdFALSE );
+            }
+            else
+            {
+                /* The next job is already released, move the task to the
+                 * place of its new deadline. */
+                if( uxListRemove( &( pxTCB->xStateListItem ) ) == ( UBaseType_t ) 0 )
+                {
+                    portRESET_READY_PRIORITY( pxTCB->uxPriority, uxTopReadyPriority );
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                prvAddTaskToReadyList( pxTCB );
+            }
+        }
+        xAlreadyYielded = xTaskResumeAll();
+
+        /* Yield to the task of the earliest deadline, or to any other task
+         * while this one waits. */
+        if( xAlreadyYielded == pdFALSE )
+        {
+            portYIELD_WITHIN_API();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    UBaseType_t uxTaskGetDeadlineMisses( TaskHandle_t xTask )
+    {
+        TCB_t const * pxTCB;
+
+        pxTCB = prvGetTCBFromHandle( xTask );
+
+        return pxTCB->uxEDFDeadlineMisses;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvSetEDFPeriod( TCB_t * pxTCB,
+                                 TickType_t xPeriod,
+                                 TickType_t xRelativeDeadline )
+    {
+        configASSERT( xPeriod > ( TickType_t ) 0 );
+        configASSERT( ( xRelativeDeadline > ( TickType_t ) 0 ) && ( xRelativeDeadline <= xPeriod ) );
+
+        /* The first job is released now, the tick count is reset to the
+         * same value when the scheduler starts. */
+        pxTCB->xEDFPeriod = xPeriod;
+        pxTCB->xEDFRelativeDeadline = xRelativeDeadline;
+        pxTCB->xEDFRelease = xTickCount;
+        pxTCB->xEDFDeadline = pxTCB->xEDFRelease + xRelativeDeadline;
+    }
+
+#endif /* configUSE_EDF_SCHEDULING */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_ADMISSION_CONTROL == 1 )
+
+/* The priority a task with a timing contract is analysed at, not raised by
+ * priority inheritance. */
+    #if ( configUSE_MUTEXES == 1 )
+        #define taskCONTRACT_PRIORITY( pxTCB )    ( ( pxTCB )->uxBasePriority )
+    #else
+        #define taskCONTRACT_PRIORITY( pxTCB )    ( ( pxTCB )->uxPriority )
+    #endif
+
+/* Fixed point 1.0 of the processor density of the EDF test. */
+    #define taskDENSITY_ONE    ( ( uint64_t ) 1 << 16 )
+
+    static BaseType_t prvTimingContractsSchedulable( void )
+    {
+        TCB_t * pxTCB;
+        TCB_t * pxOther;
+        TickType_t xResponse, xNextResponse;
+        BaseType_t xReturn = pdTRUE;
+
+        #if ( configUSE_EDF_SCHEDULING == 1 )
+            uint64_t ullDensity = 0;
+            BaseType_t xEDFTasks = pdFALSE;
+        #endif
+
+        for( pxTCB = pxTimingContracts; ( pxTCB != NULL ) && ( xReturn != pdFALSE ); pxTCB = pxTCB->pxNextContract )
+        {
+            #if ( configUSE_EDF_SCHEDULING == 1 )
+                {
+                    /* The EDF tasks, and the tasks that run before them, share
+                     * the processor by density. */
+                    if( taskCONTRACT_PRIORITY( pxTCB ) >= ( UBaseType_t ) configEDF_PRIORITY )
+                    {
+                        ullDensity += ( ( ( uint64_t ) pxTCB->xContractWCET * taskDENSITY_ONE ) + pxTCB->xContractDeadline - 1U ) / pxTCB->xContractDeadline;
+                    }
+
+                    if( pxTCB->xEDFPeriod > ( TickType_t ) 0 )
+                    {
+                        xEDFTasks = pdTRUE;
+                        continue;
+                    }
+                }
+            #endif /* configUSE_EDF_SCHEDULING */
+
+            /* Response time analysis: the worst case response time is the
+             * execution time of a job plus the preemption by the jobs of the
+             * tasks of higher priority released meanwhile.  The tasks of the
+             * same priority are counted as higher, as time slicing may run
+             * them first. */
+            xResponse = pxTCB->xContractWCET;
+
+            for( ; ; )
+            {
+                xNextResponse = pxTCB->xContractWCET;
+
+                for( pxOther = pxTimingContracts; pxOther != NULL; pxOther = pxOther->pxNextContract )
+                {
+                    if( ( pxOther != pxTCB ) && ( taskCONTRACT_PRIORITY( pxOther ) >= taskCONTRACT_PRIORITY( pxTCB ) ) )
+                    {
+                        xNextResponse += ( ( xResponse + pxOther->xContractPeriod - 1U ) / pxOther->xContractPeriod ) * pxOther->xContractWCET;
+                    }
+                }
+
+                if( xNextResponse > pxTCB->xContractDeadline )
+                {
+                    xReturn = pdFALSE;
+                    break;
+                }
+                else if( xNextResponse == xResponse )
+                {
+                    break;
+                }
+                else
+                {
+                    xResponse = xNextResponse;
+                }
+            }
+        }
+
+        #if ( configUSE_EDF_SCHEDULING == 1 )
+            {
+                if( ( xEDFTasks != pdFALSE ) && ( ullDensity > taskDENSITY_ONE ) )
+                {
+                    xReturn = pdFALSE;
+                }
+            }
+        #endif
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvAdmitTimingContract( TCB_t * pxTCB,
+                                              const TaskTimingContract_t * const pxContract )
+    {
+        TCB_t ** ppxLink;
+        TaskTimingContract_t xPrevious;
+        BaseType_t xReturn = pdPASS;
+
+        xPrevious.xPeriod = pxTCB->xContractPeriod;
+        xPrevious.xWCET = pxTCB->xContractWCET;
+        xPrevious.xDeadline = pxTCB->xContractDeadline;
+
+        if( pxContract != NULL )
+        {
+            configASSERT( pxContract->xPeriod > ( TickType_t ) 0 );
+            configASSERT( ( pxContract->xDeadline > ( TickType_t ) 0 ) && ( pxContract->xDeadline <= pxContract->xPeriod ) );
+
+            #if ( configUSE_EDF_SCHEDULING == 1 )
+                configASSERT( ( pxTCB->xEDFPeriod == ( TickType_t ) 0 ) ||
+                              ( ( pxTCB->xEDFPeriod == pxContract->xPeriod ) && ( pxTCB->xEDFRelativeDeadline == pxContract->xDeadline ) ) );
+            #endif
+
+            if( xPrevious.xPeriod == ( TickType_t ) 0 )
+            {
+                pxTCB->pxNextContract = pxTimingContracts;
+                pxTimingContracts = pxTCB;
+
+                /* The CPU time of a task is only read by the task itself,
+                 * the current job is not measured. */
+                pxTCB->ullJobStartNs = ( uint64_t ) 0;
+            }
+
+            pxTCB->xContractPeriod = pxContract->xPeriod;
+            pxTCB->xContractWCET = pxContract->xWCET;
+            pxTCB->xContractDeadline = pxContract->xDeadline;
+
+            if( prvTimingContractsSchedulable() == pdFALSE )
+            {
+                #if ( configADMISSION_CONTROL_REJECTS == 1 )
+                    {
+                        if( xPrevious.xPeriod == ( TickType_t ) 0 )
+                        {
+                            pxTimingContracts = pxTCB->pxNextContract;
+                            pxTCB->pxNextContract = NULL;
+                        }
+
+                        pxTCB->xContractPeriod = xPrevious.xPeriod;
+                        pxTCB->xContractWCET = xPrevious.xWCET;
+                        pxTCB->xContractDeadline = xPrevious.xDeadline;
+                        xReturn = errTASK_NOT_SCHEDULABLE;
+                    }
+                #else
+                    {
+                        vApplicationAdmissionWarningHook( ( TaskHandle_t ) pxTCB, pxTCB->pcTaskName );
+                    }
+                #endif
+            }
+        }
+        else if( xPrevious.xPeriod > ( TickType_t ) 0 )
+        {
+            ppxLink = &pxTimingContracts;
+
+            while( *ppxLink != pxTCB )
+            {
+                ppxLink = &( ( *ppxLink )->pxNextContract );
+            }
+
+            *ppxLink = pxTCB->pxNextContract;
+            pxTCB->pxNextContract = NULL;
+            pxTCB->xContractPeriod = ( TickType_t ) 0;
+            pxTCB->xContractWCET = ( TickType_t ) 0;
+            pxTCB->xContractDeadline = ( TickType_t ) 0;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    BaseType_t xTaskSetTimingContract( TaskHandle_t xTask,
+                                       const TaskTimingContract_t * const pxContract )
+    {
+        BaseType_t xReturn;
+
+        vTaskSuspendAll();
+        {
+            xReturn = prvAdmitTimingContract( prvGetTCBFromHandle( xTask ), pxContract );
+        }
+        ( void ) xTaskResumeAll();
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    BaseType_t xTaskGetTimingContract( TaskHandle_t xTask,
+                                       TaskTimingContract_t * const pxContract )
+    {
+        TCB_t const * pxTCB;
+        BaseType_t xReturn;
+
+        configASSERT( pxContract != NULL );
+
+        vTaskSuspendAll();
+        {
+            pxTCB = prvGetTCBFromHandle( xTask );
+            pxContract->xPeriod = pxTCB->xContractPeriod;
+            pxContract->xWCET = pxTCB->xContractWCET;
+            pxContract->xDeadline = pxTCB->xContractDeadline;
+            xReturn = ( pxTCB->xContractPeriod > ( TickType_t ) 0 ) ? pdTRUE : pdFALSE;
+        }
+        ( void ) xTaskResumeAll();
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    BaseType_t xTaskCheckSchedulability( void )
+    {
+        BaseType_t xReturn;
+
+        vTaskSuspendAll();
+        {
+            xReturn = prvTimingContractsSchedulable();
+        }
+        ( void ) xTaskResumeAll();
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    #if ( taskMEASURE_JOBS == 1 )
+
+        uint64_t ullTaskGetLongestJobNs( TaskHandle_t xTask )
+        {
+            uint64_t ullReturn;
+
+            /* Measured with the scheduler suspended, not torn. */
+            vTaskSuspendAll();
+            {
+                ullReturn = prvGetTCBFromHandle( xTask )->ullLongestJobNs;
+            }
+            ( void ) xTaskResumeAll();
+
+            return ullReturn;
+        }
+/*-----------------------------------------------------------*/
+
+        UBaseType_t uxTaskGetContractOverruns( TaskHandle_t xTask )
+        {
+            TCB_t const * pxTCB;
+
+            pxTCB = prvGetTCBFromHandle( xTask );
+
+            return pxTCB->uxContractOverruns;
+        }
+
+    #endif /* taskMEASURE_JOBS */
+
+#endif /* configUSE_ADMISSION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TASK_BUDGETS == 1 )
+
+/* Whether pxTCB ran up to the tick. */
+    #if ( configNUMBER_OF_CORES == 1 )
+        #define taskBUDGET_IS_RUNNING( pxTCB )    ( ( pxTCB ) == pxCurrentTCB )
+    #else
+        #define taskBUDGET_IS_RUNNING( pxTCB )    taskTASK_IS_RUNNING( pxTCB )
+    #endif
+
+    static BaseType_t prvProcessBudgets( const TickType_t xConstTickCount )
+    {
+        TCB_t * pxTCB;
+        TickType_t xElapsed;
+        BaseType_t xSwitchRequired = pdFALSE;
+
+        for( pxTCB = pxBudgetedTasks; pxTCB != NULL; pxTCB = pxTCB->pxNextBudget )
+        {
+            /* The tick is charged to the task that was running when it
+             * came. */
+            if( taskBUDGET_IS_RUNNING( pxTCB ) )
+            {
+                if( pxTCB->xBudgetRemaining > ( TickType_t ) 0 )
+                {
+                    pxTCB->xBudgetRemaining--;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                if( ( pxTCB->xBudgetRemaining == ( TickType_t ) 0 ) && ( pxTCB->ucBudgetState == taskBUDGET_AVAILABLE ) )
+                {
+                    /* Still running with no budget left. */
+                    pxTCB->uxBudgetOverruns++;
+                    pxTCB->ucBudgetState = taskBUDGET_EXHAUSTED;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                if( pxTCB->ucBudgetState == taskBUDGET_EXHAUSTED )
+                {
+                    if( prvThrottleTask( pxTCB ) != pdFALSE )
+                    {
+                        xSwitchRequired = pdTRUE;
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            /* The whole budget is available again at the start of each
+             * period.  Periods skipped by tickless idle are caught up. */
+            xElapsed = xConstTickCount - pxTCB->xBudgetPeriodStart;
+
+            if( xElapsed >= pxTCB->xBudgetPeriod )
+            {
+                pxTCB->xBudgetPeriodStart += xElapsed - ( xElapsed % pxTCB->xBudgetPeriod );
+                pxTCB->xBudgetRemaining = pxTCB->xBudget;
+
+                if( pxTCB->ucBudgetState != taskBUDGET_AVAILABLE )
+                {
+                    if( prvReleaseThrottledTask( pxTCB ) != pdFALSE )
+                    {
+                        xSwitchRequired = pdTRUE;
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+
+        return xSwitchRequired;
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvThrottleTask( TCB_t * pxTCB )
+    {
+        BaseType_t xSwitchRequired = pdFALSE;
+
+        #if ( configUSE_MUTEXES == 1 )
+            if( pxTCB->uxMutexesHeld > ( UBaseType_t ) 0U )
+            {
+                /* Demoting a mutex holder would delay the tasks waiting for
+                 * the mutex, it is throttled once it released them. */
+                mtCOVERAGE_TEST_MARKER();
+            }
+            else
+        #endif
+        if( listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ pxTCB->uxPriority ] ), &( pxTCB->xStateListItem ) ) != pdFALSE )
+        {
+            if( uxListRemove( &( pxTCB->xStateListItem ) ) == ( UBaseType_t ) 0 )
+            {
+                taskRESET_READY_PRIORITY( pxTCB->uxPriority );
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            #if ( INCLUDE_vTaskSuspend == 1 )
+                if( pxTCB->ucBudgetAction == ( uint8_t ) eBudgetSuspend )
+                {
+                    listINSERT_END( &xSuspendedTaskList, &( pxTCB->xStateListItem ) );
+                    pxTCB->ucBudgetState = taskBUDGET_SUSPENDED;
+                }
+                else
+            #endif
+            {
+                pxTCB->uxBudgetPriority = pxTCB->uxPriority;
+                pxTCB->uxPriority = configBUDGET_DEMOTED_PRIORITY;
+
+                #if ( configUSE_MUTEXES == 1 )
+                    {
+                        pxTCB->uxBasePriority = configBUDGET_DEMOTED_PRIORITY;
+                    }
+                #endif
+
+                /* The event list item value is only used for the priority
+                 * while the task is not waiting on an event. */
+                if( ( listGET_LIST_ITEM_VALUE( &( pxTCB->xEventListItem ) ) & taskEVENT_LIST_ITEM_VALUE_IN_USE ) == 0UL )
+                {
+                    listSET_LIST_ITEM_VALUE( &( pxTCB->xEventListItem ), ( ( TickType_t ) configMAX_PRIORITIES - ( TickType_t ) configBUDGET_DEMOTED_PRIORITY ) ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                prvAddTaskToReadyList( pxTCB );
+                pxTCB->ucBudgetState = taskBUDGET_DEMOTED;
+            }
+
+            #if ( configNUMBER_OF_CORES == 1 )
+                {
+                    xSwitchRequired = ( pxTCB == pxCurrentTCB ) ? pdTRUE : pdFALSE;
+                }
+            #else
+                {
+                    if( taskTASK_IS_RUNNING( pxTCB ) )
+                    {
+                        xSwitchRequired = prvYieldCore( pxTCB->xTaskRunState );
+                    }
+                }
+            #endif
+        }
+        else
+        {
+            /* Blocked, it is throttled at a tick it runs through. */
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        return xSwitchRequired;
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvReleaseThrottledTask( TCB_t * pxTCB )
+    {
+        BaseType_t xReady = pdFALSE;
+        BaseType_t xSwitchRequired = pdFALSE;
+
+        if( pxTCB->ucBudgetState == taskBUDGET_DEMOTED )
+        {
+            #if ( configUSE_MUTEXES == 1 )
+                {
+                    pxTCB->uxBasePriority = pxTCB->uxBudgetPriority;
+                }
+            #endif
+
+            /* A higher priority inherited meanwhile is kept. */
+            if( pxTCB->uxBudgetPriority > pxTCB->uxPriority )
+            {
+                if( listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ pxTCB->uxPriority ] ), &( pxTCB->xStateListItem ) ) != pdFALSE )
+                {
+                    if( uxListRemove( &( pxTCB->xStateListItem ) ) == ( UBaseType_t ) 0 )
+                    {
+                        taskRESET_READY_PRIORITY( pxTCB->uxPriority );
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+
+                    xReady = pdTRUE;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                pxTCB->uxPriority = pxTCB->uxBudgetPriority;
+
+                if( ( listGET_LIST_ITEM_VALUE( &( pxTCB->xEventListItem ) ) & taskEVENT_LIST_ITEM_VALUE_IN_USE ) == 0UL )
+                {
+                    listSET_LIST_ITEM_VALUE( &( pxTCB->xEventListItem ), ( ( TickType_t ) configMAX_PRIORITIES - ( TickType_t ) pxTCB->uxPriority ) ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+
+        #if ( INCLUDE_vTaskSuspend == 1 )
+            else if( pxTCB->ucBudgetState == taskBUDGET_SUSPENDED )
+            {
+                /* Unless it was resumed meanwhile. */
+                if( listIS_CONTAINED_WITHIN( &xSuspendedTaskList, &( pxTCB->xStateListItem ) ) != pdFALSE )
+                {
+                    ( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+                    xReady = pdTRUE;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+        #endif /* INCLUDE_vTaskSuspend */
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        if( xReady != pdFALSE )
+        {
+            prvAddTaskToReadyList( pxTCB );
+
+            #if ( configNUMBER_OF_CORES == 1 )
+                if( taskPREEMPTS_OR_SHARES_CURRENT( pxTCB ) )
+            #else
+                if( prvYieldForTask( pxTCB ) != pdFALSE )
+            #endif
+            {
+                xSwitchRequired = pdTRUE;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        pxTCB->ucBudgetState = taskBUDGET_AVAILABLE;
+
+        return xSwitchRequired;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvRemoveBudget( TCB_t * pxTCB )
+    {
+        TCB_t ** ppxLink = &pxBudgetedTasks;
+
+        while( *ppxLink != pxTCB )
+        {
+            ppxLink = &( ( *ppxLink )->pxNextBudget );
+        }
+
+        *ppxLink = pxTCB->pxNextBudget;
+        pxTCB->pxNextBudget = NULL;
+        pxTCB->xBudget = ( TickType_t ) 0;
+    }
+/*-----------------------------------------------------------*/
+
+    void vTaskSetBudget( TaskHandle_t xTask,
+                         TickType_t xBudget,
+                         TickType_t xPeriod,
+                         eBudgetAction eAction )
+    {
+        TCB_t * pxTCB;
+        BaseType_t xYieldRequired = pdFALSE;
+
+        configASSERT( ( xBudget == ( TickType_t ) 0 ) || ( ( xPeriod > ( TickType_t ) 0 ) && ( xBudget <= xPeriod ) ) );
+
+        #if ( INCLUDE_vTaskSuspend == 0 )
+            configASSERT( eAction != eBudgetSuspend );
+        #endif
+
+        taskENTER_CRITICAL();
+        {
+            pxTCB = prvGetTCBFromHandle( xTask );
+
+            /* A throttled task starts over. */
+            if( pxTCB->ucBudgetState != taskBUDGET_AVAILABLE )
+            {
+                xYieldRequired = prvReleaseThrottledTask( pxTCB );
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            if( xBudget > ( TickType_t ) 0 )
+            {
+                if( pxTCB->xBudget == ( TickType_t ) 0 )
+                {
+                    pxTCB->pxNextBudget = pxBudgetedTasks;
+                    pxBudgetedTasks = pxTCB;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                pxTCB->xBudget = xBudget;
+                pxTCB->xBudgetPeriod = xPeriod;
+                pxTCB->xBudgetRemaining = xBudget;
+                pxTCB->xBudgetPeriodStart = xTickCount;
+                pxTCB->ucBudgetAction = ( uint8_t ) eAction;
+            }
+            else if( pxTCB->xBudget > ( TickType_t ) 0 )
+            {
+                prvRemoveBudget( pxTCB );
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            if( xYieldRequired != pdFALSE )
+            {
+                taskYIELD_IF_USING_PREEMPTION();
             }
             else
             {
                 mtCOVERAGE_TEST_MARKER();
             }
         }
+        taskEXIT_CRITICAL();
     }
+/*-----------------------------------------------------------*/
 
-#endif /* INCLUDE_vTaskDelete */
+    UBaseType_t uxTaskGetBudgetOverruns( TaskHandle_t xTask )
+    {
+        TCB_t const * pxTCB;
+
+        pxTCB = prvGetTCBFromHandle( xTask );
+
+        return pxTCB->uxBudgetOverruns;
+    }
+
+#endif /* configUSE_TASK_BUDGETS */
 /*-----------------------------------------------------------*/
 
-#if ( INCLUDE_xTaskDelayUntil == 1 )
+#if ( taskMEASURE_JOBS == 1 )
 
-    BaseType_t xTaskDelayUntil( TickType_t * const pxPreviousWakeTime,
-                                const TickType_t xTimeIncrement )
+    static void prvMeasureJob( TCB_t * pxTCB )
     {
-        TickType_t xTimeToWake;
-        BaseType_t xAlreadyYielded, xShouldDelay = pdFALSE;
-
-        configASSERT( pxPreviousWakeTime );
-        configASSERT( ( xTimeIncrement > 0U ) );
-        configASSERT( uxSchedulerSuspended == 0 );
+        uint64_t ullNow, ullJobNs;
+        TickType_t xJobTicks;
+        const uint64_t ullTickNs = ( uint64_t ) 1000000000U / ( uint64_t ) configTICK_RATE_HZ;
 
-        vTaskSuspendAll();
+        if( pxTCB->xContractPeriod > ( TickType_t ) 0 )
         {
-            /* Minor optimisation.  The tick count cannot change in this
-             * block. */
-            const TickType_t xConstTickCount = xTickCount;
-
-            /* Generate the tick time at which the task wants to wake. */
-            xTimeToWake = *pxPreviousWakeTime + xTimeIncrement;
+            ullNow = portGET_TASK_CPU_TIME_NS();
 
-            if( xConstTickCount < *pxPreviousWakeTime )
+            if( pxTCB->ullJobStartNs > ( uint64_t ) 0 )
             {
-                /* The tick count has overflowed since this function was
-                 * lasted called.  In this case the only time we should ever
-                 * actually delay is if the wake time has also  overflowed,
-                 * and the wake time is greater than the tick time.  When this
-                 * is the case it is as if neither time had overflowed. */
-                if( ( xTimeToWake < *pxPreviousWakeTime ) && ( xTimeToWake > xConstTickCount ) )
+                ullJobNs = ullNow - pxTCB->ullJobStartNs;
+
+                if( ullJobNs > pxTCB->ullLongestJobNs )
                 {
-                    xShouldDelay = pdTRUE;
+                    pxTCB->ullLongestJobNs = ullJobNs;
                 }
                 else
                 {
                     mtCOVERAGE_TEST_MARKER();
                 }
-            }
-            else
-            {
-                /* The tick time has not overflowed.  In this case we will
-                 * delay if either the wake time has overflowed, and/or the
-                 * tick time is less than the wake time. */
-                if( ( xTimeToWake < *pxPreviousWakeTime ) || ( xTimeToWake > xConstTickCount ) )
+
+                if( ullJobNs > ( ( uint64_t ) pxTCB->xContractWCET * ullTickNs ) )
                 {
-                    xShouldDelay = pdTRUE;
+                    /* The admission test counts whole ticks, the estimate is
+                     * raised to the ticks the job ran into. */
+                    xJobTicks = ( TickType_t ) ( ( ullJobNs + ullTickNs - 1U ) / ullTickNs );
+                    pxTCB->xContractWCET = xJobTicks;
+                    pxTCB->uxContractOverruns++;
+
+                    if( prvTimingContractsSchedulable() == pdFALSE )
+                    {
+                        #if ( configADMISSION_CONTROL_REJECTS == 0 )
+                            {
+                                vApplicationAdmissionWarningHook( ( TaskHandle_t ) pxTCB, pxTCB->pcTaskName );
+                            }
+                        #endif
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
                 }
                 else
                 {
                     mtCOVERAGE_TEST_MARKER();
                 }
             }
-
-            /* Update the wake time ready for the next call. */
-            *pxPreviousWakeTime = xTimeToWake;
-
-            if( xShouldDelay != pdFALSE )
-            {
-                traceTASK_DELAY_UNTIL( xTimeToWake );
-
-                /* prvAddCurrentTaskToDelayedList() needs the block time, not
-                 * the time to wake, so subtract the current tick count. */
-                prvAddCurrentTaskToDelayedList( xTimeToWake - xConstTickCount, pdFALSE );
-            }
             else
             {
                 mtCOVERAGE_TEST_MARKER();
             }
-        }
-        xAlreadyYielded = xTaskResumeAll();
 
-        /* Force a reschedule if xTaskResumeAll has not already done so, we may
-         * have put ourselves to sleep. */
-        if( xAlreadyYielded == pdFALSE )
-        {
-            portYIELD_WITHIN_API();
+            pxTCB->ullJobStartNs = ullNow;
         }
         else
         {
             mtCOVERAGE_TEST_MARKER();
         }
-
-        return xShouldDelay;
     }
 
-#endif /* INCLUDE_xTaskDelayUntil */
+#endif /* taskMEASURE_JOBS */
 /*-----------------------------------------------------------*/
 
 #if ( INCLUDE_vTaskDelay == 1 )
@@ -1341,7 +2881,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
         /* A delay time of zero just forces a reschedule. */
         if( xTicksToDelay > ( TickType_t ) 0U )
         {
-            configASSERT( uxSchedulerSuspended == 0 );
+            taskASSERT_SCHEDULER_NOT_SUSPENDED();
             vTaskSuspendAll();
             {
                 traceTASK_DELAY();
@@ -1377,95 +2917,116 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
 #endif /* INCLUDE_vTaskDelay */
 /*-----------------------------------------------------------*/
 
-#if ( ( INCLUDE_eTaskGetState == 1 ) || ( configUSE_TRACE_FACILITY == 1 ) || ( INCLUDE_xTaskAbortDelay == 1 ) )
+#if ( ( INCLUDE_eTaskGetState == 1 ) || ( configUSE_TRACE_FACILITY == 1 ) || ( INCLUDE_xTaskAbortDelay == 1 ) || ( configUSE_TASK_SNAPSHOTS == 1 ) )
 
-    eTaskState eTaskGetState( TaskHandle_t xTask )
+    static eTaskState prvGetTaskStateFromLists( const TCB_t * pxTCB )
     {
         eTaskState eReturn;
-        List_t const * pxStateList, * pxDelayedList, * pxOverflowedDelayedList;
-        const TCB_t * const pxTCB = xTask;
+        List_t const * pxStateList;
 
-        configASSERT( pxTCB );
+        pxStateList = listLIST_ITEM_CONTAINER( &( pxTCB->xStateListItem ) );
 
-        if( pxTCB == pxCurrentTCB )
+        #if ( configUSE_TIMING_WHEEL == 0 )
+            if( ( pxStateList == pxDelayedTaskList ) || ( pxStateList == pxOverflowDelayedTaskList ) )
+        #else
+            if( taskLIST_IS_DELAYED( pxStateList ) )
+        #endif
         {
-            /* The task calling this function is querying its own state. */
-            eReturn = eRunning;
+            /* The task being queried is referenced from one of the Blocked
+             * lists. */
+            eReturn = eBlocked;
         }
-        else
-        {
-            taskENTER_CRITICAL();
-            {
-                pxStateList = listLIST_ITEM_CONTAINER( &( pxTCB->xStateListItem ) );
-                pxDelayedList = pxDelayedTaskList;
-                pxOverflowedDelayedList = pxOverflowDelayedTaskList;
-            }
-            taskEXIT_CRITICAL();
 
-            if( ( pxStateList == pxDelayedList ) || ( pxStateList == pxOverflowedDelayedList ) )
+        #if ( INCLUDE_vTaskSuspend == 1 )
+            else if( pxStateList == &xSuspendedTaskList )
             {
-                /* The task being queried is referenced from one of the Blocked
-                 * lists. */
-                eReturn = eBlocked;
-            }
-
-            #if ( INCLUDE_vTaskSuspend == 1 )
-                else if( pxStateList == &xSuspendedTaskList )
+                /* The task being queried is referenced from the suspended
+                 * list.  Is it genuinely suspended or is it blocked
+                 * indefinitely? */
+                if( listLIST_ITEM_CONTAINER( &( pxTCB->xEventListItem ) ) == NULL )
                 {
-                    /* The task being queried is referenced from the suspended
-                     * list.  Is it genuinely suspended or is it blocked
-                     * indefinitely? */
-                    if( listLIST_ITEM_CONTAINER( &( pxTCB->xEventListItem ) ) == NULL )
-                    {
-                        #if ( configUSE_TASK_NOTIFICATIONS == 1 )
-                            {
-                                BaseType_t x;
+                    #if ( configUSE_TASK_NOTIFICATIONS == 1 )
+                        {
+                            BaseType_t x;
 
-                                /* The task does not appear on the event list item of
-                                 * and of the RTOS objects, but could still be in the
-                                 * blocked state if it is waiting on its notification
-                                 * rather than waiting on an object.  If not, is
-                                 * suspended. */
-                                eReturn = eSuspended;
+                            /* The task does not appear on the event list item of
+                             * and of the RTOS objects, but could still be in the
+                             * blocked state if it is waiting on its notification
+                             * rather than waiting on an object.  If not, is
+                             * suspended. */
+                            eReturn = eSuspended;
 
-                                for( x = 0; x < configTASK_NOTIFICATION_ARRAY_ENTRIES; x++ )
+                            for( x = 0; x < configTASK_NOTIFICATION_ARRAY_ENTRIES; x++ )
+                            {
+                                if( pxTCB->ucNotifyState[ x ] == taskWAITING_NOTIFICATION )
                                 {
-                                    if( pxTCB->ucNotifyState[ x ] == taskWAITING_NOTIFICATION )
-                                    {
-                                        eReturn = eBlocked;
-                                        break;
-                                    }
+                                    eReturn = eBlocked;
+                                    break;
                                 }
                             }
-                        #else /* if ( configUSE_TASK_NOTIFICATIONS == 1 ) */
-                            {
-                                eReturn = eSuspended;
-                            }
-                        #endif /* if ( configUSE_TASK_NOTIFICATIONS == 1 ) */
-                    }
-                    else
-                    {
-                        eReturn = eBlocked;
-                    }
+                        }
+                    #else /* if ( configUSE_TASK_NOTIFICATIONS == 1 ) */
+                        {
+                            eReturn = eSuspended;
+                        }
+                    #endif /* if ( configUSE_TASK_NOTIFICATIONS == 1 ) */
                 }
-            #endif /* if ( INCLUDE_vTaskSuspend == 1 ) */
-
-            #if ( INCLUDE_vTaskDelete == 1 )
-                else if( ( pxStateList == &xTasksWaitingTermination ) || ( pxStateList == NULL ) )
+                else
                 {
-                    /* The task being queried is referenced from the deleted
-                     * tasks list, or it is not referenced from any lists at
-                     * all. */
-                    eReturn = eDeleted;
+                    eReturn = eBlocked;
                 }
-            #endif
+            }
+        #endif /* if ( INCLUDE_vTaskSuspend == 1 ) */
+
+        #if ( INCLUDE_vTaskDelete == 1 )
+            else if( ( pxStateList == &xTasksWaitingTermination ) || ( pxStateList == NULL ) )
+            {
+                /* The task being queried is referenced from the deleted
+                 * tasks list, or it is not referenced from any lists at
+                 * all. */
+                eReturn = eDeleted;
+            }
+        #endif
+
+        else /*lint !e525 Negative indentation is intended to make use of pre-processor clearer. */
+        {
+            /* If the task is not in any other state, it must be in the
+             * Ready (including pending ready) state. */
+            eReturn = eReady;
+        }
+
+        return eReturn;
+    }
+
+#endif /* ( ( INCLUDE_eTaskGetState == 1 ) || ( configUSE_TRACE_FACILITY == 1 ) || ( INCLUDE_xTaskAbortDelay == 1 ) || ( configUSE_TASK_SNAPSHOTS == 1 ) ) */
+/*-----------------------------------------------------------*/
+
+#if ( ( INCLUDE_eTaskGetState == 1 ) || ( configUSE_TRACE_FACILITY == 1 ) || ( INCLUDE_xTaskAbortDelay == 1 ) )
+
+    eTaskState eTaskGetState( TaskHandle_t xTask )
+    {
+        eTaskState eReturn;
+        const TCB_t * const pxTCB = xTask;
+
+        configASSERT( pxTCB );
 
-            else /*lint !e525 Negative indentation is intended to make use of pre-processor clearer. */
+        #if ( configNUMBER_OF_CORES == 1 )
+            if( pxTCB == pxCurrentTCB )
+        #else
+            if( taskTASK_IS_RUNNING( pxTCB ) )
+        #endif
+        {
+            /* The task calling this function is querying its own state, or
+             * the task is running on another core. */
+            eReturn = eRunning;
+        }
+        else
+        {
+            taskENTER_CRITICAL();
             {
-                /* If the task is not in any other state, it must be in the
-                 * Ready (including pending ready) state. */
-                eReturn = eReady;
+                eReturn = prvGetTaskStateFromLists( pxTCB );
             }
+            taskEXIT_CRITICAL();
         }
 
         return eReturn;
@@ -1577,6 +3138,8 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
 
             if( uxCurrentBasePriority != uxNewPriority )
             {
+                #if ( configNUMBER_OF_CORES == 1 )
+
                 /* The priority change may have readied a task of higher
                  * priority than the calling task. */
                 if( uxNewPriority > uxCurrentBasePriority )
@@ -1615,6 +3178,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
                      * require a yield as the running task must be above the
                      * new priority of the task being modified. */
                 }
+                #endif /* configNUMBER_OF_CORES */
 
                 /* Remember the ready list the task might be referenced from
                  * before its uxPriority member is changed so the
@@ -1682,6 +3246,38 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
                     mtCOVERAGE_TEST_MARKER();
                 }
 
+                /* A blocked or suspended task is not moved, but is
+                 * published with its new priorities. */
+                taskPUBLISH_SNAPSHOT( pxTCB );
+
+                #if ( configNUMBER_OF_CORES > 1 )
+                    {
+                        if( taskTASK_IS_RUNNING( pxTCB ) )
+                        {
+                            /* A running task set down may now be preempted by
+                             * a ready task on its core. */
+                            if( ( uxNewPriority < uxCurrentBasePriority ) && ( configUSE_PREEMPTION == 1 ) )
+                            {
+                                xYieldRequired = prvYieldCore( pxTCB->xTaskRunState );
+                            }
+                            else
+                            {
+                                mtCOVERAGE_TEST_MARKER();
+                            }
+                        }
+                        else if( uxNewPriority > uxCurrentBasePriority )
+                        {
+                            /* A ready task set up may preempt the task of
+                             * another core. */
+                            xYieldRequired = prvYieldForTask( pxTCB );
+                        }
+                        else
+                        {
+                            mtCOVERAGE_TEST_MARKER();
+                        }
+                    }
+                #endif /* configNUMBER_OF_CORES */
+
                 if( xYieldRequired != pdFALSE )
                 {
                     taskYIELD_IF_USING_PREEMPTION();
@@ -1702,6 +3298,77 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
 #endif /* INCLUDE_vTaskPrioritySet */
 /*-----------------------------------------------------------*/
 
+#if ( ( configNUMBER_OF_CORES > 1 ) && ( configUSE_CORE_AFFINITY == 1 ) )
+
+    void vTaskCoreAffinitySet( const TaskHandle_t xTask,
+                               UBaseType_t uxCoreAffinityMask )
+    {
+        TCB_t * pxTCB;
+        BaseType_t xYieldRequired = pdFALSE;
+
+        taskENTER_CRITICAL();
+        {
+            pxTCB = prvGetTCBFromHandle( xTask );
+            pxTCB->uxCoreAffinityMask = uxCoreAffinityMask;
+
+            if( xSchedulerRunning != pdFALSE )
+            {
+                if( taskTASK_IS_RUNNING( pxTCB ) )
+                {
+                    /* Switch the task out of a core it is no longer allowed
+                     * on. */
+                    if( taskCORE_ALLOWED( pxTCB, pxTCB->xTaskRunState ) == pdFALSE )
+                    {
+                        xYieldRequired = prvYieldCore( pxTCB->xTaskRunState );
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+                else
+                {
+                    /* A ready task may now preempt the task of a core it is
+                     * newly allowed on. */
+                    xYieldRequired = prvYieldForTask( pxTCB );
+                }
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            if( xYieldRequired != pdFALSE )
+            {
+                portYIELD_WITHIN_API();
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        taskEXIT_CRITICAL();
+    }
+/*-----------------------------------------------------------*/
+
+    UBaseType_t vTaskCoreAffinityGet( const TaskHandle_t xTask )
+    {
+        const TCB_t * pxTCB;
+        UBaseType_t uxCoreAffinityMask;
+
+        taskENTER_CRITICAL();
+        {
+            pxTCB = prvGetTCBFromHandle( xTask );
+            uxCoreAffinityMask = pxTCB->uxCoreAffinityMask;
+        }
+        taskEXIT_CRITICAL();
+
+        return uxCoreAffinityMask;
+    }
+
+#endif /* ( ( configNUMBER_OF_CORES > 1 ) && ( configUSE_CORE_AFFINITY == 1 ) ) */
+/*-----------------------------------------------------------*/
+
 #if ( INCLUDE_vTaskSuspend == 1 )
 
     void vTaskSuspend( TaskHandle_t xTaskToSuspend )
@@ -1754,6 +3421,23 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
                     }
                 }
             #endif /* if ( configUSE_TASK_NOTIFICATIONS == 1 ) */
+
+            taskPUBLISH_SNAPSHOT( pxTCB );
+
+            #if ( configNUMBER_OF_CORES > 1 )
+                {
+                    /* A task suspended while running on another core is
+                     * switched out there. */
+                    if( taskTASK_IS_RUNNING( pxTCB ) && ( pxTCB->xTaskRunState != portGET_CORE_ID() ) )
+                    {
+                        ( void ) prvYieldCore( pxTCB->xTaskRunState );
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+            #endif
         }
         taskEXIT_CRITICAL();
 
@@ -1777,9 +3461,11 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
             if( xSchedulerRunning != pdFALSE )
             {
                 /* The current task has just been suspended. */
-                configASSERT( uxSchedulerSuspended == 0 );
+                taskASSERT_SCHEDULER_NOT_SUSPENDED();
                 portYIELD_WITHIN_API();
             }
+
+            #if ( configNUMBER_OF_CORES == 1 )
             else
             {
                 /* The scheduler is not running, but the task that was pointed
@@ -1798,6 +3484,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
                     vTaskSwitchContext();
                 }
             }
+            #endif /* configNUMBER_OF_CORES */
         }
         else
         {
@@ -1879,7 +3566,11 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
                     prvAddTaskToReadyList( pxTCB );
 
                     /* A higher priority task may have just been resumed. */
-                    if( pxTCB->uxPriority >= pxCurrentTCB->uxPriority )
+                    #if ( configNUMBER_OF_CORES == 1 )
+                        if( taskPREEMPTS_OR_SHARES_CURRENT( pxTCB ) )
+                    #else
+                        if( prvYieldForTask( pxTCB ) != pdFALSE )
+                    #endif
                     {
                         /* This yield may not cause the task just resumed to run,
                          * but will leave the lists in the correct state for the
@@ -1947,7 +3638,8 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
                 {
                     /* Ready lists can be accessed so move the task from the
                      * suspended list to the ready list directly. */
-                    if( pxTCB->uxPriority >= pxCurrentTCB->uxPriority )
+                    #if ( configNUMBER_OF_CORES == 1 )
+                    if( taskPREEMPTS_OR_SHARES_CURRENT( pxTCB ) )
                     {
                         xYieldRequired = pdTRUE;
 
@@ -1963,6 +3655,14 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
 
                     ( void ) uxListRemove( &( pxTCB->xStateListItem ) );
                     prvAddTaskToReadyList( pxTCB );
+                    #else /* configNUMBER_OF_CORES */
+                    ( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+                    prvAddTaskToReadyList( pxTCB );
+
+                    /* The yield is marked pending on the core selected, as
+                     * above. */
+                    xYieldRequired = prvYieldForTask( pxTCB );
+                    #endif /* configNUMBER_OF_CORES */
                 }
                 else
                 {
@@ -2026,7 +3726,57 @@ void vTaskStartScheduler( void )
                                    portPRIVILEGE_BIT,  /* In effect ( tskIDLE_PRIORITY | portPRIVILEGE_BIT ), but tskIDLE_PRIORITY is zero. */
                                    &xIdleTaskHandle ); /*lint !e961 MISRA exception, justified as it is not a redundant explicit cast to all supported compilers. */
         }
-    #endif /* configSUPPORT_STATIC_ALLOCATION */
+    #endif /* configSUPPORT_STATIC_ALLOCATION */
+
+    #if ( configNUMBER_OF_CORES > 1 )
+        {
+            BaseType_t xCoreID;
+            TaskHandle_t xPassiveIdleTaskHandle = NULL;
+            char cIdleName[ configMAX_TASK_NAME_LEN ];
+            size_t xNameLength;
+
+            if( xReturn == pdPASS )
+            {
+                xIdleTaskHandle->xIsIdle = pdTRUE;
+            }
+
+            /* Every other core gets a passive idle task, named after the idle
+             * task with the number of the core appended. */
+            xNameLength = strlen( configIDLE_TASK_NAME );
+
+            if( xNameLength > ( size_t ) ( configMAX_TASK_NAME_LEN - 3 ) )
+            {
+                xNameLength = ( size_t ) ( configMAX_TASK_NAME_LEN - 3 );
+            }
+
+            memcpy( cIdleName, configIDLE_TASK_NAME, xNameLength );
+
+            for( xCoreID = 1; ( xCoreID < ( BaseType_t ) configNUMBER_OF_CORES ) && ( xReturn == pdPASS ); xCoreID++ )
+            {
+                size_t x = xNameLength;
+
+                if( xCoreID >= 10 )
+                {
+                    cIdleName[ x++ ] = ( char ) ( '0' + ( xCoreID / 10 ) );
+                }
+
+                cIdleName[ x++ ] = ( char ) ( '0' + ( xCoreID % 10 ) );
+                cIdleName[ x ] = '\0';
+
+                xReturn = xTaskCreate( prvPassiveIdleTask,
+                                       cIdleName,
+                                       configMINIMAL_STACK_SIZE,
+                                       ( void * ) NULL,
+                                       portPRIVILEGE_BIT,
+                                       &xPassiveIdleTaskHandle );
+
+                if( xReturn == pdPASS )
+                {
+                    xPassiveIdleTaskHandle->xIsIdle = pdTRUE;
+                }
+            }
+        }
+    #endif /* configNUMBER_OF_CORES */
 
     #if ( configUSE_TIMERS == 1 )
         {
@@ -2073,6 +3823,12 @@ void vTaskStartScheduler( void )
         xSchedulerRunning = pdTRUE;
         xTickCount = ( TickType_t ) configINITIAL_TICK_COUNT;
 
+        #if ( configUSE_TIMING_WHEEL == 1 )
+            {
+                xTimingWheelTime = xTickCount;
+            }
+        #endif
+
         /* If configGENERATE_RUN_TIME_STATS is defined then the following
          * macro must be defined to configure the timer/counter used to generate
          * the run time counter time base.   NOTE:  If configGENERATE_RUN_TIME_STATS
@@ -2081,6 +3837,18 @@ void vTaskStartScheduler( void )
          * FreeRTOSConfig.h file. */
         portCONFIGURE_TIMER_FOR_RUN_TIME_STATS();
 
+        #if ( configNUMBER_OF_CORES > 1 )
+            {
+                BaseType_t xCoreID;
+
+                /* Core 0 selects first, so it runs the highest priority task. */
+                for( xCoreID = 0; xCoreID < ( BaseType_t ) configNUMBER_OF_CORES; xCoreID++ )
+                {
+                    prvSelectHighestPriorityTask( xCoreID );
+                }
+            }
+        #endif
+
         traceTASK_SWITCHED_IN();
 
         /* Setting up the timer tick is hardware specific and thus in the
@@ -2126,22 +3894,38 @@ void vTaskEndScheduler( void )
 
 void vTaskSuspendAll( void )
 {
-    /* A critical section is not required as the variable is of type
-     * BaseType_t.  Please read Richard Barry's reply in the following link to a
-     * post in the FreeRTOS support forum before reporting this as a bug! -
-     * https://goo.gl/wu4acr */
-
-    /* portSOFRWARE_BARRIER() is only implemented for emulated/simulated ports that
-     * do not otherwise exhibit real time behaviour. */
-    portSOFTWARE_BARRIER();
-
-    /* The scheduler is suspended if uxSchedulerSuspended is non-zero.  An increment
-     * is used to allow calls to vTaskSuspendAll() to nest. */
-    ++uxSchedulerSuspended;
-
-    /* Enforces ordering for ports and optimised compilers that may otherwise place
-     * the above increment elsewhere. */
-    portMEMORY_BARRIER();
+    #if ( configNUMBER_OF_CORES == 1 )
+        {
+            /* A critical section is not required as the variable is of type
+             * BaseType_t.  Please read Richard Barry's reply in the following link to a
+             * post in the FreeRTOS support forum before reporting this as a bug! -
+             * https://goo.gl/wu4acr */
+
+            /* portSOFRWARE_BARRIER() is only implemented for emulated/simulated ports that
+             * do not otherwise exhibit real time behaviour. */
+            portSOFTWARE_BARRIER();
+
+            /* The scheduler is suspended if uxSchedulerSuspended is non-zero.  An increment
+             * is used to allow calls to vTaskSuspendAll() to nest. */
+            ++uxSchedulerSuspended;
+
+            /* Enforces ordering for ports and optimised compilers that may otherwise place
+             * the above increment elsewhere. */
+            portMEMORY_BARRIER();
+        }
+    #else /* configNUMBER_OF_CORES */
+        {
+            /* The task lock is held until xTaskResumeAll(), so the other cores
+             * wait before entering the kernel while the scheduler is
+             * suspended. */
+            taskENTER_CRITICAL();
+            {
+                portGET_TASK_LOCK();
+                ++uxSchedulerSuspended;
+            }
+            taskEXIT_CRITICAL();
+        }
+    #endif /* configNUMBER_OF_CORES */
 }
 /*----------------------------------------------------------*/
 
@@ -2165,14 +3949,17 @@ void vTaskSuspendAll( void )
             }
         #else
             {
-                const UBaseType_t uxLeastSignificantBit = ( UBaseType_t ) 0x01;
+                UBaseType_t uxTopPriority;
 
                 /* When port optimised task selection is used the uxTopReadyPriority
-                 * variable is used as a bit map.  If bits other than the least
-                 * significant bit are set then there are tasks that have a priority
-                 * above the idle priority that are in the Ready state.  This takes
-                 * care of the case where the co-operative scheduler is in use. */
-                if( uxTopReadyPriority > uxLeastSignificantBit )
+                 * variable is used as a bit map, of one or more levels, that only
+                 * the port reads.  If the highest ready priority is above the idle
+                 * priority then there are tasks that have a priority above the idle
+                 * priority that are in the Ready state.  This takes care of the
+                 * case where the co-operative scheduler is in use. */
+                portGET_HIGHEST_PRIORITY( uxTopPriority, uxTopReadyPriority );
+
+                if( uxTopPriority > tskIDLE_PRIORITY )
                 {
                     uxHigherPriorityReadyTasks = pdTRUE;
                 }
@@ -2226,6 +4013,14 @@ BaseType_t xTaskResumeAll( void )
     {
         --uxSchedulerSuspended;
 
+        #if ( configNUMBER_OF_CORES > 1 )
+            {
+                /* Taken by vTaskSuspendAll(), the critical section still
+                 * holds the kernel lock. */
+                portRELEASE_TASK_LOCK();
+            }
+        #endif
+
         if( uxSchedulerSuspended == ( UBaseType_t ) pdFALSE )
         {
             if( uxCurrentNumberOfTasks > ( UBaseType_t ) 0U )
@@ -2242,7 +4037,11 @@ BaseType_t xTaskResumeAll( void )
 
                     /* If the moved task has a priority higher than or equal to
                      * the current task then a yield must be performed. */
-                    if( pxTCB->uxPriority >= pxCurrentTCB->uxPriority )
+                    #if ( configNUMBER_OF_CORES == 1 )
+                        if( taskPREEMPTS_OR_SHARES_CURRENT( pxTCB ) )
+                    #else
+                        if( prvYieldForTask( pxTCB ) != pdFALSE )
+                    #endif
                     {
                         xYieldPending = pdTRUE;
                     }
@@ -2481,15 +4280,26 @@ char * pcTaskGetName( TaskHandle_t xTaskToQuery ) /*lint !e971 Unqualified char
             } while( uxQueue > ( UBaseType_t ) tskIDLE_PRIORITY ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
 
             /* Search the delayed lists. */
-            if( pxTCB == NULL )
-            {
-                pxTCB = prvSearchForNameWithinSingleList( ( List_t * ) pxDelayedTaskList, pcNameToQuery );
-            }
+            #if ( configUSE_TIMING_WHEEL == 0 )
+                {
+                    if( pxTCB == NULL )
+                    {
+                        pxTCB = prvSearchForNameWithinSingleList( ( List_t * ) pxDelayedTaskList, pcNameToQuery );
+                    }
 
-            if( pxTCB == NULL )
-            {
-                pxTCB = prvSearchForNameWithinSingleList( ( List_t * ) pxOverflowDelayedTaskList, pcNameToQuery );
-            }
+                    if( pxTCB == NULL )
+                    {
+                        pxTCB = prvSearchForNameWithinSingleList( ( List_t * ) pxOverflowDelayedTaskList, pcNameToQuery );
+                    }
+                }
+            #else
+                {
+                    for( uxQueue = 0; ( uxQueue < ( UBaseType_t ) configTIMING_WHEEL_SIZE ) && ( pxTCB == NULL ); uxQueue++ )
+                    {
+                        pxTCB = prvSearchForNameWithinSingleList( &( xDelayedTaskWheel[ uxQueue ] ), pcNameToQuery );
+                    }
+                }
+            #endif /* configUSE_TIMING_WHEEL */
 
             #if ( INCLUDE_vTaskSuspend == 1 )
                 {
@@ -2519,79 +4329,388 @@ char * pcTaskGetName( TaskHandle_t xTaskToQuery ) /*lint !e971 Unqualified char
 #endif /* INCLUDE_xTaskGetHandle */
 /*-----------------------------------------------------------*/
 
-#if ( configUSE_TRACE_FACILITY == 1 )
-
-    UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray,
-                                      const UBaseType_t uxArraySize,
-                                      configRUN_TIME_COUNTER_TYPE * const pulTotalRunTime )
+#if ( configUSE_TRACE_FACILITY == 1 )
+
+    UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray,
+                                      const UBaseType_t uxArraySize,
+                                      configRUN_TIME_COUNTER_TYPE * const pulTotalRunTime )
+    {
+        UBaseType_t uxTask = 0, uxQueue = configMAX_PRIORITIES;
+
+        vTaskSuspendAll();
+        {
+            /* Is there a space in the array for each task in the system? */
+            if( uxArraySize >= uxCurrentNumberOfTasks )
+            {
+                /* Fill in an TaskStatus_t structure with information on each
+                 * task in the Ready state. */
+                do
+                {
+                    uxQueue--;
+                    uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), &( pxReadyTasksLists[ uxQueue ] ), eReady );
+                } while( uxQueue > ( UBaseType_t ) tskIDLE_PRIORITY ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+
+                /* Fill in an TaskStatus_t structure with information on each
+                 * task in the Blocked state. */
+                #if ( configUSE_TIMING_WHEEL == 0 )
+                    {
+                        uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), ( List_t * ) pxDelayedTaskList, eBlocked );
+                        uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), ( List_t * ) pxOverflowDelayedTaskList, eBlocked );
+                    }
+                #else
+                    {
+                        for( uxQueue = 0; uxQueue < ( UBaseType_t ) configTIMING_WHEEL_SIZE; uxQueue++ )
+                        {
+                            uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), &( xDelayedTaskWheel[ uxQueue ] ), eBlocked );
+                        }
+                    }
+                #endif /* configUSE_TIMING_WHEEL */
+
+                #if ( INCLUDE_vTaskDelete == 1 )
+                    {
+                        /* Fill in an TaskStatus_t structure with information on
+                         * each task that has been deleted but not yet cleaned up. */
+                        uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), &xTasksWaitingTermination, eDeleted );
+                    }
+                #endif
+
+                #if ( INCLUDE_vTaskSuspend == 1 )
+                    {
+                        /* Fill in an TaskStatus_t structure with information on
+                         * each task in the Suspended state. */
+                        uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), &xSuspendedTaskList, eSuspended );
+                    }
+                #endif
+
+                #if ( configGENERATE_RUN_TIME_STATS == 1 )
+                    {
+                        if( pulTotalRunTime != NULL )
+                        {
+                            #ifdef portALT_GET_RUN_TIME_COUNTER_VALUE
+                                portALT_GET_RUN_TIME_COUNTER_VALUE( ( *pulTotalRunTime ) );
+                            #else
+                                *pulTotalRunTime = portGET_RUN_TIME_COUNTER_VALUE();
+                            #endif
+                        }
+                    }
+                #else /* if ( configGENERATE_RUN_TIME_STATS == 1 ) */
+                    {
+                        if( pulTotalRunTime != NULL )
+                        {
+                            *pulTotalRunTime = 0;
+                        }
+                    }
+                #endif /* if ( configGENERATE_RUN_TIME_STATS == 1 ) */
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        ( void ) xTaskResumeAll();
+
+        return uxTask;
+    }
+
+#endif /* configUSE_TRACE_FACILITY */
+/*----------------------------------------------------------*/
+
+#if ( configUSE_TASK_SNAPSHOTS == 1 )
+
+    static void prvClaimTaskSnapshot( TCB_t * pxTCB )
+    {
+        TaskSnapshotSlot_t * pxSlot;
+        UBaseType_t uxSlot, x;
+
+        for( uxSlot = 0; uxSlot < ( UBaseType_t ) configTASK_SNAPSHOT_SLOTS; uxSlot++ )
+        {
+            pxSlot = &( xTaskSnapshots[ uxSlot ] );
+
+            if( pxSlot->xSnapshot.xHandle == NULL )
+            {
+                /* Until the idle task scans the stack, all of it up to the
+                 * top of stack is taken as free.  A scan never finds more. */
+                #if ( portSTACK_GROWTH < 0 )
+                    {
+                        pxSlot->ulStackFreeBytes = ( uint32_t ) ( pxTCB->pxTopOfStack - pxTCB->pxStack + 1 ) * ( uint32_t ) sizeof( StackType_t );
+                    }
+                #else
+                    {
+                        pxSlot->ulStackFreeBytes = ( uint32_t ) ( pxTCB->pxEndOfStack - pxTCB->pxTopOfStack + 1 ) * ( uint32_t ) sizeof( StackType_t );
+                    }
+                #endif
+                pxSlot->ulStackScannedBytes = 0U;
+
+                pxSlot->uxSequence++;
+                portSEQLOCK_BARRIER();
+
+                pxSlot->xSnapshot.xHandle = ( TaskHandle_t ) pxTCB;
+                pxSlot->xSnapshot.xTaskNumber = uxTaskNumber;
+
+                for( x = ( UBaseType_t ) 0; x < ( UBaseType_t ) configMAX_TASK_NAME_LEN; x++ )
+                {
+                    pxSlot->xSnapshot.pcTaskName[ x ] = pxTCB->pcTaskName[ x ];
+                }
+
+                prvWriteTaskSnapshot( pxSlot, pxTCB, eReady );
+
+                portSEQLOCK_BARRIER();
+                pxSlot->uxSequence++;
+
+                pxTCB->pxSnapshotSlot = pxSlot;
+                break;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+
+        if( pxTCB->pxSnapshotSlot == NULL )
+        {
+            uxTasksWithoutSnapshot++;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvReleaseTaskSnapshot( TCB_t * pxTCB )
+    {
+        TaskSnapshotSlot_t * pxSlot = pxTCB->pxSnapshotSlot;
+
+        if( pxSlot != NULL )
+        {
+            pxSlot->uxSequence++;
+            portSEQLOCK_BARRIER();
+
+            pxSlot->xSnapshot.xHandle = NULL;
+
+            portSEQLOCK_BARRIER();
+            pxSlot->uxSequence++;
+
+            pxTCB->pxSnapshotSlot = NULL;
+        }
+        else
+        {
+            uxTasksWithoutSnapshot--;
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvWriteTaskSnapshot( TaskSnapshotSlot_t * pxSlot,
+                                      const TCB_t * pxTCB,
+                                      eTaskState eState )
+    {
+        pxSlot->xSnapshot.eCurrentState = eState;
+        pxSlot->xSnapshot.uxCurrentPriority = pxTCB->uxPriority;
+
+        #if ( configUSE_MUTEXES == 1 )
+            {
+                pxSlot->xSnapshot.uxBasePriority = pxTCB->uxBasePriority;
+            }
+        #else
+            {
+                pxSlot->xSnapshot.uxBasePriority = 0;
+            }
+        #endif
+
+        #if ( configGENERATE_RUN_TIME_STATS == 1 )
+            {
+                pxSlot->xSnapshot.ulRunTimeCounter = pxTCB->ulRunTimeCounter;
+            }
+        #else
+            {
+                pxSlot->xSnapshot.ulRunTimeCounter = 0;
+            }
+        #endif
+
+        pxSlot->xSnapshot.usStackHighWaterMark = ( configSTACK_DEPTH_TYPE ) ( pxSlot->ulStackFreeBytes / ( uint32_t ) sizeof( StackType_t ) );
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvPublishTaskSnapshot( const TCB_t * pxTCB,
+                                        eTaskState eState )
+    {
+        TaskSnapshotSlot_t * pxSlot = pxTCB->pxSnapshotSlot;
+
+        if( pxSlot != NULL )
+        {
+            pxSlot->uxSequence++;
+            portSEQLOCK_BARRIER();
+
+            prvWriteTaskSnapshot( pxSlot, pxTCB, eState );
+
+            portSEQLOCK_BARRIER();
+            pxSlot->uxSequence++;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvUpdateTaskSnapshots( void )
+    {
+        TaskSnapshotSlot_t * pxSlot;
+        TCB_t * pxTCB;
+        const uint8_t * pucStackByte;
+        uint32_t ulBytes = 0U;
+        BaseType_t xScanComplete = pdTRUE;
+
+        /* The critical section keeps the task from being deleted, and only
+         * lasts for configTASK_SNAPSHOT_SCAN_BYTES compares. */
+        taskENTER_CRITICAL();
+        {
+            pxSlot = &( xTaskSnapshots[ uxSnapshotScanSlot ] );
+            pxTCB = pxSlot->xSnapshot.xHandle;
+
+            if( pxTCB != NULL )
+            {
+                /* The fill bytes are counted from the far end of the stack,
+                 * resuming where the last call stopped.  A byte the task wrote
+                 * over never holds the fill value again, so the scan stops at
+                 * the length found by the previous one. */
+                #if ( portSTACK_GROWTH < 0 )
+                    {
+                        pucStackByte = ( const uint8_t * ) pxTCB->pxStack + pxSlot->ulStackScannedBytes;
+                    }
+                #else
+                    {
+                        pucStackByte = ( const uint8_t * ) pxTCB->pxEndOfStack - pxSlot->ulStackScannedBytes;
+                    }
+                #endif
+
+                while( ( pxSlot->ulStackScannedBytes < pxSlot->ulStackFreeBytes ) && ( *pucStackByte == ( uint8_t ) tskSTACK_FILL_BYTE ) )
+                {
+                    if( ulBytes == ( uint32_t ) configTASK_SNAPSHOT_SCAN_BYTES )
+                    {
+                        xScanComplete = pdFALSE;
+                        break;
+                    }
+
+                    pucStackByte -= portSTACK_GROWTH;
+                    pxSlot->ulStackScannedBytes++;
+                    ulBytes++;
+                }
+
+                if( xScanComplete != pdFALSE )
+                {
+                    pxSlot->ulStackFreeBytes = pxSlot->ulStackScannedBytes;
+                    pxSlot->ulStackScannedBytes = 0U;
+
+                    taskPUBLISH_SNAPSHOT( pxTCB );
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            if( xScanComplete != pdFALSE )
+            {
+                uxSnapshotScanSlot = ( uxSnapshotScanSlot + ( UBaseType_t ) 1U ) % ( UBaseType_t ) configTASK_SNAPSHOT_SLOTS;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        taskEXIT_CRITICAL();
+    }
+/*-----------------------------------------------------------*/
+
+    UBaseType_t uxTaskGetSnapshot( TaskSnapshot_t * const pxSnapshotArray,
+                                   const UBaseType_t uxArraySize,
+                                   configRUN_TIME_COUNTER_TYPE * const pulTotalRunTime,
+                                   BaseType_t * const pxTruncated )
     {
-        UBaseType_t uxTask = 0, uxQueue = configMAX_PRIORITIES;
+        const TaskSnapshotSlot_t * pxSlot;
+        UBaseType_t uxSlot, uxSequence, uxTask = 0;
+        BaseType_t xTruncated;
 
-        vTaskSuspendAll();
+        for( uxSlot = 0; ( uxSlot < ( UBaseType_t ) configTASK_SNAPSHOT_SLOTS ) && ( uxTask < uxArraySize ); uxSlot++ )
         {
-            /* Is there a space in the array for each task in the system? */
-            if( uxArraySize >= uxCurrentNumberOfTasks )
-            {
-                /* Fill in an TaskStatus_t structure with information on each
-                 * task in the Ready state. */
-                do
-                {
-                    uxQueue--;
-                    uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), &( pxReadyTasksLists[ uxQueue ] ), eReady );
-                } while( uxQueue > ( UBaseType_t ) tskIDLE_PRIORITY ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+            pxSlot = &( xTaskSnapshots[ uxSlot ] );
 
-                /* Fill in an TaskStatus_t structure with information on each
-                 * task in the Blocked state. */
-                uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), ( List_t * ) pxDelayedTaskList, eBlocked );
-                uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), ( List_t * ) pxOverflowDelayedTaskList, eBlocked );
+            /* Copy the slot again if the kernel was writing it. */
+            do
+            {
+                uxSequence = pxSlot->uxSequence;
+                portSEQLOCK_BARRIER();
 
-                #if ( INCLUDE_vTaskDelete == 1 )
-                    {
-                        /* Fill in an TaskStatus_t structure with information on
-                         * each task that has been deleted but not yet cleaned up. */
-                        uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), &xTasksWaitingTermination, eDeleted );
-                    }
-                #endif
+                pxSnapshotArray[ uxTask ] = pxSlot->xSnapshot;
 
-                #if ( INCLUDE_vTaskSuspend == 1 )
-                    {
-                        /* Fill in an TaskStatus_t structure with information on
-                         * each task in the Suspended state. */
-                        uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), &xSuspendedTaskList, eSuspended );
-                    }
-                #endif
+                portSEQLOCK_BARRIER();
+            } while( ( ( uxSequence & ( UBaseType_t ) 1U ) != ( UBaseType_t ) 0U ) || ( uxSequence != pxSlot->uxSequence ) );
 
-                #if ( configGENERATE_RUN_TIME_STATS == 1 )
-                    {
-                        if( pulTotalRunTime != NULL )
-                        {
-                            #ifdef portALT_GET_RUN_TIME_COUNTER_VALUE
-                                portALT_GET_RUN_TIME_COUNTER_VALUE( ( *pulTotalRunTime ) );
-                            #else
-                                *pulTotalRunTime = portGET_RUN_TIME_COUNTER_VALUE();
-                            #endif
-                        }
-                    }
-                #else /* if ( configGENERATE_RUN_TIME_STATS == 1 ) */
-                    {
-                        if( pulTotalRunTime != NULL )
-                        {
-                            *pulTotalRunTime = 0;
-                        }
-                    }
-                #endif /* if ( configGENERATE_RUN_TIME_STATS == 1 ) */
+            if( pxSnapshotArray[ uxTask ].xHandle != NULL )
+            {
+                uxTask++;
             }
             else
             {
                 mtCOVERAGE_TEST_MARKER();
             }
         }
-        ( void ) xTaskResumeAll();
+
+        if( pxTruncated != NULL )
+        {
+            /* Tasks are left out if they have no slot, or if the array was
+             * filled before the last slot in use. */
+            xTruncated = ( uxTasksWithoutSnapshot > ( UBaseType_t ) 0U ) ? pdTRUE : pdFALSE;
+
+            for( ; ( uxSlot < ( UBaseType_t ) configTASK_SNAPSHOT_SLOTS ) && ( xTruncated == pdFALSE ); uxSlot++ )
+            {
+                if( xTaskSnapshots[ uxSlot ].xSnapshot.xHandle != NULL )
+                {
+                    xTruncated = pdTRUE;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+
+            *pxTruncated = xTruncated;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        if( pulTotalRunTime != NULL )
+        {
+            #if ( configGENERATE_RUN_TIME_STATS == 1 )
+                {
+                    #ifdef portALT_GET_RUN_TIME_COUNTER_VALUE
+                        portALT_GET_RUN_TIME_COUNTER_VALUE( ( *pulTotalRunTime ) );
+                    #else
+                        *pulTotalRunTime = portGET_RUN_TIME_COUNTER_VALUE();
+                    #endif
+                }
+            #else
+                {
+                    *pulTotalRunTime = 0;
+                }
+            #endif
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
 
         return uxTask;
     }
 
-#endif /* configUSE_TRACE_FACILITY */
+#endif /* configUSE_TASK_SNAPSHOTS */
 /*----------------------------------------------------------*/
 
 #if ( INCLUDE_xTaskGetIdleTaskHandle == 1 )
@@ -2632,7 +4751,7 @@ BaseType_t xTaskCatchUpTicks( TickType_t xTicksToCatchUp )
 
     /* Must not be called with the scheduler suspended as the implementation
      * relies on xPendedTicks being wound down to 0 in xTaskResumeAll(). */
-    configASSERT( uxSchedulerSuspended == 0 );
+    taskASSERT_SCHEDULER_NOT_SUSPENDED();
 
     /* Use xPendedTicks to mimic xTicksToCatchUp number of ticks occurring when
      * the scheduler is suspended so the ticks are executed in xTaskResumeAll(). */
@@ -2698,7 +4817,11 @@ BaseType_t xTaskCatchUpTicks( TickType_t xTicksToCatchUp )
                         /* Preemption is on, but a context switch should only be
                          * performed if the unblocked task has a priority that is
                          * higher than the currently executing task. */
-                        if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+                        #if ( configNUMBER_OF_CORES == 1 )
+                            if( taskPREEMPTS_CURRENT( pxTCB ) )
+                        #else
+                            if( prvYieldForTask( pxTCB ) != pdFALSE )
+                        #endif
                         {
                             /* Pend the yield to be performed when the scheduler
                              * is unsuspended. */
@@ -2726,8 +4849,10 @@ BaseType_t xTaskCatchUpTicks( TickType_t xTicksToCatchUp )
 
 BaseType_t xTaskIncrementTick( void )
 {
-    TCB_t * pxTCB;
-    TickType_t xItemValue;
+    #if ( configUSE_TIMING_WHEEL == 0 )
+        TCB_t * pxTCB;
+        TickType_t xItemValue;
+    #endif
     BaseType_t xSwitchRequired = pdFALSE;
 
     /* Called by the portable layer each time a tick interrupt occurs.
@@ -2758,6 +4883,12 @@ BaseType_t xTaskIncrementTick( void )
          * the  queue in the order of their wake time - meaning once one task
          * has been found whose block time has not expired there is no need to
          * look any further down the list. */
+        #if ( configUSE_TIMING_WHEEL == 1 )
+            if( xConstTickCount >= xNextTaskUnblockTime )
+            {
+                xSwitchRequired = prvProcessTimingWheel( xConstTickCount );
+            }
+        #else
         if( xConstTickCount >= xNextTaskUnblockTime )
         {
             for( ; ; )
@@ -2822,7 +4953,11 @@ BaseType_t xTaskIncrementTick( void )
                              * only be performed if the unblocked task has a
                              * priority that is equal to or higher than the
                              * currently executing task. */
-                            if( pxTCB->uxPriority >= pxCurrentTCB->uxPriority )
+                            #if ( configNUMBER_OF_CORES == 1 )
+                                if( taskPREEMPTS_OR_SHARES_CURRENT( pxTCB ) )
+                            #else
+                                if( prvYieldForTask( pxTCB ) != pdFALSE )
+                            #endif
                             {
                                 xSwitchRequired = pdTRUE;
                             }
@@ -2835,11 +4970,12 @@ BaseType_t xTaskIncrementTick( void )
                 }
             }
         }
+        #endif /* configUSE_TIMING_WHEEL */
 
         /* Tasks of equal priority to the currently running task will share
          * processing time (time slice) if preemption is on, and the application
          * writer has not explicitly turned time slicing off. */
-        #if ( ( configUSE_PREEMPTION == 1 ) && ( configUSE_TIME_SLICING == 1 ) )
+        #if ( ( configUSE_PREEMPTION == 1 ) && ( configUSE_TIME_SLICING == 1 ) && ( configNUMBER_OF_CORES == 1 ) )
             {
                 if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ pxCurrentTCB->uxPriority ] ) ) > ( UBaseType_t ) 1 )
                 {
@@ -2850,8 +4986,52 @@ BaseType_t xTaskIncrementTick( void )
                     mtCOVERAGE_TEST_MARKER();
                 }
             }
+        #elif ( ( configUSE_PREEMPTION == 1 ) && ( configUSE_TIME_SLICING == 1 ) )
+            {
+                BaseType_t xCoreID, x;
+                UBaseType_t uxPriority, uxRunning;
+
+                /* A core time slices when its priority has more ready tasks
+                 * than cores running them.  The switch of the calling core is
+                 * returned through xYieldPending below. */
+                for( xCoreID = 0; xCoreID < ( BaseType_t ) configNUMBER_OF_CORES; xCoreID++ )
+                {
+                    uxPriority = pxCurrentTCBs[ xCoreID ]->uxPriority;
+                    uxRunning = 0U;
+
+                    for( x = 0; x < ( BaseType_t ) configNUMBER_OF_CORES; x++ )
+                    {
+                        if( pxCurrentTCBs[ x ]->uxPriority == uxPriority )
+                        {
+                            uxRunning++;
+                        }
+                    }
+
+                    if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ uxPriority ] ) ) > uxRunning )
+                    {
+                        ( void ) prvYieldCore( xCoreID );
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+            }
         #endif /* ( ( configUSE_PREEMPTION == 1 ) && ( configUSE_TIME_SLICING == 1 ) ) */
 
+        #if ( configUSE_TASK_BUDGETS == 1 )
+            {
+                if( prvProcessBudgets( xConstTickCount ) != pdFALSE )
+                {
+                    xSwitchRequired = pdTRUE;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+        #endif /* configUSE_TASK_BUDGETS */
+
         #if ( configUSE_TICK_HOOK == 1 )
             {
                 /* Guard against the tick hook being called when the pended tick
@@ -3039,50 +5219,248 @@ void vTaskSwitchContext( void )
                  * are provided by the application, not the kernel. */
                 if( ulTotalRunTime > ulTaskSwitchedInTime )
                 {
-                    pxCurrentTCB->ulRunTimeCounter += ( ulTotalRunTime - ulTaskSwitchedInTime );
+                    pxCurrentTCB->ulRunTimeCounter += ( ulTotalRunTime - ulTaskSwitchedInTime );
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                ulTaskSwitchedInTime = ulTotalRunTime;
+            }
+        #endif /* configGENERATE_RUN_TIME_STATS */
+
+        /* Check for stack overflow, if configured. */
+        taskCHECK_FOR_STACK_OVERFLOW();
+
+        #if ( configUSE_TASK_BUDGETS == 1 )
+            {
+                /* A task that ran past its budget while holding a mutex is
+                 * throttled when it switches out without one, if still
+                 * ready. */
+                if( pxCurrentTCB->ucBudgetState == taskBUDGET_EXHAUSTED )
+                {
+                    ( void ) prvThrottleTask( pxCurrentTCB );
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+        #endif
+
+        #if ( configUSE_TASK_SNAPSHOTS == 1 )
+            {
+                /* The task switched out is published with its run time and
+                 * the state it leaves for. */
+                prvPublishTaskSnapshot( pxCurrentTCB, prvGetTaskStateFromLists( pxCurrentTCB ) );
+            }
+        #endif
+
+        /* Before the currently running task is switched out, save its errno. */
+        #if ( configUSE_POSIX_ERRNO == 1 )
+            {
+                pxCurrentTCB->iTaskErrno = FreeRTOS_errno;
+            }
+        #endif
+
+        /* Select a new task to run using either the generic C or port
+         * optimised asm code. */
+        taskSELECT_HIGHEST_PRIORITY_TASK(); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+        traceTASK_SWITCHED_IN();
+
+        #if ( configUSE_TASK_SNAPSHOTS == 1 )
+            {
+                prvPublishTaskSnapshot( pxCurrentTCB, eRunning );
+            }
+        #endif
+
+        /* After the new task is switched in, update the global errno. */
+        #if ( configUSE_POSIX_ERRNO == 1 )
+            {
+                FreeRTOS_errno = pxCurrentTCB->iTaskErrno;
+            }
+        #endif
+
+        #if ( configUSE_NEWLIB_REENTRANT == 1 )
+            {
+                /* Switch Newlib's _impure_ptr variable to point to the _reent
+                 * structure specific to this task.
+                 * See the third party link http://www.nadler.com/embedded/newlibAndFreeRTOS.html
+                 * for additional information. */
+                _impure_ptr = &( pxCurrentTCB->xNewLib_reent );
+            }
+        #endif /* configUSE_NEWLIB_REENTRANT */
+    }
+}
+/*-----------------------------------------------------------*/
+
+#if ( configNUMBER_OF_CORES > 1 )
+
+    static void prvSelectHighestPriorityTask( BaseType_t xCoreID )
+    {
+        UBaseType_t uxTopPriority = uxTopReadyPriority;
+        List_t * pxReadyList;
+        ListItem_t * pxIterator;
+        TCB_t * pxCandidate;
+        TCB_t * pxTCB = NULL;
+        UBaseType_t uxCount;
+
+        /* The task switched out may now be selected by any core. */
+        if( ( pxCurrentTCBs[ xCoreID ] != NULL ) && ( pxCurrentTCBs[ xCoreID ]->xTaskRunState == xCoreID ) )
+        {
+            pxCurrentTCBs[ xCoreID ]->xTaskRunState = taskTASK_NOT_RUNNING;
+        }
+
+        /* Find the highest priority queue that contains ready tasks. */
+        while( listLIST_IS_EMPTY( &( pxReadyTasksLists[ uxTopPriority ] ) ) )
+        {
+            configASSERT( uxTopPriority );
+            --uxTopPriority;
+        }
+
+        uxTopReadyPriority = uxTopPriority;
+
+        /* The tasks of a priority may all be running on other cores or not be
+         * allowed on this one, the next priority down is searched then.  An
+         * idle task is always left at the idle priority. */
+        for( ; ; )
+        {
+            pxReadyList = &( pxReadyTasksLists[ uxTopPriority ] );
+            pxIterator = pxReadyList->pxIndex;
+
+            #if ( configUSE_EDF_SCHEDULING == 1 )
+                {
+                    /* The EDF ready list is walked from its head, the
+                     * earliest deadline. */
+                    if( uxTopPriority == ( UBaseType_t ) configEDF_PRIORITY )
+                    {
+                        pxIterator = ( ListItem_t * ) &( pxReadyList->xListEnd );
+                    }
+                }
+            #endif
+
+            /* Walk the list once from the entry after the index, as
+             * listGET_OWNER_OF_NEXT_ENTRY() does, so the tasks of the same
+             * priority get an equal share of the cores. */
+            for( uxCount = listCURRENT_LIST_LENGTH( pxReadyList ); uxCount > ( UBaseType_t ) 0; uxCount-- )
+            {
+                pxIterator = pxIterator->pxNext;
+
+                if( ( void * ) pxIterator == ( void * ) &( pxReadyList->xListEnd ) )
+                {
+                    pxIterator = pxIterator->pxNext;
+                }
+
+                pxCandidate = listGET_LIST_ITEM_OWNER( pxIterator );
+
+                if( ( pxCandidate->xTaskRunState == taskTASK_NOT_RUNNING ) && taskCORE_ALLOWED( pxCandidate, xCoreID ) )
+                {
+                    pxReadyList->pxIndex = pxIterator;
+                    pxTCB = pxCandidate;
+                    break;
+                }
+            }
+
+            if( pxTCB != NULL )
+            {
+                break;
+            }
+
+            configASSERT( uxTopPriority );
+            --uxTopPriority;
+        }
+
+        pxTCB->xTaskRunState = xCoreID;
+        pxCurrentTCBs[ xCoreID ] = pxTCB;
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvYieldCore( BaseType_t xCoreID )
+    {
+        BaseType_t xReturn = pdFALSE;
+
+        xYieldPendings[ xCoreID ] = pdTRUE;
+
+        if( xCoreID == portGET_CORE_ID() )
+        {
+            xReturn = pdTRUE;
+        }
+        else
+        {
+            portYIELD_CORE( xCoreID );
+        }
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvYieldForTask( const TCB_t * pxTCB )
+    {
+        BaseType_t xReturn = pdFALSE;
+        BaseType_t xLocalCore = portGET_CORE_ID();
+        BaseType_t xLowestCore = -1;
+        BaseType_t xCoreID, x;
+        UBaseType_t uxLowestPriority, uxCorePriority;
+        const TCB_t * pxRunning;
+
+        #if ( configUSE_PREEMPTION == 1 )
+            if( ( xSchedulerRunning != pdFALSE ) &&
+                ( pxTCB->xTaskRunState == taskTASK_NOT_RUNNING ) &&
+                ( listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ pxTCB->uxPriority ] ), &( pxTCB->xStateListItem ) ) != pdFALSE ) )
+            {
+                /* An idle task counts one below the idle priority, so a task of
+                 * the idle priority preempts it.  The calling core is tried
+                 * first, so it keeps the switch when cores tie. */
+                uxLowestPriority = pxTCB->uxPriority + 1U;
+
+                for( x = 0; x < ( BaseType_t ) configNUMBER_OF_CORES; x++ )
+                {
+                    xCoreID = ( xLocalCore + x ) % ( BaseType_t ) configNUMBER_OF_CORES;
+                    pxRunning = pxCurrentTCBs[ xCoreID ];
+
+                    if( ( xYieldPendings[ xCoreID ] != pdFALSE ) || ( taskCORE_ALLOWED( pxTCB, xCoreID ) == pdFALSE ) )
+                    {
+                        /* The core selects again anyway, or cannot run the
+                         * task. */
+                        continue;
+                    }
+
+                    uxCorePriority = pxRunning->uxPriority + ( ( pxRunning->xIsIdle != pdFALSE ) ? 0U : 1U );
+
+                    if( uxCorePriority < uxLowestPriority )
+                    {
+                        uxLowestPriority = uxCorePriority;
+                        xLowestCore = xCoreID;
+                    }
+                }
+
+                if( xLowestCore >= 0 )
+                {
+                    xReturn = prvYieldCore( xLowestCore );
                 }
                 else
                 {
                     mtCOVERAGE_TEST_MARKER();
                 }
-
-                ulTaskSwitchedInTime = ulTotalRunTime;
-            }
-        #endif /* configGENERATE_RUN_TIME_STATS */
-
-        /* Check for stack overflow, if configured. */
-        taskCHECK_FOR_STACK_OVERFLOW();
-
-        /* Before the currently running task is switched out, save its errno. */
-        #if ( configUSE_POSIX_ERRNO == 1 )
-            {
-                pxCurrentTCB->iTaskErrno = FreeRTOS_errno;
             }
-        #endif
-
-        /* Select a new task to run using either the generic C or port
-         * optimised asm code. */
-        taskSELECT_HIGHEST_PRIORITY_TASK(); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
-        traceTASK_SWITCHED_IN();
-
-        /* After the new task is switched in, update the global errno. */
-        #if ( configUSE_POSIX_ERRNO == 1 )
+        #else /* configUSE_PREEMPTION */
             {
-                FreeRTOS_errno = pxCurrentTCB->iTaskErrno;
+                ( void ) pxTCB;
+                ( void ) xLocalCore;
+                ( void ) xLowestCore;
+                ( void ) xCoreID;
+                ( void ) x;
+                ( void ) uxLowestPriority;
+                ( void ) uxCorePriority;
+                ( void ) pxRunning;
             }
-        #endif
+        #endif /* configUSE_PREEMPTION */
 
-        #if ( configUSE_NEWLIB_REENTRANT == 1 )
-            {
-                /* Switch Newlib's _impure_ptr variable to point to the _reent
-                 * structure specific to this task.
-                 * See the third party link http://www.nadler.com/embedded/newlibAndFreeRTOS.html
-                 * for additional information. */
-                _impure_ptr = &( pxCurrentTCB->xNewLib_reent );
-            }
-        #endif /* configUSE_NEWLIB_REENTRANT */
+        return xReturn;
     }
-}
+
+#endif /* configNUMBER_OF_CORES */
 /*-----------------------------------------------------------*/
 
 void vTaskPlaceOnEventList( List_t * const pxEventList,
@@ -3219,7 +5597,8 @@ BaseType_t xTaskRemoveFromEventList( const List_t * const pxEventList )
         listINSERT_END( &( xPendingReadyList ), &( pxUnblockedTCB->xEventListItem ) );
     }
 
-    if( pxUnblockedTCB->uxPriority > pxCurrentTCB->uxPriority )
+    #if ( configNUMBER_OF_CORES == 1 )
+    if( taskPREEMPTS_CURRENT( pxUnblockedTCB ) )
     {
         /* Return true if the task removed from the event list has a higher
          * priority than the calling task.  This allows the calling task to know if
@@ -3234,6 +5613,13 @@ BaseType_t xTaskRemoveFromEventList( const List_t * const pxEventList )
     {
         xReturn = pdFALSE;
     }
+    #else /* configNUMBER_OF_CORES */
+
+    /* Return true if the task preempts the calling core, the yield is marked
+     * pending on the core selected.  A task held in the pending ready list is
+     * placed when the scheduler is resumed. */
+    xReturn = prvYieldForTask( pxUnblockedTCB );
+    #endif /* configNUMBER_OF_CORES */
 
     return xReturn;
 }
@@ -3277,7 +5663,8 @@ void vTaskRemoveFromUnorderedEventList( ListItem_t * pxEventListItem,
     listREMOVE_ITEM( &( pxUnblockedTCB->xStateListItem ) );
     prvAddTaskToReadyList( pxUnblockedTCB );
 
-    if( pxUnblockedTCB->uxPriority > pxCurrentTCB->uxPriority )
+    #if ( configNUMBER_OF_CORES == 1 )
+    if( taskPREEMPTS_CURRENT( pxUnblockedTCB ) )
     {
         /* The unblocked task has a priority above that of the calling task, so
          * a context switch is required.  This function is called with the
@@ -3285,6 +5672,11 @@ void vTaskRemoveFromUnorderedEventList( ListItem_t * pxEventListItem,
          * occurs immediately that the scheduler is resumed (unsuspended). */
         xYieldPending = pdTRUE;
     }
+    #else
+
+    /* xYieldPending of the core selected is set. */
+    ( void ) prvYieldForTask( pxUnblockedTCB );
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -3448,6 +5840,13 @@ static portTASK_FUNCTION( prvIdleTask, pvParameters )
          * is responsible for freeing the deleted task's TCB and stack. */
         prvCheckTasksWaitingTermination();
 
+        #if ( configUSE_TASK_SNAPSHOTS == 1 )
+            {
+                /* Scan a part of a task stack for the task snapshots. */
+                prvUpdateTaskSnapshots();
+            }
+        #endif
+
         #if ( configUSE_PREEMPTION == 0 )
             {
                 /* If we are not using preemption we keep forcing a task switch to
@@ -3468,8 +5867,9 @@ static portTASK_FUNCTION( prvIdleTask, pvParameters )
                  * A critical region is not required here as we are just reading from
                  * the list, and an occasional incorrect value will not matter.  If
                  * the ready list at the idle priority contains more than one task
-                 * then a task other than the idle task is ready to execute. */
-                if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ tskIDLE_PRIORITY ] ) ) > ( UBaseType_t ) 1 )
+                 * (one per core) then a task other than an idle task is ready to
+                 * execute. */
+                if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ tskIDLE_PRIORITY ] ) ) > ( UBaseType_t ) configNUMBER_OF_CORES )
                 {
                     taskYIELD();
                 }
@@ -3546,6 +5946,49 @@ static portTASK_FUNCTION( prvIdleTask, pvParameters )
 }
 /*-----------------------------------------------------------*/
 
+#if ( configNUMBER_OF_CORES > 1 )
+
+    static portTASK_FUNCTION( prvPassiveIdleTask, pvParameters )
+    {
+        ( void ) pvParameters;
+
+        for( ; ; )
+        {
+            #if ( configUSE_PREEMPTION == 0 )
+                {
+                    taskYIELD();
+                }
+            #endif /* configUSE_PREEMPTION */
+
+            #if ( ( configUSE_PREEMPTION == 1 ) && ( configIDLE_SHOULD_YIELD == 1 ) )
+                {
+                    /* See prvIdleTask(). */
+                    if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ tskIDLE_PRIORITY ] ) ) > ( UBaseType_t ) configNUMBER_OF_CORES )
+                    {
+                        taskYIELD();
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+            #endif /* ( ( configUSE_PREEMPTION == 1 ) && ( configIDLE_SHOULD_YIELD == 1 ) ) */
+
+            #if ( configUSE_PASSIVE_IDLE_HOOK == 1 )
+                {
+                    extern void vApplicationPassiveIdleHook( void );
+
+                    /* The hook of the cores other than core 0, which runs
+                     * vApplicationIdleHook().  It MUST NOT block either. */
+                    vApplicationPassiveIdleHook();
+                }
+            #endif /* configUSE_PASSIVE_IDLE_HOOK */
+        }
+    }
+
+#endif /* configNUMBER_OF_CORES */
+/*-----------------------------------------------------------*/
+
 #if ( configUSE_TICKLESS_IDLE != 0 )
 
     eSleepModeStatus eTaskConfirmSleepModeStatus( void )
@@ -3663,8 +6106,20 @@ static void prvInitialiseTaskLists( void )
         vListInitialise( &( pxReadyTasksLists[ uxPriority ] ) );
     }
 
-    vListInitialise( &xDelayedTaskList1 );
-    vListInitialise( &xDelayedTaskList2 );
+    #if ( configUSE_TIMING_WHEEL == 0 )
+        {
+            vListInitialise( &xDelayedTaskList1 );
+            vListInitialise( &xDelayedTaskList2 );
+        }
+    #else
+        {
+            for( uxPriority = ( UBaseType_t ) 0U; uxPriority < ( UBaseType_t ) configTIMING_WHEEL_SIZE; uxPriority++ )
+            {
+                vListInitialise( &( xDelayedTaskWheel[ uxPriority ] ) );
+            }
+        }
+    #endif /* configUSE_TIMING_WHEEL */
+
     vListInitialise( &xPendingReadyList );
 
     #if ( INCLUDE_vTaskDelete == 1 )
@@ -3679,10 +6134,14 @@ static void prvInitialiseTaskLists( void )
         }
     #endif /* INCLUDE_vTaskSuspend */
 
-    /* Start with pxDelayedTaskList using list1 and the pxOverflowDelayedTaskList
-     * using list2. */
-    pxDelayedTaskList = &xDelayedTaskList1;
-    pxOverflowDelayedTaskList = &xDelayedTaskList2;
+    #if ( configUSE_TIMING_WHEEL == 0 )
+        {
+            /* Start with pxDelayedTaskList using list1 and the pxOverflowDelayedTaskList
+             * using list2. */
+            pxDelayedTaskList = &xDelayedTaskList1;
+            pxOverflowDelayedTaskList = &xDelayedTaskList2;
+        }
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -3698,6 +6157,7 @@ static void prvCheckTasksWaitingTermination( void )
              * being called too often in the idle task. */
             while( uxDeletedTasksWaitingCleanUp > ( UBaseType_t ) 0U )
             {
+                #if ( configNUMBER_OF_CORES == 1 )
                 taskENTER_CRITICAL();
                 {
                     pxTCB = listGET_OWNER_OF_HEAD_ENTRY( ( &xTasksWaitingTermination ) ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
@@ -3706,6 +6166,36 @@ static void prvCheckTasksWaitingTermination( void )
                     --uxDeletedTasksWaitingCleanUp;
                 }
                 taskEXIT_CRITICAL();
+                #else /* configNUMBER_OF_CORES */
+                pxTCB = NULL;
+
+                taskENTER_CRITICAL();
+                {
+                    /* A task deleted while running on another core is freed
+                     * once that core has switched it out. */
+                    if( uxDeletedTasksWaitingCleanUp > ( UBaseType_t ) 0U )
+                    {
+                        pxTCB = listGET_OWNER_OF_HEAD_ENTRY( ( &xTasksWaitingTermination ) ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+
+                        if( pxTCB->xTaskRunState == taskTASK_NOT_RUNNING )
+                        {
+                            ( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+                            --uxCurrentNumberOfTasks;
+                            --uxDeletedTasksWaitingCleanUp;
+                        }
+                        else
+                        {
+                            pxTCB = NULL;
+                        }
+                    }
+                }
+                taskEXIT_CRITICAL();
+
+                if( pxTCB == NULL )
+                {
+                    break;
+                }
+                #endif /* configNUMBER_OF_CORES */
 
                 prvDeleteTCB( pxTCB );
             }
@@ -3757,7 +6247,11 @@ static void prvCheckTasksWaitingTermination( void )
          * state is just set to whatever is passed in. */
         if( eState != eInvalid )
         {
-            if( pxTCB == pxCurrentTCB )
+            #if ( configNUMBER_OF_CORES == 1 )
+                if( pxTCB == pxCurrentTCB )
+            #else
+                if( taskTASK_IS_RUNNING( pxTCB ) )
+            #endif
             {
                 pxTaskStatus->eCurrentState = eRunning;
             }
@@ -3994,28 +6488,198 @@ static void prvCheckTasksWaitingTermination( void )
 #endif /* INCLUDE_vTaskDelete */
 /*-----------------------------------------------------------*/
 
-static void prvResetNextTaskUnblockTime( void )
-{
-    if( listLIST_IS_EMPTY( pxDelayedTaskList ) != pdFALSE )
+#if ( configUSE_TIMING_WHEEL == 0 )
+
+    static void prvResetNextTaskUnblockTime( void )
     {
-        /* The new current delayed list is empty.  Set xNextTaskUnblockTime to
-         * the maximum possible value so it is  extremely unlikely that the
-         * if( xTickCount >= xNextTaskUnblockTime ) test will pass until
-         * there is an item in the delayed list. */
-        xNextTaskUnblockTime = portMAX_DELAY;
+        if( listLIST_IS_EMPTY( pxDelayedTaskList ) != pdFALSE )
+        {
+            /* The new current delayed list is empty.  Set xNextTaskUnblockTime to
+             * the maximum possible value so it is  extremely unlikely that the
+             * if( xTickCount >= xNextTaskUnblockTime ) test will pass until
+             * there is an item in the delayed list. */
+            xNextTaskUnblockTime = portMAX_DELAY;
+        }
+        else
+        {
+            /* The new current delayed list is not empty, get the value of
+             * the item at the head of the delayed list.  This is the time at
+             * which the task at the head of the delayed list should be removed
+             * from the Blocked state. */
+            xNextTaskUnblockTime = listGET_ITEM_VALUE_OF_HEAD_ENTRY( pxDelayedTaskList );
+        }
     }
-    else
+
+#else /* configUSE_TIMING_WHEEL */
+
+    static void prvResetNextTaskUnblockTime( void )
+    {
+        TickType_t xSlot, xIndex, xDistance, xMinDistance = portMAX_DELAY, xNextUnblockTime;
+        BaseType_t xFound = pdFALSE;
+
+        /* Only the earliest wake time of each slot is read, so the cost does
+         * not depend on the number of delayed tasks.  The slots are visited in
+         * the order of their next tick from the last one processed.  A task in
+         * the slot visited at xSlot wakes xSlot ticks from it, or whole turns
+         * of the wheel later, so once a task waking within xSlot ticks has
+         * been found no later slot holds an earlier one.  The earliest wake
+         * time of a slot can be earlier than that of its tasks when a task was
+         * removed before its wake time: the tick then only processes the slot
+         * early, which updates it. */
+        for( xSlot = 0; xSlot < ( TickType_t ) configTIMING_WHEEL_SIZE; xSlot++ )
+        {
+            xIndex = taskTIMING_WHEEL_INDEX( xTimingWheelTime + xSlot );
+
+            if( listLIST_IS_EMPTY( &( xDelayedTaskWheel[ xIndex ] ) ) == pdFALSE )
+            {
+                xDistance = xTimingWheelSlotWake[ xIndex ] - xTimingWheelTime;
+
+                if( ( xFound == pdFALSE ) || ( xDistance < xMinDistance ) )
+                {
+                    xMinDistance = xDistance;
+                    xFound = pdTRUE;
+                }
+
+                if( xMinDistance <= xSlot )
+                {
+                    break;
+                }
+            }
+        }
+
+        if( xFound == pdFALSE )
+        {
+            /* The wheel is empty. */
+            xNextTaskUnblockTime = portMAX_DELAY;
+        }
+        else
+        {
+            xNextUnblockTime = xTimingWheelTime + xMinDistance;
+
+            if( ( xMinDistance > ( xTickCount - xTimingWheelTime ) ) && ( xNextUnblockTime < xTickCount ) )
+            {
+                /* The earliest wake time is beyond the tick count overflow,
+                 * it is looked for again when the tick count wraps. */
+                xNextTaskUnblockTime = portMAX_DELAY;
+            }
+            else
+            {
+                xNextTaskUnblockTime = xNextUnblockTime;
+            }
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvProcessTimingWheel( const TickType_t xConstTickCount )
     {
-        /* The new current delayed list is not empty, get the value of
-         * the item at the head of the delayed list.  This is the time at
-         * which the task at the head of the delayed list should be removed
-         * from the Blocked state. */
-        xNextTaskUnblockTime = listGET_ITEM_VALUE_OF_HEAD_ENTRY( pxDelayedTaskList );
+        const TickType_t xElapsed = xConstTickCount - xTimingWheelTime;
+        TickType_t xSlot, xSlots, xIndex, xDistance, xMinDistance;
+        List_t * pxList;
+        ListItem_t * pxItem, * pxNextItem;
+        TCB_t * pxTCB;
+        BaseType_t xSwitchRequired = pdFALSE;
+
+        /* The slot of the last tick processed is visited again, for the tasks
+         * delayed by 0 ticks after it was, then each slot up to the current
+         * tick, at most once when the tick count jumped a whole turn. */
+        if( xElapsed < ( TickType_t ) configTIMING_WHEEL_SIZE )
+        {
+            xSlots = xElapsed + ( TickType_t ) 1;
+        }
+        else
+        {
+            xSlots = ( TickType_t ) configTIMING_WHEEL_SIZE;
+        }
+
+        for( xSlot = 0; xSlot < xSlots; xSlot++ )
+        {
+            xIndex = taskTIMING_WHEEL_INDEX( xTimingWheelTime + xSlot );
+            pxList = &( xDelayedTaskWheel[ xIndex ] );
+
+            /* A slot whose tasks all wake after the current tick is left as
+             * it is. */
+            if( ( listLIST_IS_EMPTY( pxList ) == pdFALSE ) &&
+                ( ( xTimingWheelSlotWake[ xIndex ] - xTimingWheelTime ) <= xElapsed ) )
+            {
+                pxItem = listGET_HEAD_ENTRY( pxList );
+                xMinDistance = portMAX_DELAY;
+
+                while( pxItem != listGET_END_MARKER( pxList ) )
+                {
+                    pxNextItem = listGET_NEXT( pxItem );
+                    xDistance = listGET_LIST_ITEM_VALUE( pxItem ) - xConstTickCount;
+
+                    /* The other tasks of the slot wake on a later turn. */
+                    if( ( listGET_LIST_ITEM_VALUE( pxItem ) - xTimingWheelTime ) <= xElapsed )
+                    {
+                        pxTCB = listGET_LIST_ITEM_OWNER( pxItem ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+
+                        /* It is time to remove the item from the Blocked state. */
+                        listREMOVE_ITEM( &( pxTCB->xStateListItem ) );
+
+                        /* Is the task waiting on an event also?  If so remove
+                         * it from the event list. */
+                        if( listLIST_ITEM_CONTAINER( &( pxTCB->xEventListItem ) ) != NULL )
+                        {
+                            listREMOVE_ITEM( &( pxTCB->xEventListItem ) );
+                        }
+                        else
+                        {
+                            mtCOVERAGE_TEST_MARKER();
+                        }
+
+                        prvAddTaskToReadyList( pxTCB );
+
+                        #if ( configUSE_PREEMPTION == 1 )
+                            {
+                                #if ( configNUMBER_OF_CORES == 1 )
+                                    if( taskPREEMPTS_OR_SHARES_CURRENT( pxTCB ) )
+                                #else
+                                    if( prvYieldForTask( pxTCB ) != pdFALSE )
+                                #endif
+                                {
+                                    xSwitchRequired = pdTRUE;
+                                }
+                                else
+                                {
+                                    mtCOVERAGE_TEST_MARKER();
+                                }
+                            }
+                        #endif /* configUSE_PREEMPTION */
+                    }
+                    else if( xDistance < xMinDistance )
+                    {
+                        xMinDistance = xDistance;
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+
+                    pxItem = pxNextItem;
+                }
+
+                /* The earliest wake time of the tasks left in the slot. */
+                xTimingWheelSlotWake[ xIndex ] = xConstTickCount + xMinDistance;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+
+        xTimingWheelTime = xConstTickCount;
+        prvResetNextTaskUnblockTime();
+
+        return xSwitchRequired;
     }
-}
+
+#endif /* configUSE_TIMING_WHEEL */
 /*-----------------------------------------------------------*/
 
-#if ( ( INCLUDE_xTaskGetCurrentTaskHandle == 1 ) || ( configUSE_MUTEXES == 1 ) )
+#if ( ( INCLUDE_xTaskGetCurrentTaskHandle == 1 ) || ( configUSE_MUTEXES == 1 ) || ( configNUMBER_OF_CORES > 1 ) )
+
+    #if ( configNUMBER_OF_CORES == 1 )
 
     TaskHandle_t xTaskGetCurrentTaskHandle( void )
     {
@@ -4029,10 +6693,43 @@ static void prvResetNextTaskUnblockTime( void )
         return xReturn;
     }
 
-#endif /* ( ( INCLUDE_xTaskGetCurrentTaskHandle == 1 ) || ( configUSE_MUTEXES == 1 ) ) */
+    #else /* configNUMBER_OF_CORES */
+
+    TaskHandle_t xTaskGetCurrentTaskHandle( void )
+    {
+        TaskHandle_t xReturn;
+        BaseType_t xCoreID;
+
+        /* The calling task may be moved to another core between reading the
+         * core and its current TCB, which is then read again. */
+        do
+        {
+            xCoreID = portGET_CORE_ID();
+            xReturn = pxCurrentTCBs[ xCoreID ];
+        } while( xCoreID != portGET_CORE_ID() );
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    TaskHandle_t xTaskGetCurrentTaskHandleForCore( BaseType_t xCoreID )
+    {
+        TaskHandle_t xReturn = NULL;
+
+        if( ( xCoreID >= 0 ) && ( xCoreID < ( BaseType_t ) configNUMBER_OF_CORES ) )
+        {
+            xReturn = pxCurrentTCBs[ xCoreID ];
+        }
+
+        return xReturn;
+    }
+
+    #endif /* configNUMBER_OF_CORES */
+
+#endif /* ( ( INCLUDE_xTaskGetCurrentTaskHandle == 1 ) || ( configUSE_MUTEXES == 1 ) || ( configNUMBER_OF_CORES > 1 ) ) */
 /*-----------------------------------------------------------*/
 
-#if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
+#if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) || ( configNUMBER_OF_CORES > 1 ) )
 
     BaseType_t xTaskGetSchedulerState( void )
     {
@@ -4044,6 +6741,14 @@ static void prvResetNextTaskUnblockTime( void )
         }
         else
         {
+            #if ( configNUMBER_OF_CORES > 1 )
+
+            /* Another core holds the kernel lock while it has the scheduler
+             * suspended, so the scheduler is only seen suspended by the core
+             * that suspended it. */
+            taskENTER_CRITICAL();
+            #endif
+
             if( uxSchedulerSuspended == ( UBaseType_t ) pdFALSE )
             {
                 xReturn = taskSCHEDULER_RUNNING;
@@ -4052,12 +6757,16 @@ static void prvResetNextTaskUnblockTime( void )
             {
                 xReturn = taskSCHEDULER_SUSPENDED;
             }
+
+            #if ( configNUMBER_OF_CORES > 1 )
+            taskEXIT_CRITICAL();
+            #endif
         }
 
         return xReturn;
     }
 
-#endif /* ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) ) */
+#endif /* ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) || ( configNUMBER_OF_CORES > 1 ) ) */
 /*-----------------------------------------------------------*/
 
 #if ( configUSE_MUTEXES == 1 )
@@ -4108,11 +6817,20 @@ static void prvResetNextTaskUnblockTime( void )
                     /* Inherit the priority before being moved into the new list. */
                     pxMutexHolderTCB->uxPriority = pxCurrentTCB->uxPriority;
                     prvAddTaskToReadyList( pxMutexHolderTCB );
+
+                    #if ( configNUMBER_OF_CORES > 1 )
+                        {
+                            /* The holder may now preempt the task of another
+                             * core. */
+                            ( void ) prvYieldForTask( pxMutexHolderTCB );
+                        }
+                    #endif
                 }
                 else
                 {
                     /* Just inherit the priority. */
                     pxMutexHolderTCB->uxPriority = pxCurrentTCB->uxPriority;
+                    taskPUBLISH_SNAPSHOT( pxMutexHolderTCB );
                 }
 
                 traceTASK_PRIORITY_INHERIT( pxMutexHolderTCB, pxCurrentTCB->uxPriority );
@@ -4316,6 +7034,23 @@ static void prvResetNextTaskUnblockTime( void )
                     {
                         mtCOVERAGE_TEST_MARKER();
                     }
+
+                    taskPUBLISH_SNAPSHOT( pxTCB );
+
+                    #if ( configNUMBER_OF_CORES > 1 )
+                        {
+                            /* A holder running on another core may now be
+                             * preempted there. */
+                            if( taskTASK_IS_RUNNING( pxTCB ) && ( pxTCB->xTaskRunState != portGET_CORE_ID() ) )
+                            {
+                                ( void ) prvYieldCore( pxTCB->xTaskRunState );
+                            }
+                            else
+                            {
+                                mtCOVERAGE_TEST_MARKER();
+                            }
+                        }
+                    #endif
                 }
                 else
                 {
@@ -4947,7 +7682,11 @@ TickType_t uxTaskResetEventItemValue( void )
                     }
                 #endif
 
-                if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+                #if ( configNUMBER_OF_CORES == 1 )
+                    if( taskPREEMPTS_CURRENT( pxTCB ) )
+                #else
+                    if( prvYieldForTask( pxTCB ) != pdFALSE )
+                #endif
                 {
                     /* The notified task has a priority above the currently
                      * executing task so a yield is required. */
@@ -5082,7 +7821,11 @@ TickType_t uxTaskResetEventItemValue( void )
                     listINSERT_END( &( xPendingReadyList ), &( pxTCB->xEventListItem ) );
                 }
 
-                if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+                #if ( configNUMBER_OF_CORES == 1 )
+                    if( taskPREEMPTS_CURRENT( pxTCB ) )
+                #else
+                    if( prvYieldForTask( pxTCB ) != pdFALSE )
+                #endif
                 {
                     /* The notified task has a priority above the currently
                      * executing task so a yield is required. */
@@ -5173,7 +7916,11 @@ TickType_t uxTaskResetEventItemValue( void )
                     listINSERT_END( &( xPendingReadyList ), &( pxTCB->xEventListItem ) );
                 }
 
-                if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+                #if ( configNUMBER_OF_CORES == 1 )
+                    if( taskPREEMPTS_CURRENT( pxTCB ) )
+                #else
+                    if( prvYieldForTask( pxTCB ) != pdFALSE )
+                #endif
                 {
                     /* The notified task has a priority above the currently
                      * executing task so a yield is required. */
@@ -5349,13 +8096,21 @@ TickType_t uxTaskResetEventItemValue( void )
                 {
                     /* Wake time has overflowed.  Place this item in the overflow
                      * list. */
-                    vListInsert( pxOverflowDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
+                    #if ( configUSE_TIMING_WHEEL == 0 )
+                        vListInsert( pxOverflowDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
+                    #else
+                        taskTIMING_WHEEL_INSERT( pxCurrentTCB, xTimeToWake );
+                    #endif
                 }
                 else
                 {
                     /* The wake time has not overflowed, so the current block list
                      * is used. */
-                    vListInsert( pxDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
+                    #if ( configUSE_TIMING_WHEEL == 0 )
+                        vListInsert( pxDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
+                    #else
+                        taskTIMING_WHEEL_INSERT( pxCurrentTCB, xTimeToWake );
+                    #endif
 
                     /* If the task entering the blocked state was placed at the
                      * head of the list of blocked tasks then xNextTaskUnblockTime
@@ -5384,12 +8139,20 @@ TickType_t uxTaskResetEventItemValue( void )
             if( xTimeToWake < xConstTickCount )
             {
                 /* Wake time has overflowed.  Place this item in the overflow list. */
-                vListInsert( pxOverflowDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
+                #if ( configUSE_TIMING_WHEEL == 0 )
+                    vListInsert( pxOverflowDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
+                #else
+                    taskTIMING_WHEEL_INSERT( pxCurrentTCB, xTimeToWake );
+                #endif
             }
             else
             {
                 /* The wake time has not overflowed, so the current block list is used. */
-                vListInsert( pxDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
+                #if ( configUSE_TIMING_WHEEL == 0 )
+                    vListInsert( pxDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
+                #else
+                    taskTIMING_WHEEL_INSERT( pxCurrentTCB, xTimeToWake );
+                #endif
 
                 /* If the task entering the blocked state was placed at the head of the
                  * list of blocked tasks then xNextTaskUnblockTime needs to be updated
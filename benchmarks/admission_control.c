@@ -0,0 +1,229 @@
+/**
+ * @file admission_control.c
+ * @brief Admission test and job measurement benchmark of timing contracts
+ *
+ * Two periodic tasks are admitted with timing contracts (period, WCET,
+ * deadline in ticks): the first one of { 10, 1, 10 } runs jobs of 100 us,
+ * the second one of { 20, 2, 20 } runs jobs of 2.5 ms, longer than its
+ * contract.  A third contract of { 10, 9, 10 } is rejected.  The work of a
+ * job is spun in CPU time of its host thread, and each task also reads that
+ * clock at the end of its jobs: the longest job measured by the kernel
+ * (configUSE_ADMISSION_CONTROL) must match the longest job seen by the task,
+ * and the WCET be raised to the ticks of that job only if it overran.  The
+ * first task keeps a WCET of 1 tick and the second one is raised to 3 ticks,
+ * unless the host charged a job with more time; then the tasks must still
+ * pass the admission test and a contract of { 20, 2, 20 } is admitted.
+ * Built by "make bench":
+ *
+ *     admission_control_rm     fixed priorities, response time analysis
+ *     admission_control_edf    EDF tasks, density test
+ *
+ * Usage: admission_control [ticks]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef BENCH_NAME
+    #define BENCH_NAME    "admission_control"
+#endif
+
+#define benchDEFAULT_TICKS    3000UL
+#define benchTASKS            2
+
+/* The kernel measures the jobs from inside the calls that end them, a
+ * little after the task reads the clock. */
+#define benchTOLERANCE_NS     50000LL
+#define benchTICK_NS          ( 1000000000LL / configTICK_RATE_HZ )
+
+typedef struct
+{
+    TaskTimingContract_t xContract;
+    long long llWorkNs;
+    UBaseType_t uxPriority;
+    TickType_t xExpectedWCET;
+    TaskHandle_t xHandle;
+    long long llJobEndNs;
+    long long llLongestJobNs;
+} BenchTask_t;
+
+static BenchTask_t xBenchTasks[ benchTASKS ] =
+{
+    { { 10, 1, 10 }, 100000LL,  tskIDLE_PRIORITY + 3, 1, NULL, 0, 0 },
+    { { 20, 2, 20 }, 2500000LL, tskIDLE_PRIORITY + 2, 3, NULL, 0, 0 }
+};
+
+/* Admitted after the run. */
+static BenchTask_t xLate = { { 20, 2, 20 }, 100000LL, tskIDLE_PRIORITY + 1, 2, NULL, 0, 0 };
+
+static const TaskTimingContract_t xRejected = { 10, 9, 10 };
+
+static unsigned long ulTicks;
+
+static long long prvCPUTimeNs( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_THREAD_CPUTIME_ID, &xNow );
+
+    return ( long long ) xNow.tv_sec * 1000000000LL + ( long long ) xNow.tv_nsec;
+}
+
+/* Spin for the work of a job in CPU time of this task, then note the length
+ * of the job since the end of the last one.  The first job is not counted,
+ * as by the kernel. */
+static void prvJob( BenchTask_t * pxTask )
+{
+    long long llStart, llNow;
+
+    llStart = prvCPUTimeNs();
+
+    do
+    {
+        llNow = prvCPUTimeNs();
+    } while( llNow - llStart < pxTask->llWorkNs );
+
+    if( ( pxTask->llJobEndNs > 0 ) && ( llNow - pxTask->llJobEndNs > pxTask->llLongestJobNs ) )
+    {
+        pxTask->llLongestJobNs = llNow - pxTask->llJobEndNs;
+    }
+
+    pxTask->llJobEndNs = llNow;
+}
+
+static void prvPeriodicTask( void * pvParameters )
+{
+    BenchTask_t * pxTask = ( BenchTask_t * ) pvParameters;
+
+    #if ( configUSE_EDF_SCHEDULING == 1 )
+        for( ; ; )
+        {
+            prvJob( pxTask );
+            ( void ) xTaskWaitForNextPeriod();
+        }
+    #else
+        TickType_t xRelease = xTaskGetTickCount();
+
+        for( ; ; )
+        {
+            prvJob( pxTask );
+            ( void ) xTaskDelayUntil( &xRelease, pxTask->xContract.xPeriod );
+        }
+    #endif
+}
+
+static BaseType_t prvCreate( const TaskTimingContract_t * pxContract,
+                             void * pvParameters,
+                             UBaseType_t uxPriority,
+                             TaskHandle_t * pxHandle )
+{
+    #if ( configUSE_EDF_SCHEDULING == 1 )
+        uxPriority = configEDF_PRIORITY;
+    #endif
+
+    return xTaskCreateWithContract( prvPeriodicTask, "Periodic", configMINIMAL_STACK_SIZE, pvParameters,
+                                    uxPriority, pxContract, pxHandle );
+}
+
+static void prvReportTask( void * pvParameters )
+{
+    TaskTimingContract_t xContract;
+    long long llJobNs;
+    TickType_t xWCET;
+    BaseType_t xFailed = pdFALSE, xNoisy = pdFALSE;
+    int i;
+
+    ( void ) pvParameters;
+
+    vTaskDelay( ( TickType_t ) ulTicks );
+
+    printf( "%-28s", BENCH_NAME );
+
+    for( i = 0; i < benchTASKS; i++ )
+    {
+        ( void ) xTaskGetTimingContract( xBenchTasks[ i ].xHandle, &xContract );
+        llJobNs = ( long long ) ullTaskGetLongestJobNs( xBenchTasks[ i ].xHandle );
+
+        printf( " %6.1f us work %7.1f us job %7.1f us measured %lu wcet %lu overruns",
+                ( double ) xBenchTasks[ i ].llWorkNs * 1e-3, ( double ) xBenchTasks[ i ].llLongestJobNs * 1e-3,
+                ( double ) llJobNs * 1e-3, ( unsigned long ) xContract.xWCET,
+                ( unsigned long ) uxTaskGetContractOverruns( xBenchTasks[ i ].xHandle ) );
+
+        /* The WCET is raised to the ticks of the longest job only if it ran
+         * past the contract. */
+        xWCET = ( TickType_t ) ( ( llJobNs + benchTICK_NS - 1 ) / benchTICK_NS );
+
+        if( xWCET < xBenchTasks[ i ].xContract.xWCET )
+        {
+            xWCET = xBenchTasks[ i ].xContract.xWCET;
+        }
+
+        if( ( llJobNs < xBenchTasks[ i ].llLongestJobNs - benchTOLERANCE_NS ) ||
+            ( llJobNs > xBenchTasks[ i ].llLongestJobNs + benchTOLERANCE_NS ) ||
+            ( xContract.xWCET != xWCET ) )
+        {
+            xFailed = pdTRUE;
+        }
+
+        if( xWCET != xBenchTasks[ i ].xExpectedWCET )
+        {
+            xNoisy = pdTRUE;
+        }
+    }
+
+    /* The contracts admitted at the start still pass with the measured
+     * times, and leave room for one more. */
+    if( ( xNoisy == pdFALSE ) &&
+        ( ( xTaskCheckSchedulability() == pdFALSE ) ||
+          ( prvCreate( &xRejected, &xLate, xLate.uxPriority, NULL ) != errTASK_NOT_SCHEDULABLE ) ||
+          ( prvCreate( &( xLate.xContract ), &xLate, xLate.uxPriority, &( xLate.xHandle ) ) != pdPASS ) ) )
+    {
+        xFailed = pdTRUE;
+    }
+
+    printf( "  %s\n", ( xFailed != pdFALSE ) ? "FAILED" : ( xNoisy != pdFALSE ) ? "ok, noisy host" : "ok" );
+    exit( 0 );
+}
+
+int main( int argc,
+          char ** argv )
+{
+    int i;
+
+    ulTicks = benchDEFAULT_TICKS;
+    if( argc > 1 )
+    {
+        ulTicks = strtoul( argv[ 1 ], NULL, 0 );
+    }
+
+    for( i = 0; i < benchTASKS; i++ )
+    {
+        if( prvCreate( &( xBenchTasks[ i ].xContract ), &( xBenchTasks[ i ] ), xBenchTasks[ i ].uxPriority,
+                       &( xBenchTasks[ i ].xHandle ) ) != pdPASS )
+        {
+            vAssertCalled( __FILE__, __LINE__ );
+        }
+    }
+
+    if( prvCreate( &xRejected, &( xBenchTasks[ 0 ] ), tskIDLE_PRIORITY + 1, NULL ) != errTASK_NOT_SCHEDULABLE )
+    {
+        vAssertCalled( __FILE__, __LINE__ );
+    }
+
+    xTaskCreate( prvReportTask, "Report", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 1, NULL );
+
+    vTaskStartScheduler();
+
+    return 1;
+}
+
+void vAssertCalled( const char * const pcFileName,
+                    unsigned long ulLine )
+{
+    fprintf( stderr, "assert: %s:%lu\n", pcFileName, ulLine );
+    abort();
+}
@@ -0,0 +1,121 @@
+/**
+ * @file atomic_ops.c
+ * @brief Stress benchmark of atomic.h on the Posix port
+ *
+ * Four tasks of the same priority update shared words only through
+ * atomic.h: a counter with Atomic_Increment_u32(), a sum with a
+ * compare-and-swap loop, and a word of flags where each task sets and
+ * clears its own bit with Atomic_OR_u32() and Atomic_AND_u32().  The tasks
+ * are preempted by the tick, and run at once with several cores, so any
+ * operation that is not atomic loses updates: the final values are
+ * checked, then the rate of operations is printed.  Built by "make bench":
+ *
+ *     atomic_ops_critical        critical sections, one core
+ *     atomic_ops_builtins        configUSE_ATOMIC_BUILTINS, one core
+ *     atomic_ops_critical_smp    critical sections, four cores
+ *     atomic_ops_builtins_smp    configUSE_ATOMIC_BUILTINS, four cores
+ *
+ * Usage: atomic_ops [rounds per task]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "atomic.h"
+
+#ifndef BENCH_NAME
+    #define BENCH_NAME    "atomic_ops"
+#endif
+
+#define benchDEFAULT_ROUNDS    1000000UL
+#define benchTASKS             4
+#define benchOPS_PER_ROUND     4
+
+static unsigned long ulRounds;
+static uint32_t volatile ulCounter;
+static uint32_t volatile ulSum;
+static uint32_t volatile ulFlags;
+static uint32_t volatile ulFlagErrors;
+static uint32_t volatile ulTasksDone;
+static struct timespec xStart;
+
+static void prvAtomicTask( void * pvParameters )
+{
+    uint32_t ulBit = 1UL << ( uint32_t ) ( uintptr_t ) pvParameters;
+    uint32_t ulExpected;
+    unsigned long ulRound;
+    struct timespec xNow;
+    double dElapsed;
+    BaseType_t xPassed;
+
+    for( ulRound = 0; ulRound < ulRounds; ulRound++ )
+    {
+        ( void ) Atomic_Increment_u32( &ulCounter );
+
+        do
+        {
+            ulExpected = ulSum;
+        } while( Atomic_CompareAndSwap_u32( &ulSum, ulExpected + 3U, ulExpected ) != ATOMIC_COMPARE_AND_SWAP_SUCCESS );
+
+        /* Only this task changes its bit. */
+        if( ( Atomic_OR_u32( &ulFlags, ulBit ) & ulBit ) != 0U )
+        {
+            ( void ) Atomic_Increment_u32( &ulFlagErrors );
+        }
+
+        if( ( Atomic_AND_u32( &ulFlags, ~ulBit ) & ulBit ) == 0U )
+        {
+            ( void ) Atomic_Increment_u32( &ulFlagErrors );
+        }
+    }
+
+    /* The last task done checks and reports. */
+    if( Atomic_Increment_u32( &ulTasksDone ) == ( benchTASKS - 1 ) )
+    {
+        clock_gettime( CLOCK_MONOTONIC, &xNow );
+        dElapsed = ( double ) ( xNow.tv_sec - xStart.tv_sec ) +
+                   ( double ) ( xNow.tv_nsec - xStart.tv_nsec ) * 1e-9;
+        xPassed = ( ulCounter == ( uint32_t ) ( ulRounds * benchTASKS ) ) &&
+                  ( ulSum == ( uint32_t ) ( ulRounds * benchTASKS * 3UL ) ) &&
+                  ( ulFlags == 0U ) && ( ulFlagErrors == 0U );
+        printf( "%-28s %2d cores %9lu ops %8.3f s %6.1f ns/op  %s\n",
+                BENCH_NAME, configNUMBER_OF_CORES, ulRounds * benchTASKS * benchOPS_PER_ROUND, dElapsed,
+                dElapsed * 1e9 / ( double ) ( ulRounds * benchTASKS * benchOPS_PER_ROUND ),
+                xPassed ? "ok" : "LOST UPDATES" );
+        exit( xPassed ? 0 : 1 );
+    }
+
+    vTaskSuspend( NULL );
+}
+
+int main( int argc,
+          char ** argv )
+{
+    int i;
+
+    ulRounds = benchDEFAULT_ROUNDS;
+    if( argc > 1 )
+    {
+        ulRounds = strtoul( argv[ 1 ], NULL, 0 );
+    }
+
+    for( i = 0; i < benchTASKS; i++ )
+    {
+        xTaskCreate( prvAtomicTask, "Atomic", configMINIMAL_STACK_SIZE, ( void * ) ( uintptr_t ) i, tskIDLE_PRIORITY + 1, NULL );
+    }
+
+    clock_gettime( CLOCK_MONOTONIC, &xStart );
+    vTaskStartScheduler();
+
+    return 1;
+}
+
+void vAssertCalled( const char * const pcFileName,
+                    unsigned long ulLine )
+{
+    fprintf( stderr, "assert: %s:%lu\n", pcFileName, ulLine );
+    abort();
+}
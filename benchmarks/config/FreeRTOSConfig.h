@@ -0,0 +1,51 @@
+/**
+ * @file FreeRTOSConfig.h
+ * @brief Kernel configuration of the benchmarks
+ *
+ * Only what the benchmarks use.  The options of the Posix port
+ * (configPOSIX_*) keep the defaults of port.c and are selected per binary
+ * on the command line by the Makefile.
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#define configUSE_PREEMPTION                       1
+#ifndef configUSE_PORT_OPTIMISED_TASK_SELECTION
+    #define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
+#endif
+#define configUSE_IDLE_HOOK                        0
+#ifndef configUSE_TICK_HOOK
+    #define configUSE_TICK_HOOK                    0
+#endif
+#ifndef configTICK_RATE_HZ
+    #define configTICK_RATE_HZ                     ( 1000 )
+#endif
+#define configMINIMAL_STACK_SIZE                   ( ( unsigned short ) 70 )
+#define configTOTAL_HEAP_SIZE                      ( ( size_t ) ( 64 * 1024 ) )
+#define configMAX_TASK_NAME_LEN                    ( 12 )
+#define configUSE_16_BIT_TICKS                     0
+#define configIDLE_SHOULD_YIELD                    1
+#define configUSE_MUTEXES                          1
+#ifndef configCHECK_FOR_STACK_OVERFLOW
+    #define configCHECK_FOR_STACK_OVERFLOW         0
+#endif
+#define configUSE_TIMERS                           0
+#define configUSE_CO_ROUTINES                      0
+#ifndef configMAX_PRIORITIES
+    #define configMAX_PRIORITIES                   ( 5 )
+#endif
+#define configSTACK_DEPTH_TYPE                     uint32_t
+
+void vAssertCalled( const char * const pcFileName,
+                    unsigned long ulLine );
+#define configASSERT( x )    if( ( x ) == 0 ) vAssertCalled( __FILE__, __LINE__ )
+
+#define INCLUDE_vTaskDelete                        1
+#define INCLUDE_vTaskDelay                         1
+#define INCLUDE_xTaskDelayUntil                    1
+#define INCLUDE_xTaskGetIdleTaskHandle             1
+#define INCLUDE_xTaskGetSchedulerState             1
+#define INCLUDE_vTaskSuspend                       1
+
+#endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,117 @@
+/**
+ * @file context_switch.c
+ * @brief Task switch microbenchmark for the events of the Posix port
+ *
+ * Two threads hand the CPU to each other exactly as prvSwitchThread() does
+ * in port.c: signal the event of the thread to resume, then wait on the
+ * event of the own thread, with all signals blocked.  The number of switches
+ * per second is the upper bound of the task switch rate of the port.
+ *
+ * The same source is built against each implementation of
+ * utils/wait_for_event.c ("make bench"):
+ *
+ *     context_switch_pthread     mutex and condition variable
+ *     context_switch_futex       futex word
+ *     context_switch_futex_spin  futex word, spinning before sleeping
+ *
+ * Usage: context_switch [switches]
+ */
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "wait_for_event.h"
+
+#ifndef BENCH_NAME
+    #define BENCH_NAME    "context_switch"
+#endif
+
+#define benchDEFAULT_SWITCHES    200000UL
+
+typedef struct xBENCH_THREAD
+{
+    pthread_t xThread;
+    struct event * pxEvent;
+    struct xBENCH_THREAD * pxPeer;
+} BenchThread_t;
+
+static unsigned long ulRounds;
+
+static void * prvPingPong( void * pvParams )
+{
+    BenchThread_t * pxSelf = pvParams;
+    unsigned long ul;
+
+    for( ul = 0; ul < ulRounds; ul++ )
+    {
+        event_wait( pxSelf->pxEvent );
+        event_signal( pxSelf->pxPeer->pxEvent );
+    }
+
+    return NULL;
+}
+
+static double prvNow( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+    return ( double ) xNow.tv_sec + ( double ) xNow.tv_nsec * 1e-9;
+}
+
+int main( int argc,
+          char ** argv )
+{
+    BenchThread_t xThreads[ 2 ];
+    sigset_t xAllSignals;
+    unsigned long ulSwitches = benchDEFAULT_SWITCHES;
+    double dStart, dElapsed;
+    int i;
+
+    if( argc > 1 )
+    {
+        ulSwitches = strtoul( argv[ 1 ], NULL, 0 );
+    }
+
+    ulRounds = ( ulSwitches + 1UL ) / 2UL;
+
+    /* Threads of suspended tasks run with every signal blocked, the threads
+     * inherit the mask. */
+    sigfillset( &xAllSignals );
+    pthread_sigmask( SIG_SETMASK, &xAllSignals, NULL );
+
+    for( i = 0; i < 2; i++ )
+    {
+        xThreads[ i ].pxEvent = event_create();
+        xThreads[ i ].pxPeer = &xThreads[ 1 - i ];
+    }
+
+    for( i = 0; i < 2; i++ )
+    {
+        pthread_create( &xThreads[ i ].xThread, NULL, prvPingPong, &xThreads[ i ] );
+    }
+
+    dStart = prvNow();
+    event_signal( xThreads[ 0 ].pxEvent );
+
+    for( i = 0; i < 2; i++ )
+    {
+        pthread_join( xThreads[ i ].xThread, NULL );
+    }
+
+    dElapsed = prvNow() - dStart;
+
+    for( i = 0; i < 2; i++ )
+    {
+        event_delete( xThreads[ i ].pxEvent );
+    }
+
+    printf( "%-28s %9lu switches %8.3f s %10.0f switches/s %7.2f us/switch\n",
+            BENCH_NAME, ulRounds * 2UL, dElapsed, ( double ) ( ulRounds * 2UL ) / dElapsed,
+            dElapsed * 1e6 / ( double ) ( ulRounds * 2UL ) );
+
+    return 0;
+}
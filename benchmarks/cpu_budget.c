@@ -0,0 +1,121 @@
+/**
+ * @file cpu_budget.c
+ * @brief Runaway task benchmark of the task budgets
+ *
+ * An acquisition task wakes every tick to take a sample, below a processing
+ * task of higher priority that never blocks, as a signal processing loop
+ * gone wrong would.  Without a budget the acquisition task never runs
+ * again; with configUSE_TASK_BUDGETS the processing task may run 2 ticks in
+ * every 10, then it is throttled until the next period and the acquisition
+ * task keeps most of its samples.  The samples taken, the longest gap
+ * between two of them and the overruns of the processing task are printed.
+ * Built by "make bench":
+ *
+ *     cpu_budget_none       no budget
+ *     cpu_budget_demote     eBudgetDemote, to the idle priority
+ *     cpu_budget_suspend    eBudgetSuspend
+ *
+ * Usage: cpu_budget [ticks]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef BENCH_NAME
+    #define BENCH_NAME    "cpu_budget"
+#endif
+
+#define benchDEFAULT_TICKS    2000UL
+#define benchBUDGET           ( ( TickType_t ) 2 )
+#define benchBUDGET_PERIOD    ( ( TickType_t ) 10 )
+
+static unsigned long ulTicks;
+static unsigned long volatile ulSamples;
+static TickType_t volatile xLongestGap;
+static TaskHandle_t xProcessingTask;
+
+static void prvProcessingTask( void * pvParameters )
+{
+    volatile uint32_t ulState = 1U;
+
+    ( void ) pvParameters;
+
+    for( ; ; )
+    {
+        ulState = ulState * 1664525U + 1013904223U;
+    }
+}
+
+static void prvAcquisitionTask( void * pvParameters )
+{
+    TickType_t xLastWake, xLastSample, xNow;
+
+    ( void ) pvParameters;
+
+    xLastWake = xTaskGetTickCount();
+    xLastSample = xLastWake;
+
+    for( ; ; )
+    {
+        vTaskDelayUntil( &xLastWake, 1 );
+
+        xNow = xTaskGetTickCount();
+
+        if( ( xNow - xLastSample ) > xLongestGap )
+        {
+            xLongestGap = xNow - xLastSample;
+        }
+
+        xLastSample = xNow;
+        ulSamples++;
+    }
+}
+
+static void prvReportTask( void * pvParameters )
+{
+    UBaseType_t uxOverruns = 0;
+
+    ( void ) pvParameters;
+
+    vTaskDelay( ( TickType_t ) ulTicks );
+
+    #if ( configUSE_TASK_BUDGETS == 1 )
+        uxOverruns = uxTaskGetBudgetOverruns( xProcessingTask );
+    #endif
+
+    printf( "%-28s %6lu ticks %6lu samples %5lu ticks longest gap %5lu overruns\n",
+            BENCH_NAME, ulTicks, ulSamples, ( unsigned long ) xLongestGap, ( unsigned long ) uxOverruns );
+    exit( 0 );
+}
+
+int main( int argc,
+          char ** argv )
+{
+    ulTicks = benchDEFAULT_TICKS;
+    if( argc > 1 )
+    {
+        ulTicks = strtoul( argv[ 1 ], NULL, 0 );
+    }
+
+    xTaskCreate( prvAcquisitionTask, "Acquisition", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, NULL );
+    xTaskCreate( prvProcessingTask, "Processing", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 2, &xProcessingTask );
+    xTaskCreate( prvReportTask, "Report", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 1, NULL );
+
+    #if ( configUSE_TASK_BUDGETS == 1 )
+        vTaskSetBudget( xProcessingTask, benchBUDGET, benchBUDGET_PERIOD, BENCH_BUDGET_ACTION );
+    #endif
+
+    vTaskStartScheduler();
+
+    return 1;
+}
+
+void vAssertCalled( const char * const pcFileName,
+                    unsigned long ulLine )
+{
+    fprintf( stderr, "assert: %s:%lu\n", pcFileName, ulLine );
+    abort();
+}
@@ -0,0 +1,155 @@
+/**
+ * @file delayed_expiry.c
+ * @brief Delayed task expiry benchmark of the kernel
+ *
+ * Sleeper tasks block with timeouts that run out long after the benchmark,
+ * on later turns of a timing wheel, while periodic tasks of periods about
+ * one turn of the wheel and longer wake with vTaskDelayUntil().  Every wake
+ * looks up the next unblock time again, usually a turn or more ahead, past
+ * the slots of every sleeper.  The ticks run on the virtual clock of
+ * configPOSIX_VIRTUAL_TIME and the idle ticks are stepped at once, so the
+ * time per wake is the cost of the expiry, and every task must wake exactly
+ * on its tick: a wake early or late, or a lost wake, is reported.  The wrap
+ * variants start configINITIAL_TICK_COUNT ticks before the tick count
+ * overflows, so the periodic tasks and the sleepers wait across it.  Green
+ * threads keep the switch itself cheap.  Built by "make bench":
+ *
+ *     delayed_expiry_list          sorted delayed lists
+ *     delayed_expiry_list_wrap     sorted delayed lists, across the overflow
+ *     delayed_expiry_wheel         timing wheel
+ *     delayed_expiry_wheel_wrap    timing wheel, across the overflow
+ *
+ * Usage: delayed_expiry [ticks]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef BENCH_NAME
+    #define BENCH_NAME    "delayed_expiry"
+#endif
+
+#ifndef BENCH_SLEEPERS
+    #define BENCH_SLEEPERS    10000
+#endif
+
+#define benchDEFAULT_TICKS       1000000UL
+#define benchSLEEPER_TIMEOUT     ( ( TickType_t ) 1000000000UL )
+
+static const TickType_t xPeriods[] = { 255, 256, 257, 1000, 3001 };
+
+#define benchPERIODIC_TASKS      ( sizeof( xPeriods ) / sizeof( xPeriods[ 0 ] ) )
+
+static unsigned long ulTicks;
+static unsigned long volatile ulWakes[ benchPERIODIC_TASKS ];
+static unsigned long volatile ulMissed;
+
+static void prvSleeperTask( void * pvParameters )
+{
+    ( void ) ulTaskNotifyTake( pdTRUE, benchSLEEPER_TIMEOUT + ( TickType_t ) ( uintptr_t ) pvParameters * 7U );
+    vTaskSuspend( NULL );
+}
+
+static void prvPeriodicTask( void * pvParameters )
+{
+    const uintptr_t uxIndex = ( uintptr_t ) pvParameters;
+    TickType_t xLastWake = xTaskGetTickCount();
+
+    for( ; ; )
+    {
+        vTaskDelayUntil( &xLastWake, xPeriods[ uxIndex ] );
+
+        if( xTaskGetTickCount() != xLastWake )
+        {
+            ulMissed++;
+        }
+
+        ulWakes[ uxIndex ]++;
+    }
+}
+
+static void prvReportTask( void * pvParameters )
+{
+    TickType_t xStartTick;
+    struct timespec xStart, xNow;
+    unsigned long ulExpected;
+    unsigned long ulTotal = 0;
+    double dElapsed;
+    uint32_t ul;
+
+    ( void ) pvParameters;
+
+    /* The periodic tasks and the report task started on the same tick. */
+    xStartTick = xTaskGetTickCount();
+    clock_gettime( CLOCK_MONOTONIC, &xStart );
+
+    vTaskDelay( ( TickType_t ) ulTicks );
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+    dElapsed = ( double ) ( xNow.tv_sec - xStart.tv_sec ) +
+               ( double ) ( xNow.tv_nsec - xStart.tv_nsec ) * 1e-9;
+
+    /* The report task runs first on its tick, the wakes of that tick are
+     * not counted yet. */
+    for( ul = 0; ul < benchPERIODIC_TASKS; ul++ )
+    {
+        ulExpected = ( ulTicks - 1UL ) / ( unsigned long ) xPeriods[ ul ];
+
+        if( ulWakes[ ul ] != ulExpected )
+        {
+            ulMissed++;
+        }
+
+        ulTotal += ulWakes[ ul ];
+    }
+
+    printf( "%-28s %5d sleepers %8lu ticks %s %6lu wakes %8.1f ns/wake  %s\n",
+            BENCH_NAME, BENCH_SLEEPERS, ulTicks,
+            ( xTaskGetTickCount() < xStartTick ) ? "wrapped" : "       ",
+            ulTotal, dElapsed * 1e9 / ( double ) ( ulTotal + 1UL ),
+            ( ulMissed == 0UL ) ? "ok" : "MISSED WAKES" );
+    exit( 0 );
+}
+
+int main( int argc,
+          char ** argv )
+{
+    uint32_t ul;
+    int i;
+
+    ulTicks = benchDEFAULT_TICKS;
+    if( argc > 1 )
+    {
+        ulTicks = strtoul( argv[ 1 ], NULL, 0 );
+    }
+
+    for( i = 0; i < BENCH_SLEEPERS; i++ )
+    {
+        if( xTaskCreate( prvSleeperTask, "Sleeper", configMINIMAL_STACK_SIZE, ( void * ) ( uintptr_t ) i, tskIDLE_PRIORITY + 1, NULL ) != pdPASS )
+        {
+            vAssertCalled( __FILE__, __LINE__ );
+        }
+    }
+
+    for( ul = 0; ul < benchPERIODIC_TASKS; ul++ )
+    {
+        xTaskCreate( prvPeriodicTask, "Periodic", configMINIMAL_STACK_SIZE, ( void * ) ( uintptr_t ) ul, tskIDLE_PRIORITY + 1, NULL );
+    }
+
+    xTaskCreate( prvReportTask, "Report", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 2, NULL );
+
+    vTaskStartScheduler();
+
+    return 1;
+}
+
+void vAssertCalled( const char * const pcFileName,
+                    unsigned long ulLine )
+{
+    fprintf( stderr, "assert: %s:%lu\n", pcFileName, ulLine );
+    abort();
+}
@@ -0,0 +1,120 @@
+/**
+ * @file delayed_tasks.c
+ * @brief Delayed task insertion benchmark of the kernel
+ *
+ * Sleeper tasks block with timeouts that run out long after the benchmark,
+ * then two tasks wake each other with notifications, each one blocking
+ * with a timeout longer than the sleepers' every round.  With the sorted
+ * delayed list every block walks past all the sleepers; with
+ * configUSE_TIMING_WHEEL the task is appended to the slot of its wake
+ * time.  Green threads keep the switch itself cheap.  Built by
+ * "make bench":
+ *
+ *     delayed_tasks_list_10       sorted delayed lists, 10 sleepers
+ *     delayed_tasks_list_1000     sorted delayed lists, 1000 sleepers
+ *     delayed_tasks_wheel_10      timing wheel, 10 sleepers
+ *     delayed_tasks_wheel_1000    timing wheel, 1000 sleepers
+ *
+ * Usage: delayed_tasks [rounds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef BENCH_NAME
+    #define BENCH_NAME    "delayed_tasks"
+#endif
+
+#ifndef BENCH_SLEEPERS
+    #define BENCH_SLEEPERS    1000
+#endif
+
+#define benchDEFAULT_ROUNDS       100000UL
+#define benchSLEEPER_TIMEOUT      ( ( TickType_t ) 1000000000UL )
+#define benchPING_PONG_TIMEOUT    ( ( TickType_t ) 2000000000UL )
+
+static unsigned long ulRounds;
+static TaskHandle_t xPingTask, xPongTask;
+
+static void prvSleeperTask( void * pvParameters )
+{
+    ( void ) ulTaskNotifyTake( pdTRUE, benchSLEEPER_TIMEOUT + ( TickType_t ) ( uintptr_t ) pvParameters );
+    vTaskSuspend( NULL );
+}
+
+static void prvPongTask( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ; ; )
+    {
+        ( void ) ulTaskNotifyTake( pdTRUE, benchPING_PONG_TIMEOUT );
+        xTaskNotifyGive( xPingTask );
+    }
+}
+
+static void prvPingTask( void * pvParameters )
+{
+    unsigned long ulRound;
+    struct timespec xStart, xNow;
+    double dElapsed;
+
+    ( void ) pvParameters;
+
+    /* Let every sleeper block first. */
+    vTaskDelay( 2 );
+
+    clock_gettime( CLOCK_MONOTONIC, &xStart );
+
+    for( ulRound = 0; ulRound < ulRounds; ulRound++ )
+    {
+        xTaskNotifyGive( xPongTask );
+        ( void ) ulTaskNotifyTake( pdTRUE, benchPING_PONG_TIMEOUT );
+    }
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+    dElapsed = ( double ) ( xNow.tv_sec - xStart.tv_sec ) +
+               ( double ) ( xNow.tv_nsec - xStart.tv_nsec ) * 1e-9;
+    printf( "%-28s %5d sleepers %7lu rounds %8.3f s %7.1f ns/round\n",
+            BENCH_NAME, BENCH_SLEEPERS, ulRounds, dElapsed,
+            dElapsed * 1e9 / ( double ) ulRounds );
+    exit( 0 );
+}
+
+int main( int argc,
+          char ** argv )
+{
+    int i;
+
+    ulRounds = benchDEFAULT_ROUNDS;
+    if( argc > 1 )
+    {
+        ulRounds = strtoul( argv[ 1 ], NULL, 0 );
+    }
+
+    for( i = 0; i < BENCH_SLEEPERS; i++ )
+    {
+        if( xTaskCreate( prvSleeperTask, "Sleeper", configMINIMAL_STACK_SIZE, ( void * ) ( uintptr_t ) i, tskIDLE_PRIORITY + 2, NULL ) != pdPASS )
+        {
+            vAssertCalled( __FILE__, __LINE__ );
+        }
+    }
+
+    xTaskCreate( prvPingTask, "Ping", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, &xPingTask );
+    xTaskCreate( prvPongTask, "Pong", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, &xPongTask );
+
+    vTaskStartScheduler();
+
+    return 1;
+}
+
+void vAssertCalled( const char * const pcFileName,
+                    unsigned long ulLine )
+{
+    fprintf( stderr, "assert: %s:%lu\n", pcFileName, ulLine );
+    abort();
+}
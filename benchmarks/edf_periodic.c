@@ -0,0 +1,150 @@
+/**
+ * @file edf_periodic.c
+ * @brief Deadline benchmark of rate monotonic and EDF scheduling
+ *
+ * Two periodic tasks share the processor at a utilisation of 0.9: the first
+ * one runs 8 ticks every 20 ticks, the second one 14 ticks every 28 ticks,
+ * each job due at the end of its period.  With fixed priorities given by
+ * rate (the shorter period first) the second task misses deadlines, since
+ * the set is above the rate monotonic bound; scheduled by earliest deadline
+ * first (configUSE_EDF_SCHEDULING) no job is late.  The work of a job is
+ * measured in CPU time of its host thread, so the time of the other tasks
+ * and of the host is not counted.  Built by "make bench":
+ *
+ *     edf_periodic_rm     xTaskCreate() and xTaskDelayUntil(), by rate
+ *     edf_periodic_edf    xTaskCreateEDF() and xTaskWaitForNextPeriod()
+ *
+ * Usage: edf_periodic [hyperperiods of 140 ticks]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef BENCH_NAME
+    #define BENCH_NAME    "edf_periodic"
+#endif
+
+#define benchDEFAULT_HYPERPERIODS    10UL
+#define benchHYPERPERIOD             ( ( TickType_t ) 140 )
+#define benchTASKS                   2
+
+typedef struct
+{
+    TickType_t xWork;
+    TickType_t xPeriod;
+    unsigned long ulJobs;
+    unsigned long ulMisses;
+} BenchTask_t;
+
+static BenchTask_t xBenchTasks[ benchTASKS ] =
+{
+    { 8,  20, 0, 0 },
+    { 14, 28, 0, 0 }
+};
+
+static unsigned long ulHyperperiods;
+
+/* Spin for the given ticks of CPU time of this task. */
+static void prvWork( TickType_t xTicks )
+{
+    struct timespec xStart, xNow;
+    long long llElapsed, llWork;
+
+    llWork = ( long long ) xTicks * ( 1000000000LL / configTICK_RATE_HZ );
+    clock_gettime( CLOCK_THREAD_CPUTIME_ID, &xStart );
+
+    do
+    {
+        clock_gettime( CLOCK_THREAD_CPUTIME_ID, &xNow );
+        llElapsed = ( long long ) ( xNow.tv_sec - xStart.tv_sec ) * 1000000000LL +
+                    ( long long ) ( xNow.tv_nsec - xStart.tv_nsec );
+    } while( llElapsed < llWork );
+}
+
+static void prvPeriodicTask( void * pvParameters )
+{
+    BenchTask_t * pxTask = ( BenchTask_t * ) pvParameters;
+
+    #if ( configUSE_EDF_SCHEDULING == 1 )
+        for( ; ; )
+        {
+            prvWork( pxTask->xWork );
+            pxTask->ulJobs++;
+
+            if( xTaskWaitForNextPeriod() == pdFALSE )
+            {
+                pxTask->ulMisses++;
+            }
+        }
+    #else
+        TickType_t xRelease = 0;
+
+        for( ; ; )
+        {
+            prvWork( pxTask->xWork );
+            pxTask->ulJobs++;
+
+            if( ( xTaskGetTickCount() - xRelease ) > pxTask->xPeriod )
+            {
+                pxTask->ulMisses++;
+            }
+
+            /* Late jobs are not skipped, as with xTaskWaitForNextPeriod(). */
+            ( void ) xTaskDelayUntil( &xRelease, pxTask->xPeriod );
+        }
+    #endif
+}
+
+static void prvReportTask( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    vTaskDelay( benchHYPERPERIOD * ( TickType_t ) ulHyperperiods );
+
+    printf( "%-28s %6lu jobs %5lu missed (%lu + %lu)\n",
+            BENCH_NAME, xBenchTasks[ 0 ].ulJobs + xBenchTasks[ 1 ].ulJobs,
+            xBenchTasks[ 0 ].ulMisses + xBenchTasks[ 1 ].ulMisses,
+            xBenchTasks[ 0 ].ulMisses, xBenchTasks[ 1 ].ulMisses );
+    exit( 0 );
+}
+
+int main( int argc,
+          char ** argv )
+{
+    int i;
+
+    ulHyperperiods = benchDEFAULT_HYPERPERIODS;
+    if( argc > 1 )
+    {
+        ulHyperperiods = strtoul( argv[ 1 ], NULL, 0 );
+    }
+
+    for( i = 0; i < benchTASKS; i++ )
+    {
+        #if ( configUSE_EDF_SCHEDULING == 1 )
+            xTaskCreateEDF( prvPeriodicTask, "Periodic", configMINIMAL_STACK_SIZE, &( xBenchTasks[ i ] ),
+                            xBenchTasks[ i ].xPeriod, xBenchTasks[ i ].xPeriod, NULL );
+        #else
+            /* The shorter period gets the higher priority. */
+            xTaskCreate( prvPeriodicTask, "Periodic", configMINIMAL_STACK_SIZE, &( xBenchTasks[ i ] ),
+                         tskIDLE_PRIORITY + benchTASKS - i, NULL );
+        #endif
+    }
+
+    xTaskCreate( prvReportTask, "Report", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 1, NULL );
+
+    vTaskStartScheduler();
+
+    return 1;
+}
+
+void vAssertCalled( const char * const pcFileName,
+                    unsigned long ulLine )
+{
+    fprintf( stderr, "assert: %s:%lu\n", pcFileName, ulLine );
+    abort();
+}
@@ -0,0 +1,117 @@
+/**
+ * @file smp_scaling.c
+ * @brief SMP scaling benchmark of the Posix port
+ *
+ * A fixed amount of CPU-bound work is shared by four tasks of the same
+ * priority, each one also taking a critical section every block of work,
+ * as a task updating shared state would.  The wall time to finish every
+ * block is measured with configNUMBER_OF_CORES simulated cores: it drops
+ * with the cores as long as the host has as many CPUs free, and the rate
+ * of critical sections shows the cost of the kernel lock.  Built once per
+ * number of cores ("make bench"):
+ *
+ *     smp_scaling_1 ... smp_scaling_4   tick thread, soft mask
+ *
+ * Usage: smp_scaling [blocks of work]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef BENCH_NAME
+    #define BENCH_NAME    "smp_scaling"
+#endif
+
+#define benchDEFAULT_BLOCKS    4000UL
+#define benchTASKS             4
+#define benchBLOCK_ROUNDS      20000UL
+
+static unsigned long ulBlocks;
+static unsigned long ulBlocksDone;
+static unsigned long ulTasksDone;
+static struct timespec xStart;
+
+static void prvWorkTask( void * pvParameters )
+{
+    volatile uint32_t ulState = ( uint32_t ) ( uintptr_t ) pvParameters + 1U;
+    unsigned long ulRound;
+    struct timespec xNow;
+    double dElapsed;
+    BaseType_t xClaimed, xLast = pdFALSE;
+
+    for( ; ; )
+    {
+        /* Claim a block, or count this task done once they are all
+         * taken: the last task done reports. */
+        taskENTER_CRITICAL();
+        {
+            xClaimed = ( ulBlocksDone < ulBlocks );
+            if( xClaimed != pdFALSE )
+            {
+                ulBlocksDone++;
+            }
+            else
+            {
+                ulTasksDone++;
+                xLast = ( ulTasksDone == benchTASKS );
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        if( xClaimed == pdFALSE )
+        {
+            break;
+        }
+
+        for( ulRound = 0; ulRound < benchBLOCK_ROUNDS; ulRound++ )
+        {
+            ulState = ulState * 1664525U + 1013904223U;
+        }
+    }
+
+    if( xLast != pdFALSE )
+    {
+        clock_gettime( CLOCK_MONOTONIC, &xNow );
+        dElapsed = ( double ) ( xNow.tv_sec - xStart.tv_sec ) +
+                   ( double ) ( xNow.tv_nsec - xStart.tv_nsec ) * 1e-9;
+        printf( "%-28s %2d cores %7lu blocks %8.3f s %9.0f blocks/s\n",
+                BENCH_NAME, configNUMBER_OF_CORES, ulBlocks, dElapsed,
+                ( double ) ulBlocks / dElapsed );
+        exit( 0 );
+    }
+
+    vTaskSuspend( NULL );
+}
+
+int main( int argc,
+          char ** argv )
+{
+    int i;
+
+    ulBlocks = benchDEFAULT_BLOCKS;
+    if( argc > 1 )
+    {
+        ulBlocks = strtoul( argv[ 1 ], NULL, 0 );
+    }
+
+    for( i = 0; i < benchTASKS; i++ )
+    {
+        xTaskCreate( prvWorkTask, "Work", configMINIMAL_STACK_SIZE, ( void * ) ( uintptr_t ) i, tskIDLE_PRIORITY + 1, NULL );
+    }
+
+    clock_gettime( CLOCK_MONOTONIC, &xStart );
+    vTaskStartScheduler();
+
+    return 1;
+}
+
+void vAssertCalled( const char * const pcFileName,
+                    unsigned long ulLine )
+{
+    fprintf( stderr, "assert: %s:%lu\n", pcFileName, ulLine );
+    abort();
+}
@@ -0,0 +1,111 @@
+/**
+ * @file task_churn.c
+ * @brief Task creation and deletion benchmark of the Posix port
+ *
+ * A task creates short-lived workers of a higher priority one after the
+ * other: each one runs at once, wakes the creator, and either deletes
+ * itself (freed by the idle task) or is deleted by the creator.  The rate
+ * of workers shows the cost of the host thread and of the wait event
+ * behind every task, with and without configPOSIX_THREAD_POOL_SIZE.
+ * Built by "make bench":
+ *
+ *     task_churn_threads    a host thread created per task
+ *     task_churn_pool       host threads reused by the pool
+ *
+ * Usage: task_churn [workers]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef BENCH_NAME
+    #define BENCH_NAME    "task_churn"
+#endif
+
+#define benchDEFAULT_WORKERS    20000UL
+
+static unsigned long ulWorkers;
+static TaskHandle_t xCreatorTask;
+
+static void prvWorkerTask( void * pvParameters )
+{
+    xTaskNotifyGive( xCreatorTask );
+
+    if( pvParameters != NULL )
+    {
+        vTaskDelete( NULL );
+    }
+
+    vTaskSuspend( NULL );
+}
+
+static void prvCreatorTask( void * pvParameters )
+{
+    unsigned long ulWorker;
+    TaskHandle_t xWorker;
+    struct timespec xStart, xNow;
+    double dElapsed;
+
+    ( void ) pvParameters;
+
+    clock_gettime( CLOCK_MONOTONIC, &xStart );
+
+    for( ulWorker = 0; ulWorker < ulWorkers; ulWorker++ )
+    {
+        if( xTaskCreate( prvWorkerTask, "Worker", configMINIMAL_STACK_SIZE,
+                         ( void * ) ( uintptr_t ) ( ulWorker & 1UL ), tskIDLE_PRIORITY + 1, &xWorker ) != pdPASS )
+        {
+            vAssertCalled( __FILE__, __LINE__ );
+        }
+
+        ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+        if( ( ulWorker & 1UL ) == 0 )
+        {
+            /* Suspended, deleted and freed here. */
+            vTaskDelete( xWorker );
+        }
+        else
+        {
+            /* Deleted itself, freed by the idle task. */
+            taskYIELD();
+        }
+    }
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+    dElapsed = ( double ) ( xNow.tv_sec - xStart.tv_sec ) +
+               ( double ) ( xNow.tv_nsec - xStart.tv_nsec ) * 1e-9;
+    printf( "%-28s %7lu workers %8.3f s %9.0f workers/s %6.1f us/worker\n",
+            BENCH_NAME, ulWorkers, dElapsed, ( double ) ulWorkers / dElapsed,
+            dElapsed * 1e6 / ( double ) ulWorkers );
+    exit( 0 );
+}
+
+int main( int argc,
+          char ** argv )
+{
+    ulWorkers = benchDEFAULT_WORKERS;
+    if( argc > 1 )
+    {
+        ulWorkers = strtoul( argv[ 1 ], NULL, 0 );
+    }
+
+    /* At the priority of the idle task, which frees the workers deleting
+     * themselves when the creator yields. */
+    xTaskCreate( prvCreatorTask, "Creator", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY, &xCreatorTask );
+
+    vTaskStartScheduler();
+
+    return 1;
+}
+
+void vAssertCalled( const char * const pcFileName,
+                    unsigned long ulLine )
+{
+    fprintf( stderr, "assert: %s:%lu\n", pcFileName, ulLine );
+    abort();
+}
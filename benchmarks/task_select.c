@@ -0,0 +1,95 @@
+/**
+ * @file task_select.c
+ * @brief Ready task selection benchmark of the Posix port
+ *
+ * A task at the lowest priority above the idle one wakes a task at the
+ * highest priority in a loop: the woken task runs at once and blocks again,
+ * so every round selects the highest ready priority twice, and the second
+ * time the generic selection walks every empty ready list from the top
+ * priority down.  With configUSE_PORT_OPTIMISED_TASK_SELECTION the port
+ * reads a bitmap of the ready priorities instead, at a cost that does not
+ * depend on configMAX_PRIORITIES.  Green threads with the soft interrupt
+ * mask (configPOSIX_SOFT_INTERRUPT_MASK) keep the switch itself cheap, with
+ * no signal mask system call.  Built by "make bench":
+ *
+ *     task_select_generic_8      generic selection, 8 priorities
+ *     task_select_generic_256    generic selection, 256 priorities
+ *     task_select_bitmap_8       bitmap of one word, 8 priorities
+ *     task_select_bitmap_256     bitmap of two levels, 256 priorities
+ *
+ * Usage: task_select [rounds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef BENCH_NAME
+    #define BENCH_NAME    "task_select"
+#endif
+
+#define benchDEFAULT_ROUNDS    200000UL
+
+static unsigned long ulRounds;
+static TaskHandle_t xHighTask;
+
+static void prvHighTask( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ; ; )
+    {
+        ( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+    }
+}
+
+static void prvLowTask( void * pvParameters )
+{
+    unsigned long ulRound;
+    struct timespec xStart, xNow;
+    double dElapsed;
+
+    ( void ) pvParameters;
+
+    clock_gettime( CLOCK_MONOTONIC, &xStart );
+
+    for( ulRound = 0; ulRound < ulRounds; ulRound++ )
+    {
+        xTaskNotifyGive( xHighTask );
+    }
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+    dElapsed = ( double ) ( xNow.tv_sec - xStart.tv_sec ) +
+               ( double ) ( xNow.tv_nsec - xStart.tv_nsec ) * 1e-9;
+    printf( "%-28s %4d priorities %7lu rounds %8.3f s %6.1f ns/round\n",
+            BENCH_NAME, configMAX_PRIORITIES, ulRounds, dElapsed,
+            dElapsed * 1e9 / ( double ) ulRounds );
+    exit( 0 );
+}
+
+int main( int argc,
+          char ** argv )
+{
+    ulRounds = benchDEFAULT_ROUNDS;
+    if( argc > 1 )
+    {
+        ulRounds = strtoul( argv[ 1 ], NULL, 0 );
+    }
+
+    xTaskCreate( prvHighTask, "High", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 1, &xHighTask );
+    xTaskCreate( prvLowTask, "Low", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, NULL );
+
+    vTaskStartScheduler();
+
+    return 1;
+}
+
+void vAssertCalled( const char * const pcFileName,
+                    unsigned long ulLine )
+{
+    fprintf( stderr, "assert: %s:%lu\n", pcFileName, ulLine );
+    abort();
+}
@@ -0,0 +1,167 @@
+/**
+ * @file task_snapshot.c
+ * @brief Monitoring benchmark of uxTaskGetSystemState() and task snapshots
+ *
+ * A monitoring task of low priority reads the state of 64 blocked tasks with
+ * large stacks over and over, while an acquisition task of higher priority
+ * wakes every tick.  uxTaskGetSystemState() suspends the scheduler while it
+ * walks the task lists and scans every stack for its high water mark, so a
+ * tick that comes during a call only wakes the acquisition task when the
+ * call returns.  uxTaskGetSnapshot() (configUSE_TASK_SNAPSHOTS) copies the
+ * published snapshots without holding the scheduler.  The time per call and
+ * the mean and worst lateness of the acquisition task are printed.
+ * Built by "make bench":
+ *
+ *     task_snapshot_system_state    uxTaskGetSystemState()
+ *     task_snapshot_seqlock         uxTaskGetSnapshot()
+ *
+ * Usage: task_snapshot [ticks]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef BENCH_NAME
+    #define BENCH_NAME    "task_snapshot"
+#endif
+
+#define benchDEFAULT_TICKS     2000UL
+#define benchSLEEPERS          64
+#define benchSLEEPER_STACK     2048
+#define benchMAX_TASKS         ( benchSLEEPERS + 8 )
+
+static unsigned long ulTicks;
+static unsigned long volatile ulCalls;
+static long long volatile llCallNs;
+static long long volatile llTickNs;
+static unsigned long volatile ulWakes;
+static long long volatile llLatenessNs;
+static long long volatile llWorstLatenessNs;
+
+#if ( configUSE_TASK_SNAPSHOTS == 1 )
+    static TaskSnapshot_t xTasks[ benchMAX_TASKS ];
+#else
+    static TaskStatus_t xTasks[ benchMAX_TASKS ];
+#endif
+
+static long long prvNowNs( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return ( long long ) xNow.tv_sec * 1000000000LL + ( long long ) xNow.tv_nsec;
+}
+
+static void prvSleeperTask( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ; ; )
+    {
+        vTaskDelay( portMAX_DELAY );
+    }
+}
+
+static void prvMonitorTask( void * pvParameters )
+{
+    long long llStart;
+
+    ( void ) pvParameters;
+
+    for( ; ; )
+    {
+        llStart = prvNowNs();
+
+        #if ( configUSE_TASK_SNAPSHOTS == 1 )
+            ( void ) uxTaskGetSnapshot( xTasks, benchMAX_TASKS, NULL, NULL );
+        #else
+            ( void ) uxTaskGetSystemState( xTasks, benchMAX_TASKS, NULL );
+        #endif
+
+        llCallNs += prvNowNs() - llStart;
+        ulCalls++;
+    }
+}
+
+/* The lateness of a wake is measured from the last tick, whose time is taken
+ * by the tick hook, called even while the scheduler is suspended. */
+static void prvAcquisitionTask( void * pvParameters )
+{
+    TickType_t xLastWake;
+    long long llLateness;
+
+    ( void ) pvParameters;
+
+    xLastWake = xTaskGetTickCount();
+
+    for( ; ; )
+    {
+        vTaskDelayUntil( &xLastWake, 1 );
+
+        llLateness = prvNowNs() - llTickNs;
+
+        if( llLateness > llWorstLatenessNs )
+        {
+            llWorstLatenessNs = llLateness;
+        }
+
+        llLatenessNs += llLateness;
+        ulWakes++;
+    }
+}
+
+static void prvReportTask( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    vTaskDelay( ( TickType_t ) ulTicks );
+
+    printf( "%-28s %2d tasks %7lu calls %8.1f us/call %7.1f us mean %7.1f us worst lateness\n",
+            BENCH_NAME, benchSLEEPERS, ulCalls,
+            ( ulCalls > 0UL ) ? ( double ) llCallNs / ( double ) ulCalls * 1e-3 : 0.0,
+            ( ulWakes > 0UL ) ? ( double ) llLatenessNs / ( double ) ulWakes * 1e-3 : 0.0,
+            ( double ) llWorstLatenessNs * 1e-3 );
+    exit( 0 );
+}
+
+int main( int argc,
+          char ** argv )
+{
+    int i;
+
+    ulTicks = benchDEFAULT_TICKS;
+    if( argc > 1 )
+    {
+        ulTicks = strtoul( argv[ 1 ], NULL, 0 );
+    }
+
+    for( i = 0; i < benchSLEEPERS; i++ )
+    {
+        xTaskCreate( prvSleeperTask, "Sleeper", benchSLEEPER_STACK, NULL, tskIDLE_PRIORITY + 1, NULL );
+    }
+
+    xTaskCreate( prvMonitorTask, "Monitor", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, NULL );
+    xTaskCreate( prvAcquisitionTask, "Acquisition", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 2, NULL );
+    xTaskCreate( prvReportTask, "Report", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 1, NULL );
+
+    vTaskStartScheduler();
+
+    return 1;
+}
+
+void vApplicationTickHook( void )
+{
+    llTickNs = prvNowNs();
+}
+
+void vAssertCalled( const char * const pcFileName,
+                    unsigned long ulLine )
+{
+    fprintf( stderr, "assert: %s:%lu\n", pcFileName, ulLine );
+    abort();
+}
@@ -0,0 +1,110 @@
+/**
+ * @file task_yield.c
+ * @brief Task switch microbenchmark of the Posix port through the kernel
+ *
+ * Two tasks of the same priority call taskYIELD() in a loop, so every yield
+ * is a full kernel task switch: critical section, vTaskSwitchContext() and
+ * the switch of the port.  Built once per port mode ("make bench"):
+ *
+ *     task_yield_threads           one host thread per task
+ *     task_yield_threads_softmask  same, configPOSIX_SOFT_INTERRUPT_MASK
+ *     task_yield_green             green threads, stack switch routine
+ *     task_yield_green_softmask    same, configPOSIX_SOFT_INTERRUPT_MASK
+ *     task_yield_green_ucontext    green threads, swapcontext()
+ *     task_yield_stack_check       threads, configCHECK_FOR_STACK_OVERFLOW 2
+ *     task_yield_guarded_stacks    threads, configPOSIX_GUARDED_STACKS
+ *
+ * Usage: task_yield [switches]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef BENCH_NAME
+    #define BENCH_NAME    "task_yield"
+#endif
+
+#define benchDEFAULT_SWITCHES    200000UL
+
+static unsigned long ulRounds;
+static struct timespec xStart;
+static volatile int iFinished;
+
+static double prvElapsed( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+    return ( double ) ( xNow.tv_sec - xStart.tv_sec ) +
+           ( double ) ( xNow.tv_nsec - xStart.tv_nsec ) * 1e-9;
+}
+
+static void prvYieldTask( void * pvParameters )
+{
+    unsigned long ul;
+    double dElapsed;
+
+    ( void ) pvParameters;
+
+    /* The first task to run starts the clock. */
+    if( xStart.tv_sec == 0 )
+    {
+        clock_gettime( CLOCK_MONOTONIC, &xStart );
+    }
+
+    for( ul = 0; ul < ulRounds; ul++ )
+    {
+        taskYIELD();
+    }
+
+    if( ++iFinished == 2 )
+    {
+        dElapsed = prvElapsed();
+        printf( "%-28s %9lu switches %8.3f s %10.0f switches/s %7.3f us/switch\n",
+                BENCH_NAME, ulRounds * 2UL, dElapsed, ( double ) ( ulRounds * 2UL ) / dElapsed,
+                dElapsed * 1e6 / ( double ) ( ulRounds * 2UL ) );
+        exit( 0 );
+    }
+
+    vTaskDelete( NULL );
+}
+
+int main( int argc,
+          char ** argv )
+{
+    unsigned long ulSwitches = benchDEFAULT_SWITCHES;
+
+    if( argc > 1 )
+    {
+        ulSwitches = strtoul( argv[ 1 ], NULL, 0 );
+    }
+
+    ulRounds = ( ulSwitches + 1UL ) / 2UL;
+
+    xTaskCreate( prvYieldTask, "Yield1", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, NULL );
+    xTaskCreate( prvYieldTask, "Yield2", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, NULL );
+
+    vTaskStartScheduler();
+
+    return 1;
+}
+
+void vAssertCalled( const char * const pcFileName,
+                    unsigned long ulLine )
+{
+    fprintf( stderr, "assert: %s:%lu\n", pcFileName, ulLine );
+    abort();
+}
+
+void vApplicationStackOverflowHook( TaskHandle_t xTask,
+                                    char * pcTaskName )
+{
+    ( void ) xTask;
+
+    fprintf( stderr, "stack overflow: %s\n", pcTaskName );
+    abort();
+}
@@ -0,0 +1,134 @@
+/**
+ * @file tick_rate.c
+ * @brief Tick rate benchmark of the Posix port
+ *
+ * A task blocks for one tick in a loop with vTaskDelayUntil(), as a
+ * sampling task at the tick rate would, and measures the period of its
+ * wake-ups on the monotonic clock.  At the end the kernel time is compared
+ * with the wall time: a tick rate is sustained when the kernel keeps up
+ * without dropping ticks, the catch-up counters tell how often it had to
+ * handle ticks late.  The tick interrupts per tick tell how often the host
+ * really woke up: below 1 when the ticks are batched (above
+ * configPOSIX_TICK_INTERRUPT_MAX_HZ) or caught up, the task then wakes once
+ * per interrupt and its next delays return at once.  Built once per tick
+ * rate ("make bench"):
+ *
+ *     tick_rate_1k ... tick_rate_100k   tick thread, catch-up, soft mask
+ *
+ * Usage: tick_rate [seconds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef BENCH_NAME
+    #define BENCH_NAME    "tick_rate"
+#endif
+
+#define benchDEFAULT_SECONDS    2UL
+
+static unsigned long ulPeriods;
+static uint32_t * pulPeriodNs;
+
+static uint64_t prvNowNs( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+    return ( uint64_t ) xNow.tv_sec * 1000000000ULL + ( uint64_t ) xNow.tv_nsec;
+}
+
+static int prvCompare( const void * pvA,
+                       const void * pvB )
+{
+    uint32_t ulA = *( const uint32_t * ) pvA;
+    uint32_t ulB = *( const uint32_t * ) pvB;
+
+    return ( ulA > ulB ) - ( ulA < ulB );
+}
+
+static void prvSampleTask( void * pvParameters )
+{
+    TickType_t xLastWake, xStartTick, xEndTick;
+    uint32_t ulStartInterrupts;
+    uint64_t ullStart, ullLast, ullNow, ullSumDev = 0;
+    uint32_t ulDev;
+    unsigned long ul;
+    double dElapsed;
+
+    ( void ) pvParameters;
+
+    /* Start on a tick boundary. */
+    vTaskDelay( 1 );
+    xStartTick = xLastWake = xTaskGetTickCount();
+    ulStartInterrupts = ulPortTickInterrupts;
+    ullStart = ullLast = prvNowNs();
+
+    for( ul = 0; ul < ulPeriods; ul++ )
+    {
+        vTaskDelayUntil( &xLastWake, 1 );
+        ullNow = prvNowNs();
+        pulPeriodNs[ ul ] = ( uint32_t ) ( ullNow - ullLast );
+        ullLast = ullNow;
+    }
+
+    xEndTick = xTaskGetTickCount();
+    dElapsed = ( double ) ( ullLast - ullStart ) * 1e-9;
+
+    for( ul = 0; ul < ulPeriods; ul++ )
+    {
+        ulDev = ( pulPeriodNs[ ul ] > portTICK_PERIOD_NS ) ? pulPeriodNs[ ul ] - portTICK_PERIOD_NS :
+                portTICK_PERIOD_NS - pulPeriodNs[ ul ];
+        pulPeriodNs[ ul ] = ulDev;
+        ullSumDev += ulDev;
+    }
+
+    qsort( pulPeriodNs, ulPeriods, sizeof( pulPeriodNs[ 0 ] ), prvCompare );
+
+    /* Kernel ticks per wall time tick, 1.000 when the rate is sustained,
+     * and tick interrupts per kernel tick. */
+    printf( "%-28s %7lu Hz %6.3f kernel/wall %5.3f irq/tick %6lu caught up %6lu lost  jitter mean %7.2f p99 %8.2f max %9.2f us\n",
+            BENCH_NAME, ( unsigned long ) configTICK_RATE_HZ,
+            ( double ) ( xEndTick - xStartTick ) / ( dElapsed * configTICK_RATE_HZ ),
+            ( double ) ( ulPortTickInterrupts - ulStartInterrupts ) / ( double ) ( xEndTick - xStartTick ),
+            ( unsigned long ) ulPortTicksCaughtUp, ( unsigned long ) ulPortTicksLost,
+            ( double ) ullSumDev / ( double ) ulPeriods * 1e-3,
+            ( double ) pulPeriodNs[ ( ulPeriods * 99UL ) / 100UL ] * 1e-3,
+            ( double ) pulPeriodNs[ ulPeriods - 1UL ] * 1e-3 );
+    exit( 0 );
+}
+
+int main( int argc,
+          char ** argv )
+{
+    unsigned long ulSeconds = benchDEFAULT_SECONDS;
+
+    if( argc > 1 )
+    {
+        ulSeconds = strtoul( argv[ 1 ], NULL, 0 );
+    }
+
+    ulPeriods = ulSeconds * configTICK_RATE_HZ;
+    pulPeriodNs = malloc( ulPeriods * sizeof( pulPeriodNs[ 0 ] ) );
+    if( ( ulPeriods == 0 ) || ( pulPeriodNs == NULL ) )
+    {
+        return 1;
+    }
+
+    xTaskCreate( prvSampleTask, "Sample", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, NULL );
+
+    vTaskStartScheduler();
+
+    return 1;
+}
+
+void vAssertCalled( const char * const pcFileName,
+                    unsigned long ulLine )
+{
+    fprintf( stderr, "assert: %s:%lu\n", pcFileName, ulLine );
+    abort();
+}
@@ -0,0 +1,134 @@
+/**
+ * @file virtual_time.c
+ * @brief Virtual time benchmark of the Posix port
+ *
+ * Periodic tasks of different rates and a timer interrupt line waking a
+ * task run on the virtual clock of configPOSIX_VIRTUAL_TIME.  The time
+ * simulated is compared with the wall time, and every wake-up is folded
+ * with its task and time into a hash: two runs print the same hash when
+ * the simulation is deterministic.  Built by "make bench":
+ *
+ *     virtual_time    tick thread, soft mask, interrupt controller,
+ *                     tickless idle, virtual time
+ *
+ * Usage: virtual_time [simulated seconds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef BENCH_NAME
+    #define BENCH_NAME    "virtual_time"
+#endif
+
+#define benchDEFAULT_SECONDS    120UL
+#define benchTIMER_LINE         1U
+#define benchTIMER_PERIOD_US    2500UL
+
+static TickType_t xEndTick;
+static TaskHandle_t xInterruptTask;
+static uint64_t ullHash = 14695981039346656037ULL;
+static unsigned long ulEvents;
+static struct timespec xStart;
+
+/* FNV-1a of the task, the tick count and the virtual time of a wake-up. */
+static void prvRecord( uint32_t ulTask )
+{
+    uint64_t ullValues[ 3 ] = { ulTask, xTaskGetTickCount(), ullPortGetTimeNs() };
+    const uint8_t * pucByte = ( const uint8_t * ) ullValues;
+    size_t x;
+
+    for( x = 0; x < sizeof( ullValues ); x++ )
+    {
+        ullHash = ( ullHash ^ pucByte[ x ] ) * 1099511628211ULL;
+    }
+
+    ulEvents++;
+}
+
+static void prvPeriodicTask( void * pvParameters )
+{
+    TickType_t xPeriod = ( TickType_t ) ( uintptr_t ) pvParameters;
+    TickType_t xLastWake = xTaskGetTickCount();
+    struct timespec xNow;
+    double dElapsed;
+
+    for( ; ; )
+    {
+        vTaskDelayUntil( &xLastWake, xPeriod );
+        prvRecord( ( uint32_t ) xPeriod );
+
+        if( xLastWake >= xEndTick )
+        {
+            clock_gettime( CLOCK_MONOTONIC, &xNow );
+            dElapsed = ( double ) ( xNow.tv_sec - xStart.tv_sec ) +
+                       ( double ) ( xNow.tv_nsec - xStart.tv_nsec ) * 1e-9;
+            printf( "%-28s %7.0f s simulated %8.3f s real %9.0fx  %9lu events  hash %016llx\n",
+                    BENCH_NAME, ( double ) ullPortGetTimeNs() * 1e-9, dElapsed,
+                    ( double ) ullPortGetTimeNs() * 1e-9 / dElapsed, ulEvents,
+                    ( unsigned long long ) ullHash );
+            exit( 0 );
+        }
+    }
+}
+
+static void prvInterruptTask( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ; ; )
+    {
+        ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+        prvRecord( 0 );
+    }
+}
+
+static void prvTimerInterrupt( void * pvParameter )
+{
+    BaseType_t xWoken = pdFALSE;
+
+    ( void ) pvParameter;
+
+    vTaskNotifyGiveFromISR( xInterruptTask, &xWoken );
+    portYIELD_FROM_ISR( xWoken );
+}
+
+int main( int argc,
+          char ** argv )
+{
+    unsigned long ulSeconds = benchDEFAULT_SECONDS;
+
+    if( argc > 1 )
+    {
+        ulSeconds = strtoul( argv[ 1 ], NULL, 0 );
+    }
+
+    xEndTick = ( TickType_t ) ulSeconds * configTICK_RATE_HZ;
+
+    xTaskCreate( prvInterruptTask, "Irq", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 4, &xInterruptTask );
+    xTaskCreate( prvPeriodicTask, "P10", configMINIMAL_STACK_SIZE, ( void * ) 10, tskIDLE_PRIORITY + 3, NULL );
+    xTaskCreate( prvPeriodicTask, "P35", configMINIMAL_STACK_SIZE, ( void * ) 35, tskIDLE_PRIORITY + 2, NULL );
+    xTaskCreate( prvPeriodicTask, "P1000", configMINIMAL_STACK_SIZE, ( void * ) 1000, tskIDLE_PRIORITY + 1, NULL );
+
+    if( ( xPortInstallInterruptHandler( benchTIMER_LINE, 5, prvTimerInterrupt, NULL ) != pdPASS ) ||
+        ( iPortInterruptAttachTimer( benchTIMER_LINE, benchTIMER_PERIOD_US ) < 0 ) )
+    {
+        return 1;
+    }
+
+    clock_gettime( CLOCK_MONOTONIC, &xStart );
+    vTaskStartScheduler();
+
+    return 1;
+}
+
+void vAssertCalled( const char * const pcFileName,
+                    unsigned long ulLine )
+{
+    fprintf( stderr, "assert: %s:%lu\n", pcFileName, ulLine );
+    abort();
+}
@@ -38,11 +38,12 @@
 *----------------------------------------------------------*/
 
 #define configUSE_PREEMPTION                       1
-#define configUSE_PORT_OPTIMISED_TASK_SELECTION    0
 #define configUSE_IDLE_HOOK                        1
 #define configUSE_TICK_HOOK                        1
 #define configUSE_DAEMON_TASK_STARTUP_HOOK         1
-#define configTICK_RATE_HZ                         ( 1000 )                  /* In this non-real time simulated environment the tick frequency has to be at least a multiple of the Win32 tick frequency, and therefore very slow. */
+#ifndef configTICK_RATE_HZ
+    #define configTICK_RATE_HZ                     ( 1000 )                  /* Up to 100 kHz with the Posix port, "make TICK_RATE_HZ=10000" overrides it. */
+#endif
 #define configMINIMAL_STACK_SIZE                   ( ( unsigned short ) 70 ) /* In this simulated case, the stack only has to hold one small structure as the real stack is part of the win32 thread. */
 #define configTOTAL_HEAP_SIZE                      ( ( size_t ) ( 65 * 1024 ) )
 #define configMAX_TASK_NAME_LEN                    ( 12 )
@@ -86,6 +87,76 @@ void vConfigureTimerForRunTimeStats( void );    /* Prototype of function that in
  * FreeRTOS/Source/tasks.c for limitations. */
 #define configUSE_STATS_FORMATTING_FUNCTIONS      1
 
+/* Binary kernel event recorder, see trace_recorder.c.  The buffers are written
+ * to configTRACE_RECORDER_FILE when the application is stopped with Ctrl+C and
+ * can be converted with tools/trace_to_chrome.py. */
+#define configUSE_TRACE_RECORDER                  1
+#define configTRACE_RECORDER_BUFFER_SIZE          16384U
+#define configTRACE_RECORDER_FILE                 BUILD_DIR "/trace.bin"
+
+/* Mutex contention statistics, see mutex_profiler.c.  Printed by the "mutex"
+ * command of the serial interface. */
+#define configUSE_MUTEX_PROFILER                  1
+
+/* Allocation profiler, see heap_profiler.c.  Enabled by "make HEAP_PROFILER=1",
+ * which also routes pvPortMalloc()/vPortFree() through the profiler at link
+ * time.  Printed by the "heap" command of the serial interface. */
+#ifndef configUSE_HEAP_PROFILER
+    #define configUSE_HEAP_PROFILER               0
+#endif
+
+/* Prometheus metrics served on a Unix domain socket, see metrics_server.c. */
+#define configUSE_METRICS_SERVER                  1
+#define configMETRICS_SOCKET_PATH                 BUILD_DIR "/metrics.sock"
+
+/* Sampling profiler, see sample_profiler.c.  The "profile" command of the
+ * serial interface writes the folded stacks to configSAMPLE_PROFILER_FILE. */
+#define configUSE_SAMPLE_PROFILER                 1
+#define configSAMPLE_PROFILER_FILE                BUILD_DIR "/profile.folded"
+
+/* Posix port: the tick is sent by a host thread blocked on a timerfd to the
+ * thread of the running task, instead of the process wide setitimer(). */
+#define configPOSIX_TICK_THREAD                   1
+
+/* Posix port: handle the ticks missed under host load so the kernel time
+ * follows the monotonic time, see ulPortTicksCaughtUp / ulPortTicksLost. */
+#define configPOSIX_TICK_CATCH_UP                 1
+
+/* Posix port: critical sections set a flag instead of blocking the signals
+ * with a system call, interrupts raised meanwhile run when they end. */
+#define configPOSIX_SOFT_INTERRUPT_MASK           1
+
+/* Posix port: interrupt lines with priorities raised by host file
+ * descriptors, the ADC data ready interrupt of main_app.c is one. */
+#define configPOSIX_INTERRUPT_CONTROLLER          1
+
+/* SMP scheduler on simulated cores, "make CORES=2" enables it.  The
+ * tickless idle is single core only. */
+#ifndef configNUMBER_OF_CORES
+    #define configNUMBER_OF_CORES                 1
+#endif
+#define configUSE_CORE_AFFINITY                   1
+#define configUSE_PASSIVE_IDLE_HOOK               1
+
+/* Stop the tick and sleep the host while no task is due, see
+ * vPortSuppressTicksAndSleep() in the Posix port, and select the next task
+ * from the bitmap of the ready priorities of the port.  Both single core
+ * only. */
+#if ( configNUMBER_OF_CORES == 1 )
+    #define configUSE_TICKLESS_IDLE                    1
+    #define configUSE_PORT_OPTIMISED_TASK_SELECTION    1
+#else
+    #define configUSE_TICKLESS_IDLE                    0
+    #define configUSE_PORT_OPTIMISED_TASK_SELECTION    0
+#endif
+
+/* Posix port: run on a virtual clock that jumps to the next event while
+ * every task is blocked, deterministic and as fast as the host allows.
+ * Enabled by "make VIRTUAL_TIME=1". */
+#ifndef configPOSIX_VIRTUAL_TIME
+    #define configPOSIX_VIRTUAL_TIME              0
+#endif
+
 /* Enables the test whereby a stack larger than the total heap size is
  * requested. */
 #define configSTACK_DEPTH_TYPE                    uint32_t
@@ -152,8 +223,8 @@ extern void vAssertCalled( const char * const pcFileName,
 
     #define configUSE_MALLOC_FAILED_HOOK    1
 
-/* Include the FreeRTOS+Trace FreeRTOS trace macro definitions. */
-    //#include "trcRecorder.h"
+/* Include the kernel trace macro definitions. */
+    #include "trace_hooks.h"
 #endif /* if ( projCOVERAGE_TEST == 1 ) */
 
 /* networking definitions */
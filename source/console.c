@@ -40,6 +40,7 @@ StaticSemaphore_t xStdioMutexBuffer;
 void console_init( void )
 {
     xStdioMutex = xSemaphoreCreateMutexStatic( &xStdioMutexBuffer );
+    vQueueAddToRegistry( xStdioMutex, "StdioMutex" );
 }
 
 void console_print( const char * fmt,
@@ -0,0 +1,557 @@
+/**
+ * @file heap_profiler.c
+ * @brief Allocation profiler for pvPortMalloc() / vPortFree()
+ *
+ * Every block returned by the heap is remembered in an open addressing hash
+ * table together with its size, call site and owning task, so a free can be
+ * charged back to the site and task that made the allocation.  Counts, bytes
+ * and live high-water marks are kept per call site, per task and in total,
+ * along with a latency histogram of each heap call.
+ *
+ * The tables are updated with the scheduler suspended, as heap_3.c does
+ * around malloc() itself.  pvPortMalloc() must not be called from an ISR.
+ */
+
+/* dladdr() is a GNU extension. */
+#define _GNU_SOURCE
+
+/* System includes. */
+#include <dlfcn.h>
+#include <malloc.h>
+#include <string.h>
+#include <time.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Local includes. */
+#include "console.h"
+#include "heap_profiler.h"
+
+#if ( configUSE_HEAP_PROFILER == 1 )
+
+    #if ( ( configHEAP_PROFILER_MAX_BLOCKS & ( configHEAP_PROFILER_MAX_BLOCKS - 1U ) ) != 0 )
+        #error configHEAP_PROFILER_MAX_BLOCKS must be a power of two
+    #endif
+
+/* Index used for blocks whose site or task could not be recorded. */
+    #define heapprofilerNO_INDEX    0xFFFFU
+
+/*-----------------------------------------------------------*/
+
+typedef struct xHEAP_BLOCK
+{
+    void * pvBlock;
+    size_t xSize;
+    uint16_t usSite;
+    uint16_t usTask;
+} HeapBlock_t;
+
+/* The real heap functions, renamed by the linker. */
+extern void * __real_pvPortMalloc( size_t xWantedSize );
+extern void __real_vPortFree( void * pv );
+
+/* Only heap_4.c and heap_5.c provide heap statistics. */
+extern void vPortGetHeapStats( HeapStats_t * pxHeapStats ) __attribute__( ( weak ) );
+
+void * __wrap_pvPortMalloc( size_t xWantedSize );
+void __wrap_vPortFree( void * pv );
+
+/*-----------------------------------------------------------*/
+
+static HeapBlock_t xHeapBlocks[ configHEAP_PROFILER_MAX_BLOCKS ];
+static HeapProfile_t xHeapProfile;
+
+/* Copy used by vHeapProfilerPrint(), kept off the task stack. */
+static HeapProfile_t xHeapProfileCopy;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNowNs( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return ( uint64_t ) xNow.tv_sec * 1000000000ULL + ( uint64_t ) xNow.tv_nsec;
+}
+
+static uint32_t prvHashBlock( const void * pvBlock )
+{
+    uintptr_t uxKey = ( uintptr_t ) pvBlock;
+
+    /* Blocks are at least 8 byte aligned, drop the constant bits first. */
+    uxKey = ( uxKey >> 3 ) * 0x9E3779B97F4A7C15ULL;
+
+    return ( uint32_t ) ( uxKey >> 32 ) & ( configHEAP_PROFILER_MAX_BLOCKS - 1U );
+}
+
+static void prvRecordLatency( HeapProfileLatency_t * pxLatency,
+                              uint64_t ullNs )
+{
+    uint32_t ulBucket = 0;
+
+    pxLatency->ulCalls++;
+    pxLatency->ullTotalNs += ullNs;
+
+    if( ullNs > pxLatency->ullMaxNs )
+    {
+        pxLatency->ullMaxNs = ullNs;
+    }
+
+    if( ullNs > 0U )
+    {
+        ulBucket = 63U - ( uint32_t ) __builtin_clzll( ullNs );
+    }
+
+    if( ulBucket >= heapprofilerLATENCY_BUCKETS )
+    {
+        ulBucket = heapprofilerLATENCY_BUCKETS - 1U;
+    }
+
+    pxLatency->ulHistogram[ ulBucket ]++;
+}
+
+static void prvCountAllocation( HeapProfileCounters_t * pxCounters,
+                                size_t xSize )
+{
+    pxCounters->ulAllocations++;
+    pxCounters->ullBytesAllocated += xSize;
+    pxCounters->ulLiveBlocks++;
+    pxCounters->ullLiveBytes += xSize;
+
+    if( pxCounters->ulLiveBlocks > pxCounters->ulPeakLiveBlocks )
+    {
+        pxCounters->ulPeakLiveBlocks = pxCounters->ulLiveBlocks;
+    }
+
+    if( pxCounters->ullLiveBytes > pxCounters->ullPeakLiveBytes )
+    {
+        pxCounters->ullPeakLiveBytes = pxCounters->ullLiveBytes;
+    }
+}
+
+static void prvCountFree( HeapProfileCounters_t * pxCounters,
+                          size_t xSize )
+{
+    pxCounters->ulFrees++;
+    pxCounters->ullBytesFreed += xSize;
+
+    /* Blocks allocated before a reset are freed without a live entry. */
+    if( pxCounters->ulLiveBlocks > 0U )
+    {
+        pxCounters->ulLiveBlocks--;
+    }
+
+    pxCounters->ullLiveBytes = ( pxCounters->ullLiveBytes > xSize ) ? ( pxCounters->ullLiveBytes - xSize ) : 0U;
+}
+
+static uint16_t prvFindSite( void * pvCaller )
+{
+    uint32_t i;
+
+    for( i = 0; i < configHEAP_PROFILER_MAX_SITES; i++ )
+    {
+        if( xHeapProfile.xSites[ i ].pvCaller == pvCaller )
+        {
+            return ( uint16_t ) i;
+        }
+
+        if( xHeapProfile.xSites[ i ].pvCaller == NULL )
+        {
+            xHeapProfile.xSites[ i ].pvCaller = pvCaller;
+            return ( uint16_t ) i;
+        }
+    }
+
+    return heapprofilerNO_INDEX;
+}
+
+static uint16_t prvFindTask( void )
+{
+    TaskHandle_t xTask = NULL;
+    uint32_t i;
+
+    if( xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED )
+    {
+        xTask = xTaskGetCurrentTaskHandle();
+    }
+
+    for( i = 0; i < configHEAP_PROFILER_MAX_TASKS; i++ )
+    {
+        if( ( xHeapProfile.xTasks[ i ].pvTask == xTask ) &&
+            ( ( xTask != NULL ) || ( xHeapProfile.xTasks[ i ].cName[ 0 ] != '\0' ) ) )
+        {
+            return ( uint16_t ) i;
+        }
+
+        if( ( xHeapProfile.xTasks[ i ].pvTask == NULL ) && ( xHeapProfile.xTasks[ i ].cName[ 0 ] == '\0' ) )
+        {
+            xHeapProfile.xTasks[ i ].pvTask = xTask;
+            strncpy( xHeapProfile.xTasks[ i ].cName,
+                     ( xTask != NULL ) ? pcTaskGetName( xTask ) : "(startup)",
+                     sizeof( xHeapProfile.xTasks[ i ].cName ) - 1U );
+            return ( uint16_t ) i;
+        }
+    }
+
+    return heapprofilerNO_INDEX;
+}
+
+static void prvInsertBlock( void * pvBlock,
+                            size_t xSize,
+                            uint16_t usSite,
+                            uint16_t usTask )
+{
+    uint32_t ulIndex = prvHashBlock( pvBlock );
+    uint32_t ulProbe;
+
+    for( ulProbe = 0; ulProbe < configHEAP_PROFILER_MAX_BLOCKS; ulProbe++ )
+    {
+        if( xHeapBlocks[ ulIndex ].pvBlock == NULL )
+        {
+            xHeapBlocks[ ulIndex ].pvBlock = pvBlock;
+            xHeapBlocks[ ulIndex ].xSize = xSize;
+            xHeapBlocks[ ulIndex ].usSite = usSite;
+            xHeapBlocks[ ulIndex ].usTask = usTask;
+            return;
+        }
+
+        ulIndex = ( ulIndex + 1U ) & ( configHEAP_PROFILER_MAX_BLOCKS - 1U );
+    }
+
+    xHeapProfile.ulUntrackedBlocks++;
+}
+
+static BaseType_t prvRemoveBlock( void * pvBlock,
+                                  HeapBlock_t * pxBlock )
+{
+    uint32_t ulIndex = prvHashBlock( pvBlock );
+    uint32_t ulNext;
+    uint32_t ulHome;
+    uint32_t ulProbe;
+
+    for( ulProbe = 0; ulProbe < configHEAP_PROFILER_MAX_BLOCKS; ulProbe++ )
+    {
+        if( xHeapBlocks[ ulIndex ].pvBlock == NULL )
+        {
+            return pdFALSE;
+        }
+
+        if( xHeapBlocks[ ulIndex ].pvBlock == pvBlock )
+        {
+            break;
+        }
+
+        ulIndex = ( ulIndex + 1U ) & ( configHEAP_PROFILER_MAX_BLOCKS - 1U );
+    }
+
+    if( ulProbe == configHEAP_PROFILER_MAX_BLOCKS )
+    {
+        return pdFALSE;
+    }
+
+    *pxBlock = xHeapBlocks[ ulIndex ];
+    xHeapBlocks[ ulIndex ].pvBlock = NULL;
+
+    /* Backward shift deletion keeps the probe sequences intact without
+     * tombstones. */
+    ulNext = ( ulIndex + 1U ) & ( configHEAP_PROFILER_MAX_BLOCKS - 1U );
+
+    while( xHeapBlocks[ ulNext ].pvBlock != NULL )
+    {
+        ulHome = prvHashBlock( xHeapBlocks[ ulNext ].pvBlock );
+
+        /* Move the entry back if the hole lies between its home slot and its
+         * current slot (cyclically). */
+        if( ( ( ulNext - ulHome ) & ( configHEAP_PROFILER_MAX_BLOCKS - 1U ) ) >=
+            ( ( ulNext - ulIndex ) & ( configHEAP_PROFILER_MAX_BLOCKS - 1U ) ) )
+        {
+            xHeapBlocks[ ulIndex ] = xHeapBlocks[ ulNext ];
+            xHeapBlocks[ ulNext ].pvBlock = NULL;
+            ulIndex = ulNext;
+        }
+
+        ulNext = ( ulNext + 1U ) & ( configHEAP_PROFILER_MAX_BLOCKS - 1U );
+    }
+
+    return pdTRUE;
+}
+
+/*-----------------------------------------------------------*/
+
+void * __wrap_pvPortMalloc( size_t xWantedSize )
+{
+    void * pvCaller = __builtin_return_address( 0 );
+    void * pvReturn;
+    uint64_t ullStart;
+    uint64_t ullLatency;
+    uint16_t usSite;
+    uint16_t usTask;
+
+    ullStart = prvNowNs();
+    pvReturn = __real_pvPortMalloc( xWantedSize );
+    ullLatency = prvNowNs() - ullStart;
+
+    vTaskSuspendAll();
+    {
+        prvRecordLatency( &xHeapProfile.xMallocLatency, ullLatency );
+
+        if( pvReturn == NULL )
+        {
+            xHeapProfile.ulFailedAllocations++;
+        }
+        else
+        {
+            usSite = prvFindSite( pvCaller );
+            usTask = prvFindTask();
+
+            prvCountAllocation( &xHeapProfile.xTotal, xWantedSize );
+
+            if( usSite != heapprofilerNO_INDEX )
+            {
+                prvCountAllocation( &xHeapProfile.xSites[ usSite ].xCounters, xWantedSize );
+            }
+
+            if( usTask != heapprofilerNO_INDEX )
+            {
+                prvCountAllocation( &xHeapProfile.xTasks[ usTask ].xCounters, xWantedSize );
+            }
+
+            prvInsertBlock( pvReturn, xWantedSize, usSite, usTask );
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void __wrap_vPortFree( void * pv )
+{
+    HeapBlock_t xBlock;
+    uint64_t ullStart;
+    uint64_t ullLatency;
+
+    if( pv == NULL )
+    {
+        return;
+    }
+
+    ullStart = prvNowNs();
+    __real_vPortFree( pv );
+    ullLatency = prvNowNs() - ullStart;
+
+    vTaskSuspendAll();
+    {
+        prvRecordLatency( &xHeapProfile.xFreeLatency, ullLatency );
+
+        if( prvRemoveBlock( pv, &xBlock ) != pdFALSE )
+        {
+            prvCountFree( &xHeapProfile.xTotal, xBlock.xSize );
+
+            if( xBlock.usSite != heapprofilerNO_INDEX )
+            {
+                prvCountFree( &xHeapProfile.xSites[ xBlock.usSite ].xCounters, xBlock.xSize );
+            }
+
+            if( xBlock.usTask != heapprofilerNO_INDEX )
+            {
+                prvCountFree( &xHeapProfile.xTasks[ xBlock.usTask ].xCounters, xBlock.xSize );
+            }
+        }
+        else
+        {
+            /* Block allocated while its table entry could not be stored. */
+            xHeapProfile.xTotal.ulFrees++;
+        }
+    }
+    ( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Copy the current profile
+ *
+ * @param pxProfile destination
+ */
+void vHeapProfilerGetProfile( HeapProfile_t * pxProfile )
+{
+    vTaskSuspendAll();
+    {
+        *pxProfile = xHeapProfile;
+    }
+    ( void ) xTaskResumeAll();
+}
+
+/**
+ * @brief Query the fragmentation of the linked heap
+ *
+ * heap_4.c and heap_5.c report their free blocks through vPortGetHeapStats().
+ * heap_3.c uses the C library allocator, for which only the arena size and
+ * the free bytes inside it are known.
+ *
+ * @param pxFragmentation destination
+ */
+void vHeapProfilerGetFragmentation( HeapFragmentation_t * pxFragmentation )
+{
+    HeapStats_t xStats;
+
+    memset( pxFragmentation, 0, sizeof( *pxFragmentation ) );
+
+    if( vPortGetHeapStats != NULL )
+    {
+        vPortGetHeapStats( &xStats );
+        pxFragmentation->xHeapBytes = configTOTAL_HEAP_SIZE;
+        pxFragmentation->xFreeBytes = xStats.xAvailableHeapSpaceInBytes;
+        pxFragmentation->xLargestFreeBlock = xStats.xSizeOfLargestFreeBlockInBytes;
+        pxFragmentation->xFreeBlocks = xStats.xNumberOfFreeBlocks;
+
+        if( pxFragmentation->xFreeBytes > 0U )
+        {
+            pxFragmentation->ulFragmentationPercent = ( uint32_t ) ( 100U - ( ( pxFragmentation->xLargestFreeBlock * 100U ) / pxFragmentation->xFreeBytes ) );
+        }
+    }
+    else
+    {
+        #if defined( __GLIBC__ ) && ( ( __GLIBC__ > 2 ) || ( __GLIBC_MINOR__ >= 33 ) )
+            struct mallinfo2 xInfo = mallinfo2();
+
+            pxFragmentation->xHeapBytes = xInfo.arena;
+            pxFragmentation->xFreeBytes = xInfo.fordblks;
+            pxFragmentation->xFreeBlocks = xInfo.ordblks;
+
+            /* Free bytes trapped inside the arena, the top chunk that can be
+             * given back to the system is not counted. */
+            if( xInfo.arena > 0U )
+            {
+                pxFragmentation->ulFragmentationPercent = ( uint32_t ) ( ( ( xInfo.fordblks - xInfo.keepcost ) * 100U ) / xInfo.arena );
+            }
+        #endif
+    }
+}
+
+/**
+ * @brief Clear the counters and latencies
+ *
+ * Blocks that are live at the time of the reset stay tracked, their frees
+ * are still charged to the right site and task.
+ */
+void vHeapProfilerReset( void )
+{
+    uint32_t i;
+
+    vTaskSuspendAll();
+    {
+        memset( &xHeapProfile.xTotal, 0, sizeof( xHeapProfile.xTotal ) );
+        memset( &xHeapProfile.xMallocLatency, 0, sizeof( xHeapProfile.xMallocLatency ) );
+        memset( &xHeapProfile.xFreeLatency, 0, sizeof( xHeapProfile.xFreeLatency ) );
+        xHeapProfile.ulFailedAllocations = 0;
+
+        for( i = 0; i < configHEAP_PROFILER_MAX_SITES; i++ )
+        {
+            memset( &xHeapProfile.xSites[ i ].xCounters, 0, sizeof( HeapProfileCounters_t ) );
+        }
+
+        for( i = 0; i < configHEAP_PROFILER_MAX_TASKS; i++ )
+        {
+            memset( &xHeapProfile.xTasks[ i ].xCounters, 0, sizeof( HeapProfileCounters_t ) );
+        }
+    }
+    ( void ) xTaskResumeAll();
+}
+
+static void prvPrintCounters( const char * pcName,
+                              const HeapProfileCounters_t * pxCounters )
+{
+    console_print( "%-36.36s %8u %8u %10llu %8u %10llu %10llu\n",
+                   pcName,
+                   ( unsigned ) pxCounters->ulAllocations,
+                   ( unsigned ) pxCounters->ulFrees,
+                   ( unsigned long long ) pxCounters->ullBytesAllocated,
+                   ( unsigned ) pxCounters->ulLiveBlocks,
+                   ( unsigned long long ) pxCounters->ullLiveBytes,
+                   ( unsigned long long ) pxCounters->ullPeakLiveBytes );
+}
+
+static void prvPrintLatency( const char * pcName,
+                             const HeapProfileLatency_t * pxLatency )
+{
+    uint32_t i;
+
+    console_print( "%s: %u calls, avg %llu ns, max %llu ns\n    ",
+                   pcName,
+                   ( unsigned ) pxLatency->ulCalls,
+                   ( unsigned long long ) ( ( pxLatency->ulCalls > 0U ) ? ( pxLatency->ullTotalNs / pxLatency->ulCalls ) : 0U ),
+                   ( unsigned long long ) pxLatency->ullMaxNs );
+
+    for( i = 0; i < heapprofilerLATENCY_BUCKETS; i++ )
+    {
+        if( pxLatency->ulHistogram[ i ] != 0U )
+        {
+            console_print( "<%lluns:%u ", 1ULL << ( i + 1U ), ( unsigned ) pxLatency->ulHistogram[ i ] );
+        }
+    }
+
+    console_print( "\n" );
+}
+
+/**
+ * @brief Print the profile per call site and per task
+ *
+ * Call sites are resolved with dladdr(), which needs the symbols exported
+ * (-rdynamic, set by "make HEAP_PROFILER=1"); static functions are printed as
+ * the nearest exported symbol plus offset.  Must be called from a task.
+ */
+void vHeapProfilerPrint( void )
+{
+    HeapFragmentation_t xFragmentation;
+    char cSite[ 40 ];
+    Dl_info xInfo;
+    uint32_t i;
+
+    vHeapProfilerGetProfile( &xHeapProfileCopy );
+    vHeapProfilerGetFragmentation( &xFragmentation );
+
+    console_print( "\nHEAP PROFILE:\n" );
+    console_print( "%-36s %8s %8s %10s %8s %10s %10s\n",
+                   "Site / task", "Allocs", "Frees", "Bytes", "Live", "LiveBytes", "PeakBytes" );
+
+    prvPrintCounters( "total", &xHeapProfileCopy.xTotal );
+
+    for( i = 0; ( i < configHEAP_PROFILER_MAX_SITES ) && ( xHeapProfileCopy.xSites[ i ].pvCaller != NULL ); i++ )
+    {
+        if( ( dladdr( xHeapProfileCopy.xSites[ i ].pvCaller, &xInfo ) != 0 ) && ( xInfo.dli_sname != NULL ) )
+        {
+            snprintf( cSite, sizeof( cSite ), "%s+0x%lx", xInfo.dli_sname,
+                      ( unsigned long ) ( ( uintptr_t ) xHeapProfileCopy.xSites[ i ].pvCaller - ( uintptr_t ) xInfo.dli_saddr ) );
+        }
+        else
+        {
+            snprintf( cSite, sizeof( cSite ), "%p", xHeapProfileCopy.xSites[ i ].pvCaller );
+        }
+
+        prvPrintCounters( cSite, &xHeapProfileCopy.xSites[ i ].xCounters );
+    }
+
+    for( i = 0; ( i < configHEAP_PROFILER_MAX_TASKS ) && ( xHeapProfileCopy.xTasks[ i ].cName[ 0 ] != '\0' ); i++ )
+    {
+        snprintf( cSite, sizeof( cSite ), "task %s", xHeapProfileCopy.xTasks[ i ].cName );
+        prvPrintCounters( cSite, &xHeapProfileCopy.xTasks[ i ].xCounters );
+    }
+
+    prvPrintLatency( "pvPortMalloc", &xHeapProfileCopy.xMallocLatency );
+    prvPrintLatency( "vPortFree", &xHeapProfileCopy.xFreeLatency );
+
+    console_print( "failed %u, untracked %u, heap %lu bytes, free %lu in %lu blocks, largest %lu, fragmentation %u%%\n",
+                   ( unsigned ) xHeapProfileCopy.ulFailedAllocations,
+                   ( unsigned ) xHeapProfileCopy.ulUntrackedBlocks,
+                   ( unsigned long ) xFragmentation.xHeapBytes,
+                   ( unsigned long ) xFragmentation.xFreeBytes,
+                   ( unsigned long ) xFragmentation.xFreeBlocks,
+                   ( unsigned long ) xFragmentation.xLargestFreeBlock,
+                   ( unsigned ) xFragmentation.ulFragmentationPercent );
+}
+
+#endif /* configUSE_HEAP_PROFILER */
@@ -0,0 +1,107 @@
+/**
+ * @file heap_profiler.h
+ * @brief Allocation profiler for pvPortMalloc() / vPortFree()
+ *
+ * The profiler sits between the callers and whichever heap_x.c is linked:
+ * "make HEAP_PROFILER=1" links with --wrap=pvPortMalloc and --wrap=vPortFree
+ * so every call from the kernel or the application goes through
+ * __wrap_pvPortMalloc() / __wrap_vPortFree() before reaching the heap.
+ */
+
+#ifndef HEAP_PROFILER_H
+    #define HEAP_PROFILER_H
+
+    #include <stddef.h>
+    #include <stdint.h>
+
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    #ifndef configUSE_HEAP_PROFILER
+        #define configUSE_HEAP_PROFILER    0
+    #endif
+
+/* Maximum number of live blocks tracked, must be a power of two. */
+    #ifndef configHEAP_PROFILER_MAX_BLOCKS
+        #define configHEAP_PROFILER_MAX_BLOCKS    4096U
+    #endif
+
+/* Maximum number of distinct call sites (return addresses). */
+    #ifndef configHEAP_PROFILER_MAX_SITES
+        #define configHEAP_PROFILER_MAX_SITES    64U
+    #endif
+
+/* Maximum number of tasks with their own counters. */
+    #ifndef configHEAP_PROFILER_MAX_TASKS
+        #define configHEAP_PROFILER_MAX_TASKS    32U
+    #endif
+
+/* Latency histogram buckets, bucket n counts calls that took [2^n, 2^(n+1)) ns. */
+    #define heapprofilerLATENCY_BUCKETS    32U
+
+/* Counters shared by the call site, task and global views. */
+    typedef struct xHEAP_PROFILE_COUNTERS
+    {
+        uint32_t ulAllocations;
+        uint32_t ulFrees;
+        uint64_t ullBytesAllocated;
+        uint64_t ullBytesFreed;
+        uint32_t ulLiveBlocks;
+        uint32_t ulPeakLiveBlocks;
+        uint64_t ullLiveBytes;
+        uint64_t ullPeakLiveBytes;
+    } HeapProfileCounters_t;
+
+    typedef struct xHEAP_PROFILE_LATENCY
+    {
+        uint32_t ulCalls;
+        uint64_t ullTotalNs;
+        uint64_t ullMaxNs;
+        uint32_t ulHistogram[ heapprofilerLATENCY_BUCKETS ];
+    } HeapProfileLatency_t;
+
+    typedef struct xHEAP_PROFILE_SITE
+    {
+        void * pvCaller;          /* Return address of the pvPortMalloc() call. */
+        HeapProfileCounters_t xCounters;
+    } HeapProfileSite_t;
+
+    typedef struct xHEAP_PROFILE_TASK
+    {
+        void * pvTask;            /* NULL collects allocations made before the scheduler started. */
+        char cName[ 16 ];
+        HeapProfileCounters_t xCounters;
+    } HeapProfileTask_t;
+
+    typedef struct xHEAP_PROFILE
+    {
+        HeapProfileCounters_t xTotal;
+        uint32_t ulFailedAllocations;
+        uint32_t ulUntrackedBlocks;  /* Blocks not tracked because a table was full. */
+        HeapProfileLatency_t xMallocLatency;
+        HeapProfileLatency_t xFreeLatency;
+        HeapProfileSite_t xSites[ configHEAP_PROFILER_MAX_SITES ];
+        HeapProfileTask_t xTasks[ configHEAP_PROFILER_MAX_TASKS ];
+    } HeapProfile_t;
+
+/* Fragmentation of the underlying heap at the time of the call. */
+    typedef struct xHEAP_PROFILE_FRAGMENTATION
+    {
+        size_t xHeapBytes;           /* Bytes managed by the heap (arena for heap_3). */
+        size_t xFreeBytes;
+        size_t xLargestFreeBlock;    /* 0 when the heap cannot report it (heap_3). */
+        size_t xFreeBlocks;
+        uint32_t ulFragmentationPercent;
+    } HeapFragmentation_t;
+
+    void vHeapProfilerGetProfile( HeapProfile_t * pxProfile );
+    void vHeapProfilerGetFragmentation( HeapFragmentation_t * pxFragmentation );
+    void vHeapProfilerReset( void );
+    void vHeapProfilerPrint( void );
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif /* HEAP_PROFILER_H */
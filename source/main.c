@@ -25,6 +25,7 @@
 
 /* Local includes. */
 #include "console.h"
+#include "trace_recorder.h"
 
 /* This demo uses heap_3.c (the libc provided malloc() and free()). */
 
@@ -39,6 +40,7 @@ extern void main_app( void );
  */
 void vApplicationMallocFailedHook( void );
 void vApplicationIdleHook( void );
+void vApplicationPassiveIdleHook( void );
 void vApplicationStackOverflowHook( TaskHandle_t pxTask,
                                     char * pcTaskName );
 void vApplicationTickHook( void );
@@ -116,6 +118,19 @@ void vApplicationMallocFailedHook( void )
  * 
  */
 void vApplicationIdleHook( void )
+{
+#if ( configUSE_TICKLESS_IDLE == 0 )
+    usleep( 15000 );
+#endif
+    /* With tickless idle the host sleeps in vPortSuppressTicksAndSleep(). */
+}
+
+/**
+ * @brief vApplicationPassiveIdleHook() is called by the idle tasks of the
+ *      cores other than the first one (configNUMBER_OF_CORES above 1), with
+ *      the same restrictions as vApplicationIdleHook().
+ */
+void vApplicationPassiveIdleHook( void )
 {
     usleep( 15000 );
 }
@@ -123,9 +138,10 @@ void vApplicationIdleHook( void )
 /**
  * @brief Run time stack overflow checking is performed if
  *      configCHECK_FOR_STACK_OVERFLOW is defined to 1 or 2.  This hook
- *      function is called if a stack overflow is detected.  This function is
- *      provided as an example only as stack overflow checking does not function
- *      when running the FreeRTOS POSIX port.
+ *      function is called if a stack overflow is detected.  On the POSIX
+ *      port the task stacks are not the stacks the tasks run on, so only
+ *      configPOSIX_GUARDED_STACKS (make GUARDED_STACKS=1) detects the
+ *      overflows, calling this hook from its SIGSEGV handler.
  * 
  * @param pxTask 
  * @param pcTaskName 
@@ -133,9 +149,9 @@ void vApplicationIdleHook( void )
 void vApplicationStackOverflowHook( TaskHandle_t pxTask,
                                     char * pcTaskName )
 {
-    ( void ) pcTaskName;
     ( void ) pxTask;
 
+    fprintf( stderr, "Stack overflow in task %s\n", pcTaskName );
     vAssertCalled( __FILE__, __LINE__ );
 }
 
@@ -283,5 +299,13 @@ void vApplicationGetTimerTaskMemory( StaticTask_t ** ppxTimerTaskTCBBuffer,
 void handle_sigint( int signal )
 {
     console_print( "\nExecution stopped by user (by hitting Ctrl+C)\n" );
+
+#if ( configUSE_TRACE_RECORDER == 1 )
+    if( xTraceRecorderDump( configTRACE_RECORDER_FILE ) == 0 )
+    {
+        console_print( "Kernel trace written to %s\n", configTRACE_RECORDER_FILE );
+    }
+#endif
+
     exit( 2 );
 }
@@ -22,21 +22,38 @@
 
 /* Local includes. */
 #include "console.h"
+#include "mutex_profiler.h"
+#include "heap_profiler.h"
+#include "metrics_server.h"
+#include "sample_profiler.h"
 
 /* Priorities at which the tasks are created. */
-#define mainADC_READ_TASK_PRIORITY              ( tskIDLE_PRIORITY + 3 )
+#define mainADC_READ_TASK_PRIORITY              ( tskIDLE_PRIORITY + 1 )
 #define mainSIGNAL_PROCESSING_TASK_PRIORITY     ( tskIDLE_PRIORITY + 2 )
 #define mainSERIAL_INTERFACE_TASK_PRIORITY      ( tskIDLE_PRIORITY + 1 )
 #define mainSHOW_RUNTIME_STATUS_TASK_PRIORITY   ( tskIDLE_PRIORITY + 1 )
 
 /* The rate at which data is sent to the queue.  The times are converted from
  * milliseconds to ticks using the pdMS_TO_TICKS() macro. */
-#define mainADC_READ_CYCLE_TIME_MS                1UL
-#define mainADC_READ_CYCLE_TIME_TICKS             pdMS_TO_TICKS( mainADC_READ_CYCLE_TIME_MS )
+#ifndef mainADC_READ_CYCLE_TIME_US                                 /* "make ADC_PERIOD_US=100" samples at 10 kHz. */
+    #define mainADC_READ_CYCLE_TIME_US            1000UL
+#endif
+#define mainADC_READ_CYCLE_TIME_TICKS             ( ( TickType_t ) ( ( ( uint64_t ) mainADC_READ_CYCLE_TIME_US * configTICK_RATE_HZ ) / 1000000ULL ) )
+
+/* Without the interrupt controller the ADC task polls with xTaskDelayUntil(),
+ * which cannot wait less than one tick. */
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 0 ) && ( ( mainADC_READ_CYCLE_TIME_US * configTICK_RATE_HZ ) < 1000000UL )
+    #error mainADC_READ_CYCLE_TIME_US is below one tick, raise TICK_RATE_HZ or enable the interrupt controller
+#endif
 #define mainSIGNAL_PROCESSING_CYCLE_TIME_TICKS    pdMS_TO_TICKS( 100UL )
 #define mainINTERFACE_CYCLE_TIME_TICKS            pdMS_TO_TICKS( 1UL )
 #define mainSHOW_RUNTIME_STATUS_CYCLE_TIME_TIKS   pdMS_TO_TICKS( 3000UL )
 
+/* The processor time the signal processing task may take every cycle, see
+ * configUSE_TASK_BUDGETS.  Past it the task runs at the idle priority, below
+ * the acquisition, until the next cycle. */
+#define mainSIGNAL_PROCESSING_BUDGET_TICKS        pdMS_TO_TICKS( 20UL )
+
 /* Constants */
 #define ADC_READ_BUFFER_SIZE                    1000U
 #define ALLOW_ADC_BUFFER_OVERWRITE              0U
@@ -45,6 +62,10 @@
 #define PI_VALUE                                3.141592
 #define SINE_WAVE_FREQ_HZ                       60U
 
+/* Simulated ADC data ready interrupt, see configPOSIX_INTERRUPT_CONTROLLER. */
+#define mainADC_DATA_READY_LINE                 1U
+#define mainADC_DATA_READY_PRIORITY             5U
+
 /*-----------------------------------------------------------*/
 
 /*
@@ -61,6 +82,9 @@ static void prvShowRunTimeStatus( void *pvParameters );
 static void enqueue_adc_sample(double p_sample);
 static uint32_t dequeue_adc_sample(double *const p_sample_p);
 static void clear_adc_queue(void);
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 1 )
+static void adc_data_ready_isr(void *p_param);
+#endif
 
 /* 
  * Signal processing. 
@@ -85,6 +109,17 @@ uint32_t g_adc_buffer_count = 0;
 uint32_t g_adc_buffer_tail = 0;
 uint32_t g_adc_buffer_head = 0;
 uint32_t g_adc_first_overflow = 0;
+uint32_t g_adc_dropped_samples = 0;
+#if ( configUSE_METRICS_SERVER == 1 )
+MetricsHistogram_t g_adc_period_jitter_us;
+#endif
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 1 )
+TaskHandle_t xADCTask = NULL;
+volatile int64_t g_adc_isr_time_us = 0;
+#if ( configUSE_METRICS_SERVER == 1 )
+MetricsHistogram_t g_adc_isr_latency_us;
+#endif
+#endif
 
 /* 
  * Signal processing. 
@@ -95,6 +130,10 @@ uint32_t g_signal_buffer_count = 0;
 uint32_t g_signal_buffer_tail = 0;
 uint32_t g_signal_buffer_head = 0;
 uint32_t g_signal_first_overflow = 0;
+uint32_t g_signal_overwritten_samples = 0;
+#if ( configUSE_TASK_BUDGETS == 1 )
+TaskHandle_t xSignalProcessingTask = NULL;
+#endif
 
 /*-----------------------------------------------------------*/
 
@@ -109,27 +148,82 @@ void main_app( void )
     {
         while(1);
     }
+    vQueueAddToRegistry( xADCMutex, "ADCMutex" );
 
     xSignalMutex = xSemaphoreCreateMutex();
     if( xSignalMutex == NULL )
     {
         while(1);
     }
+    vQueueAddToRegistry( xSignalMutex, "SignalMutex" );
+
+#if ( configUSE_METRICS_SERVER == 1 )
+    vMetricsServerAddGauge( "app_adc_buffer_depth", "Samples in the ADC buffer.", &g_adc_buffer_count );
+    vMetricsServerAddCounter( "app_adc_dropped_samples_total", "ADC samples lost because the buffer was full.", &g_adc_dropped_samples );
+    vMetricsServerAddGauge( "app_signal_buffer_depth", "Samples in the signal buffer.", &g_signal_buffer_count );
+    vMetricsServerAddCounter( "app_signal_overwritten_samples_total", "Signal samples overwritten before being read.", &g_signal_overwritten_samples );
+    vMetricsServerAddCounter( "freertos_ticks_caught_up_total", "Ticks handled late by the tick catch-up.", &ulPortTicksCaughtUp );
+    vMetricsServerAddCounter( "freertos_ticks_lost_total", "Ticks dropped by the tick catch-up.", &ulPortTicksLost );
+    vMetricsServerAddHistogram( "app_adc_period_jitter_us", "Deviation of the ADC task period from its nominal value.", &g_adc_period_jitter_us );
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 1 )
+    vMetricsServerAddHistogram( "app_adc_isr_latency_us", "Time from the ADC data ready interrupt to the ADC task.", &g_adc_isr_latency_us );
+    vMetricsServerAddCounter( "app_adc_data_ready_interrupts_total", "ADC data ready interrupts handled.", pulPortInterruptCounter( mainADC_DATA_READY_LINE ) );
+#endif
+
+    if( xMetricsServerStart() != 0 )
+    {
+        perror( "metrics server" );
+    }
+#endif
+
+#if ( configUSE_SAMPLE_PROFILER == 1 )
+    if( xSampleProfilerStart() != 0 )
+    {
+        perror( "sample profiler" );
+    }
+#endif
 
     /* Start the tasks. */
     xTaskCreate( prvACDReadTask,                     /* The function that implements the task. */
                     "ACDRead",                       /* The text name assigned to the task - for debug only as it is not used by the kernel. */
                     configMINIMAL_STACK_SIZE,        /* The size of the stack to allocate to the task. */
                     NULL,                            /* The parameter passed to the task - not used in this simple case. */
-                    mainADC_READ_CYCLE_TIME_TICKS,      /* The priority assigned to the task. */
+                    mainADC_READ_TASK_PRIORITY,      /* The priority assigned to the task. */
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 1 )
+                    &xADCTask );                     /* Notified by the data ready interrupt. */
+#else
                     NULL );                          /* The task handle is not required, so NULL is passed. */
+#endif
+
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 1 )
+    /* The ADC raises data ready once per conversion, the interrupt runs
+     * as soon as the scheduler enables the interrupts. */
+    if( ( xPortInstallInterruptHandler( mainADC_DATA_READY_LINE, mainADC_DATA_READY_PRIORITY, adc_data_ready_isr, NULL ) != pdPASS ) ||
+        ( iPortInterruptAttachTimer( mainADC_DATA_READY_LINE, mainADC_READ_CYCLE_TIME_US ) < 0 ) )
+    {
+        perror( "ADC data ready interrupt" );
+        while(1);
+    }
+
+#if ( configNUMBER_OF_CORES > 1 )
+    /* The interrupt lines are handled on core 0, the task follows them. */
+    vTaskCoreAffinitySet( xADCTask, 1U << 0 );
+#endif
+#endif
 
     xTaskCreate( prvSignalProcessingTask, 
                     "SignalProcessing", 
                     configMINIMAL_STACK_SIZE, 
                     NULL, 
                     mainSIGNAL_PROCESSING_TASK_PRIORITY, 
+#if ( configUSE_TASK_BUDGETS == 1 )
+                    &xSignalProcessingTask );
+
+    vTaskSetBudget( xSignalProcessingTask, mainSIGNAL_PROCESSING_BUDGET_TICKS,
+                    mainSIGNAL_PROCESSING_CYCLE_TIME_TICKS, eBudgetDemote );
+#else
                     NULL );
+#endif
 
     xTaskCreate( prvSerialInterfaceTask, 
                     "SerialInterface", 
@@ -163,28 +257,66 @@ void main_app( void )
  */
 static void prvACDReadTask( void * pvParameters )
 {
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 0 )
     TickType_t xNextWakeTime;
     const TickType_t xBlockTime = mainADC_READ_CYCLE_TIME_TICKS;
+#endif
     uint32_t cycle_counter = 0;
     double time = 0;
     double sample = 0;
+#if ( configUSE_METRICS_SERVER == 1 )
+    int64_t now_us = 0;
+    int64_t last_wake_us = 0;
+    int64_t jitter_us = 0;
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 1 )
+    int64_t isr_time_us = 0;
+#endif
+#endif
 
     /* Prevent the compiler warning about the unused parameter. */
     ( void ) pvParameters;
 
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 0 )
     /* Initialise xNextWakeTime - this only needs to be done once. */
     xNextWakeTime = xTaskGetTickCount();
+#endif
 
     while( 1 )
     {
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 1 )
+        /* Wait for the data ready interrupt of the ADC.  Conversions
+        *  completed while this task was late are read once. */
+        ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+#if ( configUSE_METRICS_SERVER == 1 )
+        /* Read before the clock, the next interrupt may come meanwhile. */
+        isr_time_us = g_adc_isr_time_us;
+#endif
+#else
         /* Place this task in the blocked state until it is time to run again.
         *  The block time is specified in ticks, pdMS_TO_TICKS() was used to
         *  convert a time specified in milliseconds into a time specified in ticks.
         *  While in the Blocked state this task will not consume any CPU time. */
         vTaskDelayUntil( &xNextWakeTime, xBlockTime );
+#endif
+
+#if ( configUSE_METRICS_SERVER == 1 )
+        /* Period jitter, on the clock of the port (virtual with
+        *  configPOSIX_VIRTUAL_TIME) */
+        now_us = (int64_t)(ullPortGetTimeNs() / 1000);
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 1 )
+        /* Interrupt to task latency */
+        vMetricsHistogramObserve(&g_adc_isr_latency_us, (uint32_t)(now_us - isr_time_us));
+#endif
+        if (last_wake_us != 0)
+        {
+            jitter_us = (now_us - last_wake_us) - (int64_t)mainADC_READ_CYCLE_TIME_US;
+            vMetricsHistogramObserve(&g_adc_period_jitter_us, (uint32_t)(jitter_us < 0 ? -jitter_us : jitter_us));
+        }
+        last_wake_us = now_us;
+#endif
 
         /* ADC reading */
-        time = (double)cycle_counter * ((double)mainADC_READ_CYCLE_TIME_MS / 1000);
+        time = (double)cycle_counter * ((double)mainADC_READ_CYCLE_TIME_US / 1000000);
         sample = sin(2*PI_VALUE*SINE_WAVE_FREQ_HZ*time);
 
         enqueue_adc_sample(sample);
@@ -199,8 +331,8 @@ static void prvACDReadTask( void * pvParameters )
         }
 
         /* ONLY TO GEN RUNTIME STATUS */
-        int k;
-        for(k=0;k<1000000;k++)
+        unsigned long k;
+        for(k=0;k<1000*mainADC_READ_CYCLE_TIME_US;k++)
         {
             __asm volatile ( "NOP" );
         }
@@ -269,6 +401,16 @@ static void prvSerialInterfaceTask( void * pvParameters )
 
 	const char getCommandStr[] = "obter\n";
 	const char clearCommandStr[] = "zerar\n";
+#if ( configUSE_MUTEX_PROFILER == 1 )
+	const char mutexCommandStr[] = "mutex\n";
+#endif
+#if ( configUSE_HEAP_PROFILER == 1 )
+	const char heapCommandStr[] = "heap\n";
+#endif
+#if ( configUSE_SAMPLE_PROFILER == 1 )
+	const char profileCommandStr[] = "profile\n";
+	uint32_t dropped_samples = 0;
+#endif
 
     while( 1 )
     {
@@ -283,33 +425,52 @@ static void prvSerialInterfaceTask( void * pvParameters )
             /* check if input is ENTER key */
             if (user_input_char == '\n')
             {
-                /* check command (must have 6 chars (counting \n) */
-                if (user_input_counter == 6U)
+                if (!strcmp(getCommandStr, user_input_string))
+                {
+                    /* get command */
+                    console_print("Obtendo dados...\n");
+                    get_signal();
+                    console_print("Obtenção de dados concluída!\n");
+                }
+                else if (!strcmp(clearCommandStr, user_input_string))
+                {
+                    /* clear command */
+                    console_print("Limpando buffers...\n");
+                    clear_adc_queue();
+                    clear_signal_queue();
+                    console_print("Limpeza de buffers concluída!\n");
+                }
+#if ( configUSE_MUTEX_PROFILER == 1 )
+                else if (!strcmp(mutexCommandStr, user_input_string))
+                {
+                    /* mutex contention statistics */
+                    vMutexProfilerPrint();
+                }
+#endif
+#if ( configUSE_HEAP_PROFILER == 1 )
+                else if (!strcmp(heapCommandStr, user_input_string))
                 {
-                    if (!strcmp(getCommandStr, &user_input_string[user_input_counter-6U]))
-                    {                  
-                        /* get command */      
-                        console_print("Obtendo dados...\n");
-                        get_signal();
-                        console_print("Obtenção de dados concluída!\n");
+                    /* allocation profile */
+                    vHeapProfilerPrint();
+                }
+#endif
+#if ( configUSE_SAMPLE_PROFILER == 1 )
+                else if (!strcmp(profileCommandStr, user_input_string))
+                {
+                    /* folded stacks of the sampling profiler */
+                    if (xSampleProfilerWrite(configSAMPLE_PROFILER_FILE) == 0)
+                    {
+                        console_print("%u samples (%u dropped) written to %s\n",
+                                      (unsigned)ulSampleProfilerGetSamples(&dropped_samples),
+                                      (unsigned)dropped_samples,
+                                      configSAMPLE_PROFILER_FILE);
                     }
                     else
                     {
-                        if (!strcmp(clearCommandStr, &user_input_string[user_input_counter-6U]))
-                        {
-                            /* clear command */
-                            console_print("Limpando buffers...\n");
-                            clear_adc_queue();
-                            clear_signal_queue();
-                            console_print("Limpeza de buffers concluída!\n");
-                        }
-                        else
-                        {
-                            /* unknown command */
-                            console_print("Undefined command!\n");
-                        }                       
+                        console_print("Could not write %s\n", configSAMPLE_PROFILER_FILE);
                     }
                 }
+#endif
                 else
                 {
                     /* unknown command */
@@ -360,9 +521,33 @@ static void prvShowRunTimeStatus( void *pvParameters )
 		/* copy status to pcWriteBuffer and print on console */
 		vTaskGetRunTimeStats(pcWriteBuffer);
 		console_print("\nTASKS RUNTIME STATUS:\n%s\n", pcWriteBuffer);
+#if ( configUSE_TASK_BUDGETS == 1 )
+		console_print("SignalProcessing budget overruns: %lu\n",
+		              (unsigned long) uxTaskGetBudgetOverruns(xSignalProcessingTask));
+#endif
 	}
 }
 
+#if ( configPOSIX_INTERRUPT_CONTROLLER == 1 )
+/**
+ * @brief ADC data ready interrupt, wakes the ADC task
+ * 
+ * @param p_param 
+ */
+static void adc_data_ready_isr(void *p_param)
+{
+    BaseType_t woken = pdFALSE;
+
+    ( void ) p_param;
+
+    g_adc_isr_time_us = (int64_t)(ullPortGetTimeNs() / 1000);
+
+    vTaskNotifyGiveFromISR(xADCTask, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+#endif
+
 /**
  * @brief Enqueue ADC sample
  * 
@@ -414,6 +599,7 @@ static void enqueue_adc_sample(double p_sample)
     {
         /* Cant enqueue message */
         /* Data lost */
+        g_adc_dropped_samples++;
         if (!g_adc_first_overflow)
         {
             g_adc_first_overflow = 1;
@@ -500,6 +686,7 @@ static void enqueue_signal_sample(double p_sample)
         else
         {
             /* overwrite */
+            g_signal_overwritten_samples++;
             /* Increment head index */
             if (g_signal_buffer_head < (SIGNAL_PROCESSING_BUFFER_SIZE - 1U))
             {
@@ -0,0 +1,812 @@
+/**
+ * @file metrics_server.c
+ * @brief Prometheus metrics exporter on a Unix domain socket
+ *
+ * Two threads share the data:
+ *
+ * - prvMetricsSnapshotTask() is a low priority FreeRTOS task.  It collects the task, queue, heap and application statistics with the
+ *   regular kernel API, so the kernel locks are only held for the copies.
+ *   The result is written into the unpublished half of a double buffer,
+ *   guarded by a sequence counter, and then published.
+ *
+ * - prvMetricsServerThread() is a host thread created outside of the
+ *   scheduler with every signal blocked, so it never receives the tick and
+ *   never runs kernel code.  A scrape copies the published snapshot, retrying
+ *   if the snapshot task rewrote it meanwhile, and formats it.
+ *
+ * A scrape therefore neither blocks nor delays any task.
+ */
+
+/* System includes. */
+#include <errno.h>
+#include <malloc.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+/* Local includes. */
+#include "metrics_server.h"
+
+#if ( configUSE_METRICS_SERVER == 1 )
+
+    #if ( configUSE_TRACE_FACILITY != 1 ) || ( configGENERATE_RUN_TIME_STATS != 1 )
+        #error configUSE_METRICS_SERVER requires configUSE_TRACE_FACILITY and configGENERATE_RUN_TIME_STATS
+    #endif
+
+/* Size of the formatted response. */
+    #define metricsRESPONSE_SIZE             32768U
+
+/* Time a client gets to send its request before the response is sent. */
+    #define metricsREQUEST_TIMEOUT_MS        100
+
+/*-----------------------------------------------------------*/
+
+typedef struct xMETRICS_VALUE
+{
+    const char * pcName;
+    const char * pcHelp;
+    const volatile uint32_t * pulValue;
+    BaseType_t xIsCounter;
+} MetricsValue_t;
+
+typedef struct xMETRICS_HISTOGRAM_SOURCE
+{
+    const char * pcName;
+    const char * pcHelp;
+    const MetricsHistogram_t * pxHistogram;
+} MetricsHistogramSource_t;
+
+typedef struct xMETRICS_QUEUE
+{
+    const void * pvQueue;
+    const char * pcName;
+} MetricsQueue_t;
+
+typedef struct xMETRICS_TASK_SNAPSHOT
+{
+    char cName[ configMAX_TASK_NAME_LEN ];
+    uint32_t ulNumber;
+    uint32_t ulState;
+    uint32_t ulPriority;
+    uint32_t ulBasePriority;
+    uint32_t ulRunTime;
+    uint32_t ulStackHighWaterMark;
+} MetricsTaskSnapshot_t;
+
+typedef struct xMETRICS_QUEUE_SNAPSHOT
+{
+    const char * pcName;
+    uint32_t ulWaiting;
+    uint32_t ulSpaces;
+} MetricsQueueSnapshot_t;
+
+typedef struct xMETRICS_SNAPSHOT
+{
+    uint64_t ullTimestampNs;
+    uint32_t ulTickCount;
+    uint32_t ulTotalRunTime;
+    uint32_t ulTasks;
+    uint32_t ulTasksTruncated;
+    uint32_t ulQueues;
+    uint32_t ulValues;
+    uint32_t ulHistograms;
+    size_t xHeapArena;
+    size_t xHeapInUse;
+    size_t xHeapFree;
+    MetricsTaskSnapshot_t xTasks[ configMETRICS_MAX_TASKS ];
+    MetricsQueueSnapshot_t xQueues[ configMETRICS_MAX_QUEUES ];
+    MetricsValue_t xValueSources[ configMETRICS_MAX_VALUES ];
+    uint32_t ulValueData[ configMETRICS_MAX_VALUES ];
+    MetricsHistogramSource_t xHistogramSources[ configMETRICS_MAX_HISTOGRAMS ];
+    MetricsHistogram_t xHistograms[ configMETRICS_MAX_HISTOGRAMS ];
+} MetricsSnapshot_t;
+
+/*-----------------------------------------------------------*/
+
+static void prvMetricsSnapshotTask( void * pvParameters );
+static void * prvMetricsServerThread( void * pvParameters );
+
+/*-----------------------------------------------------------*/
+
+/* Sources, written by the registration functions and read by the snapshot
+ * task. */
+static MetricsValue_t xValueSources[ configMETRICS_MAX_VALUES ];
+static uint32_t ulValueSources = 0;
+static MetricsHistogramSource_t xHistogramSources[ configMETRICS_MAX_HISTOGRAMS ];
+static uint32_t ulHistogramSources = 0;
+static MetricsQueue_t xQueueSources[ configMETRICS_MAX_QUEUES ];
+
+/* Double buffered snapshot.  ulSnapshotSequence[ n ] is odd while
+ * xSnapshots[ n ] is being written. */
+static MetricsSnapshot_t xSnapshots[ 2 ];
+static uint32_t ulSnapshotSequence[ 2 ];
+static uint32_t ulPublishedSnapshot = 0;
+
+/* Snapshot task scratch buffer. */
+#if ( configUSE_TASK_SNAPSHOTS == 1 )
+    static TaskSnapshot_t xTaskStatus[ configMETRICS_MAX_TASKS ];
+#else
+    static TaskStatus_t xTaskStatus[ configMETRICS_MAX_TASKS ];
+#endif
+
+/* Host thread buffers. */
+static MetricsSnapshot_t xScrapeSnapshot;
+static char cResponse[ metricsRESPONSE_SIZE ];
+static int iListenSocket = -1;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNowNs( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return ( uint64_t ) xNow.tv_sec * 1000000000ULL + ( uint64_t ) xNow.tv_nsec;
+}
+
+static void prvAddValue( const char * pcName,
+                         const char * pcHelp,
+                         const volatile uint32_t * pulValue,
+                         BaseType_t xIsCounter )
+{
+    taskENTER_CRITICAL();
+    {
+        if( ulValueSources < configMETRICS_MAX_VALUES )
+        {
+            xValueSources[ ulValueSources ].pcName = pcName;
+            xValueSources[ ulValueSources ].pcHelp = pcHelp;
+            xValueSources[ ulValueSources ].pulValue = pulValue;
+            xValueSources[ ulValueSources ].xIsCounter = xIsCounter;
+            ulValueSources++;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Export a counter
+ *
+ * @param pcName metric name, must be a valid Prometheus name ending in _total
+ * @param pcHelp description
+ * @param pulValue counter, read by the snapshot task
+ */
+void vMetricsServerAddCounter( const char * pcName,
+                               const char * pcHelp,
+                               const volatile uint32_t * pulValue )
+{
+    prvAddValue( pcName, pcHelp, pulValue, pdTRUE );
+}
+
+/**
+ * @brief Export a gauge
+ *
+ * @param pcName metric name
+ * @param pcHelp description
+ * @param pulValue value, read by the snapshot task
+ */
+void vMetricsServerAddGauge( const char * pcName,
+                             const char * pcHelp,
+                             const volatile uint32_t * pulValue )
+{
+    prvAddValue( pcName, pcHelp, pulValue, pdFALSE );
+}
+
+/**
+ * @brief Export a histogram
+ *
+ * @param pcName metric name
+ * @param pcHelp description
+ * @param pxHistogram histogram, filled with vMetricsHistogramObserve()
+ */
+void vMetricsServerAddHistogram( const char * pcName,
+                                 const char * pcHelp,
+                                 const MetricsHistogram_t * pxHistogram )
+{
+    taskENTER_CRITICAL();
+    {
+        if( ulHistogramSources < configMETRICS_MAX_HISTOGRAMS )
+        {
+            xHistogramSources[ ulHistogramSources ].pcName = pcName;
+            xHistogramSources[ ulHistogramSources ].pcHelp = pcHelp;
+            xHistogramSources[ ulHistogramSources ].pxHistogram = pxHistogram;
+            ulHistogramSources++;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Add an observation to a histogram
+ *
+ * Only one task may observe a given histogram.
+ *
+ * @param pxHistogram histogram
+ * @param ulValue observed value
+ */
+void vMetricsHistogramObserve( MetricsHistogram_t * pxHistogram,
+                               uint32_t ulValue )
+{
+    uint32_t ulBucket = 0;
+
+    if( ulValue > 1U )
+    {
+        /* Smallest n with ulValue <= 2^n. */
+        ulBucket = 32U - ( uint32_t ) __builtin_clz( ulValue - 1U );
+    }
+
+    if( ulBucket >= metricsHISTOGRAM_BUCKETS )
+    {
+        ulBucket = metricsHISTOGRAM_BUCKETS - 1U;
+    }
+
+    pxHistogram->ulBuckets[ ulBucket ]++;
+    pxHistogram->ullSum += ulValue;
+    pxHistogram->ulCount++;
+}
+
+/**
+ * @brief A queue was added to the queue registry
+ *
+ * @param pvQueue queue handle
+ * @param pcName registry name
+ */
+void vMetricsServerQueueNamed( const void * pvQueue,
+                               const char * pcName )
+{
+    uint32_t i;
+
+    taskENTER_CRITICAL();
+    {
+        for( i = 0; i < configMETRICS_MAX_QUEUES; i++ )
+        {
+            if( ( xQueueSources[ i ].pvQueue == NULL ) || ( xQueueSources[ i ].pvQueue == pvQueue ) )
+            {
+                xQueueSources[ i ].pvQueue = pvQueue;
+                xQueueSources[ i ].pcName = pcName;
+                break;
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief A queue is about to be deleted
+ *
+ * @param pvQueue queue handle
+ */
+void vMetricsServerQueueDeleted( const void * pvQueue )
+{
+    uint32_t i;
+
+    taskENTER_CRITICAL();
+    {
+        for( i = 0; i < configMETRICS_MAX_QUEUES; i++ )
+        {
+            if( xQueueSources[ i ].pvQueue == pvQueue )
+            {
+                xQueueSources[ i ].pvQueue = NULL;
+                xQueueSources[ i ].pcName = NULL;
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvTakeSnapshot( MetricsSnapshot_t * pxSnapshot )
+{
+    UBaseType_t uxTasks;
+    uint32_t ulTotalRunTime;
+    BaseType_t xTruncated;
+    uint32_t i;
+
+    pxSnapshot->ullTimestampNs = prvNowNs();
+    pxSnapshot->ulTickCount = ( uint32_t ) xTaskGetTickCount();
+
+    #if ( configUSE_TASK_SNAPSHOTS == 1 )
+        /* Copies the task snapshots published by the kernel, the scheduler
+         * keeps running. */
+        uxTasks = uxTaskGetSnapshot( xTaskStatus, configMETRICS_MAX_TASKS, &ulTotalRunTime, &xTruncated );
+    #else
+        /* Suspends the scheduler while the task lists are walked, and
+         * reports no task if they do not all fit. */
+        uxTasks = uxTaskGetSystemState( xTaskStatus, configMETRICS_MAX_TASKS, &ulTotalRunTime );
+        xTruncated = ( uxTaskGetNumberOfTasks() > configMETRICS_MAX_TASKS ) ? pdTRUE : pdFALSE;
+    #endif
+    pxSnapshot->ulTotalRunTime = ulTotalRunTime;
+    pxSnapshot->ulTasks = ( uint32_t ) uxTasks;
+    pxSnapshot->ulTasksTruncated = ( xTruncated != pdFALSE ) ? 1U : 0U;
+
+    for( i = 0; i < uxTasks; i++ )
+    {
+        strncpy( pxSnapshot->xTasks[ i ].cName, xTaskStatus[ i ].pcTaskName, configMAX_TASK_NAME_LEN - 1 );
+        pxSnapshot->xTasks[ i ].cName[ configMAX_TASK_NAME_LEN - 1 ] = '\0';
+        pxSnapshot->xTasks[ i ].ulNumber = ( uint32_t ) xTaskStatus[ i ].xTaskNumber;
+        pxSnapshot->xTasks[ i ].ulState = ( uint32_t ) xTaskStatus[ i ].eCurrentState;
+        pxSnapshot->xTasks[ i ].ulPriority = ( uint32_t ) xTaskStatus[ i ].uxCurrentPriority;
+        pxSnapshot->xTasks[ i ].ulBasePriority = ( uint32_t ) xTaskStatus[ i ].uxBasePriority;
+        pxSnapshot->xTasks[ i ].ulRunTime = ( uint32_t ) xTaskStatus[ i ].ulRunTimeCounter;
+        pxSnapshot->xTasks[ i ].ulStackHighWaterMark = ( uint32_t ) xTaskStatus[ i ].usStackHighWaterMark;
+    }
+
+    /* The queue table and the application values are only copied here, the
+     * critical section lasts for the copy. */
+    taskENTER_CRITICAL();
+    {
+        pxSnapshot->ulQueues = 0;
+
+        for( i = 0; i < configMETRICS_MAX_QUEUES; i++ )
+        {
+            if( xQueueSources[ i ].pvQueue != NULL )
+            {
+                pxSnapshot->xQueues[ pxSnapshot->ulQueues ].pcName = xQueueSources[ i ].pcName;
+                pxSnapshot->xQueues[ pxSnapshot->ulQueues ].ulWaiting = ( uint32_t ) uxQueueMessagesWaiting( ( QueueHandle_t ) xQueueSources[ i ].pvQueue );
+                pxSnapshot->xQueues[ pxSnapshot->ulQueues ].ulSpaces = ( uint32_t ) uxQueueSpacesAvailable( ( QueueHandle_t ) xQueueSources[ i ].pvQueue );
+                pxSnapshot->ulQueues++;
+            }
+        }
+
+        pxSnapshot->ulValues = ulValueSources;
+
+        for( i = 0; i < ulValueSources; i++ )
+        {
+            pxSnapshot->xValueSources[ i ] = xValueSources[ i ];
+            pxSnapshot->ulValueData[ i ] = *xValueSources[ i ].pulValue;
+        }
+
+        pxSnapshot->ulHistograms = ulHistogramSources;
+
+        for( i = 0; i < ulHistogramSources; i++ )
+        {
+            pxSnapshot->xHistogramSources[ i ] = xHistogramSources[ i ];
+            pxSnapshot->xHistograms[ i ] = *xHistogramSources[ i ].pxHistogram;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    /* mallinfo2() takes the allocator lock, the scheduler is suspended for
+     * the same reason heap_3.c suspends it around malloc(). */
+    #if defined( __GLIBC__ ) && ( ( __GLIBC__ > 2 ) || ( __GLIBC_MINOR__ >= 33 ) )
+        vTaskSuspendAll();
+        {
+            struct mallinfo2 xInfo = mallinfo2();
+
+            pxSnapshot->xHeapArena = xInfo.arena;
+            pxSnapshot->xHeapInUse = xInfo.uordblks;
+            pxSnapshot->xHeapFree = xInfo.fordblks;
+        }
+        ( void ) xTaskResumeAll();
+    #endif
+}
+
+static void prvPublishSnapshot( void )
+{
+    uint32_t ulIndex = __atomic_load_n( &ulPublishedSnapshot, __ATOMIC_RELAXED ) ^ 1U;
+
+    __atomic_store_n( &ulSnapshotSequence[ ulIndex ], ulSnapshotSequence[ ulIndex ] + 1U, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+
+    prvTakeSnapshot( &xSnapshots[ ulIndex ] );
+
+    __atomic_store_n( &ulSnapshotSequence[ ulIndex ], ulSnapshotSequence[ ulIndex ] + 1U, __ATOMIC_RELEASE );
+    __atomic_store_n( &ulPublishedSnapshot, ulIndex, __ATOMIC_RELEASE );
+}
+
+static void prvReadSnapshot( MetricsSnapshot_t * pxSnapshot )
+{
+    uint32_t ulIndex;
+    uint32_t ulSequence;
+
+    for( ; ; )
+    {
+        ulIndex = __atomic_load_n( &ulPublishedSnapshot, __ATOMIC_ACQUIRE );
+        ulSequence = __atomic_load_n( &ulSnapshotSequence[ ulIndex ], __ATOMIC_ACQUIRE );
+
+        if( ( ulSequence & 1U ) == 0U )
+        {
+            memcpy( pxSnapshot, &xSnapshots[ ulIndex ], sizeof( *pxSnapshot ) );
+            __atomic_thread_fence( __ATOMIC_ACQUIRE );
+
+            if( __atomic_load_n( &ulSnapshotSequence[ ulIndex ], __ATOMIC_RELAXED ) == ulSequence )
+            {
+                break;
+            }
+        }
+
+        sched_yield();
+    }
+}
+
+/**
+ * @brief Task that refreshes the published snapshot
+ *
+ * @param pvParameters
+ */
+static void prvMetricsSnapshotTask( void * pvParameters )
+{
+    TickType_t xNextWakeTime;
+
+    /* Prevent the compiler warning about the unused parameter. */
+    ( void ) pvParameters;
+
+    xNextWakeTime = xTaskGetTickCount();
+
+    while( 1 )
+    {
+        prvPublishSnapshot();
+        vTaskDelayUntil( &xNextWakeTime, pdMS_TO_TICKS( configMETRICS_SNAPSHOT_PERIOD_MS ) );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static size_t prvAppend( size_t xLength,
+                         const char * pcFormat,
+                         ... ) __attribute__( ( format( printf, 2, 3 ) ) );
+
+static size_t prvAppend( size_t xLength,
+                         const char * pcFormat,
+                         ... )
+{
+    va_list xArgs;
+    int iWritten;
+
+    if( xLength >= sizeof( cResponse ) )
+    {
+        return xLength;
+    }
+
+    va_start( xArgs, pcFormat );
+    iWritten = vsnprintf( &cResponse[ xLength ], sizeof( cResponse ) - xLength, pcFormat, xArgs );
+    va_end( xArgs );
+
+    if( iWritten < 0 )
+    {
+        return xLength;
+    }
+
+    xLength += ( size_t ) iWritten;
+
+    return ( xLength < sizeof( cResponse ) ) ? xLength : sizeof( cResponse ) - 1U;
+}
+
+static size_t prvFormatTaskMetric( size_t xLength,
+                                   const MetricsSnapshot_t * pxSnapshot,
+                                   const char * pcName,
+                                   const char * pcType,
+                                   const char * pcHelp,
+                                   size_t xOffset )
+{
+    uint32_t i;
+
+    xLength = prvAppend( xLength, "# HELP %s %s\n# TYPE %s %s\n", pcName, pcHelp, pcName, pcType );
+
+    for( i = 0; i < pxSnapshot->ulTasks; i++ )
+    {
+        xLength = prvAppend( xLength, "%s{task=\"%s\",number=\"%u\"} %u\n",
+                             pcName,
+                             pxSnapshot->xTasks[ i ].cName,
+                             ( unsigned ) pxSnapshot->xTasks[ i ].ulNumber,
+                             ( unsigned ) *( const uint32_t * ) ( ( const uint8_t * ) &pxSnapshot->xTasks[ i ] + xOffset ) );
+    }
+
+    return xLength;
+}
+
+static size_t prvFormatSnapshot( const MetricsSnapshot_t * pxSnapshot )
+{
+    static const char * const pcStates[] = { "running", "ready", "blocked", "suspended", "deleted", "invalid" };
+    const MetricsHistogram_t * pxHistogram;
+    uint64_t ullCumulative;
+    size_t xLength = 0;
+    uint32_t ulState;
+    uint32_t i;
+    uint32_t j;
+
+    xLength = prvAppend( xLength,
+                         "# HELP freertos_snapshot_timestamp_seconds Host monotonic time of the snapshot.\n"
+                         "# TYPE freertos_snapshot_timestamp_seconds gauge\n"
+                         "freertos_snapshot_timestamp_seconds %llu.%09llu\n",
+                         ( unsigned long long ) ( pxSnapshot->ullTimestampNs / 1000000000ULL ),
+                         ( unsigned long long ) ( pxSnapshot->ullTimestampNs % 1000000000ULL ) );
+    xLength = prvAppend( xLength,
+                         "# HELP freertos_tick_count Kernel tick count.\n"
+                         "# TYPE freertos_tick_count counter\n"
+                         "freertos_tick_count %u\n"
+                         "# HELP freertos_run_time_total Total run time, in run time stats clock units.\n"
+                         "# TYPE freertos_run_time_total counter\n"
+                         "freertos_run_time_total %u\n"
+                         "# HELP freertos_tasks_truncated 1 if tasks are missing from the task metrics.\n"
+                         "# TYPE freertos_tasks_truncated gauge\n"
+                         "freertos_tasks_truncated %u\n",
+                         ( unsigned ) pxSnapshot->ulTickCount,
+                         ( unsigned ) pxSnapshot->ulTotalRunTime,
+                         ( unsigned ) pxSnapshot->ulTasksTruncated );
+
+    xLength = prvFormatTaskMetric( xLength, pxSnapshot, "freertos_task_run_time_total", "counter",
+                                   "Run time of the task, in run time stats clock units.",
+                                   offsetof( MetricsTaskSnapshot_t, ulRunTime ) );
+    xLength = prvFormatTaskMetric( xLength, pxSnapshot, "freertos_task_priority", "gauge",
+                                   "Current priority of the task.",
+                                   offsetof( MetricsTaskSnapshot_t, ulPriority ) );
+    xLength = prvFormatTaskMetric( xLength, pxSnapshot, "freertos_task_base_priority", "gauge",
+                                   "Base priority of the task.",
+                                   offsetof( MetricsTaskSnapshot_t, ulBasePriority ) );
+    xLength = prvFormatTaskMetric( xLength, pxSnapshot, "freertos_task_stack_high_water_mark_words", "gauge",
+                                   "Minimum free stack space of the task.",
+                                   offsetof( MetricsTaskSnapshot_t, ulStackHighWaterMark ) );
+
+    xLength = prvAppend( xLength, "# HELP freertos_task_state State of the task.\n# TYPE freertos_task_state gauge\n" );
+
+    for( i = 0; i < pxSnapshot->ulTasks; i++ )
+    {
+        ulState = pxSnapshot->xTasks[ i ].ulState;
+
+        if( ulState >= ( sizeof( pcStates ) / sizeof( pcStates[ 0 ] ) ) )
+        {
+            ulState = ( sizeof( pcStates ) / sizeof( pcStates[ 0 ] ) ) - 1U;
+        }
+
+        xLength = prvAppend( xLength, "freertos_task_state{task=\"%s\",number=\"%u\",state=\"%s\"} 1\n",
+                             pxSnapshot->xTasks[ i ].cName,
+                             ( unsigned ) pxSnapshot->xTasks[ i ].ulNumber,
+                             pcStates[ ulState ] );
+    }
+
+    xLength = prvAppend( xLength, "# HELP freertos_queue_messages_waiting Items in the queue.\n# TYPE freertos_queue_messages_waiting gauge\n" );
+
+    for( i = 0; i < pxSnapshot->ulQueues; i++ )
+    {
+        xLength = prvAppend( xLength, "freertos_queue_messages_waiting{queue=\"%s\"} %u\n",
+                             pxSnapshot->xQueues[ i ].pcName, ( unsigned ) pxSnapshot->xQueues[ i ].ulWaiting );
+    }
+
+    xLength = prvAppend( xLength, "# HELP freertos_queue_spaces_available Free slots in the queue.\n# TYPE freertos_queue_spaces_available gauge\n" );
+
+    for( i = 0; i < pxSnapshot->ulQueues; i++ )
+    {
+        xLength = prvAppend( xLength, "freertos_queue_spaces_available{queue=\"%s\"} %u\n",
+                             pxSnapshot->xQueues[ i ].pcName, ( unsigned ) pxSnapshot->xQueues[ i ].ulSpaces );
+    }
+
+    xLength = prvAppend( xLength,
+                         "# HELP freertos_heap_arena_bytes Bytes obtained from the system by the heap.\n"
+                         "# TYPE freertos_heap_arena_bytes gauge\n"
+                         "freertos_heap_arena_bytes %lu\n"
+                         "# HELP freertos_heap_used_bytes Bytes in use in the heap.\n"
+                         "# TYPE freertos_heap_used_bytes gauge\n"
+                         "freertos_heap_used_bytes %lu\n"
+                         "# HELP freertos_heap_free_bytes Free bytes in the heap.\n"
+                         "# TYPE freertos_heap_free_bytes gauge\n"
+                         "freertos_heap_free_bytes %lu\n",
+                         ( unsigned long ) pxSnapshot->xHeapArena,
+                         ( unsigned long ) pxSnapshot->xHeapInUse,
+                         ( unsigned long ) pxSnapshot->xHeapFree );
+
+    for( i = 0; i < pxSnapshot->ulValues; i++ )
+    {
+        xLength = prvAppend( xLength, "# HELP %s %s\n# TYPE %s %s\n%s %u\n",
+                             pxSnapshot->xValueSources[ i ].pcName,
+                             pxSnapshot->xValueSources[ i ].pcHelp,
+                             pxSnapshot->xValueSources[ i ].pcName,
+                             ( pxSnapshot->xValueSources[ i ].xIsCounter != pdFALSE ) ? "counter" : "gauge",
+                             pxSnapshot->xValueSources[ i ].pcName,
+                             ( unsigned ) pxSnapshot->ulValueData[ i ] );
+    }
+
+    for( i = 0; i < pxSnapshot->ulHistograms; i++ )
+    {
+        pxHistogram = &pxSnapshot->xHistograms[ i ];
+        ullCumulative = 0;
+
+        xLength = prvAppend( xLength, "# HELP %s %s\n# TYPE %s histogram\n",
+                             pxSnapshot->xHistogramSources[ i ].pcName,
+                             pxSnapshot->xHistogramSources[ i ].pcHelp,
+                             pxSnapshot->xHistogramSources[ i ].pcName );
+
+        for( j = 0; j < ( metricsHISTOGRAM_BUCKETS - 1U ); j++ )
+        {
+            ullCumulative += pxHistogram->ulBuckets[ j ];
+            xLength = prvAppend( xLength, "%s_bucket{le=\"%u\"} %llu\n",
+                                 pxSnapshot->xHistogramSources[ i ].pcName,
+                                 1U << j,
+                                 ( unsigned long long ) ullCumulative );
+        }
+
+        xLength = prvAppend( xLength, "%s_bucket{le=\"+Inf\"} %u\n%s_sum %llu\n%s_count %u\n",
+                             pxSnapshot->xHistogramSources[ i ].pcName,
+                             ( unsigned ) pxHistogram->ulCount,
+                             pxSnapshot->xHistogramSources[ i ].pcName,
+                             ( unsigned long long ) pxHistogram->ullSum,
+                             pxSnapshot->xHistogramSources[ i ].pcName,
+                             ( unsigned ) pxHistogram->ulCount );
+    }
+
+    return xLength;
+}
+
+static void prvWriteAll( int iSocket,
+                         const char * pcData,
+                         size_t xLength )
+{
+    ssize_t xWritten;
+
+    while( xLength > 0U )
+    {
+        xWritten = send( iSocket, pcData, xLength, MSG_NOSIGNAL );
+
+        if( xWritten < 0 )
+        {
+            if( errno == EINTR )
+            {
+                continue;
+            }
+
+            return;
+        }
+
+        pcData += xWritten;
+        xLength -= ( size_t ) xWritten;
+    }
+}
+
+static void prvServeClient( int iSocket )
+{
+    struct pollfd xPoll = { .fd = iSocket, .events = POLLIN };
+    char cRequest[ 256 ];
+    ssize_t xRead = 0;
+    size_t xLength;
+    char cHeader[ 128 ];
+    int iHeaderLength;
+
+    /* "nc -U" clients send nothing, HTTP clients send a request line. */
+    if( poll( &xPoll, 1, metricsREQUEST_TIMEOUT_MS ) > 0 )
+    {
+        xRead = recv( iSocket, cRequest, sizeof( cRequest ), 0 );
+    }
+
+    prvReadSnapshot( &xScrapeSnapshot );
+    xLength = prvFormatSnapshot( &xScrapeSnapshot );
+
+    if( ( xRead >= 4 ) && ( memcmp( cRequest, "GET ", 4 ) == 0 ) )
+    {
+        iHeaderLength = snprintf( cHeader, sizeof( cHeader ),
+                                  "HTTP/1.0 200 OK\r\n"
+                                  "Content-Type: text/plain; version=0.0.4\r\n"
+                                  "Content-Length: %lu\r\n\r\n",
+                                  ( unsigned long ) xLength );
+        prvWriteAll( iSocket, cHeader, ( size_t ) iHeaderLength );
+    }
+
+    prvWriteAll( iSocket, cResponse, xLength );
+}
+
+/**
+ * @brief Host thread serving the scrapes
+ *
+ * @param pvParameters
+ * @return void*
+ */
+static void * prvMetricsServerThread( void * pvParameters )
+{
+    int iClient;
+
+    /* Prevent the compiler warning about the unused parameter. */
+    ( void ) pvParameters;
+
+    for( ; ; )
+    {
+        iClient = accept( iListenSocket, NULL, NULL );
+
+        if( iClient < 0 )
+        {
+            if( ( errno == EINTR ) || ( errno == ECONNABORTED ) )
+            {
+                continue;
+            }
+
+            break;
+        }
+
+        prvServeClient( iClient );
+        close( iClient );
+    }
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Start the exporter
+ *
+ * Binds configMETRICS_SOCKET_PATH and creates the snapshot task and the host
+ * thread.  Must be called before vTaskStartScheduler().
+ *
+ * @return int 0 on success, -1 on error (errno is set)
+ */
+int xMetricsServerStart( void )
+{
+    struct sockaddr_un xAddress;
+    pthread_t xThread;
+    sigset_t xAllSignals;
+    sigset_t xOldSignals;
+    int iRet;
+
+    if( strlen( configMETRICS_SOCKET_PATH ) >= sizeof( xAddress.sun_path ) )
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    memset( &xAddress, 0, sizeof( xAddress ) );
+    xAddress.sun_family = AF_UNIX;
+    strcpy( xAddress.sun_path, configMETRICS_SOCKET_PATH );
+
+    iListenSocket = socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+
+    if( iListenSocket < 0 )
+    {
+        return -1;
+    }
+
+    /* Remove the socket left by a previous run. */
+    ( void ) unlink( configMETRICS_SOCKET_PATH );
+
+    if( ( bind( iListenSocket, ( struct sockaddr * ) &xAddress, sizeof( xAddress ) ) != 0 ) ||
+        ( listen( iListenSocket, 4 ) != 0 ) )
+    {
+        close( iListenSocket );
+        iListenSocket = -1;
+        return -1;
+    }
+
+    if( xTaskCreate( prvMetricsSnapshotTask,
+                     "Metrics",
+                     configMINIMAL_STACK_SIZE,
+                     NULL,
+                     configMETRICS_SNAPSHOT_TASK_PRIORITY,
+                     NULL ) != pdPASS )
+    {
+        close( iListenSocket );
+        iListenSocket = -1;
+        errno = ENOMEM;
+        return -1;
+    }
+
+    /* The thread inherits the signal mask, with every signal blocked it never
+     * takes the tick or a context switch request. */
+    sigfillset( &xAllSignals );
+    pthread_sigmask( SIG_SETMASK, &xAllSignals, &xOldSignals );
+    iRet = pthread_create( &xThread, NULL, prvMetricsServerThread, NULL );
+    pthread_sigmask( SIG_SETMASK, &xOldSignals, NULL );
+
+    if( iRet != 0 )
+    {
+        errno = iRet;
+        return -1;
+    }
+
+    ( void ) pthread_detach( xThread );
+
+    return 0;
+}
+
+#endif /* configUSE_METRICS_SERVER */
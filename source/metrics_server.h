@@ -0,0 +1,109 @@
+/**
+ * @file metrics_server.h
+ * @brief Prometheus metrics exporter on a Unix domain socket
+ *
+ * A low priority task copies the kernel and application statistics into a
+ * snapshot once per configMETRICS_SNAPSHOT_PERIOD_MS.  The snapshot is served
+ * in the Prometheus text format by a host thread that runs outside of the
+ * scheduler, so a scrape never calls into the kernel:
+ *
+ *     curl --unix-socket build/metrics.sock http://localhost/metrics
+ *
+ * Queues are exported when they are added to the queue registry
+ * (vQueueAddToRegistry()).  This header is included by FreeRTOSConfig.h
+ * (through trace_hooks.h), so it must not depend on any FreeRTOS type.
+ */
+
+#ifndef METRICS_SERVER_H
+    #define METRICS_SERVER_H
+
+    #include <stddef.h>
+    #include <stdint.h>
+
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    #ifndef configUSE_METRICS_SERVER
+        #define configUSE_METRICS_SERVER    0
+    #endif
+
+    #ifndef configMETRICS_SOCKET_PATH
+        #define configMETRICS_SOCKET_PATH    "metrics.sock"
+    #endif
+
+/* Period at which the snapshot task refreshes the published snapshot. */
+    #ifndef configMETRICS_SNAPSHOT_PERIOD_MS
+        #define configMETRICS_SNAPSHOT_PERIOD_MS    1000U
+    #endif
+
+/* Priority of the snapshot task.  The idle priority never runs while the
+ * application keeps the CPU busy, one above it shares the lowest application
+ * priority; a snapshot takes a few microseconds per period. */
+    #ifndef configMETRICS_SNAPSHOT_TASK_PRIORITY
+        #define configMETRICS_SNAPSHOT_TASK_PRIORITY    ( tskIDLE_PRIORITY + 1 )
+    #endif
+
+/* Table sizes of the snapshot. */
+    #ifndef configMETRICS_MAX_TASKS
+        #define configMETRICS_MAX_TASKS    16U
+    #endif
+
+    #ifndef configMETRICS_MAX_QUEUES
+        #define configMETRICS_MAX_QUEUES    16U
+    #endif
+
+    #ifndef configMETRICS_MAX_VALUES
+        #define configMETRICS_MAX_VALUES    16U
+    #endif
+
+    #ifndef configMETRICS_MAX_HISTOGRAMS
+        #define configMETRICS_MAX_HISTOGRAMS    4U
+    #endif
+
+/* Histogram bucket n counts observations <= 2^n, the last bucket is +Inf. */
+    #define metricsHISTOGRAM_BUCKETS    17U
+
+/* A histogram filled by a single task with vMetricsHistogramObserve(). */
+    typedef struct xMETRICS_HISTOGRAM
+    {
+        uint32_t ulBuckets[ metricsHISTOGRAM_BUCKETS ];
+        uint64_t ullSum;
+        uint32_t ulCount;
+    } MetricsHistogram_t;
+
+    int xMetricsServerStart( void );
+
+    void vMetricsServerAddCounter( const char * pcName,
+                                   const char * pcHelp,
+                                   const volatile uint32_t * pulValue );
+    void vMetricsServerAddGauge( const char * pcName,
+                                 const char * pcHelp,
+                                 const volatile uint32_t * pulValue );
+    void vMetricsServerAddHistogram( const char * pcName,
+                                     const char * pcHelp,
+                                     const MetricsHistogram_t * pxHistogram );
+
+    void vMetricsHistogramObserve( MetricsHistogram_t * pxHistogram,
+                                   uint32_t ulValue );
+
+    void vMetricsServerQueueNamed( const void * pvQueue,
+                                   const char * pcName );
+    void vMetricsServerQueueDeleted( const void * pvQueue );
+
+/*
+ * Sub hooks used by trace_hooks.h.
+ */
+    #if ( configUSE_METRICS_SERVER == 1 )
+        #define metricsQUEUE_NAMED( xQueue, pcName )    vMetricsServerQueueNamed( ( xQueue ), ( pcName ) )
+        #define metricsQUEUE_DELETED( pxQueue )         vMetricsServerQueueDeleted( ( pxQueue ) )
+    #else
+        #define metricsQUEUE_NAMED( xQueue, pcName )
+        #define metricsQUEUE_DELETED( pxQueue )
+    #endif
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif /* METRICS_SERVER_H */
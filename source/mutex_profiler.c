@@ -0,0 +1,459 @@
+/**
+ * @file mutex_profiler.c
+ * @brief Contention statistics for mutexes
+ *
+ * A take is contended when the task had to block at least once before it
+ * obtained the mutex; the wait time runs from the first block to the
+ * successful take.  The hold time runs from the take to the final give (a
+ * recursive mutex only reaches xQueueGenericSend() on its last give).
+ *
+ * A task only gets a waiter slot on the contended path, the first time it
+ * blocks on the mutex.  The slot keeps a copy of the task name and is freed
+ * when the task is deleted, so the report never dereferences the handle.
+ *
+ * The take and give hooks run inside the queue critical sections, the
+ * blocking hook with the scheduler suspended and the delete hook inside the
+ * vTaskDelete() critical section, so the table needs no lock of its own.
+ * Readers copy it inside a critical section.
+ */
+
+/* System includes. */
+#include <string.h>
+#include <time.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Local includes. */
+#include "console.h"
+#include "mutex_profiler.h"
+
+#if ( configUSE_MUTEX_PROFILER == 1 )
+
+    #if ( configUSE_TRACE_FACILITY != 1 )
+        #error configUSE_MUTEX_PROFILER requires configUSE_TRACE_FACILITY (the queue type is checked)
+    #endif
+
+/* Number of waiters printed per mutex by vMutexProfilerPrint(). */
+    #define mutexprofilerTOP_WAITERS    3U
+
+/*-----------------------------------------------------------*/
+
+static MutexStats_t xMutexStats[ configMUTEX_PROFILER_MAX_MUTEXES ];
+
+/* Copy used by vMutexProfilerPrint(), kept off the task stack. */
+static MutexStats_t xMutexStatsCopy[ configMUTEX_PROFILER_MAX_MUTEXES ];
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNowNs( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return ( uint64_t ) xNow.tv_sec * 1000000000ULL + ( uint64_t ) xNow.tv_nsec;
+}
+
+static MutexStats_t * prvFindMutex( const void * pvMutex )
+{
+    uint32_t i;
+
+    for( i = 0; i < configMUTEX_PROFILER_MAX_MUTEXES; i++ )
+    {
+        if( xMutexStats[ i ].pvMutex == pvMutex )
+        {
+            return &xMutexStats[ i ];
+        }
+    }
+
+    return NULL;
+}
+
+/* A slot is only claimed for pvTask when xClaim is set. */
+static MutexWaiterStats_t * prvFindWaiter( MutexStats_t * pxStats,
+                                           void * pvTask,
+                                           BaseType_t xClaim )
+{
+    MutexWaiterStats_t * pxFree = NULL;
+    uint32_t i;
+
+    for( i = 0; i < configMUTEX_PROFILER_MAX_WAITERS; i++ )
+    {
+        if( pxStats->xWaiters[ i ].pvTask == pvTask )
+        {
+            return &pxStats->xWaiters[ i ];
+        }
+
+        if( ( pxFree == NULL ) && ( pxStats->xWaiters[ i ].pvTask == NULL ) )
+        {
+            pxFree = &pxStats->xWaiters[ i ];
+        }
+    }
+
+    if( ( xClaim == pdFALSE ) || ( pxFree == NULL ) )
+    {
+        return NULL;
+    }
+
+    memset( pxFree, 0, sizeof( *pxFree ) );
+    pxFree->pvTask = pvTask;
+    strncpy( pxFree->cTaskName, pcTaskGetName( ( TaskHandle_t ) pvTask ), sizeof( pxFree->cTaskName ) - 1U );
+
+    return pxFree;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Start tracking a new mutex
+ *
+ * @param pvMutex mutex handle
+ */
+void vMutexProfilerCreated( const void * pvMutex )
+{
+    MutexStats_t * pxStats;
+
+    taskENTER_CRITICAL();
+    {
+        pxStats = prvFindMutex( NULL );
+
+        if( pxStats != NULL )
+        {
+            memset( pxStats, 0, sizeof( *pxStats ) );
+            pxStats->pvMutex = pvMutex;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Stop tracking a deleted mutex
+ *
+ * @param pvMutex mutex handle
+ */
+void vMutexProfilerDeleted( const void * pvMutex )
+{
+    MutexStats_t * pxStats;
+
+    taskENTER_CRITICAL();
+    {
+        pxStats = prvFindMutex( pvMutex );
+
+        if( pxStats != NULL )
+        {
+            pxStats->pvMutex = NULL;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Name a tracked mutex, called when it is added to the queue registry
+ *
+ * @param pvMutex queue handle, ignored if it is not a tracked mutex
+ * @param pcName registry name
+ */
+void vMutexProfilerNamed( const void * pvMutex,
+                          const char * pcName )
+{
+    MutexStats_t * pxStats;
+
+    taskENTER_CRITICAL();
+    {
+        pxStats = prvFindMutex( pvMutex );
+
+        if( pxStats != NULL )
+        {
+            pxStats->pcName = pcName;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief The calling task is about to block on the mutex
+ *
+ * @param pvMutex mutex handle
+ */
+void vMutexProfilerBlocking( const void * pvMutex )
+{
+    MutexStats_t * pxStats = prvFindMutex( pvMutex );
+    MutexWaiterStats_t * pxWaiter;
+
+    if( pxStats != NULL )
+    {
+        pxWaiter = prvFindWaiter( pxStats, xTaskGetCurrentTaskHandle(), pdTRUE );
+
+        /* A take can block several times (spurious wake ups, priority
+         * inheritance), only the first one starts the wait. */
+        if( ( pxWaiter != NULL ) && ( pxWaiter->ullWaitStartNs == 0U ) )
+        {
+            pxWaiter->ullWaitStartNs = prvNowNs();
+        }
+    }
+}
+
+/**
+ * @brief The calling task obtained the mutex
+ *
+ * @param pvMutex mutex handle
+ */
+void vMutexProfilerTaken( const void * pvMutex )
+{
+    MutexStats_t * pxStats = prvFindMutex( pvMutex );
+    MutexWaiterStats_t * pxWaiter;
+    uint64_t ullNow;
+    uint64_t ullWait;
+    void * pvTask;
+
+    if( pxStats == NULL )
+    {
+        return;
+    }
+
+    ullNow = prvNowNs();
+    pvTask = xTaskGetCurrentTaskHandle();
+
+    pxStats->ulAcquisitions++;
+    pxStats->pvHolder = pvTask;
+    pxStats->ullHoldStartNs = ullNow;
+
+    pxWaiter = prvFindWaiter( pxStats, pvTask, pdFALSE );
+
+    if( ( pxWaiter != NULL ) && ( pxWaiter->ullWaitStartNs != 0U ) )
+    {
+        ullWait = ullNow - pxWaiter->ullWaitStartNs;
+        pxWaiter->ullWaitStartNs = 0U;
+
+        pxWaiter->ulContended++;
+        pxWaiter->ullTotalWaitNs += ullWait;
+
+        if( ullWait > pxWaiter->ullMaxWaitNs )
+        {
+            pxWaiter->ullMaxWaitNs = ullWait;
+        }
+
+        pxStats->ulContended++;
+        pxStats->ullTotalWaitNs += ullWait;
+
+        if( ullWait > pxStats->ullMaxWaitNs )
+        {
+            pxStats->ullMaxWaitNs = ullWait;
+        }
+    }
+}
+
+/**
+ * @brief A take of the calling task timed out
+ *
+ * @param pvMutex mutex handle
+ */
+void vMutexProfilerTakeFailed( const void * pvMutex )
+{
+    MutexStats_t * pxStats = prvFindMutex( pvMutex );
+    MutexWaiterStats_t * pxWaiter;
+
+    if( pxStats != NULL )
+    {
+        pxStats->ulTimeouts++;
+        pxWaiter = prvFindWaiter( pxStats, xTaskGetCurrentTaskHandle(), pdFALSE );
+
+        if( pxWaiter != NULL )
+        {
+            pxWaiter->ullWaitStartNs = 0U;
+        }
+    }
+}
+
+/**
+ * @brief The holder released the mutex
+ *
+ * @param pvMutex mutex handle
+ */
+void vMutexProfilerGiven( const void * pvMutex )
+{
+    MutexStats_t * pxStats = prvFindMutex( pvMutex );
+    uint64_t ullHold;
+
+    /* The give made when the mutex is created has no holder. */
+    if( ( pxStats != NULL ) && ( pxStats->pvHolder != NULL ) )
+    {
+        ullHold = prvNowNs() - pxStats->ullHoldStartNs;
+        pxStats->pvHolder = NULL;
+        pxStats->ullTotalHoldNs += ullHold;
+
+        if( ullHold > pxStats->ullMaxHoldNs )
+        {
+            pxStats->ullMaxHoldNs = ullHold;
+        }
+    }
+}
+
+/**
+ * @brief Free the waiter slots of a deleted task
+ *
+ * @param pvTask handle of the task being deleted
+ */
+void vMutexProfilerTaskDeleted( const void * pvTask )
+{
+    uint32_t i;
+    uint32_t j;
+
+    for( i = 0; i < configMUTEX_PROFILER_MAX_MUTEXES; i++ )
+    {
+        if( xMutexStats[ i ].pvMutex == NULL )
+        {
+            continue;
+        }
+
+        for( j = 0; j < configMUTEX_PROFILER_MAX_WAITERS; j++ )
+        {
+            if( xMutexStats[ i ].xWaiters[ j ].pvTask == pvTask )
+            {
+                memset( &xMutexStats[ i ].xWaiters[ j ], 0, sizeof( xMutexStats[ i ].xWaiters[ j ] ) );
+            }
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Copy the statistics of every tracked mutex
+ *
+ * @param pxStats destination array
+ * @param ulMaxMutexes size of pxStats
+ * @return uint32_t number of entries written
+ */
+uint32_t ulMutexProfilerGetStats( MutexStats_t * pxStats,
+                                  uint32_t ulMaxMutexes )
+{
+    uint32_t ulCount = 0;
+    uint32_t i;
+
+    taskENTER_CRITICAL();
+    {
+        for( i = 0; ( i < configMUTEX_PROFILER_MAX_MUTEXES ) && ( ulCount < ulMaxMutexes ); i++ )
+        {
+            if( xMutexStats[ i ].pvMutex != NULL )
+            {
+                pxStats[ ulCount++ ] = xMutexStats[ i ];
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return ulCount;
+}
+
+/**
+ * @brief Clear the counters, the tracked mutexes and their names are kept
+ *
+ */
+void vMutexProfilerReset( void )
+{
+    uint32_t i;
+
+    taskENTER_CRITICAL();
+    {
+        for( i = 0; i < configMUTEX_PROFILER_MAX_MUTEXES; i++ )
+        {
+            xMutexStats[ i ].ulAcquisitions = 0;
+            xMutexStats[ i ].ulContended = 0;
+            xMutexStats[ i ].ulTimeouts = 0;
+            xMutexStats[ i ].ullTotalWaitNs = 0;
+            xMutexStats[ i ].ullMaxWaitNs = 0;
+            xMutexStats[ i ].ullTotalHoldNs = 0;
+            xMutexStats[ i ].ullMaxHoldNs = 0;
+            memset( xMutexStats[ i ].xWaiters, 0, sizeof( xMutexStats[ i ].xWaiters ) );
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Print the statistics and the top waiters of every mutex
+ *
+ * Times are printed in microseconds.  Must be called from a task.
+ */
+void vMutexProfilerPrint( void )
+{
+    MutexWaiterStats_t xTop[ mutexprofilerTOP_WAITERS ];
+    MutexStats_t * pxStats;
+    uint32_t ulCount;
+    uint32_t i;
+    uint32_t j;
+    uint32_t k;
+
+    ulCount = ulMutexProfilerGetStats( xMutexStatsCopy, configMUTEX_PROFILER_MAX_MUTEXES );
+
+    console_print( "\nMUTEX CONTENTION:\n" );
+    console_print( "%-12s %8s %8s %8s %12s %10s %12s %10s\n",
+                   "Mutex", "Acq", "Cont", "Timeout", "Wait(us)", "MaxWait", "Hold(us)", "MaxHold" );
+
+    for( i = 0; i < ulCount; i++ )
+    {
+        pxStats = &xMutexStatsCopy[ i ];
+
+        if( pxStats->pcName != NULL )
+        {
+            console_print( "%-12.12s", pxStats->pcName );
+        }
+        else
+        {
+            console_print( "%-12p", pxStats->pvMutex );
+        }
+
+        console_print( " %8u %8u %8u %12llu %10llu %12llu %10llu\n",
+                       ( unsigned ) pxStats->ulAcquisitions,
+                       ( unsigned ) pxStats->ulContended,
+                       ( unsigned ) pxStats->ulTimeouts,
+                       ( unsigned long long ) ( pxStats->ullTotalWaitNs / 1000U ),
+                       ( unsigned long long ) ( pxStats->ullMaxWaitNs / 1000U ),
+                       ( unsigned long long ) ( pxStats->ullTotalHoldNs / 1000U ),
+                       ( unsigned long long ) ( pxStats->ullMaxHoldNs / 1000U ) );
+
+        /* Keep the waiters with the largest total wait, insertion sorted. */
+        memset( xTop, 0, sizeof( xTop ) );
+
+        for( j = 0; j < configMUTEX_PROFILER_MAX_WAITERS; j++ )
+        {
+            if( ( pxStats->xWaiters[ j ].pvTask == NULL ) || ( pxStats->xWaiters[ j ].ulContended == 0U ) )
+            {
+                continue;
+            }
+
+            for( k = mutexprofilerTOP_WAITERS; k > 0U; k-- )
+            {
+                if( ( xTop[ k - 1U ].pvTask != NULL ) &&
+                    ( xTop[ k - 1U ].ullTotalWaitNs >= pxStats->xWaiters[ j ].ullTotalWaitNs ) )
+                {
+                    break;
+                }
+
+                if( k < mutexprofilerTOP_WAITERS )
+                {
+                    xTop[ k ] = xTop[ k - 1U ];
+                }
+            }
+
+            if( k < mutexprofilerTOP_WAITERS )
+            {
+                xTop[ k ] = pxStats->xWaiters[ j ];
+            }
+        }
+
+        for( k = 0; ( k < mutexprofilerTOP_WAITERS ) && ( xTop[ k ].pvTask != NULL ); k++ )
+        {
+            console_print( "    waiter %-12s %8u blocked %12llu us (max %llu us)\n",
+                           xTop[ k ].cTaskName,
+                           ( unsigned ) xTop[ k ].ulContended,
+                           ( unsigned long long ) ( xTop[ k ].ullTotalWaitNs / 1000U ),
+                           ( unsigned long long ) ( xTop[ k ].ullMaxWaitNs / 1000U ) );
+        }
+    }
+}
+
+#endif /* configUSE_MUTEX_PROFILER */
@@ -0,0 +1,121 @@
+/**
+ * @file mutex_profiler.h
+ * @brief Contention statistics for mutexes
+ *
+ * The profiler is fed by the queue trace macros on the mutex path of
+ * xQueueSemaphoreTake() (take, block, timeout) and xQueueGenericSend()
+ * (give).  A mutex is tracked from its creation and named through the queue
+ * registry (vQueueAddToRegistry()).
+ *
+ * This header is included by FreeRTOSConfig.h (through trace_hooks.h), so it
+ * must not depend on any FreeRTOS type; configMAX_TASK_NAME_LEN must be
+ * defined before it.
+ */
+
+#ifndef MUTEX_PROFILER_H
+    #define MUTEX_PROFILER_H
+
+    #include <stddef.h>
+    #include <stdint.h>
+
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    #ifndef configUSE_MUTEX_PROFILER
+        #define configUSE_MUTEX_PROFILER    0
+    #endif
+
+/* Maximum number of mutexes tracked at the same time. */
+    #ifndef configMUTEX_PROFILER_MAX_MUTEXES
+        #define configMUTEX_PROFILER_MAX_MUTEXES    16U
+    #endif
+
+/* Number of waiting tasks tracked per mutex.  A task gets a slot the first
+ * time it blocks on the mutex and loses it when it is deleted; waits of
+ * further tasks are not counted. */
+    #ifndef configMUTEX_PROFILER_MAX_WAITERS
+        #define configMUTEX_PROFILER_MAX_WAITERS    8U
+    #endif
+
+    typedef struct xMUTEX_WAITER_STATS
+    {
+        void * pvTask;            /* Task handle, NULL for an unused slot. */
+        char cTaskName[ configMAX_TASK_NAME_LEN ];
+        uint32_t ulContended;     /* Acquisitions that had to block. */
+        uint64_t ullTotalWaitNs;
+        uint64_t ullMaxWaitNs;
+        uint64_t ullWaitStartNs;  /* Non zero while the task is blocked. */
+    } MutexWaiterStats_t;
+
+    typedef struct xMUTEX_STATS
+    {
+        const void * pvMutex;
+        const char * pcName;      /* From the queue registry, may be NULL. */
+        uint32_t ulAcquisitions;
+        uint32_t ulContended;
+        uint32_t ulTimeouts;
+        uint64_t ullTotalWaitNs;
+        uint64_t ullMaxWaitNs;
+        uint64_t ullTotalHoldNs;
+        uint64_t ullMaxHoldNs;
+        void * pvHolder;
+        uint64_t ullHoldStartNs;
+        MutexWaiterStats_t xWaiters[ configMUTEX_PROFILER_MAX_WAITERS ];
+    } MutexStats_t;
+
+    void vMutexProfilerCreated( const void * pvMutex );
+    void vMutexProfilerDeleted( const void * pvMutex );
+    void vMutexProfilerNamed( const void * pvMutex,
+                              const char * pcName );
+    void vMutexProfilerBlocking( const void * pvMutex );
+    void vMutexProfilerTaken( const void * pvMutex );
+    void vMutexProfilerTakeFailed( const void * pvMutex );
+    void vMutexProfilerGiven( const void * pvMutex );
+    void vMutexProfilerTaskDeleted( const void * pvTask );
+
+    uint32_t ulMutexProfilerGetStats( MutexStats_t * pxStats,
+                                      uint32_t ulMaxMutexes );
+    void vMutexProfilerReset( void );
+    void vMutexProfilerPrint( void );
+
+/*
+ * Sub hooks used by trace_hooks.h.  Only mutexes and recursive mutexes are
+ * forwarded, so other queues pay a single compare.
+ */
+    #if ( configUSE_MUTEX_PROFILER == 1 )
+        #define mutexprofilerIS_MUTEX( pxQueue )                                  \
+    ( ( ( pxQueue )->ucQueueType == queueQUEUE_TYPE_MUTEX ) ||                    \
+      ( ( pxQueue )->ucQueueType == queueQUEUE_TYPE_RECURSIVE_MUTEX ) )
+        #define mutexprofilerCALL( pxQueue, xFunction )                           \
+    do {                                                                          \
+        if( mutexprofilerIS_MUTEX( pxQueue ) )                                    \
+        {                                                                         \
+            xFunction( ( pxQueue ) );                                             \
+        }                                                                         \
+    } while( 0 )
+
+        #define mutexprofilerCREATED( pxQueue )           vMutexProfilerCreated( ( pxQueue ) )
+        #define mutexprofilerDELETED( pxQueue )           mutexprofilerCALL( pxQueue, vMutexProfilerDeleted )
+        #define mutexprofilerNAMED( xQueue, pcName )      vMutexProfilerNamed( ( xQueue ), ( pcName ) )
+        #define mutexprofilerBLOCKING( pxQueue )          mutexprofilerCALL( pxQueue, vMutexProfilerBlocking )
+        #define mutexprofilerTAKEN( pxQueue )             mutexprofilerCALL( pxQueue, vMutexProfilerTaken )
+        #define mutexprofilerTAKE_FAILED( pxQueue )       mutexprofilerCALL( pxQueue, vMutexProfilerTakeFailed )
+        #define mutexprofilerGIVEN( pxQueue )             mutexprofilerCALL( pxQueue, vMutexProfilerGiven )
+        #define mutexprofilerTASK_DELETED( pxTCB )        vMutexProfilerTaskDeleted( ( pxTCB ) )
+    #else
+        #define mutexprofilerCREATED( pxQueue )
+        #define mutexprofilerDELETED( pxQueue )
+        #define mutexprofilerNAMED( xQueue, pcName )
+        #define mutexprofilerBLOCKING( pxQueue )
+        #define mutexprofilerTAKEN( pxQueue )
+        #define mutexprofilerTAKE_FAILED( pxQueue )
+        #define mutexprofilerGIVEN( pxQueue )
+        #define mutexprofilerTASK_DELETED( pxTCB )
+    #endif
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif /* MUTEX_PROFILER_H */
@@ -36,32 +36,23 @@
  * of time only, and therefore timer overflows are not handled.
  */
 
-#include <time.h>
-
 /* FreeRTOS includes. */
 #include <FreeRTOS.h>
 
-/* Time at start of day (in ns). */
+/* Time at start of day (in ns), on the clock of the port: the virtual clock
+ * with configPOSIX_VIRTUAL_TIME. */
 static unsigned long ulStartTimeNs;
 
 /*-----------------------------------------------------------*/
 
 void vConfigureTimerForRunTimeStats( void )
 {
-    struct timespec xNow;
-
-    clock_gettime( CLOCK_MONOTONIC, &xNow );
-    ulStartTimeNs = xNow.tv_sec * 1000000000ul + xNow.tv_nsec;
+    ulStartTimeNs = ( unsigned long ) ullPortGetTimeNs();
 }
 /*-----------------------------------------------------------*/
 
 unsigned long ulGetRunTimeCounterValue( void )
 {
-    struct timespec xNow;
-
-    /* Time at start. */
-    clock_gettime( CLOCK_MONOTONIC, &xNow );
-
-    return xNow.tv_sec * 1000000000ul + xNow.tv_nsec - ulStartTimeNs;
+    return ( unsigned long ) ullPortGetTimeNs() - ulStartTimeNs;
 }
 /*-----------------------------------------------------------*/
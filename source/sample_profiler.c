@@ -0,0 +1,476 @@
+/**
+ * @file sample_profiler.c
+ * @brief Statistical sampling profiler for the Posix port
+ *
+ * The SIGPROF handler takes a backtrace() of the interrupted task and adds
+ * it to an open addressing table of unique stacks.  The handler runs with
+ * every signal blocked and only touches the table, so its cost per sample is
+ * one unwind and one hash probe sequence; when the table is full the sample
+ * is counted as dropped.
+ *
+ * With configPOSIX_SOFT_INTERRUPT_MASK a critical section only raises the
+ * interrupt level of the port and leaves the thread signal mask alone, so
+ * SIGPROF is not a port interrupt line and is never held back: a sample that
+ * fires inside a critical section is taken at once and the time spent there
+ * shows up in the profile.  The handler does not call the kernel, so it is
+ * safe at any level.  A sample taken while the tasks are being switched can
+ * be charged to the incoming task, as pxCurrentTCB changes before the
+ * outgoing thread stops.  Without the soft mask the port blocks every signal
+ * in a critical section and such a sample is only taken when it ends.
+ */
+
+/* dladdr() is a GNU extension. */
+#define _GNU_SOURCE
+
+/* System includes. */
+#include <dlfcn.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <link.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Local includes. */
+#include "sample_profiler.h"
+
+#if ( configUSE_SAMPLE_PROFILER == 1 )
+
+    #if ( ( configSAMPLE_PROFILER_MAX_STACKS & ( configSAMPLE_PROFILER_MAX_STACKS - 1U ) ) != 0 )
+        #error configSAMPLE_PROFILER_MAX_STACKS must be a power of two
+    #endif
+
+/* Frames of the handler itself and of the signal trampoline, skipped when
+ * the interrupted program counter cannot be found in the backtrace. */
+    #define sampleprofilerHANDLER_FRAMES    2
+
+/* Probes before a sample is dropped. */
+    #define sampleprofilerMAX_PROBES        16U
+
+/* Tasks whose name is looked up by xSampleProfilerWrite(). */
+    #define sampleprofilerMAX_TASKS         32U
+
+/*-----------------------------------------------------------*/
+
+typedef struct xSAMPLE_STACK
+{
+    const void * pvTask;
+    uint32_t ulCount;        /* 0 for an unused entry. */
+    uint32_t ulDepth;
+    void * pvFrames[ configSAMPLE_PROFILER_MAX_DEPTH ]; /* Innermost first. */
+} SampleStack_t;
+
+/*-----------------------------------------------------------*/
+
+static SampleStack_t xStacks[ configSAMPLE_PROFILER_MAX_STACKS ];
+static volatile uint32_t ulSamples = 0;
+static volatile uint32_t ulDropped = 0;
+static volatile int xSampling = 0;
+static timer_t xTimer;
+static int xTimerCreated = 0;
+
+/* Copies used by xSampleProfilerWrite(), kept off the task stack. */
+static SampleStack_t xStacksCopy[ configSAMPLE_PROFILER_MAX_STACKS ];
+static TaskStatus_t xTaskStatus[ sampleprofilerMAX_TASKS ];
+static char cWriteBuffer[ 4096 ];
+
+/*-----------------------------------------------------------*/
+
+static void * prvInterruptedPC( const void * pvContext )
+{
+    const ucontext_t * pxContext = pvContext;
+
+    #if defined( __x86_64__ )
+        return ( void * ) pxContext->uc_mcontext.gregs[ REG_RIP ];
+    #elif defined( __aarch64__ )
+        return ( void * ) pxContext->uc_mcontext.pc;
+    #else
+        ( void ) pxContext;
+        return NULL;
+    #endif
+}
+
+static uint32_t prvHashStack( const void * pvTask,
+                              void * const * pvFrames,
+                              uint32_t ulDepth )
+{
+    uint64_t ullHash = 14695981039346656037ULL ^ ( uintptr_t ) pvTask;
+    uint32_t i;
+
+    for( i = 0; i < ulDepth; i++ )
+    {
+        ullHash = ( ullHash ^ ( uintptr_t ) pvFrames[ i ] ) * 1099511628211ULL;
+    }
+
+    return ( uint32_t ) ( ullHash ^ ( ullHash >> 32 ) ) & ( configSAMPLE_PROFILER_MAX_STACKS - 1U );
+}
+
+static void prvSampleHandler( int iSignal,
+                              siginfo_t * pxInfo,
+                              void * pvContext )
+{
+    void * pvFrames[ configSAMPLE_PROFILER_MAX_DEPTH + sampleprofilerHANDLER_FRAMES + 1 ];
+    void * pvPC = prvInterruptedPC( pvContext );
+    const void * pvTask;
+    SampleStack_t * pxStack;
+    uint32_t ulFirst = sampleprofilerHANDLER_FRAMES;
+    uint32_t ulDepth;
+    uint32_t ulIndex;
+    uint32_t ulProbe;
+    int iFrames;
+    int i;
+
+    ( void ) iSignal;
+    ( void ) pxInfo;
+
+    if( xSampling == 0 )
+    {
+        return;
+    }
+
+    iFrames = backtrace( pvFrames, ( int ) ( sizeof( pvFrames ) / sizeof( pvFrames[ 0 ] ) ) );
+
+    for( i = 0; i < iFrames; i++ )
+    {
+        if( pvFrames[ i ] == pvPC )
+        {
+            ulFirst = ( uint32_t ) i;
+            break;
+        }
+    }
+
+    if( ( uint32_t ) iFrames <= ulFirst )
+    {
+        ulDropped++;
+        return;
+    }
+
+    ulDepth = ( uint32_t ) iFrames - ulFirst;
+
+    if( ulDepth > configSAMPLE_PROFILER_MAX_DEPTH )
+    {
+        ulDepth = configSAMPLE_PROFILER_MAX_DEPTH;
+    }
+
+    pvTask = xTaskGetCurrentTaskHandle();
+    ulIndex = prvHashStack( pvTask, &pvFrames[ ulFirst ], ulDepth );
+
+    for( ulProbe = 0; ulProbe < sampleprofilerMAX_PROBES; ulProbe++ )
+    {
+        pxStack = &xStacks[ ulIndex ];
+
+        if( pxStack->ulCount == 0U )
+        {
+            pxStack->pvTask = pvTask;
+            pxStack->ulDepth = ulDepth;
+            memcpy( pxStack->pvFrames, &pvFrames[ ulFirst ], ulDepth * sizeof( void * ) );
+            pxStack->ulCount = 1U;
+            ulSamples++;
+            return;
+        }
+
+        if( ( pxStack->pvTask == pvTask ) && ( pxStack->ulDepth == ulDepth ) &&
+            ( memcmp( pxStack->pvFrames, &pvFrames[ ulFirst ], ulDepth * sizeof( void * ) ) == 0 ) )
+        {
+            pxStack->ulCount++;
+            ulSamples++;
+            return;
+        }
+
+        ulIndex = ( ulIndex + 1U ) & ( configSAMPLE_PROFILER_MAX_STACKS - 1U );
+    }
+
+    ulDropped++;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Start sampling
+ *
+ * @return int 0 on success, -1 on error (errno is set)
+ */
+int xSampleProfilerStart( void )
+{
+    struct sigaction xAction;
+    struct sigevent xEvent;
+    struct itimerspec xPeriod;
+    void * pvWarmUp[ 2 ];
+
+    /* The first backtrace() loads the unwinder, which is not safe inside a
+     * signal handler. */
+    ( void ) backtrace( pvWarmUp, 2 );
+
+    memset( &xAction, 0, sizeof( xAction ) );
+    xAction.sa_sigaction = prvSampleHandler;
+    xAction.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigfillset( &xAction.sa_mask );
+
+    if( sigaction( SIGPROF, &xAction, NULL ) != 0 )
+    {
+        return -1;
+    }
+
+    if( xTimerCreated == 0 )
+    {
+        memset( &xEvent, 0, sizeof( xEvent ) );
+        xEvent.sigev_notify = SIGEV_SIGNAL;
+        xEvent.sigev_signo = SIGPROF;
+
+        if( timer_create( configSAMPLE_PROFILER_CLOCK, &xEvent, &xTimer ) != 0 )
+        {
+            return -1;
+        }
+
+        xTimerCreated = 1;
+    }
+
+    xPeriod.it_interval.tv_sec = 0;
+    xPeriod.it_interval.tv_nsec = 1000000000L / configSAMPLE_PROFILER_HZ;
+    xPeriod.it_value = xPeriod.it_interval;
+
+    xSampling = 1;
+
+    return timer_settime( xTimer, 0, &xPeriod, NULL );
+}
+
+/**
+ * @brief Stop sampling, the samples are kept
+ */
+void vSampleProfilerStop( void )
+{
+    struct itimerspec xPeriod;
+
+    xSampling = 0;
+
+    if( xTimerCreated != 0 )
+    {
+        memset( &xPeriod, 0, sizeof( xPeriod ) );
+        ( void ) timer_settime( xTimer, 0, &xPeriod, NULL );
+    }
+}
+
+/**
+ * @brief Discard the samples
+ */
+void vSampleProfilerReset( void )
+{
+    taskENTER_CRITICAL();
+    {
+        memset( xStacks, 0, sizeof( xStacks ) );
+        ulSamples = 0;
+        ulDropped = 0;
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Number of samples taken
+ *
+ * @param pulDropped if not NULL, receives the number of samples dropped
+ * @return uint32_t samples stored
+ */
+uint32_t ulSampleProfilerGetSamples( uint32_t * pulDropped )
+{
+    if( pulDropped != NULL )
+    {
+        *pulDropped = ulDropped;
+    }
+
+    return ulSamples;
+}
+
+/*-----------------------------------------------------------*/
+
+static int prvFlush( int iFile,
+                     size_t * pxLength )
+{
+    size_t xDone = 0;
+    ssize_t xWritten;
+
+    while( xDone < *pxLength )
+    {
+        xWritten = write( iFile, &cWriteBuffer[ xDone ], *pxLength - xDone );
+
+        if( xWritten < 0 )
+        {
+            if( errno == EINTR )
+            {
+                continue;
+            }
+
+            return -1;
+        }
+
+        xDone += ( size_t ) xWritten;
+    }
+
+    *pxLength = 0;
+
+    return 0;
+}
+
+static int prvAppend( int iFile,
+                      size_t * pxLength,
+                      const char * pcText )
+{
+    size_t xText = strlen( pcText );
+
+    if( ( *pxLength + xText ) > sizeof( cWriteBuffer ) )
+    {
+        if( prvFlush( iFile, pxLength ) != 0 )
+        {
+            return -1;
+        }
+
+        if( xText > sizeof( cWriteBuffer ) )
+        {
+            xText = sizeof( cWriteBuffer );
+        }
+    }
+
+    memcpy( &cWriteBuffer[ *pxLength ], pcText, xText );
+    *pxLength += xText;
+
+    return 0;
+}
+
+static void prvFormatFrame( char * pcFrame,
+                            size_t xSize,
+                            void * pvPC,
+                            BaseType_t xIsReturnAddress )
+{
+    const ElfW( Ehdr ) * pxHeader;
+    uintptr_t uxAddress = ( uintptr_t ) pvPC;
+    Dl_info xInfo;
+
+    /* A return address points after the call, move back into it. */
+    if( xIsReturnAddress != pdFALSE )
+    {
+        uxAddress--;
+    }
+
+    if( ( dladdr( pvPC, &xInfo ) == 0 ) || ( xInfo.dli_fname == NULL ) )
+    {
+        snprintf( pcFrame, xSize, ";0x%lx", ( unsigned long ) uxAddress );
+        return;
+    }
+
+    /* Shared objects and PIE executables are relocated, non PIE executables
+     * are not. */
+    pxHeader = xInfo.dli_fbase;
+
+    if( pxHeader->e_type == ET_DYN )
+    {
+        uxAddress -= ( uintptr_t ) xInfo.dli_fbase;
+    }
+
+    snprintf( pcFrame, xSize, ";%s+0x%lx", xInfo.dli_fname, ( unsigned long ) uxAddress );
+}
+
+static const char * prvTaskName( const void * pvTask,
+                                 UBaseType_t uxTasks,
+                                 char * pcUnknown,
+                                 size_t xSize )
+{
+    UBaseType_t i;
+
+    if( pvTask == NULL )
+    {
+        return "(startup)";
+    }
+
+    for( i = 0; i < uxTasks; i++ )
+    {
+        if( xTaskStatus[ i ].xHandle == pvTask )
+        {
+            return xTaskStatus[ i ].pcTaskName;
+        }
+    }
+
+    /* Deleted task. */
+    snprintf( pcUnknown, xSize, "task@%p", pvTask );
+
+    return pcUnknown;
+}
+
+/**
+ * @brief Write the samples as folded stacks
+ *
+ * Every line is "task;outermost frame;...;innermost frame count".  Must be
+ * called from a task; sampling continues while the file is written.
+ *
+ * @param pcFileName output file
+ * @return int 0 on success, -1 on error (errno is set)
+ */
+int xSampleProfilerWrite( const char * pcFileName )
+{
+    char cFrame[ 320 ];
+    char cUnknown[ 32 ];
+    UBaseType_t uxTasks;
+    size_t xLength = 0;
+    int iFile;
+    int iRet = 0;
+    uint32_t i;
+    uint32_t j;
+
+    taskENTER_CRITICAL();
+    {
+        memcpy( xStacksCopy, xStacks, sizeof( xStacksCopy ) );
+    }
+    taskEXIT_CRITICAL();
+
+    uxTasks = uxTaskGetSystemState( xTaskStatus, sampleprofilerMAX_TASKS, NULL );
+
+    iFile = open( pcFileName, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+
+    if( iFile < 0 )
+    {
+        return -1;
+    }
+
+    for( i = 0; ( i < configSAMPLE_PROFILER_MAX_STACKS ) && ( iRet == 0 ); i++ )
+    {
+        if( xStacksCopy[ i ].ulCount == 0U )
+        {
+            continue;
+        }
+
+        iRet = prvAppend( iFile, &xLength, prvTaskName( xStacksCopy[ i ].pvTask, uxTasks, cUnknown, sizeof( cUnknown ) ) );
+
+        for( j = xStacksCopy[ i ].ulDepth; ( j > 0U ) && ( iRet == 0 ); j-- )
+        {
+            prvFormatFrame( cFrame, sizeof( cFrame ), xStacksCopy[ i ].pvFrames[ j - 1U ], ( j > 1U ) ? pdTRUE : pdFALSE );
+            iRet = prvAppend( iFile, &xLength, cFrame );
+        }
+
+        snprintf( cFrame, sizeof( cFrame ), " %u\n", ( unsigned ) xStacksCopy[ i ].ulCount );
+
+        if( iRet == 0 )
+        {
+            iRet = prvAppend( iFile, &xLength, cFrame );
+        }
+    }
+
+    if( iRet == 0 )
+    {
+        iRet = prvFlush( iFile, &xLength );
+    }
+
+    if( close( iFile ) != 0 )
+    {
+        iRet = -1;
+    }
+
+    return iRet;
+}
+
+#endif /* configUSE_SAMPLE_PROFILER */
@@ -0,0 +1,61 @@
+/**
+ * @file sample_profiler.h
+ * @brief Statistical sampling profiler for the Posix port
+ *
+ * A POSIX timer raises SIGPROF at configSAMPLE_PROFILER_HZ.  With the Posix
+ * port only the thread of the running task has its signals unblocked, so
+ * the signal always lands on the running task and its backtrace is charged
+ * to the current task handle.  Samples are aggregated per unique stack in
+ * the handler, the cost is bounded by the sampling rate.
+ *
+ * xSampleProfilerWrite() writes folded stacks ("task;outer;...;inner count")
+ * with frames as "module+0xoffset"; tools/symbolize_folded.py resolves them
+ * for flamegraph.pl or speedscope.
+ */
+
+#ifndef SAMPLE_PROFILER_H
+    #define SAMPLE_PROFILER_H
+
+    #include <stddef.h>
+    #include <stdint.h>
+
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    #ifndef configUSE_SAMPLE_PROFILER
+        #define configUSE_SAMPLE_PROFILER    0
+    #endif
+
+/* Sampling rate.  A prime rate avoids sampling in lockstep with the tick. */
+    #ifndef configSAMPLE_PROFILER_HZ
+        #define configSAMPLE_PROFILER_HZ    997U
+    #endif
+
+/* CLOCK_PROCESS_CPUTIME_ID samples CPU time (where the tasks are busy),
+ * CLOCK_MONOTONIC samples wall time (also where they sleep in the host). */
+    #ifndef configSAMPLE_PROFILER_CLOCK
+        #define configSAMPLE_PROFILER_CLOCK    CLOCK_PROCESS_CPUTIME_ID
+    #endif
+
+/* Deepest stack recorded, deeper frames are cut at the outer end. */
+    #ifndef configSAMPLE_PROFILER_MAX_DEPTH
+        #define configSAMPLE_PROFILER_MAX_DEPTH    32U
+    #endif
+
+/* Number of unique stacks, must be a power of two. */
+    #ifndef configSAMPLE_PROFILER_MAX_STACKS
+        #define configSAMPLE_PROFILER_MAX_STACKS    1024U
+    #endif
+
+    int xSampleProfilerStart( void );
+    void vSampleProfilerStop( void );
+    void vSampleProfilerReset( void );
+    uint32_t ulSampleProfilerGetSamples( uint32_t * pulDropped );
+    int xSampleProfilerWrite( const char * pcFileName );
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif /* SAMPLE_PROFILER_H */
@@ -0,0 +1,102 @@
+/**
+ * @file trace_hooks.h
+ * @brief Kernel trace macro definitions
+ *
+ * FreeRTOS.h leaves every trace*() macro empty unless it is defined before
+ * it is included.  This file is included from FreeRTOSConfig.h and maps the
+ * trace points used by this project onto the instrumentation modules; a
+ * disabled module expands its sub hooks to nothing.
+ *
+ * The macros are expanded inside tasks.c, queue.c and the heap, so they can
+ * use the private names available there (pxCurrentTCB, pxQueue, pxTCB...).
+ */
+
+#ifndef TRACE_HOOKS_H
+    #define TRACE_HOOKS_H
+
+    #include "trace_recorder.h"
+    #include "mutex_profiler.h"
+    #include "metrics_server.h"
+
+/* Tasks. */
+    #define traceTASK_CREATE( pxNewTCB )                                      \
+    do {                                                                      \
+        traceRECORD_SYMBOL( ( pxNewTCB ), ( pxNewTCB )->pcTaskName );         \
+        traceRECORD( eTraceTaskCreate, ( pxNewTCB ), ( pxNewTCB )->uxPriority ); \
+    } while( 0 )
+
+    #define traceTASK_DELETE( pxTaskToDelete )                          \
+    do {                                                                \
+        traceRECORD( eTraceTaskDelete, ( pxTaskToDelete ), 0 );         \
+        mutexprofilerTASK_DELETED( pxTaskToDelete );                    \
+    } while( 0 )
+
+    #define traceTASK_SWITCHED_IN()                                     traceRECORD( eTraceTaskSwitchedIn, pxCurrentTCB, pxCurrentTCB->uxPriority )
+    #define traceTASK_DELAY()                                           traceRECORD( eTraceTaskDelay, pxCurrentTCB, xTicksToDelay )
+    #define traceTASK_DELAY_UNTIL( xTimeToWake )                        traceRECORD( eTraceTaskDelayUntil, pxCurrentTCB, ( xTimeToWake ) )
+    #define traceTASK_SUSPEND( pxTaskToSuspend )                        traceRECORD( eTraceTaskSuspend, ( pxTaskToSuspend ), 0 )
+    #define traceTASK_RESUME( pxTaskToResume )                          traceRECORD( eTraceTaskResume, ( pxTaskToResume ), 0 )
+    #define traceTASK_RESUME_FROM_ISR( pxTaskToResume )                 traceRECORD( eTraceTaskResume, ( pxTaskToResume ), 1 )
+    #define traceTASK_PRIORITY_SET( pxTask, uxNewPriority )             traceRECORD( eTraceTaskPrioritySet, ( pxTask ), ( uxNewPriority ) )
+    #define traceTASK_PRIORITY_INHERIT( pxTCBOfMutexHolder, uxPriority )   traceRECORD( eTraceTaskPriorityInherit, ( pxTCBOfMutexHolder ), ( uxPriority ) )
+    #define traceTASK_PRIORITY_DISINHERIT( pxTCBOfMutexHolder, uxPriority ) traceRECORD( eTraceTaskPriorityDisinherit, ( pxTCBOfMutexHolder ), ( uxPriority ) )
+    #define traceTASK_NOTIFY( uxIndexToNotify )                         traceRECORD( eTraceTaskNotify, pxTCB, ( uxIndexToNotify ) )
+    #define traceTASK_NOTIFY_FROM_ISR( uxIndexToNotify )                traceRECORD( eTraceTaskNotify, pxTCB, ( uxIndexToNotify ) )
+    #define traceTASK_NOTIFY_GIVE_FROM_ISR( uxIndexToNotify )           traceRECORD( eTraceTaskNotify, pxTCB, ( uxIndexToNotify ) )
+    #define traceTASK_NOTIFY_TAKE( uxIndexToWait )                      traceRECORD( eTraceTaskNotifyTake, pxCurrentTCB, ( uxIndexToWait ) )
+    #define traceTASK_NOTIFY_WAIT( uxIndexToWait )                      traceRECORD( eTraceTaskNotifyTake, pxCurrentTCB, ( uxIndexToWait ) )
+    #define traceTASK_INCREMENT_TICK( xTickCount )                      traceRECORD( eTraceTick, NULL, ( xTickCount ) )
+
+/* Queues, semaphores and mutexes.  The queue type is recorded so the host
+ * converter can tell a mutex give/take from a queue send/receive. */
+    #define traceQUEUE_CREATE( pxNewQueue )                             traceRECORD( eTraceQueueCreate, ( pxNewQueue ), ( pxNewQueue )->ucQueueType )
+    #define traceCREATE_MUTEX( pxNewQueue )                             mutexprofilerCREATED( pxNewQueue )
+
+    #define traceQUEUE_DELETE( pxQueue )      \
+    do {                                      \
+        mutexprofilerDELETED( pxQueue );      \
+        metricsQUEUE_DELETED( pxQueue );      \
+    } while( 0 )
+
+    #define traceQUEUE_REGISTRY_ADD( xQueue, pcQueueName )       \
+    do {                                                         \
+        traceRECORD_SYMBOL( ( xQueue ), ( pcQueueName ) );       \
+        mutexprofilerNAMED( ( xQueue ), ( pcQueueName ) );       \
+        metricsQUEUE_NAMED( ( xQueue ), ( pcQueueName ) );       \
+    } while( 0 )
+
+    #define traceQUEUE_SEND( pxQueue )                                                   \
+    do {                                                                                 \
+        traceRECORD( eTraceQueueSend, ( pxQueue ), ( pxQueue )->ucQueueType );           \
+        mutexprofilerGIVEN( pxQueue );                                                   \
+    } while( 0 )
+
+    #define traceQUEUE_RECEIVE( pxQueue )                                                \
+    do {                                                                                 \
+        traceRECORD( eTraceQueueReceive, ( pxQueue ), ( pxQueue )->ucQueueType );        \
+        mutexprofilerTAKEN( pxQueue );                                                   \
+    } while( 0 )
+
+    #define traceQUEUE_RECEIVE_FAILED( pxQueue )                                         \
+    do {                                                                                 \
+        traceRECORD( eTraceQueueReceiveFailed, ( pxQueue ), ( pxQueue )->ucQueueType );  \
+        mutexprofilerTAKE_FAILED( pxQueue );                                             \
+    } while( 0 )
+
+    #define traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue )                                        \
+    do {                                                                                     \
+        traceRECORD( eTraceQueueBlockingOnReceive, ( pxQueue ), ( pxQueue )->ucQueueType );  \
+        mutexprofilerBLOCKING( pxQueue );                                                    \
+    } while( 0 )
+
+    #define traceQUEUE_SEND_FAILED( pxQueue )                           traceRECORD( eTraceQueueSendFailed, ( pxQueue ), ( pxQueue )->ucQueueType )
+    #define traceQUEUE_SEND_FROM_ISR( pxQueue )                         traceRECORD( eTraceQueueSendFromISR, ( pxQueue ), ( pxQueue )->ucQueueType )
+    #define traceQUEUE_RECEIVE_FROM_ISR( pxQueue )                      traceRECORD( eTraceQueueReceiveFromISR, ( pxQueue ), ( pxQueue )->ucQueueType )
+    #define traceQUEUE_PEEK( pxQueue )                                  traceRECORD( eTraceQueuePeek, ( pxQueue ), ( pxQueue )->ucQueueType )
+    #define traceBLOCKING_ON_QUEUE_SEND( pxQueue )                      traceRECORD( eTraceQueueBlockingOnSend, ( pxQueue ), ( pxQueue )->ucQueueType )
+
+/* Heap. */
+    #define traceMALLOC( pvAddress, uiSize )                            traceRECORD( eTraceMalloc, ( pvAddress ), ( uiSize ) )
+    #define traceFREE( pvAddress, uiSize )                              traceRECORD( eTraceFree, ( pvAddress ), ( uiSize ) )
+
+#endif /* TRACE_HOOKS_H */
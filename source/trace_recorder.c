@@ -0,0 +1,376 @@
+/**
+ * @file trace_recorder.c
+ * @brief Low overhead binary recorder for the kernel trace macros
+ *
+ * Records are written into one ring buffer per core.  A writer reserves its
+ * slot with a single atomic fetch-and-add on the ring head, so the tick
+ * interrupt can record while a task is in the middle of recording without
+ * any lock.  The ring overwrites the oldest records, the dump keeps the last
+ * configTRACE_RECORDER_BUFFER_SIZE events of every core.  Every slot has a
+ * commit word, set to the ring position of its record plus one once the
+ * record is written and cleared while it is written, and the dump skips the
+ * records whose commit word is not that of their position before and after
+ * they are copied: unfinished records, and records overwritten meanwhile even
+ * by an event of the same type.  A symbol is only dumped once its entry is
+ * written.
+ *
+ * File layout (host endianness):
+ *  - TraceFileHeader_t
+ *  - ulSymbolCount x TraceSymbol_t
+ *  - for every core: TraceCoreHeader_t followed by ulRecordCount records,
+ *    oldest first.
+ *
+ * xTraceRecorderDump() only uses async-signal-safe calls (open(), write(),
+ * lseek(), pwrite()) so it can be called from the SIGINT handler.
+ */
+
+/* System includes. */
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+
+/* Local includes. */
+#include "trace_recorder.h"
+
+#if ( configUSE_TRACE_RECORDER == 1 )
+
+    #if ( configUSE_TRACE_FACILITY != 1 )
+        #error configUSE_TRACE_RECORDER requires configUSE_TRACE_FACILITY (the queue type is recorded)
+    #endif
+
+    #if ( ( configTRACE_RECORDER_BUFFER_SIZE & ( configTRACE_RECORDER_BUFFER_SIZE - 1U ) ) != 0 )
+        #error configTRACE_RECORDER_BUFFER_SIZE must be a power of two
+    #endif
+
+/* Records copied by the dump per write(). */
+    #define traceRECORDER_DUMP_CHUNK    256U
+
+    #ifdef portGET_CORE_ID
+        #define traceRECORDER_CORE_ID()    portGET_CORE_ID()
+    #else
+        #define traceRECORDER_CORE_ID()    0U
+    #endif
+
+/*-----------------------------------------------------------*/
+
+typedef struct xTRACE_FILE_HEADER
+{
+    char cMagic[ 4 ];
+    uint32_t ulVersion;
+    uint32_t ulRecordSize;
+    uint32_t ulCoreCount;
+    uint32_t ulSymbolCount;
+    uint32_t ulSymbolSize;
+} TraceFileHeader_t;
+
+typedef struct xTRACE_SYMBOL
+{
+    uint64_t ullObject;
+    char cName[ traceRECORDER_SYMBOL_LEN ];
+} TraceSymbol_t;
+
+typedef struct xTRACE_CORE_HEADER
+{
+    uint32_t ulCore;
+    uint32_t ulRecordCount;
+    uint64_t ullLostRecords;
+} TraceCoreHeader_t;
+
+/* A record and its commit word, the ring position of the record plus one
+ * once it is written, 0 while it is written. */
+typedef struct xTRACE_SLOT
+{
+    TraceRecord_t xRecord;
+    volatile uint64_t ullCommit;
+} TraceSlot_t;
+
+/* Aligned on a cache line so cores never share the head counter. */
+typedef struct xTRACE_RING
+{
+    volatile uint64_t ullHead;
+    TraceSlot_t xSlots[ configTRACE_RECORDER_BUFFER_SIZE ];
+} __attribute__( ( aligned( 64 ) ) ) TraceRing_t;
+
+/*-----------------------------------------------------------*/
+
+static TraceRing_t xTraceRings[ traceRECORDER_NUM_CORES ];
+static TraceSymbol_t xTraceSymbols[ configTRACE_RECORDER_MAX_SYMBOLS ];
+static volatile uint8_t ucTraceSymbolReady[ configTRACE_RECORDER_MAX_SYMBOLS ];
+static volatile uint32_t ulTraceSymbolsReserved = 0;
+static volatile uint32_t ulTraceRecording = 1;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Record one event
+ *
+ * @param ucEvent eTraceEvent_t value
+ * @param pvObject task, queue or memory block the event refers to
+ * @param ulArg event specific argument
+ */
+void vTraceRecorderWrite( uint8_t ucEvent,
+                          const void * pvObject,
+                          uint32_t ulArg )
+{
+    TraceRing_t * pxRing;
+    TraceSlot_t * pxSlot;
+    TraceRecord_t * pxRecord;
+    struct timespec xNow;
+    uint64_t ullSlot;
+    uint32_t ulCore;
+
+    if( ulTraceRecording == 0 )
+    {
+        return;
+    }
+
+    ulCore = traceRECORDER_CORE_ID();
+    pxRing = &xTraceRings[ ulCore ];
+
+    ullSlot = __atomic_fetch_add( &pxRing->ullHead, 1, __ATOMIC_RELAXED );
+    pxSlot = &pxRing->xSlots[ ullSlot & ( configTRACE_RECORDER_BUFFER_SIZE - 1U ) ];
+    pxRecord = &pxSlot->xRecord;
+
+    __atomic_store_n( &pxSlot->ullCommit, 0U, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    pxRecord->ullTimestampNs = ( uint64_t ) xNow.tv_sec * 1000000000ULL + ( uint64_t ) xNow.tv_nsec;
+    pxRecord->ullObject = ( uint64_t ) ( uintptr_t ) pvObject;
+    pxRecord->ulArg = ulArg;
+    pxRecord->ucCore = ( uint8_t ) ulCore;
+    pxRecord->usReserved = 0;
+    pxRecord->ucEvent = ucEvent;
+    __atomic_store_n( &pxSlot->ullCommit, ullSlot + 1U, __ATOMIC_RELEASE );
+}
+
+/**
+ * @brief Remember the name of a task or queue for the host converter
+ *
+ * @param pvObject task or queue handle
+ * @param pcName name, truncated to traceRECORDER_SYMBOL_LEN - 1 characters
+ */
+void vTraceRecorderAddSymbol( const void * pvObject,
+                              const char * pcName )
+{
+    uint32_t ulIndex;
+    uint32_t i;
+
+    if( pcName == NULL )
+    {
+        return;
+    }
+
+    ulIndex = __atomic_fetch_add( &ulTraceSymbolsReserved, 1, __ATOMIC_RELAXED );
+
+    if( ulIndex >= configTRACE_RECORDER_MAX_SYMBOLS )
+    {
+        /* Table full, the converter falls back to the address. */
+        __atomic_store_n( &ulTraceSymbolsReserved, configTRACE_RECORDER_MAX_SYMBOLS, __ATOMIC_RELAXED );
+        return;
+    }
+
+    for( i = 0; ( i < ( traceRECORDER_SYMBOL_LEN - 1U ) ) && ( pcName[ i ] != '\0' ); i++ )
+    {
+        xTraceSymbols[ ulIndex ].cName[ i ] = pcName[ i ];
+    }
+
+    xTraceSymbols[ ulIndex ].cName[ i ] = '\0';
+    xTraceSymbols[ ulIndex ].ullObject = ( uint64_t ) ( uintptr_t ) pvObject;
+
+    /* Published for the dump once the entry is written. */
+    __atomic_store_n( &ucTraceSymbolReady[ ulIndex ], 1, __ATOMIC_RELEASE );
+}
+
+/**
+ * @brief Resume recording after vTraceRecorderStop()
+ *
+ */
+void vTraceRecorderStart( void )
+{
+    __atomic_store_n( &ulTraceRecording, 1, __ATOMIC_RELEASE );
+}
+
+/**
+ * @brief Stop recording, the buffers keep their content
+ *
+ */
+void vTraceRecorderStop( void )
+{
+    __atomic_store_n( &ulTraceRecording, 0, __ATOMIC_RELEASE );
+}
+
+/**
+ * @brief Write the whole buffer with retry on partial writes
+ *
+ */
+static int prvWriteAll( int iFile,
+                        const void * pvData,
+                        size_t xLength )
+{
+    const uint8_t * pucData = pvData;
+    ssize_t xWritten;
+
+    while( xLength > 0 )
+    {
+        xWritten = write( iFile, pucData, xLength );
+
+        if( xWritten <= 0 )
+        {
+            return -1;
+        }
+
+        pucData += xWritten;
+        xLength -= ( size_t ) xWritten;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Copy the record at a ring position unless it is unfinished or was
+ * overwritten before or during the copy
+ *
+ * @param pxRing ring of the record
+ * @param ullSlot ring position of the record
+ * @param pxCopy copy of the record
+ * @return int 1 if pxCopy holds the whole record of ullSlot
+ */
+static int prvCopyRecord( const TraceRing_t * pxRing,
+                          uint64_t ullSlot,
+                          TraceRecord_t * pxCopy )
+{
+    const TraceSlot_t * pxSlot = &pxRing->xSlots[ ullSlot & ( configTRACE_RECORDER_BUFFER_SIZE - 1U ) ];
+
+    if( __atomic_load_n( &pxSlot->ullCommit, __ATOMIC_ACQUIRE ) != ullSlot + 1U )
+    {
+        return 0;
+    }
+
+    memcpy( pxCopy, &pxSlot->xRecord, sizeof( TraceRecord_t ) );
+    __atomic_thread_fence( __ATOMIC_ACQUIRE );
+
+    return __atomic_load_n( &pxSlot->ullCommit, __ATOMIC_RELAXED ) == ullSlot + 1U;
+}
+
+/**
+ * @brief Write the symbols and every ring to a file
+ *
+ * Recording is paused while the rings are copied and restored afterwards.
+ * Writers that were already recording may still finish a record meanwhile:
+ * unfinished or changed records are left out, and the record count of each
+ * core is written once its records are.
+ *
+ * @param pcFileName output file, truncated if it exists
+ * @return int 0 on success, -1 on error
+ */
+int xTraceRecorderDump( const char * pcFileName )
+{
+    TraceFileHeader_t xHeader;
+    TraceCoreHeader_t xCoreHeader;
+    TraceRing_t * pxRing;
+    TraceRecord_t xChunk[ traceRECORDER_DUMP_CHUNK ];
+    uint32_t ulWasRecording;
+    uint32_t ulCore;
+    uint32_t ulSymbols;
+    uint32_t ulChunk;
+    uint32_t i;
+    uint64_t ullHead;
+    uint64_t ullFirst;
+    uint64_t ullSlot;
+    off_t xCoreHeaderOffset;
+    int iFile;
+    int iRet = 0;
+
+    iFile = open( pcFileName, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+
+    if( iFile < 0 )
+    {
+        return -1;
+    }
+
+    ulWasRecording = __atomic_exchange_n( &ulTraceRecording, 0, __ATOMIC_ACQ_REL );
+
+    /* The symbols written so far are counted first, the entries written
+     * meanwhile are left for the next dump. */
+    ulSymbols = __atomic_load_n( &ulTraceSymbolsReserved, __ATOMIC_ACQUIRE );
+    ulSymbols = ( ulSymbols > configTRACE_RECORDER_MAX_SYMBOLS ) ? configTRACE_RECORDER_MAX_SYMBOLS : ulSymbols;
+
+    memcpy( xHeader.cMagic, "FRTR", sizeof( xHeader.cMagic ) );
+    xHeader.ulVersion = traceRECORDER_FILE_VERSION;
+    xHeader.ulRecordSize = sizeof( TraceRecord_t );
+    xHeader.ulCoreCount = traceRECORDER_NUM_CORES;
+    xHeader.ulSymbolCount = 0;
+    xHeader.ulSymbolSize = sizeof( TraceSymbol_t );
+
+    for( i = 0; i < ulSymbols; i++ )
+    {
+        if( __atomic_load_n( &ucTraceSymbolReady[ i ], __ATOMIC_ACQUIRE ) != 0 )
+        {
+            xHeader.ulSymbolCount++;
+        }
+    }
+
+    iRet |= prvWriteAll( iFile, &xHeader, sizeof( xHeader ) );
+
+    for( i = 0, ulSymbols = 0; ( i < configTRACE_RECORDER_MAX_SYMBOLS ) && ( ulSymbols < xHeader.ulSymbolCount ); i++ )
+    {
+        if( __atomic_load_n( &ucTraceSymbolReady[ i ], __ATOMIC_ACQUIRE ) != 0 )
+        {
+            iRet |= prvWriteAll( iFile, &xTraceSymbols[ i ], sizeof( TraceSymbol_t ) );
+            ulSymbols++;
+        }
+    }
+
+    for( ulCore = 0; ulCore < traceRECORDER_NUM_CORES; ulCore++ )
+    {
+        pxRing = &xTraceRings[ ulCore ];
+        ullHead = __atomic_load_n( &pxRing->ullHead, __ATOMIC_ACQUIRE );
+        ullFirst = ( ullHead > configTRACE_RECORDER_BUFFER_SIZE ) ? ( ullHead - configTRACE_RECORDER_BUFFER_SIZE ) : 0U;
+
+        /* The header is rewritten with the count of the records kept. */
+        xCoreHeader.ulCore = ulCore;
+        xCoreHeader.ulRecordCount = 0;
+        xCoreHeader.ullLostRecords = ullFirst;
+        xCoreHeaderOffset = lseek( iFile, 0, SEEK_CUR );
+        iRet |= prvWriteAll( iFile, &xCoreHeader, sizeof( xCoreHeader ) );
+
+        /* Oldest record first. */
+        ulChunk = 0;
+
+        for( ullSlot = ullFirst; ullSlot < ullHead; ullSlot++ )
+        {
+            if( prvCopyRecord( pxRing, ullSlot, &xChunk[ ulChunk ] ) != 0 )
+            {
+                ulChunk++;
+                xCoreHeader.ulRecordCount++;
+            }
+
+            if( ( ulChunk == traceRECORDER_DUMP_CHUNK ) || ( ( ullSlot + 1U ) == ullHead ) )
+            {
+                iRet |= prvWriteAll( iFile, xChunk, ulChunk * sizeof( TraceRecord_t ) );
+                ulChunk = 0;
+            }
+        }
+
+        if( ( xCoreHeaderOffset < 0 ) ||
+            ( pwrite( iFile, &xCoreHeader, sizeof( xCoreHeader ), xCoreHeaderOffset ) != ( ssize_t ) sizeof( xCoreHeader ) ) )
+        {
+            iRet = -1;
+        }
+    }
+
+    close( iFile );
+
+    __atomic_store_n( &ulTraceRecording, ulWasRecording, __ATOMIC_RELEASE );
+
+    return iRet;
+}
+
+#endif /* configUSE_TRACE_RECORDER */
@@ -0,0 +1,115 @@
+/**
+ * @file trace_recorder.h
+ * @brief Low overhead binary recorder for the kernel trace macros
+ *
+ * Every event is stored as a fixed size record in a per core ring buffer.
+ * Recording only reserves a slot with an atomic increment, reads the
+ * monotonic clock and writes the record, so it is cheap enough to stay
+ * enabled.  The buffers are written to a file with xTraceRecorderDump() and
+ * converted on the host with tools/trace_to_chrome.py.
+ *
+ * This header is included by FreeRTOSConfig.h (through trace_hooks.h), so it
+ * must not depend on any FreeRTOS type.
+ */
+
+#ifndef TRACE_RECORDER_H
+    #define TRACE_RECORDER_H
+
+    #include <stdint.h>
+
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    #ifndef configUSE_TRACE_RECORDER
+        #define configUSE_TRACE_RECORDER    0
+    #endif
+
+/* Number of records kept per core, must be a power of two. */
+    #ifndef configTRACE_RECORDER_BUFFER_SIZE
+        #define configTRACE_RECORDER_BUFFER_SIZE    16384U
+    #endif
+
+/* Maximum number of task and queue names kept for the host converter. */
+    #ifndef configTRACE_RECORDER_MAX_SYMBOLS
+        #define configTRACE_RECORDER_MAX_SYMBOLS    64U
+    #endif
+
+    #ifdef configNUMBER_OF_CORES
+        #define traceRECORDER_NUM_CORES    configNUMBER_OF_CORES
+    #else
+        #define traceRECORDER_NUM_CORES    1U
+    #endif
+
+    #define traceRECORDER_SYMBOL_LEN       24U
+    #define traceRECORDER_FILE_VERSION     1U
+
+/* Event identifiers, shared with tools/trace_to_chrome.py. */
+    typedef enum
+    {
+        eTraceTaskCreate = 1,
+        eTraceTaskDelete,
+        eTraceTaskSwitchedIn,
+        eTraceTaskDelay,
+        eTraceTaskDelayUntil,
+        eTraceTaskSuspend,
+        eTraceTaskResume,
+        eTraceTaskPrioritySet,
+        eTraceTaskPriorityInherit,
+        eTraceTaskPriorityDisinherit,
+        eTraceTaskNotify,
+        eTraceTaskNotifyTake,
+        eTraceTick,
+        eTraceQueueCreate,
+        eTraceQueueSend,
+        eTraceQueueSendFailed,
+        eTraceQueueSendFromISR,
+        eTraceQueueReceive,
+        eTraceQueueReceiveFailed,
+        eTraceQueueReceiveFromISR,
+        eTraceQueuePeek,
+        eTraceQueueBlockingOnSend,
+        eTraceQueueBlockingOnReceive,
+        eTraceMalloc,
+        eTraceFree
+    } eTraceEvent_t;
+
+/* One event.  ullObject is the task, queue or block address the event
+ * refers to and ulArg an event specific value (queue type, tick count,
+ * priority, size...). */
+    typedef struct xTRACE_RECORD
+    {
+        uint64_t ullTimestampNs;
+        uint64_t ullObject;
+        uint32_t ulArg;
+        uint8_t ucEvent;
+        uint8_t ucCore;
+        uint16_t usReserved;
+    } TraceRecord_t;
+
+    void vTraceRecorderWrite( uint8_t ucEvent,
+                              const void * pvObject,
+                              uint32_t ulArg );
+    void vTraceRecorderAddSymbol( const void * pvObject,
+                                  const char * pcName );
+    void vTraceRecorderStart( void );
+    void vTraceRecorderStop( void );
+    int xTraceRecorderDump( const char * pcFileName );
+
+/*
+ * Sub hooks used by trace_hooks.h.  They expand to nothing when the recorder
+ * is disabled so the kernel macros cost nothing.
+ */
+    #if ( configUSE_TRACE_RECORDER == 1 )
+        #define traceRECORD( ucEvent, pvObject, ulArg )    vTraceRecorderWrite( ( uint8_t ) ( ucEvent ), ( const void * ) ( pvObject ), ( uint32_t ) ( ulArg ) )
+        #define traceRECORD_SYMBOL( pvObject, pcName )     vTraceRecorderAddSymbol( ( const void * ) ( pvObject ), ( pcName ) )
+    #else
+        #define traceRECORD( ucEvent, pvObject, ulArg )
+        #define traceRECORD_SYMBOL( pvObject, pcName )
+    #endif
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif /* TRACE_RECORDER_H */
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""
+Resolve the frames of the folded stacks written by xSampleProfilerWrite()
+(source/sample_profiler.c).
+
+Frames are written as "module+0xoffset" because static functions are not
+visible to dladdr(); this tool maps them to function names with the symbol
+tables of the modules (nm), so the output can be fed to flamegraph.pl or
+https://www.speedscope.app.
+
+Usage: symbolize_folded.py build/profile.folded [-o profile.txt] [--keep-offsets]
+"""
+
+import argparse
+import bisect
+import os
+import re
+import subprocess
+import sys
+
+FRAME = re.compile(r"^(?P<module>.+)\+0x(?P<offset>[0-9a-fA-F]+)$")
+
+
+class Module:
+    def __init__(self, path):
+        self.path = path
+        self.addresses = []
+        self.sizes = []
+        self.names = []
+        symbols = self._nm([]) or self._nm(["-D"])
+        for address, size, name in sorted(symbols):
+            self.addresses.append(address)
+            self.sizes.append(size)
+            self.names.append(name)
+
+    def _nm(self, extra):
+        try:
+            output = subprocess.run(["nm", "-n", "-S", "--defined-only"] + extra + [self.path],
+                                    capture_output=True, text=True, check=False).stdout
+        except OSError:
+            return []
+        symbols = []
+        for line in output.splitlines():
+            fields = line.split()
+            if len(fields) == 4 and fields[2] in "TtWw":
+                # Drop the symbol version of shared libraries (read@@GLIBC_2.2.5).
+                symbols.append((int(fields[0], 16), int(fields[1], 16), fields[3].split("@")[0]))
+            elif len(fields) == 3 and fields[1] in "TtWw":
+                symbols.append((int(fields[0], 16), None, fields[2].split("@")[0]))
+        return symbols
+
+    def resolve(self, offset, keep_offset):
+        index = bisect.bisect_right(self.addresses, offset) - 1
+        if index < 0:
+            return None
+        # Stripped libraries only export some functions, an offset past the
+        # end of the nearest one belongs to a function without a symbol.
+        size = self.sizes[index]
+        if size is not None and offset >= self.addresses[index] + size:
+            return None
+        name = self.names[index]
+        if keep_offset:
+            name += "+0x%x" % (offset - self.addresses[index])
+        return name
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("folded", help="folded stacks written by the profiler")
+    parser.add_argument("-o", "--output", help="output file (default: stdout)")
+    parser.add_argument("--keep-offsets", action="store_true",
+                        help="keep the offset inside the function")
+    args = parser.parse_args()
+
+    modules = {}
+
+    def resolve(frame):
+        match = FRAME.match(frame)
+        if not match:
+            return frame
+        path = match.group("module")
+        if path not in modules:
+            modules[path] = Module(path)
+        name = modules[path].resolve(int(match.group("offset"), 16), args.keep_offsets)
+        return name if name else "%s+0x%s" % (os.path.basename(path), match.group("offset"))
+
+    # Identical stacks after symbolization are merged.
+    counts = {}
+    with open(args.folded) as folded:
+        for line in folded:
+            stack, _, count = line.rstrip("\n").rpartition(" ")
+            if not stack:
+                continue
+            frames = stack.split(";")
+            key = ";".join([frames[0]] + [resolve(frame) for frame in frames[1:]])
+            counts[key] = counts.get(key, 0) + int(count)
+
+    output = open(args.output, "w") if args.output else sys.stdout
+    for stack, count in sorted(counts.items(), key=lambda item: -item[1]):
+        output.write("%s %d\n" % (stack, count))
+    if args.output:
+        output.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""
+Convert a kernel trace written by xTraceRecorderDump() (source/trace_recorder.c)
+into the Chrome trace event JSON format.
+
+The output can be opened with chrome://tracing or https://ui.perfetto.dev.
+Every core is shown as a process, every task as a thread; task execution is
+drawn as slices and kernel events as instant events on the running task.
+
+Usage: trace_to_chrome.py build/trace.bin [-o trace.json] [--ticks]
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+FILE_HEADER = struct.Struct("=4sIIIII")
+SYMBOL = struct.Struct("=Q24s")
+CORE_HEADER = struct.Struct("=IIQ")
+RECORD = struct.Struct("=QQIBBH")
+
+# Must match eTraceEvent_t in trace_recorder.h.
+EVENTS = [
+    None,
+    "TaskCreate",
+    "TaskDelete",
+    "TaskSwitchedIn",
+    "TaskDelay",
+    "TaskDelayUntil",
+    "TaskSuspend",
+    "TaskResume",
+    "TaskPrioritySet",
+    "TaskPriorityInherit",
+    "TaskPriorityDisinherit",
+    "TaskNotify",
+    "TaskNotifyTake",
+    "Tick",
+    "QueueCreate",
+    "QueueSend",
+    "QueueSendFailed",
+    "QueueSendFromISR",
+    "QueueReceive",
+    "QueueReceiveFailed",
+    "QueueReceiveFromISR",
+    "QueuePeek",
+    "QueueBlockingOnSend",
+    "QueueBlockingOnReceive",
+    "Malloc",
+    "Free",
+]
+
+# queueQUEUE_TYPE_* from queue.h.
+QUEUE_TYPES = {0: "Queue", 1: "Mutex", 2: "CountingSemaphore", 3: "BinarySemaphore", 4: "RecursiveMutex"}
+
+# Queue events renamed when the object is a mutex.
+MUTEX_EVENTS = {
+    "QueueSend": "MutexGive",
+    "QueueReceive": "MutexTake",
+    "QueueReceiveFailed": "MutexTakeFailed",
+    "QueueBlockingOnReceive": "MutexBlocked",
+}
+
+
+def read_trace(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    magic, version, record_size, cores, symbol_count, symbol_size = FILE_HEADER.unpack_from(data, 0)
+    if magic != b"FRTR":
+        raise ValueError("%s is not a kernel trace" % path)
+    if version != 1 or record_size != RECORD.size or symbol_size != SYMBOL.size:
+        raise ValueError("unsupported trace version %d" % version)
+
+    offset = FILE_HEADER.size
+    symbols = {}
+    for _ in range(symbol_count):
+        obj, name = SYMBOL.unpack_from(data, offset)
+        symbols[obj] = name.split(b"\0", 1)[0].decode(errors="replace")
+        offset += SYMBOL.size
+
+    records = []
+    lost = 0
+    for _ in range(cores):
+        core, count, core_lost = CORE_HEADER.unpack_from(data, offset)
+        offset += CORE_HEADER.size
+        lost += core_lost
+        for _ in range(count):
+            ts, obj, arg, event, rec_core, _ = RECORD.unpack_from(data, offset)
+            offset += RECORD.size
+            if event != 0:
+                records.append((ts, obj, arg, event, rec_core))
+
+    records.sort(key=lambda r: r[0])
+    return symbols, records, lost
+
+
+def convert(symbols, records, with_ticks):
+    def name_of(obj):
+        return symbols.get(obj, "0x%x" % obj)
+
+    events = []
+    if not records:
+        return events
+
+    t0 = records[0][0]
+    tids = {}
+    named = set()
+
+    def tid_of(task, core):
+        if task not in tids:
+            tids[task] = len(tids) + 1
+        if (core, task) not in named:
+            named.add((core, task))
+            events.append({"ph": "M", "name": "thread_name", "pid": core, "tid": tids[task],
+                           "args": {"name": name_of(task)}})
+        return tids[task]
+
+    running = {}  # core -> (task, start ts)
+
+    for ts, obj, arg, event, core in records:
+        us = (ts - t0) / 1000.0
+        name = EVENTS[event] if event < len(EVENTS) else "Event%d" % event
+
+        if name == "TaskSwitchedIn":
+            prev = running.get(core)
+            if prev is not None and prev[0] != obj:
+                events.append({"ph": "X", "name": name_of(prev[0]), "pid": core, "tid": tid_of(prev[0], core),
+                               "ts": (prev[1] - t0) / 1000.0, "dur": (ts - prev[1]) / 1000.0})
+            if prev is None or prev[0] != obj:
+                running[core] = (obj, ts)
+            continue
+
+        if name == "Tick" and not with_ticks:
+            continue
+
+        current = running.get(core)
+        tid = tid_of(current[0], core) if current else 0
+        args = {"object": name_of(obj), "arg": arg}
+
+        if name.startswith("Queue"):
+            args["type"] = QUEUE_TYPES.get(arg, str(arg))
+            if arg in (1, 4):
+                name = MUTEX_EVENTS.get(name, name)
+
+        events.append({"ph": "i", "s": "t", "name": name, "pid": core, "tid": tid, "ts": us, "args": args})
+
+    last_ts = records[-1][0]
+    for core, (task, start) in running.items():
+        events.append({"ph": "X", "name": name_of(task), "pid": core, "tid": tid_of(task, core),
+                       "ts": (start - t0) / 1000.0, "dur": (last_ts - start) / 1000.0})
+
+    for core in sorted({r[4] for r in records}):
+        events.append({"ph": "M", "name": "process_name", "pid": core, "args": {"name": "Core %d" % core}})
+
+    return events
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("trace", help="binary trace written by xTraceRecorderDump()")
+    parser.add_argument("-o", "--output", help="output JSON file (default: stdout)")
+    parser.add_argument("--ticks", action="store_true", help="include tick interrupts as instant events")
+    args = parser.parse_args()
+
+    symbols, records, lost = read_trace(args.trace)
+    events = convert(symbols, records, args.ticks)
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    json.dump({"traceEvents": events, "displayTimeUnit": "ns"}, out)
+    if args.output:
+        out.close()
+
+    print("%d records, %d overwritten" % (len(records), lost), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()